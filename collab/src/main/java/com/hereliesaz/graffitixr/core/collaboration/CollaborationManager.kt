@@ -35,7 +35,12 @@ class CollaborationManager @Inject constructor() {
     // previous collector (otherwise one leaks per host/join cycle and stale ones race _state).
     @Volatile private var observeJob: Job? = null
 
-    /** Begin hosting. Returns the QR payload to display. */
+    /**
+     * Begin hosting. Returns the QR payload to display.
+     *
+     * [fingerprintDelta] answers the guest's periodic fingerprint sync: given the (epoch, generation)
+     * the guest holds, the changes since, or null when it is current. Called on an IO thread.
+     */
     suspend fun startHosting(
         projectId: String,
         layerCount: Int,
@@ -43,6 +48,7 @@ class CollaborationManager @Inject constructor() {
         projectBytes: ByteArray,
         localDeviceName: String,
         protocolVersion: Int = ProtocolVersion.CURRENT,
+        fingerprintDelta: ((epoch: Long, sinceGen: Long) -> ByteArray?)? = null,
     ): String {
         check(hostSession == null && guestSession == null) { "already in a session" }
         val token = QrPayload.newToken()
@@ -54,6 +60,7 @@ class CollaborationManager @Inject constructor() {
             projectBytes = projectBytes,
             projectId = projectId,
             layerCount = layerCount,
+            fingerprintDelta = fingerprintDelta,
         )
         hostSession = session
         observe(session.state)
@@ -68,11 +75,18 @@ class CollaborationManager @Inject constructor() {
         return payload.encode()
     }
 
+    /**
+     * Join the session in [qr]. With [fingerprintBase] and [onFingerprintSync] both given, the guest
+     * periodically asks the host for the wall changes since the (epoch, generation) the first reports
+     * and hands each answer to the second.
+     */
     suspend fun joinFromQr(
         qr: String,
         localDeviceName: String,
         onBulkReceived: suspend (fingerprint: ByteArray, project: ByteArray) -> Unit,
         onOp: suspend (Op) -> Unit,
+        fingerprintBase: (() -> Pair<Long, Long>)? = null,
+        onFingerprintSync: (suspend (ByteArray) -> Unit)? = null,
     ) {
         check(hostSession == null && guestSession == null) { "already in a session" }
         val payload = QrPayload.parse(qr)
@@ -84,6 +98,8 @@ class CollaborationManager @Inject constructor() {
             localDeviceName = localDeviceName,
             onBulkReceived = onBulkReceived,
             onOp = onOp,
+            fingerprintBase = fingerprintBase,
+            onFingerprintSync = onFingerprintSync,
         )
         guestSession = session
         observe(session.state)
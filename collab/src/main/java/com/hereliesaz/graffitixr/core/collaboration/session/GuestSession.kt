@@ -24,6 +24,15 @@ internal class GuestSession(
     // use a short, deterministic window instead of waiting the full production 30s.
     private val reconnectWindowMs: Long = 30_000L,
     private val reconnectIntervalMs: Long = 2_000L,
+    /**
+     * The fingerprint state this guest holds, as (epoch, generation), for the next FP_SYNC_REQUEST;
+     * (0, 0) asks for the whole wall. Fingerprint sync runs only when this and [onFingerprintSync]
+     * are both given.
+     */
+    private val fingerprintBase: (() -> Pair<Long, Long>)? = null,
+    /** Receives each non-empty answer to an FP_SYNC_REQUEST. */
+    private val onFingerprintSync: (suspend (ByteArray) -> Unit)? = null,
+    private val fingerprintSyncIntervalMs: Long = 5_000L,
 ) : Session() {
 
     private val scope = CoroutineScope(SupervisorJob() + Dispatchers.IO)
@@ -31,6 +40,12 @@ internal class GuestSession(
     @Volatile private var lastAppliedSeq: Long = 0L
     private var socket: Socket? = null
 
+    // Fingerprint sync: at most one request outstanding, and the answer being reassembled. The
+    // buffer is touched only by the inbound loop; the flag is also read by the request loop.
+    @Volatile private var fpSyncInFlight = false
+    private var fpSyncBuffer: ByteArray? = null
+    private var fpSyncOffset = 0
+
     private fun randomNonce(): ByteArray = ByteArray(16).also { java.security.SecureRandom().nextBytes(it) }
     // Guards the check-then-set phase transition in attemptReconnect(): the inbound loop and a
     // failed PONG write can race into it, and without the lock each would run its own full
@@ -211,6 +226,9 @@ internal class GuestSession(
     }
 
     private suspend fun livePhase(input: InputStream, output: OutputStream, crypto: SessionCrypto) {
+        // A request sent on a previous connection was answered there or not at all.
+        fpSyncInFlight = false
+        fpSyncBuffer = null
         scope.launch {
             while (scope.isActive) {
                 val frame = try {
@@ -236,6 +254,34 @@ internal class GuestSession(
                             attemptReconnect(); return@launch
                         }
                     }
+                    FrameType.FP_SYNC_BEGIN -> {
+                        val begin = OpCodec.decode<FingerprintSyncBeginPayload>(frame.payload)
+                        // Peer-declared size: refuse absurd ones before allocating, as receiveChunked does.
+                        if (begin.bytes > 0 && begin.bytes <= Limits.MAX_BULK_BYTES) {
+                            fpSyncBuffer = ByteArray(begin.bytes)
+                            fpSyncOffset = 0
+                        } else {
+                            fpSyncBuffer = null
+                            fpSyncInFlight = false
+                        }
+                    }
+                    FrameType.FP_SYNC_CHUNK -> {
+                        val buffer = fpSyncBuffer
+                        if (buffer == null || frame.payload.size > buffer.size - fpSyncOffset) {
+                            // Out of step with the FP_SYNC_BEGIN header. Drop the answer; the next
+                            // request starts over from whatever base the engine then reports.
+                            fpSyncBuffer = null
+                            fpSyncInFlight = false
+                        } else {
+                            System.arraycopy(frame.payload, 0, buffer, fpSyncOffset, frame.payload.size)
+                            fpSyncOffset += frame.payload.size
+                            if (fpSyncOffset == buffer.size) {
+                                fpSyncBuffer = null
+                                onFingerprintSync?.invoke(buffer)
+                                fpSyncInFlight = false
+                            }
+                        }
+                    }
                     FrameType.BYE -> {
                         val bye = OpCodec.decode<ByePayload>(frame.payload)
                         close(bye.reason); return@launch
@@ -256,6 +302,29 @@ internal class GuestSession(
                 }
             }
         }
+        val base = fingerprintBase
+        if (base != null && onFingerprintSync != null) {
+            scope.launch {
+                // Periodic FP_SYNC_REQUEST: asks the host for the wall marks its self-grow and
+                // refinement produced since the state this guest holds. Polled rather than pushed
+                // because only the guest knows its base. A request for "nothing new" and its empty
+                // answer cost a few dozen bytes. Same write-failure exit as the ack loop.
+                while (scope.isActive) {
+                    delay(fingerprintSyncIntervalMs)
+                    if (fpSyncInFlight) continue
+                    val (epoch, sinceGen) = base()
+                    fpSyncInFlight = true
+                    try {
+                        writeSecure(
+                            output, crypto, FrameType.FP_SYNC_REQUEST,
+                            OpCodec.encode(FingerprintSyncRequestPayload(epoch, sinceGen)),
+                        )
+                    } catch (_: Exception) {
+                        return@launch
+                    }
+                }
+            }
+        }
     }
 
     private suspend fun attemptReconnect() {
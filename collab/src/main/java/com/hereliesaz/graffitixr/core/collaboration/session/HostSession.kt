@@ -9,6 +9,8 @@ import com.hereliesaz.graffitixr.core.collaboration.wire.BulkBeginPayload
 import com.hereliesaz.graffitixr.core.collaboration.wire.ByePayload
 import com.hereliesaz.graffitixr.core.collaboration.wire.DeltaAckPayload
 import com.hereliesaz.graffitixr.core.collaboration.wire.DeltaPayload
+import com.hereliesaz.graffitixr.core.collaboration.wire.FingerprintSyncBeginPayload
+import com.hereliesaz.graffitixr.core.collaboration.wire.FingerprintSyncRequestPayload
 import com.hereliesaz.graffitixr.core.collaboration.wire.Frame
 import com.hereliesaz.graffitixr.core.collaboration.wire.FrameType
 import com.hereliesaz.graffitixr.core.collaboration.wire.HelloOkPayload
@@ -48,6 +50,12 @@ internal class HostSession(
     private val projectBytes: ByteArray,
     private val projectId: String,
     private val layerCount: Int,
+    /**
+     * Answers a guest's FP_SYNC_REQUEST: the fingerprint changes since (epoch, sinceGen), or null
+     * when the guest is current. Null here answers every request with "current", which is what a
+     * host with no live engine behind it can truthfully say.
+     */
+    private val fingerprintDelta: ((epoch: Long, sinceGen: Long) -> ByteArray?)? = null,
 ) : Session() {
 
     init {
@@ -381,6 +389,27 @@ internal class HostSession(
         }
     }
 
+    /**
+     * Answer one FP_SYNC_REQUEST. Every request gets an FP_SYNC_BEGIN, if only an empty one, because
+     * the guest keeps one request outstanding and would otherwise never ask again. Written from the
+     * inbound loop, so requests are answered one at a time and in order; the chunks still interleave
+     * with the outbound loop's DELTAs, which the guest expects.
+     */
+    private suspend fun sendFingerprintSync(
+        output: OutputStream,
+        crypto: SessionCrypto,
+        request: FingerprintSyncRequestPayload,
+    ) {
+        val bytes = try {
+            fingerprintDelta?.invoke(request.epoch, request.sinceGen)
+        } catch (e: Exception) {
+            Log.w(TAG, "fingerprint delta for (${request.epoch}, ${request.sinceGen}) failed", e)
+            null
+        }?.takeIf { it.size <= Limits.MAX_BULK_BYTES } ?: ByteArray(0)
+        writeSecure(output, crypto, FrameType.FP_SYNC_BEGIN, OpCodec.encode(FingerprintSyncBeginPayload(bytes.size)))
+        chunkAndWrite(output, crypto, FrameType.FP_SYNC_CHUNK, bytes)
+    }
+
     private suspend fun outboundLoop(output: OutputStream, crypto: SessionCrypto) {
         // Seq/encoding/DeltaBuffer accounting all happened in enqueueOp; this loop only ships
         // the pre-encoded delta payloads, sealed here.
@@ -416,6 +445,14 @@ internal class HostSession(
                         enterReconnecting(); return
                     }
                 }
+                FrameType.FP_SYNC_REQUEST -> {
+                    val request = OpCodec.decode<FingerprintSyncRequestPayload>(frame.payload)
+                    try {
+                        sendFingerprintSync(output, crypto, request)
+                    } catch (_: Exception) {
+                        enterReconnecting(); return
+                    }
+                }
                 FrameType.BULK_ACK -> { /* bulk done; ignore */ }
                 FrameType.BYE -> { close(CoopSessionState.EndReason.HostClosed); return }
                 else -> {
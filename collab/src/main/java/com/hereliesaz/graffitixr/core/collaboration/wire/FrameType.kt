@@ -11,6 +11,15 @@ internal enum class FrameType(val code: Byte) {
     BULK_ACK(0x24),
     DELTA(0x30),
     DELTA_ACK(0x31),
+
+    // Wall fingerprint sync (ProtocolVersion 3). The guest names the fingerprint state it holds and
+    // the host answers with what changed since: FP_SYNC_BEGIN carries the size (0 = already current)
+    // and FP_SYNC_CHUNK frames carry the bytes, chunked like a bulk transfer. The chunks may
+    // interleave with DELTA and PING frames, since the answer is written from the host's inbound loop
+    // while its outbound loop keeps running.
+    FP_SYNC_REQUEST(0x32),
+    FP_SYNC_BEGIN(0x33),
+    FP_SYNC_CHUNK(0x34),
     PING(0x40),
     PONG(0x41),
     BYE(0x50),
@@ -97,6 +97,17 @@ internal data class DeltaAckPayload(val lastSeq: Long)
 @Serializable
 internal data class BulkAckPayload(val lastSeq: Long)
 
+/**
+ * Guest→host: send the fingerprint changes since the wall state ([epoch], [sinceGen]) the guest's
+ * engine holds. (0, 0) — no usable base — asks for the whole wall.
+ */
+@Serializable
+internal data class FingerprintSyncRequestPayload(val epoch: Long, val sinceGen: Long)
+
+/** Host→guest: the answer to an FP_SYNC_REQUEST is [bytes] long and follows as FP_SYNC_CHUNK frames. */
+@Serializable
+internal data class FingerprintSyncBeginPayload(val bytes: Int)
+
 @Serializable
 internal data class PingPayload(val ts: Long)
 
@@ -6,7 +6,11 @@ package com.hereliesaz.graffitixr.core.collaboration.wire
  *
  * v2 introduced the token-derived AES-256-GCM transport (SessionCrypto) and the nonce/proof
  * handshake, so a v1 (plaintext) peer can never establish a session with a v2 peer.
+ *
+ * v3 changed what BULK_FINGERPRINT carries — the versioned fingerprint change set
+ * (docs/data_formats.md §5) in place of the unversioned blob — and added the FP_SYNC frames. A v2
+ * guest would hand the new blob to a parser that reads its magic as a point count.
  */
 internal object ProtocolVersion {
-    const val CURRENT: Int = 2
+    const val CURRENT: Int = 3
 }
@@ -9,6 +9,7 @@ import com.hereliesaz.graffitixr.core.collaboration.session.HostSession
 import kotlinx.coroutines.delay
 import kotlinx.coroutines.runBlocking
 import kotlinx.coroutines.withTimeout
+import org.junit.Assert.assertArrayEquals
 import org.junit.Assert.assertEquals
 import org.junit.Test
 
@@ -71,4 +72,57 @@ class LocalLoopTest {
         host.close(CoopSessionState.EndReason.UserLeft)
         guest.close(CoopSessionState.EndReason.UserLeft)
     }
+
+    @Test
+    fun `fingerprint sync sends only what the guest's base lacks`() = runBlocking {
+        // Bigger than one 64KB chunk, so reassembly across FP_SYNC_CHUNK frames is exercised.
+        val delta = ByteArray(150_000) { (it * 13).toByte() }
+        val requests = java.util.Collections.synchronizedList(mutableListOf<Pair<Long, Long>>())
+        val host = HostSession(
+            token = "tok",
+            protocolVersion = 1,
+            localDeviceName = "host",
+            fingerprintBytes = ByteArray(16),
+            projectBytes = ByteArray(16),
+            projectId = "p1",
+            layerCount = 0,
+            fingerprintDelta = { epoch, sinceGen ->
+                requests.add(epoch to sinceGen)
+                // Generation 7 of wall 42 is current; anything older gets the change set.
+                if (epoch == 42L && sinceGen == 7L) null else delta
+            },
+        )
+        val port = host.startListening()
+
+        val base = java.util.concurrent.atomic.AtomicReference(0L to 0L)
+        val synced = java.util.Collections.synchronizedList(mutableListOf<ByteArray>())
+        val guest = GuestSession(
+            host = "127.0.0.1",
+            port = port,
+            token = "tok",
+            protocolVersion = 1,
+            localDeviceName = "guest",
+            onBulkReceived = { _, _ -> },
+            onOp = { },
+            fingerprintBase = { base.get() },
+            onFingerprintSync = { bytes ->
+                synced.add(bytes)
+                base.set(42L to 7L)
+            },
+            fingerprintSyncIntervalMs = 100L,
+        )
+        guest.connect()
+
+        // The first request names no base and is answered in full; later ones name the base that
+        // answer produced, and an up-to-date guest is sent nothing.
+        withTimeout(5_000) {
+            while (requests.count { it == (42L to 7L) } < 2) delay(50)
+        }
+        assertEquals(0L to 0L, requests.first())
+        assertEquals(1, synced.size)
+        assertArrayEquals(delta, synced.single())
+
+        host.close(CoopSessionState.EndReason.UserLeft)
+        guest.close(CoopSessionState.EndReason.UserLeft)
+    }
 }
@@ -175,6 +175,12 @@ data class GraffitiProject(
     // projects without one; built passively during normal use. Defaulted for back-compat.
     val wallFeatureMap: WallFeatureMap? = null,
 
+    // File name, inside the project directory, of the binary wall sidecar (docs/data_formats.md §4)
+    // that holds the feature map — and a copy of the fingerprint — in place of [wallFeatureMap]. It is
+    // memory-mapped on load rather than parsed. Null on projects saved before it; those keep loading
+    // [wallFeatureMap], and the first save after moves the map into the sidecar.
+    val wallSidecarFile: String? = null,
+
     // Per-host AzNavRail expansion state (host id -> expanded), so the rail restores exactly as the
     // user left it on reopen. Defaulted for back-compat. Populated via onRailHostExpansionChanged once
     // AzNavRail exposes a per-host expansion-change callback (onExpandedChange, expected 10.11); until
@@ -12,6 +12,7 @@ import kotlinx.serialization.encodeToString
 import kotlinx.serialization.json.Json
 import org.junit.After
 import org.junit.Assert.assertEquals
+import org.junit.Assert.assertNull
 import org.junit.Before
 import org.junit.Test
 
@@ -89,6 +90,18 @@ class GraffitiProjectTest {
         assertEquals(map, decoded.wallFeatureMap)
     }
 
+    @Test
+    fun `serialization preserves the wall sidecar reference`() {
+        // The sidecar itself is binary and native-read; project.json carries only its name, and an
+        // older project without one must decode to null so the JSON map keeps loading.
+        val project = GraffitiProject(id = "id", name = "n", wallSidecarFile = "wall.gxws")
+
+        val decoded = json.decodeFromString<GraffitiProject>(json.encodeToString(project))
+
+        assertEquals("wall.gxws", decoded.wallSidecarFile)
+        assertNull(json.decodeFromString<GraffitiProject>("""{"id":"id","name":"n"}""").wallSidecarFile)
+    }
+
     @Test
     fun `serialization preserves per-host rail expansion`() {
         val expansion = mapOf("host.design" to true, "design.layers" to false)
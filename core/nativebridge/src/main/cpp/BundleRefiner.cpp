@@ -0,0 +1,164 @@
+#include "include/BundleRefiner.h"
+#include <opencv2/calib3d.hpp>
+#include <cmath>
+
+namespace {
+
+// Pixel residual of X under P, and the camera-frame point (for the Jacobians). False behind the camera.
+bool residual(const BundleRefiner::Pose& P, const cv::Point3f& X, const BundleRefiner::Obs& o,
+              cv::Vec3d& Xc, double& ru, double& rv) {
+    Xc = P.R * cv::Vec3d(X.x, X.y, X.z) + P.t;
+    if (Xc[2] <= 1e-4) return false;
+    ru = P.fx * Xc[0] / Xc[2] + P.cx - o.u;
+    rv = P.fy * Xc[1] / Xc[2] + P.cy - o.v;
+    return true;
+}
+
+// Huber: quadratic inside [h], linear outside; weight is its IRLS weight.
+double robustCost(double r2, double h) {
+    const double r = std::sqrt(r2);
+    return r <= h ? r2 : 2.0 * h * r - h * h;
+}
+double robustWeight(double r2, double h) {
+    const double r = std::sqrt(r2);
+    return r <= h ? 1.0 : h / r;
+}
+
+// d(u,v)/d(Xc): the pinhole projection's Jacobian.
+cv::Matx23d projJacobian(const BundleRefiner::Pose& P, const cv::Vec3d& Xc) {
+    const double iz = 1.0 / Xc[2], iz2 = iz * iz;
+    return cv::Matx23d(P.fx * iz, 0.0, -P.fx * Xc[0] * iz2,
+                       0.0, P.fy * iz, -P.fy * Xc[1] * iz2);
+}
+
+struct PoseRef {
+    size_t point;
+    BundleRefiner::Obs obs;
+};
+
+}  // namespace
+
+void BundleRefiner::solve(Problem& p, int iters, double huberPx, double& rmsBefore, double& rmsAfter) {
+    std::unordered_map<uint32_t, size_t> poseIndex;
+    for (size_t j = 0; j < p.poses.size(); ++j) poseIndex[p.poses[j].id] = j;
+
+    // Per-pose observation lists, built once: the pose sweep walks these.
+    std::vector<std::vector<PoseRef>> byPose(p.poses.size());
+    std::vector<size_t> fixedPerPose(p.poses.size(), 0);
+    for (size_t i = 0; i < p.pts.size(); ++i) {
+        for (const Obs& o : p.obs[i]) {
+            auto it = poseIndex.find(o.pose);
+            if (it == poseIndex.end()) continue;
+            byPose[it->second].push_back(PoseRef{i, o});
+            if (p.fixed[i]) ++fixedPerPose[it->second];
+        }
+    }
+
+    auto pointCost = [&](size_t i, const cv::Point3f& X, size_t& n) {
+        double c = 0.0;
+        n = 0;
+        for (const Obs& o : p.obs[i]) {
+            auto it = poseIndex.find(o.pose);
+            if (it == poseIndex.end()) continue;
+            cv::Vec3d Xc; double ru, rv;
+            if (!residual(p.poses[it->second], X, o, Xc, ru, rv)) return -1.0;
+            c += robustCost(ru * ru + rv * rv, huberPx);
+            ++n;
+        }
+        return c;
+    };
+    auto poseCost = [&](size_t j, const Pose& P) {
+        double c = 0.0;
+        for (const PoseRef& r : byPose[j]) {
+            cv::Vec3d Xc; double ru, rv;
+            if (!residual(P, p.pts[r.point], r.obs, Xc, ru, rv)) return -1.0;
+            c += robustCost(ru * ru + rv * rv, huberPx);
+        }
+        return c;
+    };
+    auto totalRms = [&]() {
+        double c = 0.0;
+        size_t n = 0;
+        for (size_t i = 0; i < p.pts.size(); ++i) {
+            size_t k;
+            const double ci = pointCost(i, p.pts[i], k);
+            if (ci < 0.0) continue;
+            c += ci;
+            n += k;
+        }
+        return n ? std::sqrt(c / (double)n) : 0.0;
+    };
+
+    rmsBefore = totalRms();
+    for (int it = 0; it < iters; ++it) {
+        // Structure: each free point against its own observations, poses held.
+        for (size_t i = 0; i < p.pts.size(); ++i) {
+            if (p.fixed[i]) continue;
+            const cv::Point3f X = p.pts[i];
+            cv::Matx33d H = cv::Matx33d::zeros();
+            cv::Vec3d g(0, 0, 0);
+            size_t n = 0;
+            double c0 = 0.0;
+            bool ok = true;
+            for (const Obs& o : p.obs[i]) {
+                auto pi = poseIndex.find(o.pose);
+                if (pi == poseIndex.end()) continue;
+                const Pose& P = p.poses[pi->second];
+                cv::Vec3d Xc; double ru, rv;
+                if (!residual(P, X, o, Xc, ru, rv)) { ok = false; break; }
+                const double r2 = ru * ru + rv * rv;
+                const double w = robustWeight(r2, huberPx);
+                const cv::Matx23d J = projJacobian(P, Xc) * P.R;
+                H += w * (J.t() * J);
+                g += w * (J.t() * cv::Vec2d(ru, rv));
+                c0 += robustCost(r2, huberPx);
+                ++n;
+            }
+            if (!ok || n < 2) continue;
+            const double lambda = 1e-6 * (H(0, 0) + H(1, 1) + H(2, 2)) + 1e-9;
+            for (int d = 0; d < 3; ++d) H(d, d) += lambda;
+            cv::Vec3d delta;
+            if (!cv::solve(H, -g, delta, cv::DECOMP_CHOLESKY)) continue;
+            const cv::Point3f X1(X.x + (float)delta[0], X.y + (float)delta[1], X.z + (float)delta[2]);
+            size_t n1;
+            const double c1 = pointCost(i, X1, n1);
+            if (c1 >= 0.0 && c1 < c0) p.pts[i] = X1;
+        }
+
+        // Motion: each pose pinned by enough fixed points, against all it saw; points held.
+        for (size_t j = 0; j < p.poses.size(); ++j) {
+            if (fixedPerPose[j] < kMinFixedPerPose) continue;
+            const Pose& P = p.poses[j];
+            cv::Matx66d H = cv::Matx66d::zeros();
+            cv::Vec6d g(0, 0, 0, 0, 0, 0);
+            const double c0 = poseCost(j, P);
+            if (c0 < 0.0) continue;
+            for (const PoseRef& r : byPose[j]) {
+                cv::Vec3d Xc; double ru, rv;
+                residual(P, p.pts[r.point], r.obs, Xc, ru, rv);
+                const double w = robustWeight(ru * ru + rv * rv, huberPx);
+                // Left perturbation: Xc' = Xc + w x Xc + tau, so d Xc / d(w, tau) = [-[Xc]x | I].
+                const double d[18] = {0.0,    Xc[2], -Xc[1], 1.0, 0.0, 0.0,
+                                      -Xc[2], 0.0,    Xc[0], 0.0, 1.0, 0.0,
+                                      Xc[1], -Xc[0],  0.0,   0.0, 0.0, 1.0};
+                const cv::Matx<double, 3, 6> D(d);
+                const cv::Matx<double, 2, 6> J = projJacobian(P, Xc) * D;
+                H += w * (J.t() * J);
+                g += w * (J.t() * cv::Vec2d(ru, rv));
+            }
+            double tr = 0.0;
+            for (int d = 0; d < 6; ++d) tr += H(d, d);
+            for (int d = 0; d < 6; ++d) H(d, d) += 1e-6 * tr + 1e-9;
+            cv::Vec6d delta;
+            if (!cv::solve(H, -g, delta, cv::DECOMP_CHOLESKY)) continue;
+            cv::Matx33d dR;
+            cv::Rodrigues(cv::Vec3d(delta[0], delta[1], delta[2]), dR);
+            Pose P1 = P;
+            P1.R = dR * P.R;
+            P1.t = dR * P.t + cv::Vec3d(delta[3], delta[4], delta[5]);
+            const double c1 = poseCost(j, P1);
+            if (c1 >= 0.0 && c1 < c0) p.poses[j] = P1;
+        }
+    }
+    rmsAfter = totalRms();
+}
@@ -0,0 +1,248 @@
+#include "include/DescriptorCodec.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace {
+
+constexpr int kProbBits = 11;
+constexpr uint16_t kProbInit = 1u << (kProbBits - 1);
+constexpr int kAdaptShift = 5;
+constexpr uint32_t kTop = 1u << 24;
+// The cheapest a bit can be is -log2(1 - 2^-kAdaptShift) bits, about 1/45 of one, so a byte of
+// range-coded input never yields more than 45 bytes; decode() holds a stream to 64.
+constexpr uint64_t kMaxExpansion = 64;
+
+// The LZMA binary range coder: a probability per context, adapted after every bit.
+class RangeEncoder {
+public:
+    explicit RangeEncoder(std::vector<uint8_t>& out) : mOut(out) {}
+    void encode(uint16_t& prob, int bit) {
+        const uint32_t bound = (mRange >> kProbBits) * prob;
+        if (!bit) {
+            mRange = bound;
+            prob += ((1u << kProbBits) - prob) >> kAdaptShift;
+        } else {
+            mLow += bound;
+            mRange -= bound;
+            prob -= prob >> kAdaptShift;
+        }
+        while (mRange < kTop) {
+            mRange <<= 8;
+            shiftLow();
+        }
+    }
+    void flush() { for (int i = 0; i < 5; ++i) shiftLow(); }
+
+private:
+    void shiftLow() {
+        if ((uint32_t)mLow < 0xFF000000u || (mLow >> 32) != 0) {
+            const uint8_t carry = (uint8_t)(mLow >> 32);
+            uint8_t byte = mCache;
+            do {
+                mOut.push_back((uint8_t)(byte + carry));
+                byte = 0xFF;
+            } while (--mCacheSize != 0);
+            mCache = (uint8_t)(mLow >> 24);
+        }
+        ++mCacheSize;
+        mLow = (mLow & 0x00FFFFFFu) << 8;
+    }
+    std::vector<uint8_t>& mOut;
+    uint64_t mLow = 0;
+    uint32_t mRange = 0xFFFFFFFFu;
+    uint8_t mCache = 0;
+    uint64_t mCacheSize = 1;
+};
+
+class RangeDecoder {
+public:
+    RangeDecoder(const uint8_t* p, const uint8_t* end) : mP(p), mEnd(end) {
+        for (int i = 0; i < 5; ++i) mCode = (mCode << 8) | next();
+    }
+    int decode(uint16_t& prob) {
+        const uint32_t bound = (mRange >> kProbBits) * prob;
+        int bit;
+        if (mCode < bound) {
+            mRange = bound;
+            prob += ((1u << kProbBits) - prob) >> kAdaptShift;
+            bit = 0;
+        } else {
+            mCode -= bound;
+            mRange -= bound;
+            prob -= prob >> kAdaptShift;
+            bit = 1;
+        }
+        while (mRange < kTop) {
+            mRange <<= 8;
+            mCode = (mCode << 8) | next();
+        }
+        return bit;
+    }
+
+private:
+    // Past the end reads as zeros, which is what the encoder's flush implies; a truncated stream
+    // decodes to wrong bits, never out of bounds.
+    uint8_t next() { return mP < mEnd ? *mP++ : 0; }
+    const uint8_t* mP;
+    const uint8_t* mEnd;
+    uint32_t mRange = 0xFFFFFFFFu;
+    uint32_t mCode = 0;
+};
+
+int blocksPerRow(int cols) { return (cols + DescriptorCodec::kBlock - 1) / DescriptorCodec::kBlock; }
+
+void putMethod(std::vector<uint8_t>& out, DescriptorCodec::Method m) {
+    const uint32_t v = m;
+    out.resize(sizeof(v));
+    memcpy(out.data(), &v, sizeof(v));
+}
+
+// Worst row's L2 distance between [a] and [b], both CV_32F of one shape.
+float maxRowError(const cv::Mat& a, const cv::Mat& b) {
+    float worst = 0.f;
+    for (int r = 0; r < a.rows; ++r) worst = std::max(worst, (float)cv::norm(a.row(r), b.row(r), cv::NORM_L2));
+    return worst;
+}
+
+std::vector<uint8_t> encodeFloat16(const cv::Mat& d) {
+    cv::Mat half;
+    d.convertTo(half, CV_16F);
+    std::vector<uint8_t> out;
+    putMethod(out, DescriptorCodec::kFloat16);
+    const size_t bytes = half.total() * half.elemSize();
+    out.resize(out.size() + bytes);
+    memcpy(out.data() + sizeof(uint32_t), half.data, bytes);
+    return out;
+}
+
+std::vector<uint8_t> encodeInt8Block(const cv::Mat& d) {
+    const int blocks = blocksPerRow(d.cols);
+    std::vector<float> scales((size_t)d.rows * blocks);
+    std::vector<int8_t> q((size_t)d.rows * d.cols);
+    for (int r = 0; r < d.rows; ++r) {
+        const float* row = d.ptr<float>(r);
+        for (int b = 0; b < blocks; ++b) {
+            const int c0 = b * DescriptorCodec::kBlock, c1 = std::min(d.cols, c0 + DescriptorCodec::kBlock);
+            float peak = 0.f;
+            for (int c = c0; c < c1; ++c) peak = std::max(peak, std::abs(row[c]));
+            const float scale = peak > 0.f ? peak / 127.f : 0.f;
+            scales[(size_t)r * blocks + b] = scale;
+            for (int c = c0; c < c1; ++c) {
+                const float v = scale > 0.f ? std::round(row[c] / scale) : 0.f;
+                q[(size_t)r * d.cols + c] = (int8_t)std::max(-127.f, std::min(127.f, v));
+            }
+        }
+    }
+    std::vector<uint8_t> out;
+    putMethod(out, DescriptorCodec::kInt8Block);
+    const size_t at = out.size();
+    out.resize(at + scales.size() * sizeof(float) + q.size());
+    memcpy(out.data() + at, scales.data(), scales.size() * sizeof(float));
+    memcpy(out.data() + at + scales.size() * sizeof(float), q.data(), q.size());
+    return out;
+}
+
+std::vector<uint8_t> encodeBitRange(const cv::Mat& d) {
+    std::vector<uint8_t> out;
+    putMethod(out, DescriptorCodec::kBitRange);
+    std::vector<uint16_t> probs((size_t)d.cols * 8, kProbInit);
+    RangeEncoder enc(out);
+    for (int r = 0; r < d.rows; ++r) {
+        const uint8_t* row = d.ptr<uint8_t>(r);
+        for (int c = 0; c < d.cols; ++c)
+            for (int k = 7; k >= 0; --k) enc.encode(probs[(size_t)c * 8 + (7 - k)], (row[c] >> k) & 1);
+    }
+    enc.flush();
+    return out;
+}
+
+}  // namespace
+
+std::vector<uint8_t> DescriptorCodec::encode(const cv::Mat& descs, int level, float* maxRowErr) {
+    if (maxRowErr) *maxRowErr = 0.f;
+    if (descs.empty() || (level != 1 && level != 2)) return {};
+    const cv::Mat d = descs.isContinuous() ? descs : descs.clone();
+    const size_t rawBytes = d.total() * d.elemSize();
+    std::vector<uint8_t> out;
+
+    if (d.type() == CV_32F) {
+        if (level == 2) {
+            out = encodeInt8Block(d);
+            cv::Mat back;
+            const float err = decode(out.data(), out.size(), d.rows, d.cols, CV_32F, back)
+                            ? maxRowError(d, back) : INFINITY;
+            if (err <= kMaxRowError && out.size() < rawBytes) {
+                if (maxRowErr) *maxRowErr = err;
+                return out;
+            }
+            // Outside the bound (an unnormalised row, or one dominated by a single large element):
+            // the half-float form instead, never a worse int8 one.
+        }
+        out = encodeFloat16(d);
+        if (maxRowErr) {
+            cv::Mat back;
+            if (decode(out.data(), out.size(), d.rows, d.cols, CV_32F, back)) *maxRowErr = maxRowError(d, back);
+        }
+    } else if (d.type() == CV_8U) {
+        out = encodeBitRange(d);
+    } else {
+        return {};
+    }
+    if (out.size() >= rawBytes) return {};
+    return out;
+}
+
+bool DescriptorCodec::decode(const uint8_t* data, size_t size, int rows, int cols, int type, cv::Mat& out) {
+    if (!data || size < sizeof(uint32_t) || rows <= 0 || cols <= 0) return false;
+    uint32_t method = 0;
+    memcpy(&method, data, sizeof(method));
+    const uint8_t* p = data + sizeof(method);
+    const uint64_t payload = size - sizeof(method);
+    const uint64_t cells = (uint64_t)rows * (uint64_t)cols;
+
+    switch (method) {
+    case kFloat16: {
+        if (type != CV_32F || payload != cells * 2) return false;
+        cv::Mat half(rows, cols, CV_16F);
+        memcpy(half.data, p, (size_t)payload);
+        half.convertTo(out, CV_32F);
+        return true;
+    }
+    case kInt8Block: {
+        const uint64_t blocks = (uint64_t)blocksPerRow(cols);
+        const uint64_t scaleBytes = (uint64_t)rows * blocks * sizeof(float);
+        if (type != CV_32F || payload != scaleBytes + cells) return false;
+        const uint8_t* q = p + scaleBytes;
+        cv::Mat m(rows, cols, CV_32F);
+        for (int r = 0; r < rows; ++r) {
+            float* row = m.ptr<float>(r);
+            for (int c = 0; c < cols; ++c) {
+                float scale;
+                memcpy(&scale, p + ((size_t)r * blocks + (size_t)(c / kBlock)) * sizeof(float), sizeof(float));
+                row[c] = scale * (float)(int8_t)q[(size_t)r * cols + c];
+            }
+        }
+        out = m;
+        return true;
+    }
+    case kBitRange: {
+        if (type != CV_8U || payload < 5 || cells > payload * kMaxExpansion) return false;
+        cv::Mat m(rows, cols, CV_8U);
+        std::vector<uint16_t> probs((size_t)cols * 8, kProbInit);
+        RangeDecoder dec(p, p + payload);
+        for (int r = 0; r < rows; ++r) {
+            uint8_t* row = m.ptr<uint8_t>(r);
+            for (int c = 0; c < cols; ++c) {
+                int v = 0;
+                for (int k = 0; k < 8; ++k) v = (v << 1) | dec.decode(probs[(size_t)c * 8 + k]);
+                row[c] = (uint8_t)v;
+            }
+        }
+        out = m;
+        return true;
+    }
+    default:
+        return false;
+    }
+}
@@ -4,39 +4,67 @@
 #define LOGD(...) __android_log_print(ANDROID_LOG_DEBUG, "DistortionHead", __VA_ARGS__)
 #define LOGE(...) __android_log_print(ANDROID_LOG_ERROR, "DistortionHead", __VA_ARGS__)
 
-bool DistortionHead::load(const std::vector<uchar>& onnxBytes) {
+bool DistortionHead::load(const std::vector<uchar>& onnxBytes, const InferenceBackend::Options& opts) {
     std::lock_guard<std::mutex> lock(mMutex);
     mLoaded = false;
-    try {
-        mNet = cv::dnn::readNetFromONNX(onnxBytes);
-        mNet.setPreferableBackend(cv::dnn::DNN_BACKEND_DEFAULT);
-        if (cv::ocl::haveOpenCL()) mNet.setPreferableTarget(cv::dnn::DNN_TARGET_OPENCL);
-        else                       mNet.setPreferableTarget(cv::dnn::DNN_TARGET_CPU);
-        mLoaded = !mNet.empty();
-        if (mLoaded) LOGD("DistortionHead: loaded");
-        return mLoaded;
-    } catch (...) {
+    auto backend = InferenceBackend::create(opts.kind);
+    if (!backend->load(onnxBytes, opts) || backend->empty()) {
         LOGE("DistortionHead: failed to load ONNX");
         return false;
     }
+    LOGD("DistortionHead: loaded on %s", backend->name());
+    mBackend = std::move(backend);
+    mLoaded = true;
+    return true;
+}
+
+bool DistortionHead::warmUp() {
+    if (!mLoaded) return false;
+    std::lock_guard<std::mutex> lock(mMutex);
+    if (!mBackend) return false;
+    cv::Mat zero = cv::Mat::zeros(kPatch, kPatch, CV_32F);
+    cv::Mat blob = inference::wrapGrayAsBlob(zero);
+    mBackend->setInput(blob, "image_cur");
+    mBackend->setInput(blob, "image_fp");
+    std::vector<cv::Mat> outs;
+    const bool ok = mBackend->forward(outs, {"distortion"});
+    LOGD("DistortionHead: warm-up %s in %.1f ms", ok ? "done" : "FAILED", mBackend->lastForwardMs());
+    return ok;
+}
+
+void DistortionHead::setFingerprint(const cv::Mat& grayFp) {
+    if (grayFp.empty()) return;
+    std::lock_guard<std::mutex> lock(mMutex);
+    if (grayFp.cols == kPatch && grayFp.rows == kPatch) {
+        grayFp.convertTo(mFp, CV_32F, 1.0 / 255.0);
+    } else {
+        cv::Mat resized;
+        cv::resize(grayFp, resized, cv::Size(kPatch, kPatch));
+        resized.convertTo(mFp, CV_32F, 1.0 / 255.0);
+    }
+    mHasFp = true;
 }
 
-bool DistortionHead::run(const cv::Mat& grayCur, const cv::Mat& grayFp, std::array<float, 13>& out) {
-    if (!mLoaded || grayCur.empty() || grayFp.empty()) return false;
+void DistortionHead::clearFingerprint() {
+    std::lock_guard<std::mutex> lock(mMutex);
+    mHasFp = false;
+    mFp.release();
+}
 
-    cv::Mat cur, fp;
-    cv::resize(grayCur, cur, cv::Size(kPatch, kPatch));
-    cv::resize(grayFp, fp, cv::Size(kPatch, kPatch));
-    cur.convertTo(cur, CV_32F, 1.0 / 255.0);
-    fp.convertTo(fp, CV_32F, 1.0 / 255.0);
-    cv::Mat blobCur = cv::dnn::blobFromImage(cur); // [1,1,256,256]
-    cv::Mat blobFp  = cv::dnn::blobFromImage(fp);
+bool DistortionHead::run(const cv::Mat& grayCur, std::array<float, 13>& out) {
+    if (!mLoaded || !mHasFp || grayCur.empty()) return false;
 
     try {
         std::lock_guard<std::mutex> lock(mMutex);
-        mNet.setInput(blobCur, "image_cur");
-        mNet.setInput(blobFp, "image_fp");
-        cv::Mat o = mNet.forward("distortion");
+        if (!mBackend || mFp.empty()) return false;
+        cv::resize(grayCur, mCur, cv::Size(kPatch, kPatch));
+        mCur.convertTo(mCurF, CV_32F, 1.0 / 255.0);
+        // Both blobs view member buffers ([1,1,256,256] over mCurF / mFp) that outlive the forward.
+        mBackend->setInput(inference::wrapGrayAsBlob(mCurF), "image_cur");
+        mBackend->setInput(inference::wrapGrayAsBlob(mFp), "image_fp");
+        std::vector<cv::Mat> outs;
+        if (!mBackend->forward(outs, {"distortion"})) return false;
+        const cv::Mat& o = outs[0];
         if (o.empty() || !o.isContinuous() || (int)o.total() < 13) {
             LOGE("DistortionHead: bad output size or continuity. total=%d", (int)o.total());
             return false;
@@ -0,0 +1,176 @@
+#include "include/FingerprintDelta.h"
+#include <algorithm>
+#include <cstring>
+#include <numeric>
+
+// Fields are written and read with memcpy: every Android ABI is little-endian, which is what the
+// format specifies, and cv::Point3f is three packed floats.
+static_assert(sizeof(cv::Point3f) == 3 * sizeof(float), "points are written as N x 3 floats");
+
+namespace {
+
+constexpr size_t kHeaderBytes = 4 + 3 * 4 + 3 * 8 + 4 * 4 + 2 * 4;
+constexpr size_t kMovedBytes = sizeof(uint32_t) + sizeof(cv::Point3f);
+
+struct Reader {
+    const uint8_t* p;
+    const uint8_t* end;
+    bool take(void* dst, size_t n) {
+        if ((size_t)(end - p) < n) return false;
+        memcpy(dst, p, n);
+        p += n;
+        return true;
+    }
+};
+
+}  // namespace
+
+std::vector<uint8_t> FingerprintDelta::encode() const {
+    const uint32_t nAppended = (uint32_t)appendedPts.size();
+    const bool withDescs = nAppended > 0 && appendedDescs.rows == (int)nAppended && appendedDescs.isContinuous();
+    if (nAppended > 0 && !withDescs) return {};   // never ship points without their descriptors
+    const bool withRegions = (flags & kRegions) && appendedRegions.size() == nAppended;
+
+    const int32_t descType = withDescs ? appendedDescs.type() : -1;
+    const uint32_t descCols = withDescs ? (uint32_t)appendedDescs.cols : 0;
+    const size_t descBytes = withDescs ? appendedDescs.total() * appendedDescs.elemSize() : 0;
+    const uint32_t outFlags = (flags & kFull) | (withRegions ? kRegions : 0u);
+    const uint32_t nRemoved = (uint32_t)removed.size();
+    const uint32_t nMoved = (uint32_t)std::min(movedRows.size(), movedPts.size());
+
+    std::vector<uint8_t> out(kHeaderBytes + nRemoved * sizeof(uint32_t) + nMoved * kMovedBytes +
+                             nAppended * sizeof(cv::Point3f) + descBytes + (withRegions ? nAppended : 0));
+    uint8_t* p = out.data();
+    auto put = [&](const void* src, size_t len) { if (len) memcpy(p, src, len); p += len; };
+    const uint32_t version = kVersion, reserved = 0;
+    put("GXFD", 4);
+    put(&version, 4); put(&outFlags, 4); put(&reserved, 4);
+    put(&epoch, 8); put(&baseGen, 8); put(&newGen, 8);
+    put(&baseRows, 4); put(&nRemoved, 4); put(&nMoved, 4); put(&nAppended, 4);
+    put(&descType, 4); put(&descCols, 4);
+    put(removed.data(), nRemoved * sizeof(uint32_t));
+    for (uint32_t i = 0; i < nMoved; ++i) {
+        put(&movedRows[i], sizeof(uint32_t));
+        put(&movedPts[i], sizeof(cv::Point3f));
+    }
+    put(appendedPts.data(), nAppended * sizeof(cv::Point3f));
+    put(withDescs ? appendedDescs.data : nullptr, descBytes);
+    if (withRegions) put(appendedRegions.data(), nAppended);
+    return out;
+}
+
+bool FingerprintDelta::decode(const uint8_t* data, size_t size, FingerprintDelta& out) {
+    if (!data || size < kHeaderBytes || memcmp(data, "GXFD", 4) != 0) return false;
+    Reader r{data + 4, data + size};
+    uint32_t version = 0, reserved = 0, nRemoved = 0, nMoved = 0, nAppended = 0, descCols = 0;
+    int32_t descType = -1;
+    out = FingerprintDelta();
+    r.take(&version, 4); r.take(&out.flags, 4); r.take(&reserved, 4);
+    r.take(&out.epoch, 8); r.take(&out.baseGen, 8); r.take(&out.newGen, 8);
+    r.take(&out.baseRows, 4); r.take(&nRemoved, 4); r.take(&nMoved, 4); r.take(&nAppended, 4);
+    r.take(&descType, 4); r.take(&descCols, 4);
+    if (version != kVersion) return false;
+    if (out.baseRows > kMaxRows || nRemoved > kMaxRows || nMoved > kMaxRows || nAppended > kMaxRows) return false;
+    if (out.full() && (out.baseRows != 0 || nRemoved != 0 || nMoved != 0)) return false;
+
+    // Every section's size is known from the header, so the whole record is checked against the
+    // buffer once, in 64-bit, before anything is allocated from peer-supplied counts.
+    uint64_t descBytes = 0;
+    if (nAppended > 0) {
+        const int depth = CV_MAT_DEPTH(descType), channels = CV_MAT_CN(descType);
+        if (depth < 0 || depth > CV_64F || channels < 1 || channels > 4) return false;
+        if (descCols == 0 || descCols > 4096) return false;
+        descBytes = (uint64_t)nAppended * descCols * CV_ELEM_SIZE(descType);
+    }
+    const bool withRegions = (out.flags & kRegions) != 0;
+    const uint64_t need = (uint64_t)nRemoved * sizeof(uint32_t) + (uint64_t)nMoved * kMovedBytes +
+                          (uint64_t)nAppended * sizeof(cv::Point3f) + descBytes +
+                          (withRegions ? nAppended : 0);
+    if ((uint64_t)(r.end - r.p) != need) return false;
+
+    out.removed.resize(nRemoved);
+    r.take(out.removed.data(), nRemoved * sizeof(uint32_t));
+    out.movedRows.resize(nMoved);
+    out.movedPts.resize(nMoved);
+    for (uint32_t i = 0; i < nMoved; ++i) {
+        r.take(&out.movedRows[i], sizeof(uint32_t));
+        r.take(&out.movedPts[i], sizeof(cv::Point3f));
+    }
+    out.appendedPts.resize(nAppended);
+    r.take(out.appendedPts.data(), nAppended * sizeof(cv::Point3f));
+    if (nAppended > 0) {
+        out.appendedDescs.create((int)nAppended, (int)descCols, descType);
+        r.take(out.appendedDescs.data, (size_t)descBytes);
+    }
+    if (withRegions) {
+        out.appendedRegions.resize(nAppended);
+        r.take(out.appendedRegions.data(), nAppended);
+    }
+    return true;
+}
+
+FingerprintDelta FingerprintDelta::since(uint64_t epoch, uint64_t newGen, bool full, uint64_t sinceGen,
+                                         const std::vector<cv::Point3f>& pts, const cv::Mat& descs,
+                                         const std::vector<uint8_t>& regions, const std::vector<uint64_t>& addGen,
+                                         const std::vector<uint64_t>& moveGen) {
+    FingerprintDelta d;
+    const size_t n = pts.size();
+    d.epoch = epoch;
+    d.newGen = newGen;
+    size_t first = 0;
+    if (full) {
+        d.flags |= kFull;
+    } else {
+        first = (size_t)(std::upper_bound(addGen.begin(), addGen.end(), sinceGen) - addGen.begin());
+        d.baseGen = sinceGen;
+        d.baseRows = (uint32_t)first;
+        for (size_t i = 0; i < first && i < moveGen.size(); ++i) {
+            if (moveGen[i] <= sinceGen) continue;
+            d.movedRows.push_back((uint32_t)i);
+            d.movedPts.push_back(pts[i]);
+        }
+    }
+    d.appendedPts.assign(pts.begin() + (ptrdiff_t)first, pts.end());
+    if (first < n) d.appendedDescs = descs.rowRange((int)first, (int)n);
+    if (regions.size() == n) {
+        d.flags |= kRegions;
+        d.appendedRegions.assign(regions.begin() + (ptrdiff_t)first, regions.end());
+    }
+    return d;
+}
+
+void FingerprintDelta::Peer::installed(size_t rows, uint64_t localWallEpoch) {
+    rowMap.resize(rows);
+    std::iota(rowMap.begin(), rowMap.end(), 0u);
+    localEpoch = localWallEpoch;
+    forget();
+}
+
+const char* FingerprintDelta::Peer::check(const FingerprintDelta& d, uint64_t localWallEpoch, size_t localRows,
+                                          int descType, int descCols, std::vector<uint32_t>& movedLocal) const {
+    movedLocal.clear();
+    if (d.full()) return d.appendedPts.empty() ? "empty" : nullptr;
+    if (d.epoch != epoch || d.baseGen != gen || localEpoch != localWallEpoch) return "base mismatch";
+    if (d.baseRows != rowMap.size()) return "row count mismatch";
+    // The sender's wall only grows between replacements, so it never sends removals today.
+    // Swap-removing here would renumber rows the refiner and the BoW index are keyed by, which
+    // this wall has never had to survive; a full transfer is the safe answer if one arrives.
+    if (!d.removed.empty()) return "removals";
+    const size_t nAppended = d.appendedPts.size();
+    if (nAppended > 0 && (d.appendedDescs.type() != descType || d.appendedDescs.cols != descCols))
+        return "descriptor shape";
+    if (localRows + nAppended > kMaxRows) return "too large";
+    movedLocal.reserve(d.movedRows.size());
+    for (uint32_t row : d.movedRows) {
+        if (row >= rowMap.size() || rowMap[row] >= localRows) return "moved row out of range";
+        movedLocal.push_back(rowMap[row]);
+    }
+    return nullptr;
+}
+
+void FingerprintDelta::Peer::applied(const FingerprintDelta& d, size_t firstLocal) {
+    if (!d.full())
+        for (size_t i = 0; i < d.appendedPts.size(); ++i) rowMap.push_back((uint32_t)(firstLocal + i));
+    epoch = d.epoch;
+    gen = d.newGen;
+}
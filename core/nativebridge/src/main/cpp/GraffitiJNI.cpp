@@ -673,6 +673,30 @@ Java_com_hereliesaz_graffitixr_nativebridge_SlamManager_nativeLoadDistortionHead
     return ok ? JNI_TRUE : JNI_FALSE;
 }
 
+// Both vocabularies are optional and independent: each present asset fills its descriptor type's
+// slot, and an absent one leaves that type on brute-force matching. True if either loaded.
+JNIEXPORT jboolean JNICALL
+Java_com_hereliesaz_graffitixr_nativebridge_SlamManager_nativeLoadVocabulary(
+        JNIEnv* env, jobject thiz, jobject assetManager) {
+    std::lock_guard<std::mutex> engineLock(gEngineMutex);
+    if (!gSlamEngine) return JNI_FALSE;
+    AAssetManager* mgr = AAssetManager_fromJava(env, assetManager);
+    bool any = false;
+    for (const char* name : {"bow_superpoint.voc", "bow_orb.voc"}) {
+        AAsset* asset = AAssetManager_open(mgr, name, AASSET_MODE_BUFFER);
+        if (!asset) {
+            __android_log_print(ANDROID_LOG_WARN, "GraffitiJNI", "%s not in assets — BoW reloc off for it", name);
+            continue;
+        }
+        size_t size = (size_t)AAsset_getLength(asset);
+        std::vector<uchar> buf(size);
+        AAsset_read(asset, buf.data(), (off_t)size);
+        AAsset_close(asset);
+        if (gSlamEngine->loadVocabulary(buf)) any = true;
+    }
+    return any ? JNI_TRUE : JNI_FALSE;
+}
+
 JNIEXPORT void JNICALL
 Java_com_hereliesaz_graffitixr_nativebridge_SlamManager_nativeLoadLowLightEnhancer(
         JNIEnv* env, jobject thiz, jobject assetManager) {
@@ -874,6 +898,64 @@ Java_com_hereliesaz_graffitixr_nativebridge_SlamManager_nativeGetMapPointCount(J
     return gSlamEngine ? gSlamEngine->getMapPointCount() : 0;
 }
 
+static std::string stdStringFrom(JNIEnv* env, jstring js) {
+    if (!js) return std::string();
+    const char* p = env->GetStringUTFChars(js, nullptr);
+    if (!p) return std::string();
+    std::string out(p);
+    env->ReleaseStringUTFChars(js, p);
+    return out;
+}
+
+JNIEXPORT jboolean JNICALL
+Java_com_hereliesaz_graffitixr_nativebridge_SlamManager_nativeActivateWall(JNIEnv* env, jobject, jstring projectId) {
+    std::lock_guard<std::mutex> engineLock(gEngineMutex);
+    if (!gSlamEngine) return JNI_FALSE;
+    return gSlamEngine->activateWall(stdStringFrom(env, projectId)) ? JNI_TRUE : JNI_FALSE;
+}
+
+JNIEXPORT void JNICALL
+Java_com_hereliesaz_graffitixr_nativebridge_SlamManager_nativeSetActiveWallId(JNIEnv* env, jobject, jstring projectId) {
+    std::lock_guard<std::mutex> engineLock(gEngineMutex);
+    if (gSlamEngine) gSlamEngine->setActiveWallId(stdStringFrom(env, projectId));
+}
+
+JNIEXPORT jstring JNICALL
+Java_com_hereliesaz_graffitixr_nativebridge_SlamManager_nativeGetActiveWallId(JNIEnv* env, jobject) {
+    std::lock_guard<std::mutex> engineLock(gEngineMutex);
+    return env->NewStringUTF(gSlamEngine ? gSlamEngine->getActiveWallId().c_str() : "");
+}
+
+JNIEXPORT void JNICALL
+Java_com_hereliesaz_graffitixr_nativebridge_SlamManager_nativeForgetWall(JNIEnv* env, jobject, jstring projectId) {
+    std::lock_guard<std::mutex> engineLock(gEngineMutex);
+    if (gSlamEngine) gSlamEngine->forgetWall(stdStringFrom(env, projectId));
+}
+
+JNIEXPORT void JNICALL
+Java_com_hereliesaz_graffitixr_nativebridge_SlamManager_nativeSetWallRegistryBudget(JNIEnv*, jobject, jlong bytes) {
+    std::lock_guard<std::mutex> engineLock(gEngineMutex);
+    if (gSlamEngine) gSlamEngine->setWallRegistryBudget(bytes > 0 ? (size_t)bytes : 0);
+}
+
+JNIEXPORT jlong JNICALL
+Java_com_hereliesaz_graffitixr_nativebridge_SlamManager_nativeGetWallRegistryBytes(JNIEnv*, jobject) {
+    std::lock_guard<std::mutex> engineLock(gEngineMutex);
+    return gSlamEngine ? (jlong)gSlamEngine->getWallRegistryBytes() : 0;
+}
+
+JNIEXPORT void JNICALL
+Java_com_hereliesaz_graffitixr_nativebridge_SlamManager_nativeSetWallPreselectEnabled(JNIEnv*, jobject, jboolean enabled) {
+    std::lock_guard<std::mutex> engineLock(gEngineMutex);
+    if (gSlamEngine) gSlamEngine->setWallPreselectEnabled(enabled == JNI_TRUE);
+}
+
+JNIEXPORT jstring JNICALL
+Java_com_hereliesaz_graffitixr_nativebridge_SlamManager_nativeTakeProposedWall(JNIEnv* env, jobject) {
+    std::lock_guard<std::mutex> engineLock(gEngineMutex);
+    return env->NewStringUTF(gSlamEngine ? gSlamEngine->takeProposedWall().c_str() : "");
+}
+
 JNIEXPORT void JNICALL
 Java_com_hereliesaz_graffitixr_nativebridge_SlamManager_nativeSetMapRelocEnabled(JNIEnv*, jobject, jboolean enabled) {
     std::lock_guard<std::mutex> engineLock(gEngineMutex);
@@ -886,6 +968,60 @@ Java_com_hereliesaz_graffitixr_nativebridge_SlamManager_nativeSetMapBuildEnabled
     if (gSlamEngine) gSlamEngine->setMapBuildEnabled(enabled == JNI_TRUE);
 }
 
+JNIEXPORT void JNICALL
+Java_com_hereliesaz_graffitixr_nativebridge_SlamManager_nativeSetMapWorkerEnabled(JNIEnv*, jobject, jboolean enabled) {
+    std::lock_guard<std::mutex> engineLock(gEngineMutex);
+    if (gSlamEngine) gSlamEngine->setMapWorkerEnabled(enabled == JNI_TRUE);
+}
+
+JNIEXPORT void JNICALL
+Java_com_hereliesaz_graffitixr_nativebridge_SlamManager_nativeSetMapGlobalAssocEnabled(JNIEnv*, jobject, jboolean enabled) {
+    std::lock_guard<std::mutex> engineLock(gEngineMutex);
+    if (gSlamEngine) gSlamEngine->setMapGlobalAssocEnabled(enabled == JNI_TRUE);
+}
+
+JNIEXPORT void JNICALL
+Java_com_hereliesaz_graffitixr_nativebridge_SlamManager_nativeSetMapKeyframesEnabled(JNIEnv*, jobject, jboolean enabled) {
+    std::lock_guard<std::mutex> engineLock(gEngineMutex);
+    if (gSlamEngine) gSlamEngine->setMapKeyframesEnabled(enabled == JNI_TRUE);
+}
+
+JNIEXPORT void JNICALL
+Java_com_hereliesaz_graffitixr_nativebridge_SlamManager_nativeSetBowRelocEnabled(JNIEnv*, jobject, jboolean enabled) {
+    std::lock_guard<std::mutex> engineLock(gEngineMutex);
+    if (gSlamEngine) gSlamEngine->setBowRelocEnabled(enabled == JNI_TRUE);
+}
+
+JNIEXPORT void JNICALL
+Java_com_hereliesaz_graffitixr_nativebridge_SlamManager_nativeSetPointRefinementEnabled(JNIEnv*, jobject, jboolean enabled) {
+    std::lock_guard<std::mutex> engineLock(gEngineMutex);
+    if (gSlamEngine) gSlamEngine->setPointRefinementEnabled(enabled == JNI_TRUE);
+}
+
+JNIEXPORT void JNICALL
+Java_com_hereliesaz_graffitixr_nativebridge_SlamManager_nativeSetCompactMatchEnabled(JNIEnv*, jobject, jboolean enabled) {
+    std::lock_guard<std::mutex> engineLock(gEngineMutex);
+    if (gSlamEngine) gSlamEngine->setCompactMatchEnabled(enabled == JNI_TRUE);
+}
+
+JNIEXPORT void JNICALL
+Java_com_hereliesaz_graffitixr_nativebridge_SlamManager_nativeSetLowLightTiersEnabled(JNIEnv*, jobject, jboolean enabled) {
+    std::lock_guard<std::mutex> engineLock(gEngineMutex);
+    if (gSlamEngine) gSlamEngine->setLowLightTiersEnabled(enabled == JNI_TRUE);
+}
+
+JNIEXPORT void JNICALL
+Java_com_hereliesaz_graffitixr_nativebridge_SlamManager_nativeSetDistortionHeadRate(JNIEnv*, jobject, jfloat hz) {
+    std::lock_guard<std::mutex> engineLock(gEngineMutex);
+    if (gSlamEngine) gSlamEngine->setDistortionHeadRate(hz);
+}
+
+JNIEXPORT void JNICALL
+Java_com_hereliesaz_graffitixr_nativebridge_SlamManager_nativeSetHeadPriorEnabled(JNIEnv*, jobject, jboolean enabled) {
+    std::lock_guard<std::mutex> engineLock(gEngineMutex);
+    if (gSlamEngine) gSlamEngine->setHeadPriorEnabled(enabled == JNI_TRUE);
+}
+
 JNIEXPORT jbyteArray JNICALL
 Java_com_hereliesaz_graffitixr_nativebridge_SlamManager_nativeExportWallFeatureMap(JNIEnv* env, jobject) {
     std::lock_guard<std::mutex> engineLock(gEngineMutex);
@@ -898,6 +1034,56 @@ Java_com_hereliesaz_graffitixr_nativebridge_SlamManager_nativeExportWallFeatureM
     return arr;
 }
 
+JNIEXPORT jboolean JNICALL
+Java_com_hereliesaz_graffitixr_nativebridge_SlamManager_nativeSaveWallSidecar(JNIEnv* env, jobject, jstring path) {
+    std::lock_guard<std::mutex> engineLock(gEngineMutex);
+    if (!gSlamEngine || !path) return JNI_FALSE;
+    try {
+        return gSlamEngine->saveWallSidecar(stdStringFrom(env, path)) ? JNI_TRUE : JNI_FALSE;
+    } catch (const std::exception& e) {
+        LOGE("nativeSaveWallSidecar: exception: %s", e.what());
+    }
+    return JNI_FALSE;
+}
+
+JNIEXPORT jboolean JNICALL
+Java_com_hereliesaz_graffitixr_nativebridge_SlamManager_nativeLoadWallSidecar(
+        JNIEnv* env, jobject, jstring path, jboolean restoreFingerprint) {
+    std::lock_guard<std::mutex> engineLock(gEngineMutex);
+    if (!gSlamEngine || !path) return JNI_FALSE;
+    try {
+        return gSlamEngine->loadWallSidecar(stdStringFrom(env, path), restoreFingerprint == JNI_TRUE)
+            ? JNI_TRUE : JNI_FALSE;
+    } catch (const std::exception& e) {
+        LOGE("nativeLoadWallSidecar: exception: %s", e.what());
+    }
+    return JNI_FALSE;
+}
+
+JNIEXPORT void JNICALL
+Java_com_hereliesaz_graffitixr_nativebridge_SlamManager_nativeSetMutationJournalEnabled(JNIEnv*, jobject, jboolean enabled) {
+    std::lock_guard<std::mutex> engineLock(gEngineMutex);
+    if (gSlamEngine) gSlamEngine->setMutationJournalEnabled(enabled == JNI_TRUE);
+}
+
+JNIEXPORT jlong JNICALL
+Java_com_hereliesaz_graffitixr_nativebridge_SlamManager_nativeAppendWallJournal(JNIEnv* env, jobject, jstring path) {
+    std::lock_guard<std::mutex> engineLock(gEngineMutex);
+    if (!gSlamEngine || !path) return -1;
+    try {
+        return (jlong)gSlamEngine->appendWallJournal(stdStringFrom(env, path));
+    } catch (const std::exception& e) {
+        LOGE("nativeAppendWallJournal: exception: %s", e.what());
+    }
+    return -1;
+}
+
+JNIEXPORT void JNICALL
+Java_com_hereliesaz_graffitixr_nativebridge_SlamManager_nativeSetDescriptorCompression(JNIEnv*, jobject, jint level) {
+    std::lock_guard<std::mutex> engineLock(gEngineMutex);
+    if (gSlamEngine) gSlamEngine->setDescriptorCompression((int)level);
+}
+
 jobject buildFingerprintObject(JNIEnv* env, const MobileGS::FingerprintData& fd) {
     if (fd.descriptors.empty()) return nullptr;
 
@@ -1101,7 +1287,10 @@ Java_com_hereliesaz_graffitixr_nativebridge_SlamManager_nativeDetectSuperPoint(
     if (image.empty()) return nullptr;
     std::vector<cv::KeyPoint> kps; cv::Mat descs;
     {
-        std::lock_guard<std::mutex> lock(gSlamEngine->getMutex());
+        // No engine-state lock: getSuperPointFeatures reads only the models (each self-locking, and
+        // SuperPoint now pooled) and the atomic light level. Holding getMutex() here used to block
+        // the reloc worker's snapshot and publish for the whole forward pass. gEngineMutex above
+        // is what keeps the engine alive for the call.
         bool ok = false;
         try {
             ok = gSlamEngine->getSuperPointFeatures(image, kps, descs);
@@ -1139,7 +1328,8 @@ Java_com_hereliesaz_graffitixr_nativebridge_SlamManager_nativeGetFingerprintKeyp
     if (mask) bitmapToMat(env, mask, maskMat);
     std::vector<cv::Point2f> pts;
     {
-        std::lock_guard<std::mutex> lock(gSlamEngine->getMutex());
+        // No engine-state lock, for the same reason as nativeDetectSuperPoint: nothing here reads
+        // state mMutex guards, and taking it stalled relocalization behind the curation preview.
         try {
             gSlamEngine->getFingerprintKeypoints(image, maskMat, pts);
         } catch (const std::exception& e) {
@@ -1355,6 +1545,19 @@ Java_com_hereliesaz_graffitixr_nativebridge_SlamManager_nativeGetRelocResult(JNI
     env->SetFloatArrayRegion(out, 0, 19, buf);
 }
 
+extern "C" JNIEXPORT void JNICALL
+Java_com_hereliesaz_graffitixr_nativebridge_SlamManager_nativeGetDistortionHeadResult(JNIEnv* env, jobject, jfloatArray out) {
+    std::lock_guard<std::mutex> engineLock(gEngineMutex);
+    if (!gSlamEngine) return;
+    if (!out || env->GetArrayLength(out) < 15) {
+        LOGE("nativeGetDistortionHeadResult: out array too short (need 15)");
+        return;
+    }
+    float buf[15];
+    gSlamEngine->getDistortionHeadResult(buf);
+    env->SetFloatArrayRegion(out, 0, 15, buf);
+}
+
 extern "C" JNIEXPORT void JNICALL
 Java_com_hereliesaz_graffitixr_nativebridge_SlamManager_nativeGetFingerprintAnchor(JNIEnv* env, jobject, jfloatArray out) {
     std::lock_guard<std::mutex> engineLock(gEngineMutex);
@@ -1371,36 +1574,50 @@ Java_com_hereliesaz_graffitixr_nativebridge_SlamManager_nativeGetFingerprintAnch
 }
 
 JNIEXPORT jbyteArray JNICALL
-Java_com_hereliesaz_graffitixr_nativebridge_SlamManager_nativeExportFingerprint(
-        JNIEnv* env, jobject thiz) {
+Java_com_hereliesaz_graffitixr_nativebridge_SlamManager_nativeExportFingerprintDelta(
+        JNIEnv* env, jobject thiz, jlong epoch, jlong sinceGen) {
     std::lock_guard<std::mutex> engineLock(gEngineMutex);
     if (!gSlamEngine) return nullptr;
-    std::vector<uint8_t> fingerprint = gSlamEngine->exportFingerprint();
-    if (fingerprint.empty()) return nullptr;
+    std::vector<uint8_t> delta = gSlamEngine->exportFingerprintDelta((uint64_t)epoch, (uint64_t)sinceGen);
+    if (delta.empty()) return nullptr;
 
-    jbyteArray result = env->NewByteArray((jsize)fingerprint.size());
+    jbyteArray result = env->NewByteArray((jsize)delta.size());
     if (!result) return nullptr;
-    env->SetByteArrayRegion(result, 0, (jsize)fingerprint.size(), (jbyte*)fingerprint.data());
+    env->SetByteArrayRegion(result, 0, (jsize)delta.size(), (jbyte*)delta.data());
     return result;
 }
 
-JNIEXPORT void JNICALL
-Java_com_hereliesaz_graffitixr_nativebridge_SlamManager_nativeAlignToFingerprint(
+JNIEXPORT jboolean JNICALL
+Java_com_hereliesaz_graffitixr_nativebridge_SlamManager_nativeApplyFingerprintDelta(
         JNIEnv* env, jobject thiz, jbyteArray data) {
     std::lock_guard<std::mutex> engineLock(gEngineMutex);
-    if (!gSlamEngine || !data) return;
+    if (!gSlamEngine || !data) return JNI_FALSE;
     jsize size = env->GetArrayLength(data);
     jbyte* buffer = env->GetByteArrayElements(data, nullptr);
+    if (!buffer) return JNI_FALSE;
 
+    bool ok = false;
     try {
-        gSlamEngine->alignToFingerprint((uint8_t*)buffer, size);
+        ok = gSlamEngine->applyFingerprintDelta((uint8_t*)buffer, (size_t)size);
     } catch (const std::exception& e) {
-        LOGE("nativeAlignToFingerprint: exception: %s", e.what());
+        LOGE("nativeApplyFingerprintDelta: exception: %s", e.what());
     } catch (...) {
-        LOGE("nativeAlignToFingerprint: unknown exception");
+        LOGE("nativeApplyFingerprintDelta: unknown exception");
     }
 
     env->ReleaseByteArrayElements(data, buffer, JNI_ABORT);
+    return ok ? JNI_TRUE : JNI_FALSE;
+}
+
+JNIEXPORT void JNICALL
+Java_com_hereliesaz_graffitixr_nativebridge_SlamManager_nativeGetPeerFingerprintBase(
+        JNIEnv* env, jobject thiz, jlongArray out) {
+    std::lock_guard<std::mutex> engineLock(gEngineMutex);
+    if (!gSlamEngine || !out || env->GetArrayLength(out) < 2) return;
+    uint64_t epoch = 0, gen = 0;
+    gSlamEngine->getPeerFingerprintBase(epoch, gen);
+    const jlong buf[2] = {(jlong)epoch, (jlong)gen};
+    env->SetLongArrayRegion(out, 0, 2, buf);
 }
 
 } // extern "C"
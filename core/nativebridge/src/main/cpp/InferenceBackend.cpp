@@ -0,0 +1,108 @@
+#include "include/InferenceBackend.h"
+#include <android/log.h>
+#include <opencv2/core/ocl.hpp>
+#include <chrono>
+#include <mutex>
+
+#define LOGD(...) __android_log_print(ANDROID_LOG_DEBUG, "InferenceBackend", __VA_ARGS__)
+#define LOGE(...) __android_log_print(ANDROID_LOG_ERROR, "InferenceBackend", __VA_ARGS__)
+
+namespace {
+
+// cv::setNumThreads is process-wide, so two models forwarding at once with different per-model
+// counts would each run under whichever count was set last. Only forwards that actually ask for a
+// count take this lock; the default (numThreads <= 0) path never touches it, so the common case
+// gains no contention over the pre-abstraction code.
+std::mutex gThreadCountMutex;
+
+class OpenCvDnnBackend : public InferenceBackend {
+public:
+    explicit OpenCvDnnBackend(Kind kind) : mKind(kind) {}
+
+    bool load(const std::vector<uchar>& onnxBytes, const Options& opts) override {
+        mOpts = opts;
+        mLastForwardMs.store(-1.0f, std::memory_order_relaxed);
+        try {
+            mNet = cv::dnn::readNetFromONNX(onnxBytes);
+            if (mNet.empty()) return false;
+            mNet.setPreferableBackend(cv::dnn::DNN_BACKEND_DEFAULT);
+            const bool wantCl = mKind != Kind::OpenCvDnnCpu;
+            if (wantCl && cv::ocl::haveOpenCL()) {
+                mNet.setPreferableTarget(cv::dnn::DNN_TARGET_OPENCL);
+                mName = "opencv-dnn/opencl";
+            } else {
+                if (mKind == Kind::OpenCvDnnOpenCL) LOGD("OpenCL requested but unavailable, using CPU");
+                mNet.setPreferableTarget(cv::dnn::DNN_TARGET_CPU);
+                mName = "opencv-dnn/cpu";
+            }
+            LOGD("loaded on %s (threads=%d)", mName, mOpts.numThreads);
+            return true;
+        } catch (const cv::Exception& e) {
+            LOGE("readNetFromONNX failed: %s", e.what());
+            mNet = cv::dnn::Net();
+            return false;
+        } catch (...) {
+            // bad_alloc on a large graph, or whatever the backend throws: either escaping reaches the
+            // JNI boundary and aborts the app, where a failed load only leaves the model inert.
+            LOGE("readNetFromONNX failed: unexpected exception");
+            mNet = cv::dnn::Net();
+            return false;
+        }
+    }
+
+    bool empty() const override { return mNet.empty(); }
+
+    void setInput(const cv::Mat& blob, const std::string& name) override {
+        mNet.setInput(blob, name);
+    }
+
+    bool forward(std::vector<cv::Mat>& outputs, const std::vector<std::string>& outNames) override {
+        if (mNet.empty()) return false;
+        const auto t0 = std::chrono::steady_clock::now();
+        std::unique_lock<std::mutex> threadsLock(gThreadCountMutex, std::defer_lock);
+        int prevThreads = -1;
+        if (mOpts.numThreads > 0) {
+            threadsLock.lock();
+            prevThreads = cv::getNumThreads();
+            cv::setNumThreads(mOpts.numThreads);
+        }
+        bool ok = true;
+        try {
+            std::vector<cv::String> names;
+            if (outNames.empty()) {
+                names = mNet.getUnconnectedOutLayersNames();
+            } else {
+                names.assign(outNames.begin(), outNames.end());
+            }
+            mNet.forward(outputs, names);
+        } catch (const cv::Exception& e) {
+            LOGE("%s forward failed: %s", mName, e.what());
+            ok = false;
+        } catch (...) {
+            LOGE("%s forward failed: unexpected exception", mName);
+            ok = false;
+        }
+        // Restored on the failure path too, so one bad frame can't pin the global pool at this
+        // model's count.
+        if (prevThreads >= 0) cv::setNumThreads(prevThreads);
+        if (!ok) return false;
+        const float ms = std::chrono::duration<float, std::milli>(
+                std::chrono::steady_clock::now() - t0).count();
+        mLastForwardMs.store(ms, std::memory_order_relaxed);
+        return !outputs.empty();
+    }
+
+    const char* name() const override { return mName; }
+
+private:
+    Kind         mKind;
+    Options      mOpts;
+    cv::dnn::Net mNet;
+    const char*  mName = "opencv-dnn";
+};
+
+} // namespace
+
+std::unique_ptr<InferenceBackend> InferenceBackend::create(Kind kind) {
+    return std::make_unique<OpenCvDnnBackend>(kind);
+}
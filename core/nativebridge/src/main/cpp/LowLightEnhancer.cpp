@@ -1,76 +1,287 @@
 #include "include/LowLightEnhancer.h"
 #include <android/log.h>
 #include <algorithm>
-#include <opencv2/core/ocl.hpp>
+#include <cfloat>
+#include <cmath>
 
 #define LOGD(...) __android_log_print(ANDROID_LOG_DEBUG, "LowLightEnhancer", __VA_ARGS__)
 #define LOGE(...) __android_log_print(ANDROID_LOG_ERROR, "LowLightEnhancer", __VA_ARGS__)
 
-bool LowLightEnhancer::load(const std::vector<uchar>& onnxBytes) {
+bool LowLightEnhancer::load(const std::vector<uchar>& onnxBytes, const InferenceBackend::Options& opts) {
     std::lock_guard<std::mutex> lock(mMutex);
     mLoaded = false;
-    try {
-        mNet = cv::dnn::readNetFromONNX(onnxBytes);
-        if (mNet.empty()) return false;
-        mNet.setPreferableBackend(cv::dnn::DNN_BACKEND_DEFAULT);
-        if (cv::ocl::haveOpenCL()) {
-            mNet.setPreferableTarget(cv::dnn::DNN_TARGET_OPENCL);
-            LOGD("Using OpenCL backend");
+    auto backend = InferenceBackend::create(opts.kind);
+    if (!backend->load(onnxBytes, opts) || backend->empty()) {
+        LOGE("Failed to load ONNX model");
+        return false;
+    }
+    LOGD("Using %s", backend->name());
+    mBackend = std::move(backend);
+    mCacheValid = false;  // a new graph's curves are not the old graph's
+    mLoaded = true;
+    return true;
+}
+
+bool LowLightEnhancer::warmUp() {
+    if (!mLoaded) return false;
+    std::lock_guard<std::mutex> lock(mMutex);
+    if (!mBackend || mBackend->empty()) return false;
+    const int sz[4] = {1, 3, kInferH, kInferW};
+    cv::Mat blob(4, sz, CV_32F, cv::Scalar(0.0f));
+    mBackend->setInput(blob);
+    std::vector<cv::Mat> outs;
+    const bool ok = mBackend->forward(outs);
+    LOGD("Warm-up %s in %.1f ms", ok ? "done" : "FAILED", mBackend->lastForwardMs());
+    return ok;
+}
+
+void LowLightEnhancer::prepare(const cv::Mat& input) {
+    cv::resize(input, mResized, cv::Size(kInferW, kInferH), 0, 0, cv::INTER_AREA);
+    mResized.convertTo(mFloat, CV_32F, 1.0 / 255.0);
+}
+
+bool LowLightEnhancer::infer(cv::Mat planes[3]) {
+    // HWC -> CHW straight into the reused blob: split() writes into plane headers that alias the
+    // blob's memory, so there is no per-pixel loop and no blobFromImage allocation per frame.
+    const int sz[4] = {1, 3, kInferH, kInferW};
+    mBlob.create(4, sz, CV_32F);
+    for (int c = 0; c < 3; ++c)
+        mInPlanes[c] = cv::Mat(kInferH, kInferW, CV_32F, mBlob.ptr<float>() + (size_t)c * kInferH * kInferW);
+    cv::split(mFloat, mInPlanes);
+
+    mBackend->setInput(mBlob);
+    if (!mBackend->forward(mOutputs)) return false;
+    const cv::Mat& out = mOutputs[0];  // shape [1,3,H,W], float [0,1]
+    if (out.dims < 4 || out.size[1] != 3) return false;
+    const int H = out.size[2];
+    const int W = out.size[3];
+    for (int c = 0; c < 3; ++c)
+        planes[c] = cv::Mat(H, W, CV_32F, const_cast<float*>(out.ptr<float>()) + (size_t)c * H * W);
+    return true;
+}
+
+bool LowLightEnhancer::cacheUsable(float meanLuma, const float* viewMatrix) const {
+    if (!mCacheValid || mCacheReuses >= kCacheMaxReuses) return false;
+    if (std::fabs(meanLuma - mCacheLuma) > kCacheMaxLumaDelta) return false;
+
+    // Rotation between the two views from the Frobenius product of their 3x3 blocks
+    // (= trace(Ra * Rb^T) = 1 + 2cos(theta)); no matrix inverse needed.
+    float dot = 0.0f;
+    for (int col = 0; col < 3; ++col)
+        for (int row = 0; row < 3; ++row)
+            dot += viewMatrix[col * 4 + row] * mCacheView[col * 4 + row];
+    const float cosTheta = std::max(-1.0f, std::min(1.0f, 0.5f * (dot - 1.0f)));
+    if (std::acos(cosTheta) * (float)(180.0 / CV_PI) > kCacheMaxRotationDeg) return false;
+
+    // Camera centre C = -R^T t for each view; the translation column alone is in camera axes and
+    // changes under pure rotation.
+    float d2 = 0.0f;
+    for (int k = 0; k < 3; ++k) {
+        float ca = 0.0f, cb = 0.0f;
+        for (int i = 0; i < 3; ++i) {
+            ca -= viewMatrix[k * 4 + i] * viewMatrix[12 + i];
+            cb -= mCacheView[k * 4 + i] * mCacheView[12 + i];
+        }
+        d2 += (ca - cb) * (ca - cb);
+    }
+    return d2 <= kCacheMaxTranslationM * kCacheMaxTranslationM;
+}
+
+void LowLightEnhancer::refreshCache(const cv::Mat planes[3], float meanLuma, const float* viewMatrix) {
+    mCurves.release();
+    for (int c = 0; c < 3; ++c) mGain[c].release();
+
+    const cv::Mat* curves = nullptr;
+    for (size_t i = 1; i < mOutputs.size(); ++i) {
+        const cv::Mat& o = mOutputs[i];
+        if (o.dims == 4 && o.size[1] == 24 && o.size[2] == kInferH && o.size[3] == kInferW) {
+            curves = &o;
+            break;
+        }
+    }
+    if (curves) {
+        curves->copyTo(mCurves);  // the forward's outputs are overwritten by the next forward
+    } else {
+        // Gain the curve amounted to on this frame. Floored denominator so near-black inputs don't
+        // divide by ~0, and capped at 2^8 — the most eight Zero-DCE iterations can amplify.
+        for (int c = 0; c < 3; ++c) {
+            cv::max(mInPlanes[c], 1.0 / 255.0, mTerm);
+            cv::divide(planes[c], mTerm, mGain[c]);
+            cv::max(mGain[c], 0.0, mGain[c]);
+            cv::min(mGain[c], 256.0, mGain[c]);
+        }
+    }
+    mCacheLuma = meanLuma;
+    std::copy(viewMatrix, viewMatrix + 16, mCacheView);
+    mCacheReuses = 0;
+    mCacheValid = true;
+}
+
+void LowLightEnhancer::applyCache(cv::Mat planes[3]) {
+    cv::split(mFloat, mInPlanes);
+    const int plane = kInferH * kInferW;
+    for (int c = 0; c < 3; ++c) {
+        if (mCurves.empty()) {
+            cv::multiply(mInPlanes[c], mGain[c], mCached[c]);
         } else {
-            mNet.setPreferableTarget(cv::dnn::DNN_TARGET_CPU);
-            LOGD("OpenCL unavailable, using CPU backend");
+            // Zero-DCE's light-enhancement curve, iterated exactly as the network does it:
+            // x <- x + r_n * (x^2 - x), with r_n the channel's plane of iteration n.
+            mInPlanes[c].copyTo(mCached[c]);
+            for (int n = 0; n < 8; ++n) {
+                const cv::Mat r(kInferH, kInferW, CV_32F,
+                                mCurves.ptr<float>() + (size_t)(n * 3 + c) * plane);
+                cv::multiply(mCached[c], mCached[c], mTerm);
+                mTerm -= mCached[c];
+                cv::multiply(mTerm, r, mTerm);
+                mCached[c] += mTerm;
+            }
         }
-        mLoaded = true;
+        planes[c] = mCached[c];
+    }
+}
+
+bool LowLightEnhancer::enhance(const cv::Mat& input, cv::Mat& output) {
+    if (!mLoaded) return false;
+    std::lock_guard<std::mutex> lock(mMutex);
+    if (!mBackend || mBackend->empty()) return false;
+    try {
+        cv::Mat planes[3];
+        prepare(input);
+        if (!infer(planes)) return false;
+        // Zero-DCE routinely produces small negative outputs on near-black pixels. A one-sided
+        // clamp leaves those negative, and a narrowing cast to uchar wraps them to 255 (pure
+        // white) -- bright speckle noise injected into exactly the dark frames this enhancer
+        // exists to help. convertTo to CV_8U saturates on BOTH sides, so the whole-plane
+        // conversion keeps that guarantee without the per-pixel clamp.
+        for (int c = 0; c < 3; ++c) planes[c].convertTo(mPlanes8[c], CV_8U, 255.0);
+        cv::merge(mPlanes8, 3, mResult);
+        cv::resize(mResult, output, input.size(), 0, 0, cv::INTER_LINEAR);
         return true;
     } catch (...) {
-        LOGE("Failed to load ONNX model");
+        LOGE("Inference failed");
         return false;
     }
 }
 
-bool LowLightEnhancer::enhance(const cv::Mat& input, cv::Mat& output) {
+bool LowLightEnhancer::enhanceLuma(const cv::Mat& input, cv::Mat& grayOut, const float* viewMatrix) {
     if (!mLoaded) return false;
     std::lock_guard<std::mutex> lock(mMutex);
-    if (mNet.empty()) return false;
+    if (!mBackend || mBackend->empty()) return false;
     try {
-        static const int INF_W = 600;
-        static const int INF_H = 400;
-
-        cv::Mat resized;
-        cv::resize(input, resized, cv::Size(INF_W, INF_H), 0, 0, cv::INTER_AREA);
-
-        cv::Mat f;
-        resized.convertTo(f, CV_32F, 1.0 / 255.0);
-        cv::Mat blob = cv::dnn::blobFromImage(f);  // shape [1,3,H,W]
-
-        mNet.setInput(blob);
-        cv::Mat out = mNet.forward();  // shape [1,3,H,W], float [0,1]
-
-        if (out.dims < 4 || out.size[1] != 3) return false;
-        const int H = out.size[2];
-        const int W = out.size[3];
-        const float* data = (const float*)out.data;
-        const int hw = H * W;
-
-        cv::Mat result(H, W, CV_8UC3);
-        for (int y = 0; y < H; ++y) {
-            for (int x = 0; x < W; ++x) {
-                const int idx = y * W + x;
-                // Zero-DCE routinely produces small negative outputs on near-black pixels. A
-                // one-sided std::min(255, ...) leaves those negative, and the narrowing cast to
-                // uchar wraps them to 255 (pure white) -- bright speckle noise injected into
-                // exactly the dark frames this enhancer exists to help. Clamp both sides.
-                result.at<cv::Vec3b>(y, x) = {
-                    (uchar)std::clamp((int)(data[idx]          * 255.0f), 0, 255),
-                    (uchar)std::clamp((int)(data[hw + idx]     * 255.0f), 0, 255),
-                    (uchar)std::clamp((int)(data[2 * hw + idx] * 255.0f), 0, 255)
-                };
+        cv::Mat planes[3];
+        prepare(input);
+        if (viewMatrix) {
+            const cv::Scalar m = cv::mean(mFloat);
+            const float meanLuma = (float)(0.299 * m[0] + 0.587 * m[1] + 0.114 * m[2]);
+            if (cacheUsable(meanLuma, viewMatrix)) {
+                applyCache(planes);
+                ++mCacheReuses;
+                mCacheHits.fetch_add(1, std::memory_order_relaxed);
+            } else {
+                if (!infer(planes)) { mCacheValid = false; return false; }
+                refreshCache(planes, meanLuma, viewMatrix);
+                mCacheMisses.fetch_add(1, std::memory_order_relaxed);
             }
+        } else if (!infer(planes)) {
+            return false;
         }
-        cv::resize(result, output, input.size(), 0, 0, cv::INTER_LINEAR);
+        // Output channels come back in input order (RGB), so these are COLOR_RGB2GRAY's weights
+        // and the result is what cvtColor of enhance()'s output would give, computed on one
+        // 600x400 float plane instead of on a full-resolution three-channel frame.
+        cv::addWeighted(planes[0], 0.299, planes[1], 0.587, 0.0, mLuma);
+        cv::scaleAdd(planes[2], 0.114, mLuma, mLuma);
+        mLuma.convertTo(mLuma8, CV_8U, 255.0);  // saturating, for the same reason as enhance()
+        cv::resize(mLuma8, grayOut, input.size(), 0, 0, cv::INTER_LINEAR);
         return true;
     } catch (...) {
         LOGE("Inference failed");
         return false;
     }
 }
+
+namespace lowlight {
+
+void gammaLuma(const cv::Mat& gray, cv::Mat& out) {
+    // thread_local like normalizeForFeatures' CLAHE: only ever called from the reloc thread, and the
+    // LUT is worth keeping between frames whose mean barely moves.
+    thread_local cv::Mat lut(1, 256, CV_8U);
+    thread_local float lutGamma = -1.0f;
+    const double mean = std::max(cv::mean(gray)[0] / 255.0, 1.0 / 255.0);
+    // Exponent that takes the mean to 0.5; never brightening past linear, never below 0.3 so a
+    // near-black frame isn't stretched into pure sensor noise.
+    const float gamma = (float)std::max(0.3, std::min(1.0, std::log(0.5) / std::log(mean)));
+    if (std::fabs(gamma - lutGamma) > 0.02f) {
+        uchar* l = lut.ptr<uchar>();
+        for (int i = 0; i < 256; ++i)
+            l[i] = cv::saturate_cast<uchar>(255.0 * std::pow(i / 255.0, (double)gamma));
+        lutGamma = gamma;
+    }
+    cv::LUT(gray, lut, out);
+}
+
+void retinexLuma(const cv::Mat& gray, cv::Mat& out) {
+    constexpr int    kRadius = 8;        // at quarter resolution: ~32 px of the full frame
+    constexpr double kEps = 0.01;        // guided-filter regularizer, [0,1] intensity units
+    constexpr double kTarget = 0.5;      // illumination the gain normalizes toward
+    constexpr double kMaxGain = 6.0;
+    thread_local cv::Mat small, I, meanI, meanII, a, b, gain, gainFull, f;
+
+    cv::resize(gray, small, cv::Size(std::max(1, gray.cols / 4), std::max(1, gray.rows / 4)),
+               0, 0, cv::INTER_AREA);
+    small.convertTo(I, CV_32F, 1.0 / 255.0);
+    const cv::Size win(2 * kRadius + 1, 2 * kRadius + 1);
+    cv::boxFilter(I, meanI, CV_32F, win);
+    cv::boxFilter(I.mul(I), meanII, CV_32F, win);
+    // a = var / (var + eps), b = meanI - a * meanI; illumination = box(a) * I + box(b).
+    cv::Mat var = meanII - meanI.mul(meanI);
+    cv::divide(var, var + kEps, a);
+    b = meanI - a.mul(meanI);
+    cv::boxFilter(a, a, CV_32F, win);
+    cv::boxFilter(b, b, CV_32F, win);
+    cv::Mat illum = a.mul(I) + b;
+    cv::max(illum, 1.0 / 255.0, illum);
+    cv::divide(kTarget, illum, gain);
+    cv::min(gain, kMaxGain, gain);
+    cv::max(gain, 1.0, gain);  // brighten only; a lit region keeps its own contrast
+    cv::resize(gain, gainFull, gray.size(), 0, 0, cv::INTER_LINEAR);
+    gray.convertTo(f, CV_32F);
+    f = f.mul(gainFull);
+    f.convertTo(out, CV_8U);  // saturating
+}
+
+} // namespace lowlight
+
+LowLightTierSelector::Tier LowLightTierSelector::choose(bool networkAvailable) {
+    const int n = networkAvailable ? kTierCount : kTierNetwork;
+    ++mChoices;
+    for (int t = 0; t < n; ++t)
+        if (mStats[t].samples < kMinSamples) return (Tier)t;
+    if (mChoices % kExploreEvery == 0) {
+        mExploreCursor = (mExploreCursor + 1) % n;
+        return (Tier)mExploreCursor;
+    }
+
+    auto affordable = [&](int t) { return t <= kTierGamma || mStats[t].ms <= kMaxTierMs; };
+    float best = 0.0f;
+    for (int t = 0; t < n; ++t)
+        if (affordable(t)) best = std::max(best, mStats[t].features);
+    int pick = kTierNone;
+    float pickMs = FLT_MAX;
+    for (int t = 0; t < n; ++t) {
+        if (!affordable(t) || mStats[t].features < kRetainFraction * best) continue;
+        if (mStats[t].ms < pickMs) { pick = t; pickMs = mStats[t].ms; }
+    }
+    return (Tier)pick;
+}
+
+void LowLightTierSelector::report(Tier tier, float ms, int features) {
+    Stats& s = mStats[tier];
+    if (s.samples == 0) {
+        s.ms = ms;
+        s.features = (float)features;
+    } else {
+        s.ms += kEmaAlpha * (ms - s.ms);
+        s.features += kEmaAlpha * ((float)features - s.features);
+    }
+    ++s.samples;
+}
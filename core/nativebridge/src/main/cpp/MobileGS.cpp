@@ -1,6 +1,7 @@
 #include "include/MobileGS.h"
 #include "include/KeypointGrid.h"
 #include "include/SearchRadius.h"
+#include "include/DescriptorDistance.h"
 #include <jni.h>
 #include <EGL/egl.h>
 #include <algorithm>
@@ -11,6 +12,9 @@
 #include <fstream>
 #include <cmath>
 #include <numeric>
+#include <random>
+#include <cstdio>
+#include <sys/stat.h>
 #include <sys/resource.h>
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
@@ -166,32 +170,105 @@ void MobileGS::getAnchorTransform(float* outMat16) const {
  * @param relocView the VIO view matrix snapshotted alongside the frame, for the rectifying warp.
  */
 void MobileGS::runRelocPass(const cv::Mat& frame, const float* relocView) {
+    const long passSeq = mRelocPassSeq.fetch_add(1, std::memory_order_relaxed) + 1;
+    // Multi-wall pre-selection (setWallPreselectEnabled) votes on the previous attempt's frame; it
+    // only proposes, so the snapshot below is still the loaded wall.
+    const bool preselect = mWallPreselectEnabled.load(std::memory_order_relaxed);
+    if (preselect) preselectWall();
     cv::Mat wallDescs;
     std::vector<cv::Point3f> wallKps3d;
     // Phase 2: parallel to wallKps3d, or empty for a legacy fingerprint (= all backbone).
     std::vector<uint8_t> wallRegions;
-    cv::Mat wallPatch;
     float fpIntrinsics[4];
     bool hasFpView = false;
     // Phase 2b snapshot: the persistent feature map + the last reloc pose, used (when the flag is on)
     // as the frustum-gate prior. The map is co-registered to the fingerprint anchor, so its points
     // share wallKps3d's frame and the prior pose (camera_from_fpWorld) projects them directly.
+    //
+    // The gate runs HERE, under the lock, through mMapIndex, so only the visible subset is ever
+    // taken: mapVisible are row indices into mapDescs, a shared (not cloned) header on the map's
+    // descriptor arena — safe because the arena never rewrites a row a live view can see — and
+    // mapKps3d is parallel to mapVisible, not to mapDescs.
     cv::Mat mapDescs;
+    std::vector<int> mapVisible;
     std::vector<cv::Point3f> mapKps3d;
+    size_t mapTotal = 0;
     float mapPriorPose[16];
     long mapPriorSeq = 0;
+    // Keyframe retrieval (setMapKeyframesEnabled) stands in for the gate when it has nothing to
+    // offer; mapGen is the map generation mapDescs was viewed at, so indices resolved later under a
+    // second lock can be checked against it.
+    const bool mapKeyframes = mMapKeyframesEnabled.load(std::memory_order_relaxed);
+    uint64_t mapGen = 0;
+    // Bag-of-words (setBowRelocEnabled), for a COLD attempt only: no lock yet, or the previous
+    // attempt failed. The vocabulary pointers are those the wall / map indexes were built with (null
+    // when either is unindexed); wallGen is checked like mapGen when candidates are read later.
+    const bool bowOn = mBowRelocEnabled.load(std::memory_order_relaxed);
+    bool bowCold = false;
+    std::shared_ptr<const VocabularyTree> wallVocab, mapVocab;
+    uint64_t wallGen = 0;
+    // Point refinement (setPointRefinementEnabled): the wall this pass's row indices belong to.
+    uint64_t refineEpoch = 0;
+    // The distortion head's wall epoch, taken beside the wall snapshot it describes.
+    uint64_t headEpoch = 0;
+    // Compact matching (setCompactMatchEnabled): when on and the fingerprint is SuperPoint, wallDescs
+    // and mapDescs below hold 32-byte sign codes rather than the float rows, and every query is
+    // binarized the same way before it is matched. Decided from the FLOAT descriptors under the lock,
+    // because afterwards a code and an ORB row are both CV_8U x 32 and can no longer be told apart.
+    const bool wantCompact = mCompactMatchEnabled.load(std::memory_order_relaxed);
+    bool compact = false;
+    bool wallIsFloat = false;
     {
         std::lock_guard<std::mutex> lock(mMutex);
-        wallDescs = mWallDescriptors.clone();
+        wallIsFloat = !mWallDescriptors.empty() && mWallDescriptors.type() == CV_32F;
+        compact = wantCompact && desccodes::canBinarize(mWallDescriptors.view());
+        if (compact) {
+            if (mWallCodesGen != mWallDescGen) {
+                mWallCodes = desccodes::binarize(mWallDescriptors.view());
+                mWallCodesGen = mWallDescGen;
+            }
+            wallDescs = mWallCodes;   // shared: the cache is only ever reassigned, never written in place
+        } else {
+            wallDescs = mWallDescriptors.view();   // zero-copy: the arena never rewrites a viewed row
+        }
         wallKps3d = mWallKeypoints3D;
         wallRegions = mWallRegions;
-        wallPatch = mWallPatch.clone();
         memcpy(fpIntrinsics, mFingerprintIntrinsics, 4 * sizeof(float));
         hasFpView = mHasFingerprintView;
-        mapDescs = mMapDescriptors.clone();
-        mapKps3d = mMapPoints3D;
         memcpy(mapPriorPose, mPnpCamFromFpWorld, 16 * sizeof(float));
         mapPriorSeq = mPnpResultSeq.load(std::memory_order_relaxed);
+        mapTotal = mMapPoints3D.size();
+        refineEpoch = mRefineEpoch;
+        headEpoch = mHeadEpoch.load(std::memory_order_relaxed);
+        if (bowOn) {
+            bowCold = mapPriorSeq == 0 || mLastRelocReject.load(std::memory_order_relaxed) != kRelocOk;
+            if (bowCold) {
+                wallVocab = mWallBowVocab;
+                wallGen = mWallDescGen;
+            }
+        }
+        if (mMapRelocEnabled.load(std::memory_order_relaxed) && (mapPriorSeq > 0 || mapKeyframes || bowCold)
+                && !frame.empty() && mMapPoints3D.size() == (size_t)mMapDescriptors.rows()) {
+            mapGen = mMapDescGen;
+            if (bowCold) mapVocab = mMapBowVocab;
+            if (!compact) {
+                mapDescs = mMapDescriptors.view();
+            } else if (desccodes::canBinarize(mMapDescriptors.view()) && mMapDescriptors.cols() == mWallDescriptors.cols()) {
+                if (mMapCodesGen != mMapDescGen) {
+                    mMapCodes = desccodes::binarize(mMapDescriptors.view());
+                    mMapCodesGen = mMapDescGen;
+                }
+                mapDescs = mMapCodes;
+            }
+            // else: compact, but the map is not SuperPoint-shaped. Left empty so the map pass skips,
+            // exactly as the type check there would have made it skip a float/ORB mismatch — an ORB
+            // map must not reach a match against codes it happens to be type-compatible with.
+            if (!mapDescs.empty() && mapPriorSeq > 0) {
+                gateMapToFrustum(mapPriorPose, frame.cols, frame.rows, mapVisible);
+                mapKps3d.reserve(mapVisible.size());
+                for (int i : mapVisible) mapKps3d.push_back(mMapPoints3D[(size_t)i]);
+            }
+        }
     }
 
     // 2.11: reset the backbone counters BEFORE the early-outs below, so an attempt that never
@@ -253,47 +330,152 @@ void MobileGS::runRelocPass(const cv::Mat& frame, const float* relocView) {
 
     if (frame.empty()) return;
 
-    // Optionally enhance the RGB frame under low light before grayscale conversion
-    cv::Mat workFrame = frame;
-    if (mEnhancer.isLoaded() && mLightLevel.load(std::memory_order_relaxed) < kLowLightThreshold) {
-        cv::Mat enhanced;
-        if (mEnhancer.enhance(frame, enhanced)) workFrame = enhanced;
-    }
-    cv::Mat gray;
-    cv::cvtColor(workFrame, gray, cv::COLOR_RGB2GRAY);
+    // Optionally enhance under low light before normalization. Only luma is ever consumed from
+    // here on (the features below and the distortion head's crop both start from gray), so the
+    // enhancer is asked for luma directly rather than a full RGB frame that cvtColor would collapse
+    // on the very next line. rawGray is the un-normalized gray; the head wants it without CLAHE.
+    //
+    // With tiers enabled (setLowLightTiersEnabled) a dark frame instead gets whichever tier the
+    // selector picks — possibly none, possibly a classical one with no model loaded at all — and
+    // the tier's cost and the base pass's keypoint count are fed back once detection has run.
+    const bool dark = mLightLevel.load(std::memory_order_relaxed) < kLowLightThreshold;
+    const bool useTiers = dark && mLowLightTiersEnabled.load(std::memory_order_relaxed);
+    LowLightTierSelector::Tier tier = LowLightTierSelector::kTierNone;
+    if (useTiers) tier = mLowLightTiers.choose(mEnhancer.isLoaded());
+    else if (dark && mEnhancer.isLoaded()) tier = LowLightTierSelector::kTierNetwork;
+    cv::Mat rawGray;
+    bool enhancedLuma = false;
+    const auto tierStart = std::chrono::steady_clock::now();
+    // The VIO pose is offered only while tracking: it is what lets the enhancer reuse its last
+    // curve map across frames, and a frozen pose from a lost session would read as "camera hasn't
+    // moved" for as long as tracking stays lost. Null just means infer every time.
+    if (tier == LowLightTierSelector::kTierNetwork) {
+        const bool tracking = mIsArCoreTracking.load(std::memory_order_relaxed);
+        enhancedLuma = mEnhancer.enhanceLuma(frame, rawGray, tracking ? relocView : nullptr);
+        if (!enhancedLuma) tier = LowLightTierSelector::kTierNone;
+    }
+    if (!enhancedLuma) cv::cvtColor(frame, rawGray, cv::COLOR_RGB2GRAY);
+    if (tier == LowLightTierSelector::kTierGamma) lowlight::gammaLuma(rawGray, rawGray);
+    else if (tier == LowLightTierSelector::kTierRetinex) lowlight::retinexLuma(rawGray, rawGray);
+    const float tierMs = std::chrono::duration<float, std::milli>(
+            std::chrono::steady_clock::now() - tierStart).count();
+    cv::Mat gray = rawGray;     // normalizeForFeatures reassigns, never writes through, so rawGray survives
     normalizeForFeatures(gray); // illumination-normalize to match the (also-normalized) fingerprint
 
     // SuperPoint usable when loaded and the wall fingerprint is float-typed (or empty).
-    const bool spOk = mSuperPoint.isLoaded() &&
-        (wallDescs.empty() || wallDescs.type() == CV_32F);
-
-    // Detect + Lowe-ratio match a gray image against the wall fingerprint. When Hback is non-empty
-    // the matched keypoints are mapped through it (rectified frame -> current image) before being
-    // stored, so the returned 2D points are ALWAYS in the current camera image — exactly what the
-    // PnP below expects.
-    // Detect base-frame features ONCE and reuse them: SuperPoint is an ONNX model, so detecting the
-    // same gray twice (plain pass + map matching) would roughly double per-reloc cost. The scaled and
-    // rectified passes run on different images, so buildCorr still detects internally for those.
-    std::vector<cv::KeyPoint> baseKps; cv::Mat baseDescs;
-    {
-        bool sp = spOk;
-        if (sp && !mSuperPoint.detect(gray, baseKps, baseDescs)) sp = false;
-        if (!sp) mFeatureDetector->detectAndCompute(gray, cv::noArray(), baseKps, baseDescs);
+    const bool spOk = mSuperPoint.isLoaded() && (wallDescs.empty() || wallIsFloat);
+
+    // Every image the correspondence passes below match, built up front so detection can happen in
+    // one place. The multi-scale and rectified passes are explained where they are matched; they
+    // are hoisted here only because SuperPoint's detectBatch takes same-shape inputs in ONE forward,
+    // and with any frame over 640x480 the plain, 2x and rectified images all reach the network at
+    // exactly 640x480. Sequential detects paid three forwards for what is now one batched pass.
+    cv::Mat grayHalf, grayDouble;
+    cv::resize(gray, grayHalf, cv::Size(), 0.5, 0.5, cv::INTER_LINEAR);
+    cv::resize(gray, grayDouble, cv::Size(), 2.0, 2.0, cv::INTER_LINEAR);
+
+    // Plane-guided rectification eligibility (the pass itself is matched further down).
+    // Published so the diagnostics can show whether this pass is actually running. It was dead in
+    // practice for a long time (nothing set mHasFingerprintView on the live capture path), so
+    // "did rectification fire, and did it help" is worth being able to read off the device rather
+    // than infer. -1 = the pass was not eligible at all this attempt.
+    mLastRelocObliquityDeg.store(-1, std::memory_order_relaxed);
+    mLastRelocRectifiedCorr.store(0, std::memory_order_relaxed);
+    cv::Mat Hcur_fp, Hfp_cur, grayRect; double obliqDeg = 0.0;
+    // Head prior (setHeadPriorEnabled): a recent, confident distortion-head result stands in for
+    // the plane-fit homography below, so the warp no longer needs a fingerprint view or tracking.
+    cv::Mat Hprior;
+    double priorTilt = 0.0;
+    const bool usePrior = mHeadPriorEnabled.load(std::memory_order_relaxed) && wallKps3d.size() >= 12
+                          && headPriorHomography(passSeq, headEpoch, fpIntrinsics, Hprior, priorTilt);
+    if (usePrior) {
+        Hcur_fp = Hprior;
+        Hfp_cur = Hprior.inv();
+        obliqDeg = priorTilt;
+        mLastRelocObliquityDeg.store((int)(obliqDeg + 0.5), std::memory_order_relaxed);
+        if (obliqDeg > 25.0) cv::warpPerspective(gray, grayRect, Hfp_cur, gray.size());
+    } else if (hasFpView && mIsArCoreTracking.load(std::memory_order_relaxed) && wallKps3d.size() >= 12) {
+        const bool haveH = computeRectifyHomography(relocView, Hcur_fp, Hfp_cur, obliqDeg);
+        if (haveH) mLastRelocObliquityDeg.store((int)(obliqDeg + 0.5), std::memory_order_relaxed);
+        if (haveH && obliqDeg > 25.0) cv::warpPerspective(gray, grayRect, Hfp_cur, gray.size());
+    }
+
+    // Detect on every pass image ONCE and reuse: SuperPoint is an ONNX model, so detecting the
+    // same gray twice (plain pass + map matching) would roughly double per-reloc cost. Each pass
+    // falls back to ORB on its own when SuperPoint refuses it, exactly as the per-pass detects did.
+    enum { kPassBase = 0, kPassHalf, kPassDouble, kPassRect, kPassCount };
+    const cv::Mat* passImg[kPassCount] = {&gray, &grayHalf, &grayDouble, &grayRect};
+    std::vector<cv::KeyPoint> passKps[kPassCount];
+    cv::Mat passDescs[kPassCount];
+    bool passSp[kPassCount] = {false, false, false, false};
+    if (spOk) {
+        std::vector<cv::Mat> batch;
+        std::vector<int> slot;
+        for (int k = 0; k < kPassCount; ++k) {
+            if (!passImg[k]->empty()) { batch.push_back(*passImg[k]); slot.push_back(k); }
+        }
+        std::vector<std::vector<cv::KeyPoint>> bKps; std::vector<cv::Mat> bDescs; std::vector<bool> bOk;
+        mSuperPoint.detectBatch(batch, bKps, bDescs, bOk);
+        for (size_t i = 0; i < slot.size(); ++i) {
+            if (!bOk[i]) continue;
+            passKps[slot[i]] = std::move(bKps[i]);
+            passDescs[slot[i]] = bDescs[i];
+            passSp[slot[i]] = true;
+        }
     }
+    for (int k = 0; k < kPassCount; ++k) {
+        if (!passSp[k] && !passImg[k]->empty())
+            mFeatureDetector->detectAndCompute(*passImg[k], cv::noArray(), passKps[k], passDescs[k]);
+    }
+    std::vector<cv::KeyPoint>& baseKps = passKps[kPassBase];
+    cv::Mat& baseDescs = passDescs[kPassBase];
     mLastRelocDetected.store((int)baseKps.size(), std::memory_order_relaxed);
+    if (useTiers) mLowLightTiers.report(tier, tierMs, (int)baseKps.size());
+    if (preselect && !baseDescs.empty()) {
+        cv::Mat frameGlobal = KeyframeGraph::globalDescriptor(baseDescs);
+        std::lock_guard<std::mutex> lock(mMutex);
+        if (mWallRegistry.size() > 0) {
+            mLastFrameGlobal = frameGlobal;
+            mLastFrameGlobalType = baseDescs.type();
+        }
+    }
+    // Binarized once here for the map pass. Empty when the base detection fell back to ORB, which
+    // then matches nothing — the same outcome as the float/ORB type mismatch it replaces.
+    cv::Mat baseCodes;
+    if (compact) baseCodes = desccodes::binarize(baseDescs);
+    const cv::Mat& baseQuery = compact ? baseCodes : baseDescs;
+
+    // Under the head prior, every wall point's predicted current-image location: its fingerprint
+    // 3D point projected with the fingerprint intrinsics, then through Hprior. NaN = not predictable.
+    bool guided = usePrior;
+    std::vector<cv::Point2f> wallPred;
+    if (usePrior) {
+        const float nan = std::numeric_limits<float>::quiet_NaN();
+        std::vector<cv::Point2f> fpPx(wallKps3d.size(), cv::Point2f(nan, nan));
+        for (size_t i = 0; i < wallKps3d.size(); ++i) {
+            const cv::Point3f& X = wallKps3d[i];
+            if (X.z > 1e-4f)
+                fpPx[i] = cv::Point2f(fpIntrinsics[0] * X.x / X.z + fpIntrinsics[2],
+                                      fpIntrinsics[1] * X.y / X.z + fpIntrinsics[3]);
+        }
+        cv::perspectiveTransform(fpPx, wallPred, Hprior);
+    }
 
-    auto buildCorr = [&](const cv::Mat& g, const cv::Mat& Hback,
+    // Lowe-ratio match one pass's features against the wall fingerprint. When Hback is non-empty
+    // the matched keypoints are mapped through it (pass image -> current image) before being
+    // stored, so the returned 2D points are ALWAYS in the current camera image — exactly what the
+    // PnP below expects.
+    //
+    // Guided (head prior), the question is asked from the wall's side instead, as the gated
+    // corroboration does: each fingerprint point compares only against the pass keypoints within
+    // kHeadPriorWindowPx of where the prior puts it, and the ratio test runs over that window.
+    // Same descriptor pairing as the matchers (L2 for float, Hamming for ORB and compact codes).
+    auto buildCorr = [&](const std::vector<cv::KeyPoint>& kps, const cv::Mat& rawDescs,
+                         const cv::Mat& Hback,
                          std::vector<cv::Point2f>& outImg, std::vector<cv::Point3f>& outObj,
-                         std::vector<uint8_t>& outFromBackbone,
-                         const std::vector<cv::KeyPoint>* preKps = nullptr, const cv::Mat* preDescs = nullptr) {
-        std::vector<cv::KeyPoint> localKps; cv::Mat localDescs;
-        if (!(preKps && preDescs)) {
-            bool sp = spOk;
-            if (sp && !mSuperPoint.detect(g, localKps, localDescs)) sp = false;
-            if (!sp) mFeatureDetector->detectAndCompute(g, cv::noArray(), localKps, localDescs);
-        }
-        const std::vector<cv::KeyPoint>& kps = (preKps && preDescs) ? *preKps : localKps;
-        const cv::Mat& descs = (preKps && preDescs) ? *preDescs : localDescs;
+                         std::vector<uint8_t>& outFromBackbone, std::vector<int>& outPoint) {
+        // Codes against codes only: an ORB fallback binarizes to empty and matches nothing.
+        const cv::Mat descs = compact ? desccodes::binarize(rawDescs) : rawDescs;
         if (descs.empty() || wallDescs.empty()) return;
         if (descs.type() != wallDescs.type()) return;
         // trainIdx indexes wallDescs' ROWS but is used to subscript wallKps3d, so the two must be
@@ -303,6 +485,91 @@ void MobileGS::runRelocPass(const cv::Mat& frame, const float* relocView) {
         // not. Refuse rather than relocalize against nonsense.
         if (wallKps3d.size() != (size_t)wallDescs.rows) return;
 
+        if (guided) {
+            std::vector<cv::KeyPoint> cur = kps;
+            if (!Hback.empty() && !cur.empty()) {
+                std::vector<cv::Point2f> in, outp;
+                cv::KeyPoint::convert(kps, in);
+                cv::perspectiveTransform(in, outp, Hback);
+                for (size_t i = 0; i < cur.size(); ++i) cur[i].pt = outp[i];
+            }
+            KeypointGrid grid;
+            grid.build(cur, kHeadPriorWindowPx);
+            std::vector<int> cand;
+            for (int t = 0; t < wallDescs.rows; ++t) {
+                if (usePartition && wallRegions[t] != kRegionOutside) continue;
+                const cv::Point2f& pred = wallPred[(size_t)t];
+                grid.candidatesWithin(pred.x, pred.y, kHeadPriorWindowPx, cand);
+                if (cand.size() < 2) continue;   // no second-best to take a ratio against
+                float best = FLT_MAX, second = FLT_MAX;
+                int bestQ = -1;
+                for (int q : cand) {
+                    const float d = descdist::row(descs, q, wallDescs, t);
+                    if (d < best) { second = best; best = d; bestQ = q; }
+                    else if (d < second) { second = d; }
+                }
+                if (bestQ < 0 || !(best < kRelocLoweRatio * second)) continue;
+                outImg.push_back(cur[(size_t)bestQ].pt);
+                outObj.push_back(wallKps3d[(size_t)t]);
+                outFromBackbone.push_back(1);
+                outPoint.push_back(t);
+            }
+            return;
+        }
+
+        // Cold, with a vocabulary: each query is ratio-tested only against the marks filed under its
+        // own direct-index node, instead of against every mark. The candidate lists are copied under
+        // a short second lock, and only if the wall is still the one wallDescs views; otherwise this
+        // falls through to the brute-force match below. So does a BoW pass that found too few to
+        // solve from: a true match filed under a neighbouring node is invisible to it, and on a
+        // cold attempt that miss must cost one brute-force match, never the lock.
+        if (wallVocab && wallVocab->compatible(rawDescs)) {
+            std::vector<uint32_t> words, nodes;
+            wallVocab->quantize(rawDescs, words, nodes);
+            std::vector<std::vector<uint32_t>> cand(nodes.size());
+            bool fresh;
+            {
+                std::lock_guard<std::mutex> lock(mMutex);
+                fresh = mWallDescGen == wallGen && mWallBowVocab == wallVocab;
+                if (fresh) {
+                    for (size_t q = 0; q < nodes.size(); ++q)
+                        if (const auto* list = mWallBow.nodeEntities(nodes[q])) cand[q] = *list;
+                }
+            }
+            if (fresh && (int)cand.size() == descs.rows) {
+                const size_t start = outImg.size();
+                for (int q = 0; q < descs.rows; ++q) {
+                    float best = FLT_MAX, second = FLT_MAX;
+                    int bestT = -1, n = 0;
+                    for (uint32_t t : cand[(size_t)q]) {
+                        if ((int)t >= wallDescs.rows) continue;
+                        const float d = descdist::row(descs, q, wallDescs, (int)t);
+                        ++n;
+                        if (d < best) { second = best; best = d; bestT = (int)t; }
+                        else if (d < second) { second = d; }
+                    }
+                    if (n < 2 || !(best < kRelocLoweRatio * second)) continue;
+                    // Ratio over every candidate, then the backbone filter, as the knnMatch path orders it.
+                    if (usePartition && wallRegions[(size_t)bestT] != kRegionOutside) continue;
+                    cv::Point2f p = kps[(size_t)q].pt;
+                    if (!Hback.empty()) {
+                        std::vector<cv::Point2f> in{p}, outp;
+                        cv::perspectiveTransform(in, outp, Hback);
+                        p = outp[0];
+                    }
+                    outImg.push_back(p);
+                    outObj.push_back(wallKps3d[(size_t)bestT]);
+                    outFromBackbone.push_back(1);
+                    outPoint.push_back(bestT);
+                }
+                if (outImg.size() - start >= kRelocMinCorr) return;
+                outImg.resize(start);
+                outObj.resize(start);
+                outFromBackbone.resize(start);
+                outPoint.resize(start);
+            }
+        }
+
         cv::Ptr<cv::DescriptorMatcher>& matcher = (descs.type() == CV_32F) ? mL2Matcher : mMatcher;
         std::vector<std::vector<cv::DMatch>> matches;
         matcher->knnMatch(descs, wallDescs, matches, 2);
@@ -328,6 +595,7 @@ void MobileGS::runRelocPass(const cv::Mat& frame, const float* relocView) {
                 // makes the whole fingerprint backbone. Recorded per correspondence rather than
                 // counted, because the inlier attribution below indexes back through this.
                 outFromBackbone.push_back(1);
+                outPoint.push_back(match[0].trainIdx);
             }
         }
     };
@@ -336,46 +604,47 @@ void MobileGS::runRelocPass(const cv::Mat& frame, const float* relocView) {
     std::vector<cv::Point3f> objPts;
     // 2.11: parallel to imgPts/objPts — 1 where the correspondence came from a backbone point.
     std::vector<uint8_t> corrFromBackbone;
-    buildCorr(gray, cv::Mat(), imgPts, objPts, corrFromBackbone, &baseKps, &baseDescs);
-
-    // Multi-scale matching (distance robustness). SuperPoint isn't scale-invariant, and the marks
-    // shrink in the frame from far away and grow up close, so also match the frame DOWN- and
-    // UP-scaled, mapping the matched points back to full-res with a scale homography (Hback). These
-    // passes share the plain pass's camera geometry, so they only add consistent correspondences
-    // across distance; PnP RANSAC discards any that don't fit. Covers both ORB and SuperPoint
-    // fingerprints, beyond ORB's own pyramid range.
-    for (float s : {0.5f, 2.0f}) {
-        cv::Mat scaled;
-        cv::resize(gray, scaled, cv::Size(), s, s, cv::INTER_LINEAR);
-        double hdata[] = {1.0/(double)s, 0.0, 0.0, 0.0, 1.0/(double)s, 0.0, 0.0, 0.0, 1.0};
-        cv::Mat Hback = cv::Mat(3, 3, CV_64F, hdata).clone();
-        buildCorr(scaled, Hback, imgPts, objPts, corrFromBackbone);
-    }
-
-    // Plane-guided rectification (perspective robustness for oblique views). The marks lie on a
-    // known plane and VIO gives a pose, so the oblique-vs-frontal distortion is a homography we can
-    // pre-cancel: warp the live frame into the fingerprint's frontal frame, match, and ADD the
-    // correspondences mapped back to the current image (RANSAC filters any that don't fit).
-    // Published so the diagnostics can show whether this pass is actually running. It was dead in
-    // practice for a long time (nothing set mHasFingerprintView on the live capture path), so
-    // "did rectification fire, and did it help" is worth being able to read off the device rather
-    // than infer. -1 = the pass was not eligible at all this attempt.
-    mLastRelocObliquityDeg.store(-1, std::memory_order_relaxed);
-    mLastRelocRectifiedCorr.store(0, std::memory_order_relaxed);
-    if (hasFpView && mIsArCoreTracking.load(std::memory_order_relaxed) && wallKps3d.size() >= 12) {
-        cv::Mat Hcur_fp, Hfp_cur; double obliqDeg = 0.0;
-        const bool haveH = computeRectifyHomography(relocView, Hcur_fp, Hfp_cur, obliqDeg);
-        if (haveH) mLastRelocObliquityDeg.store((int)(obliqDeg + 0.5), std::memory_order_relaxed);
-        if (haveH && obliqDeg > 25.0) {
-            cv::Mat grayRect;
-            cv::warpPerspective(gray, grayRect, Hfp_cur, gray.size());
+    // Also parallel: which stored point each correspondence is — wall row t as t, map index i as
+    // -(i + 1) — so a lock can record its inliers as observations for point refinement.
+    std::vector<int> corrPoint;
+    // The fingerprint passes, as one unit so a guided attempt that came up short can be redone whole.
+    auto matchWall = [&]() {
+        buildCorr(baseKps, baseDescs, cv::Mat(), imgPts, objPts, corrFromBackbone, corrPoint);
+
+        // Multi-scale matching (distance robustness). SuperPoint isn't scale-invariant, and the marks
+        // shrink in the frame from far away and grow up close, so also match the frame DOWN- and
+        // UP-scaled, mapping the matched points back to full-res with a scale homography (Hback). These
+        // passes share the plain pass's camera geometry, so they only add consistent correspondences
+        // across distance; PnP RANSAC discards any that don't fit. Covers both ORB and SuperPoint
+        // fingerprints, beyond ORB's own pyramid range.
+        for (int k : {(int)kPassHalf, (int)kPassDouble}) {
+            const double s = (k == kPassHalf) ? 0.5 : 2.0;
+            double hdata[] = {1.0/s, 0.0, 0.0, 0.0, 1.0/s, 0.0, 0.0, 0.0, 1.0};
+            cv::Mat Hback = cv::Mat(3, 3, CV_64F, hdata).clone();
+            buildCorr(passKps[k], passDescs[k], Hback, imgPts, objPts, corrFromBackbone, corrPoint);
+        }
+
+        // Plane-guided rectification (perspective robustness for oblique views). The marks lie on a
+        // known plane and VIO gives a pose, so the oblique-vs-frontal distortion is a homography we can
+        // pre-cancel: warp the live frame into the fingerprint's frontal frame, match, and ADD the
+        // correspondences mapped back to the current image (RANSAC filters any that don't fit).
+        if (!grayRect.empty()) {
             size_t before = imgPts.size();
-            buildCorr(grayRect, Hcur_fp, imgPts, objPts, corrFromBackbone);
+            buildCorr(passKps[kPassRect], passDescs[kPassRect], Hcur_fp, imgPts, objPts, corrFromBackbone, corrPoint);
             mLastRelocRectifiedCorr.store((int)(imgPts.size() - before), std::memory_order_relaxed);
             if (imgPts.size() > before)
                 LOGI("Reloc: rectified (obliquity %.0f deg) added %zu corr (total %zu)",
                      obliqDeg, imgPts.size() - before, imgPts.size());
         }
+    };
+    matchWall();
+    if (guided && imgPts.size() < kHeadPriorMinCorr) {
+        LOGI("Reloc: head prior gave only %zu corr; rematching unguided", imgPts.size());
+        imgPts.clear(); objPts.clear(); corrFromBackbone.clear(); corrPoint.clear();
+        guided = false;
+        matchWall();
+    } else if (guided) {
+        LOGI("Reloc: head prior (tilt %.0f deg) guided %zu corr", priorTilt, imgPts.size());
     }
 
     // --- Persistent feature-map matching (Phase 2b; default OFF via mMapRelocEnabled) ---
@@ -385,50 +654,100 @@ void MobileGS::runRelocPass(const cv::Mat& frame, const float* relocView) {
     // APPEND the correspondences (same fingerprint frame + intrinsics) so PnP solves over both.
     // Requires a prior pose (mapPriorSeq>0, i.e. the fingerprint has locked at least once) and a
     // matching descriptor type. Default-off, so this is inert until device-validated.
-    if (mMapRelocEnabled.load(std::memory_order_relaxed) && !mapDescs.empty() && mapPriorSeq > 0
-            && mapDescs.type() == wallDescs.type() && mapKps3d.size() == (size_t)mapDescs.rows) {
-        glm::mat4 camFromFp = glm::make_mat4(mapPriorPose);
-        double gfx = (fpIntrinsics[0] > 0.f) ? (double)fpIntrinsics[0] : 1000.0;
-        double gfy = (fpIntrinsics[1] > 0.f) ? (double)fpIntrinsics[1] : 1000.0;
-        double gcx = (fpIntrinsics[0] > 0.f) ? (double)fpIntrinsics[2] : gray.cols * 0.5;
-        double gcy = (fpIntrinsics[1] > 0.f) ? (double)fpIntrinsics[3] : gray.rows * 0.5;
-        std::vector<int> visible;
-        visible.reserve(mapKps3d.size());
-        for (int i = 0; i < (int)mapKps3d.size(); ++i) {
-            glm::vec4 pc = camFromFp * glm::vec4(mapKps3d[i].x, mapKps3d[i].y, mapKps3d[i].z, 1.0f);
-            if (pc.z <= 0.05f) continue; // behind / too close to the camera
-            float u = (float)(gfx * pc.x / pc.z + gcx);
-            float v = (float)(gfy * pc.y / pc.z + gcy);
-            if (u >= 0.f && u < gray.cols && v >= 0.f && v < gray.rows) visible.push_back(i);
-        }
-        if (visible.size() >= 8) {
-            // Preallocate the gated descriptor block with the right size+type and copy rows
-            // (cv::Mat has no usable reserve() on an empty/typeless matrix). Reuse the base detection.
-            cv::Mat gatedDescs((int)visible.size(), mapDescs.cols, mapDescs.type());
-            for (size_t i = 0; i < visible.size(); ++i)
-                mapDescs.row(visible[i]).copyTo(gatedDescs.row((int)i));
-            if (!baseDescs.empty() && baseDescs.type() == gatedDescs.type()) {
-                cv::Ptr<cv::DescriptorMatcher>& matcher = (baseDescs.type() == CV_32F) ? mL2Matcher : mMatcher;
-                std::vector<std::vector<cv::DMatch>> matches;
-                matcher->knnMatch(baseDescs, gatedDescs, matches, 2);
-                size_t before = imgPts.size();
-                for (auto& m : matches) {
-                    if (m.size() < 2) continue;
-                    if (m[0].distance < kRelocLoweRatio * m[1].distance) {
-                        imgPts.push_back(baseKps[m[0].queryIdx].pt);
-                        objPts.push_back(mapKps3d[visible[m[0].trainIdx]]);
-                        // NOT backbone: the persistent map is a separate point set that Φ has
-                        // never classified, so counting it in F_out would report a backbone the
-                        // partition never vouched for — and mask an empty F_out on exactly the
-                        // configuration (large overlay, marks off-frame) the map exists for.
-                        corrFromBackbone.push_back(0);
-                    }
+    // Gated in the snapshot above (gateMapToFrustum); what reaches here is only the visible subset,
+    // matched by index straight out of the shared descriptor header with no gated-row copy.
+    //
+    // Keyframes: with no prior, or a gate that found too little to match, the points of the
+    // keyframes whose global descriptors best resemble this frame are taken instead. Resolved under
+    // a second, short lock because the frame's descriptors did not exist at snapshot time; refused if
+    // the map has changed since mapDescs was viewed, as the IDs would resolve to other rows.
+    if (mapKeyframes && !mapDescs.empty() && mapVisible.size() < 8 && !baseDescs.empty()) {
+        const cv::Mat global = KeyframeGraph::globalDescriptor(baseDescs);
+        std::vector<uint32_t> ids;
+        mapVisible.clear();
+        mapKps3d.clear();
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            if (mMapDescGen == mapGen) {
+                mKeyframes.retrieve(global, kKfRetrieve, kKfNeighbours, ids);
+                for (uint32_t id : ids) {
+                    auto it = mMapIdToIndex.find(id);
+                    if (it != mMapIdToIndex.end() && it->second < mapDescs.rows) mapVisible.push_back(it->second);
+                }
+                std::sort(mapVisible.begin(), mapVisible.end());   // stable match order, as the gate's
+                mapKps3d.reserve(mapVisible.size());
+                for (int i : mapVisible) mapKps3d.push_back(mMapPoints3D[(size_t)i]);
+            }
+        }
+        if (!mapVisible.empty())
+            LOGI("Reloc map: %s, %zu pts from keyframes", mapPriorSeq > 0 ? "gate empty" : "no prior",
+                 mapVisible.size());
+    }
+    // Bag-of-words, cold attempts only: when neither the gate nor the keyframes supplied enough, the
+    // map points sharing the most (idf-weighted) words with this frame are matched instead. Common
+    // words (inverted lists over kBowStopWordList) don't vote. Same second-lock rule as above.
+    if (mapVocab && !mapDescs.empty() && mapVisible.size() < 8 && mapVocab->compatible(baseDescs)) {
+        std::vector<uint32_t> words, nodes;
+        mapVocab->quantize(baseDescs, words, nodes);
+        mapVisible.clear();
+        mapKps3d.clear();
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            if (mMapDescGen == mapGen && mMapBowVocab == mapVocab) {
+                std::unordered_map<uint32_t, float> votes;
+                for (uint32_t w : words) {
+                    const auto* list = mMapBow.wordEntities(w);
+                    if (!list || list->size() > kBowStopWordList) continue;
+                    const float idf = mapVocab->idf(w);
+                    for (uint32_t id : *list) votes[id] += idf;
+                }
+                std::vector<std::pair<float, uint32_t>> ranked;
+                ranked.reserve(votes.size());
+                for (const auto& v : votes) ranked.emplace_back(v.second, v.first);
+                const size_t top = std::min(ranked.size(), kBowMaxMapCandidates);
+                std::partial_sort(ranked.begin(), ranked.begin() + top, ranked.end(),
+                                  [](const std::pair<float, uint32_t>& a, const std::pair<float, uint32_t>& b) {
+                                      return a.first > b.first;
+                                  });
+                for (size_t i = 0; i < top; ++i) {
+                    auto it = mMapIdToIndex.find(ranked[i].second);
+                    if (it != mMapIdToIndex.end() && it->second < mapDescs.rows) mapVisible.push_back(it->second);
                 }
-                if (imgPts.size() > before)
-                    LOGI("Reloc map: gated %zu/%zu pts, added %zu corr (total %zu)",
-                         visible.size(), mapKps3d.size(), imgPts.size() - before, imgPts.size());
+                std::sort(mapVisible.begin(), mapVisible.end());
+                mapKps3d.reserve(mapVisible.size());
+                for (int i : mapVisible) mapKps3d.push_back(mMapPoints3D[(size_t)i]);
             }
         }
+        if (!mapVisible.empty())
+            LOGI("Reloc map: cold, %zu pts from bag-of-words votes", mapVisible.size());
+    }
+    if (mapVisible.size() >= 8 && mapDescs.type() == wallDescs.type()
+            && !baseQuery.empty() && baseQuery.type() == mapDescs.type() && baseQuery.cols == mapDescs.cols) {
+        size_t before = imgPts.size();
+        // The visible rows gathered into one contiguous block for the matcher's batched (SIMD)
+        // distance kernel. Matching by index in place saved this copy but paid Q x V scalar row
+        // distances instead, which at a full gate (thousands of points, 256-float SuperPoint) is
+        // far the larger cost; the copy is V rows, once per pass.
+        cv::Mat gated((int)mapVisible.size(), mapDescs.cols, mapDescs.type());
+        for (size_t j = 0; j < mapVisible.size(); ++j) mapDescs.row(mapVisible[j]).copyTo(gated.row((int)j));
+        cv::Ptr<cv::DescriptorMatcher>& matcher = (baseQuery.type() == CV_32F) ? mL2Matcher : mMatcher;
+        std::vector<std::vector<cv::DMatch>> mapMatches;
+        matcher->knnMatch(baseQuery, gated, mapMatches, 2);
+        for (const auto& match : mapMatches) {
+            if (match.size() < 2 || !(match[0].distance < kRelocLoweRatio * match[1].distance)) continue;
+            const int q = match[0].queryIdx, bestJ = match[0].trainIdx;
+            imgPts.push_back(baseKps[(size_t)q].pt);
+            objPts.push_back(mapKps3d[(size_t)bestJ]);
+            // NOT backbone: the persistent map is a separate point set that Φ has
+            // never classified, so counting it in F_out would report a backbone the
+            // partition never vouched for — and mask an empty F_out on exactly the
+            // configuration (large overlay, marks off-frame) the map exists for.
+            corrFromBackbone.push_back(0);
+            corrPoint.push_back(-(mapVisible[(size_t)bestJ] + 1));
+        }
+        if (imgPts.size() > before)
+            LOGI("Reloc map: gated %zu/%zu pts, added %zu corr (total %zu)",
+                 mapVisible.size(), mapTotal, imgPts.size() - before, imgPts.size());
     }
 
     // Distortion head (optional, docs/DISTORTION_HEAD.md): when the model + canonical patch are
@@ -436,40 +755,23 @@ void MobileGS::runRelocPass(const cv::Mat& frame, const float* relocView) {
     // fingerprint patch -> matchability (relock confidence) + coverage (= painting-progress). The
     // corners/H -> IPPE prior is a later increment; here we consume the cheap signals. Inert unless
     // the distortion_head.onnx asset is bundled. Uses RAW gray (the head's SuperPoint expects it).
-    if (mDistortionHead.isLoaded() && !wallPatch.empty() && !imgPts.empty()) {
-        float cxs = 0, cys = 0;
-        for (const auto& p : imgPts) { cxs += p.x; cys += p.y; }
-        cxs /= (float)imgPts.size(); cys /= (float)imgPts.size();
-        cv::Mat headGray;
-        cv::cvtColor(workFrame, headGray, cv::COLOR_RGB2GRAY);
-        int side = std::min(headGray.cols, headGray.rows);
-        int x0 = std::max(0, std::min((int)cxs - side / 2, headGray.cols - side));
-        int y0 = std::max(0, std::min((int)cys - side / 2, headGray.rows - side));
-        cv::Mat crop = headGray(cv::Rect(x0, y0, side, side)).clone();
-        std::array<float, 13> dist{};
-        if (mDistortionHead.run(crop, wallPatch, dist)) {
-            const float matchability = dist[11], coverage = dist[12];
-            if (matchability > 0.5f) {
-                // A trusted look at the wall: it measures BOTH channels, and they are different
-                // quantities. Coverage says how much of the design is realized (progress);
-                // matchability says how much to trust this frame (confidence).
-                mPaintingProgress.store(coverage, std::memory_order_relaxed);
-                mCorroborationConfidence.store(matchability, std::memory_order_relaxed);
-            } else {
-                // The head looked and did not recognize the wall. That is a statement about THIS
-                // FRAME, not about the mural, so only confidence decays. Decaying progress here
-                // is what made a three-frame glitch read as the mural being un-painted.
-                decayCorroboration();
-            }
-            LOGI("DistortionHead: match %.2f coverage %.2f tilt %.0f log2scale %.2f",
-                 matchability, coverage, dist[8], dist[9]);
-        } else {
-            decayCorroboration();   // head refused to run — no information either way
+    // With a head rate set, only the crop is cut here and the forward runs on mHeadThread.
+    if (mDistortionHead.isLoaded()) {
+        cv::Mat crop;
+        cv::Rect cropRect;
+        if (mDistortionHead.hasFingerprint() && !imgPts.empty()) {
+            float cxs = 0, cys = 0;
+            for (const auto& p : imgPts) { cxs += p.x; cys += p.y; }
+            cxs /= (float)imgPts.size(); cys /= (float)imgPts.size();
+            const cv::Mat& headGray = rawGray;
+            int side = std::min(headGray.cols, headGray.rows);
+            int x0 = std::max(0, std::min((int)cxs - side / 2, headGray.cols - side));
+            int y0 = std::max(0, std::min((int)cys - side / 2, headGray.rows - side));
+            cropRect = cv::Rect(x0, y0, side, side);
+            crop = headGray(cropRect).clone();
         }
-    } else if (mDistortionHead.isLoaded()) {
-        // Head is loaded but there was no patch or no correspondences to centre the crop on, so
-        // no attempt happened at all. Still a confidence statement, never a progress one.
-        decayCorroboration();
+        if (mHeadRateHz.load(std::memory_order_relaxed) > 0.0f) postDistortionHeadJob(std::move(crop), cropRect, passSeq, headEpoch);
+        else applyDistortionHead(crop, cropRect, passSeq, headEpoch);
     }
 
     // Lowered floors so a close-up PARTIAL view (only a corner of the marks visible) can still
@@ -491,14 +793,14 @@ void MobileGS::runRelocPass(const cv::Mat& frame, const float* relocView) {
             ? (int)std::count(corrFromBackbone.begin(), corrFromBackbone.end(), (uint8_t)1)
             : -1,
         std::memory_order_relaxed);
-    if (imgPts.size() < 8) {
+    if (imgPts.size() < kRelocMinCorr) {
         // Distinguish "the detector found nothing / the descriptors don't even compare" from
         // "features were found but too few agreed with the fingerprint" — they call for opposite
         // fixes (light/focus/texture vs. aim at the registered area).
         mLastRelocReject.store(baseDescs.empty() ? kRelocNoFeatures : kRelocFewMatches,
                                std::memory_order_relaxed);
     }
-    if (imgPts.size() >= 8) {
+    if (imgPts.size() >= kRelocMinCorr) {
         cv::Mat rvec, tvec;
         std::vector<int> inliers;
         // Camera matrix: reuse the intrinsics the fingerprint's 3D points were built with (keeps
@@ -602,9 +904,34 @@ void MobileGS::runRelocPass(const cv::Mat& frame, const float* relocView) {
                 mPnpResultSeq.fetch_add(1, std::memory_order_relaxed);
                 mLastRelocReject.store(kRelocOk, std::memory_order_relaxed);
                 LOGI("Relocalization: PnP match published (%zu/%zu inliers)", inliers.size(), imgPts.size());
+                // Point refinement: this lock becomes a pose in the refiner's ring and its inliers
+                // observations of the points they matched. Map indices are only trusted if the map
+                // is still the one mapDescs was viewed from; wall rows unless the wall was replaced.
+                uint32_t refinePose = 0;
+                bool refineDue = false;
+                if (mPointRefinementEnabled.load(std::memory_order_relaxed) && corrPoint.size() == imgPts.size()) {
+                    std::lock_guard<std::mutex> lock(mMutex);
+                    if (mRefineEpoch == refineEpoch) {
+                        refinePose = mRefiner.addPose(glm::value_ptr(pnpMat), fx, fy, cx, cy);
+                        const bool mapFresh = !mapDescs.empty() && mMapDescGen == mapGen;
+                        for (int idx : inliers) {
+                            const int k = corrPoint[(size_t)idx];
+                            const cv::Point2f& px = imgPts[(size_t)idx];
+                            if (k >= 0) {
+                                mRefiner.observe(BundleRefiner::key(BundleRefiner::kWall, (uint32_t)k), refinePose,
+                                                 px.x, px.y);
+                            } else if (mapFresh && (size_t)(-k - 1) < mMapIds.size()) {
+                                mRefiner.observe(BundleRefiner::key(BundleRefiner::kMap, mMapIds[(size_t)(-k - 1)]),
+                                                 refinePose, px.x, px.y);
+                            }
+                        }
+                        refineDue = mRefiner.posesSinceSolve() >= kRefineEveryPoses;
+                    }
+                }
+                if (refineDue) requestRefinement();
                 // Phase 3 passive build: grow the feature map from this locked frame (default OFF).
                 if (mMapBuildEnabled.load(std::memory_order_relaxed))
-                    growMapFromReloc(pnpMat, baseKps, baseDescs, fx, fy, cx, cy);
+                    growMapFromReloc(pnpMat, baseKps, baseDescs, fx, fy, cx, cy, refinePose);
             }
         }
     }
@@ -649,28 +976,21 @@ bool MobileGS::computeRectifyHomography(const float* viewCur16, cv::Mat& Hcur_fp
     glm::mat4 viewCur = glm::make_mat4(viewCur16);
     glm::mat4 viewFp;
     double fx, fy, cx, cy;
-    std::vector<cv::Point3f> pts;
+    WallPlane plane;
     {
         std::lock_guard<std::mutex> lock(mMutex);
         if (!mHasFingerprintView) return false;
         viewFp = glm::make_mat4(mFingerprintViewMatrix);
         fx = mFingerprintIntrinsics[0]; fy = mFingerprintIntrinsics[1];
         cx = mFingerprintIntrinsics[2]; cy = mFingerprintIntrinsics[3];
-        pts = mWallKeypoints3D;
+        plane = mWallPlane.plane();
     }
-    if (pts.size() < 12 || fx <= 0.0 || fy <= 0.0) return false;
+    if (plane.count < 12 || !plane.valid || fx <= 0.0 || fy <= 0.0) return false;
 
-    // Fit a plane to the fingerprint-frame 3D marks: centroid + normal (smallest-variance PCA axis).
-    cv::Mat data((int)pts.size(), 3, CV_32F);
-    for (int i = 0; i < (int)pts.size(); ++i) {
-        data.at<float>(i,0) = pts[i].x; data.at<float>(i,1) = pts[i].y; data.at<float>(i,2) = pts[i].z;
-    }
-    cv::PCA pca(data, cv::Mat(), cv::PCA::DATA_AS_ROW);
-    cv::Vec3d n(pca.eigenvectors.at<float>(2,0), pca.eigenvectors.at<float>(2,1), pca.eigenvectors.at<float>(2,2));
-    cv::Vec3d c(pca.mean.at<float>(0,0), pca.mean.at<float>(0,1), pca.mean.at<float>(0,2));
-    double nn = cv::norm(n); if (nn < 1e-6) return false; n /= nn;
-    double d = n.dot(c);
-    if (d < 0) { n = -n; d = -d; }              // plane n·X = d with d > 0 (in front of the fp camera)
+    // Plane of the fingerprint-frame 3D marks (n·X = d, d > 0: in front of the fp camera), from the
+    // incrementally maintained fit rather than a PCA over a copy of every mark per pass.
+    const cv::Vec3d n = plane.normal;
+    const double d = plane.offset;
     if (d < 1e-3) return false;
 
     // Relative pose fp-camera -> current-camera (both share the VIO world while tracking):
@@ -704,11 +1024,207 @@ bool MobileGS::computeRectifyHomography(const float* viewCur16, cv::Mat& Hcur_fp
     return true;
 }
 
+void MobileGS::swapRemoveMapPoint(size_t i) {
+    if (i >= mMapPoints3D.size()) return;
+    if (mJournalRecording) mJournalPending.map.push_back({WallJournal::kMapRemove, (uint32_t)i, {}, 0.f, 0});
+    const size_t last = mMapPoints3D.size() - 1;
+    if (i != last) {
+        mMapPoints3D[i] = mMapPoints3D[last];
+        mMapConfidence[i] = mMapConfidence[last];
+        mMapObs[i] = mMapObs[last];
+        mMapLastSeen[i] = mMapLastSeen[last];
+    }
+    mMapPoints3D.pop_back(); mMapConfidence.pop_back(); mMapObs.pop_back(); mMapLastSeen.pop_back();
+    mMapDescriptors.swapRemove((int)i);
+    if (i < mMapIds.size()) {
+        mMapIdToIndex.erase(mMapIds[i]);
+        mKeyframes.forgetPoint(mMapIds[i]);
+        mMapBow.remove(mMapIds[i]);
+        mRefiner.forget(BundleRefiner::key(BundleRefiner::kMap, mMapIds[i]));
+        if (i != last && last < mMapIds.size()) {
+            mMapIds[i] = mMapIds[last];
+            mMapIdToIndex[mMapIds[i]] = (int)i;
+        }
+        mMapIds.pop_back();
+    }
+}
+
+void MobileGS::reassignMapIds() {
+    // IDs keep counting up across reassignments, so no stale ID held anywhere can ever resolve —
+    // nor a journal's marks, which is why the journal stops here: only a replacement or a
+    // misaligned map renumbers, and neither is a change the journal can describe.
+    dropJournalLocked("map renumbered");
+    mMapIds.resize(mMapPoints3D.size());
+    mMapIdToIndex.clear();
+    mMapIdToIndex.reserve(mMapIds.size());
+    for (size_t i = 0; i < mMapIds.size(); ++i) {
+        mMapIds[i] = mNextMapId++;
+        mMapIdToIndex[mMapIds[i]] = (int)i;
+    }
+    reindexMapBow();   // keyed by the IDs just replaced
+}
+
+std::shared_ptr<const VocabularyTree> MobileGS::vocabFor(int descType) const {
+    if (descType == CV_32F) return mVocabFloat;
+    if (descType == CV_8U) return mVocabBinary;
+    return nullptr;
+}
+
+void MobileGS::reindexWallBow() {
+    mWallBow.clear();
+    mWallBowVocab.reset();
+    const auto vocab = vocabFor(mWallDescriptors.type());
+    if (!vocab || !vocab->compatible(mWallDescriptors.view())) return;
+    mWallBowVocab = vocab;
+    indexWallRows(0);
+}
+
+void MobileGS::indexWallRows(int from) {
+    if (!mWallBowVocab || from >= mWallDescriptors.rows()) return;
+    const cv::Mat rows = mWallDescriptors.view().rowRange(from, mWallDescriptors.rows());
+    std::vector<uint32_t> words, nodes;
+    mWallBowVocab->quantize(rows, words, nodes);
+    for (size_t r = 0; r < words.size(); ++r) mWallBow.add((uint32_t)from + (uint32_t)r, words[r], nodes[r]);
+}
+
+void MobileGS::resetRefinement() {
+    mRefiner.clear();
+    mWallFixedRows = mWallKeypoints3D.size();
+    ++mRefineEpoch;
+}
+
+void MobileGS::restartWallSync() {
+    // Random rather than counted from zero, so two devices that each start a wall never name the
+    // same one: a peer that asks for epoch E gets a delta only if E is this very wall.
+    static std::mt19937_64 rng{std::random_device{}()};
+    do mWallSyncEpoch = rng(); while (mWallSyncEpoch == 0);
+    mWallSyncGen = 1;
+    mWallRowAddGen.assign(mWallKeypoints3D.size(), mWallSyncGen);
+    mWallRowMoveGen.assign(mWallKeypoints3D.size(), 0);
+    mPeer.rowMap.clear();
+}
+
+void MobileGS::noteWallAppended() {
+    ++mWallSyncGen;
+    mWallRowAddGen.resize(mWallKeypoints3D.size(), mWallSyncGen);
+    mWallRowMoveGen.resize(mWallKeypoints3D.size(), 0);
+}
+
+void MobileGS::requestRefinement() {
+    std::lock_guard<std::mutex> lock(mRefineMutex);
+    mRefineRequested = true;
+    if (!mRefineThread.joinable()) mRefineThread = std::thread(&MobileGS::refineThreadFunc, this);
+    mRefineCv.notify_one();
+}
+
+void MobileGS::refineThreadFunc() {
+    // The map worker's niceness: refinement is never on the pose's path.
+    setpriority(PRIO_PROCESS, 0, 15);
+    for (;;) {
+        {
+            std::unique_lock<std::mutex> lock(mRefineMutex);
+            mRefineCv.wait(lock, [this] { return mRefineRequested || !mRelocRunning; });
+            if (!mRelocRunning) return;
+            mRefineRequested = false;
+        }
+        refinePoints();
+    }
+}
+
+/**
+ * One refinement round: snapshot the tracks seen from enough recent poses under mMutex, bundle-adjust
+ * them with no lock held, and write back only what is still the point the snapshot read (same epoch,
+ * same position). Moved points leave the hashes and the wall plane stale, so those are rebuilt once.
+ */
+void MobileGS::refinePoints() {
+    BundleRefiner::Problem prob;
+    uint64_t epoch;
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        epoch = mRefineEpoch;
+        mRefiner.snapshot(prob, kRefineMinViews, [this](uint64_t k, cv::Point3f& X, bool& fixed) {
+            const uint32_t id = BundleRefiner::idOf(k);
+            if (BundleRefiner::kindOf(k) == BundleRefiner::kWall) {
+                if (id >= mWallKeypoints3D.size()) return false;
+                X = mWallKeypoints3D[id];
+                fixed = id < mWallFixedRows;
+                return true;
+            }
+            auto it = mMapIdToIndex.find(id);
+            if (it == mMapIdToIndex.end() || (size_t)it->second >= mMapPoints3D.size()) return false;
+            X = mMapPoints3D[(size_t)it->second];
+            fixed = false;
+            return true;
+        });
+    }
+    if (std::find(prob.fixed.begin(), prob.fixed.end(), 0) == prob.fixed.end()) return;   // nothing free
+
+    const std::vector<cv::Point3f> before = prob.pts;
+    double rms0 = 0.0, rms1 = 0.0;
+    BundleRefiner::solve(prob, kRefineIters, kRefineHuberPx, rms0, rms1);
+    if (!(rms1 < rms0)) {
+        LOGI("Refine: no improvement (%.2f -> %.2f px), nothing written", rms0, rms1);
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(mMutex);
+    if (mRefineEpoch != epoch) return;   // the wall was replaced or swapped mid-solve
+    int wallMoved = 0, mapMoved = 0, rejected = 0;
+    const uint64_t moveGen = mWallSyncGen + 1;   // taken only if a wall point actually moves
+    for (size_t i = 0; i < prob.pts.size(); ++i) {
+        if (prob.fixed[i]) continue;
+        const cv::Point3f d = prob.pts[i] - before[i];
+        const float shift = std::sqrt(d.dot(d));
+        if (shift == 0.f) continue;
+        if (!(shift <= kRefineMaxShiftM)) { ++rejected; continue; }
+        const uint32_t id = BundleRefiner::idOf(prob.keys[i]);
+        cv::Point3f* X = nullptr;
+        if (BundleRefiner::kindOf(prob.keys[i]) == BundleRefiner::kWall) {
+            if (id < mWallKeypoints3D.size()) X = &mWallKeypoints3D[id];
+        } else {
+            auto it = mMapIdToIndex.find(id);
+            if (it != mMapIdToIndex.end() && (size_t)it->second < mMapPoints3D.size()) X = &mMapPoints3D[(size_t)it->second];
+        }
+        if (!X || *X != before[i]) continue;
+        *X = prob.pts[i];
+        if (BundleRefiner::kindOf(prob.keys[i]) == BundleRefiner::kWall) {
+            ++wallMoved;
+            if (id < mWallRowMoveGen.size()) mWallRowMoveGen[id] = moveGen;
+        } else {
+            ++mapMoved;
+            if (mJournalRecording) mJournalDirty.insert(id);
+        }
+    }
+    if (wallMoved > 0) {
+        mWallSyncGen = moveGen;
+        mWallIndex.rebuild(mWallKeypoints3D);
+        mWallPlane.rebuild(mWallKeypoints3D);
+    }
+    if (mapMoved > 0) {
+        mMapIndex.rebuild(mMapPoints3D);
+        mMapDedup.rebuild(mMapPoints3D);
+    }
+    LOGI("Refine: %zu pts over %zu poses, rms %.2f -> %.2f px; moved %d wall / %d map (%d rejected)",
+         prob.pts.size(), prob.poses.size(), rms0, rms1, wallMoved, mapMoved, rejected);
+}
+
+void MobileGS::reindexMapBow() {
+    mMapBow.clear();
+    mMapBowVocab.reset();
+    const auto vocab = vocabFor(mMapDescriptors.type());
+    const cv::Mat dm = mMapDescriptors.view();
+    if (!vocab || !vocab->compatible(dm) || mMapIds.size() != (size_t)dm.rows) return;
+    mMapBowVocab = vocab;
+    std::vector<uint32_t> words, nodes;
+    vocab->quantize(dm, words, nodes);
+    for (size_t i = 0; i < words.size(); ++i) mMapBow.add(mMapIds[i], words[i], nodes[i]);
+}
+
 std::vector<uint8_t> MobileGS::exportWallFeatureMap() const {
     std::lock_guard<std::mutex> lock(mMutex);
     if (mMapPoints3D.empty() || mMapDescriptors.empty() ||
-        mMapPoints3D.size() != (size_t)mMapDescriptors.rows) return {};  // never export an inconsistent map
-    cv::Mat dm = mMapDescriptors.isContinuous() ? mMapDescriptors : mMapDescriptors.clone();
+        mMapPoints3D.size() != (size_t)mMapDescriptors.rows()) return {};  // never export an inconsistent map
+    const cv::Mat dm = mMapDescriptors.view();   // always continuous
     const int32_t n = (int32_t)mMapPoints3D.size();
     const int32_t descRows = dm.rows, descCols = dm.cols, descType = dm.type();
     std::vector<float> conf = mMapConfidence; conf.resize(n, 1.0f);                 // defensive align
@@ -731,85 +1247,186 @@ std::vector<uint8_t> MobileGS::exportWallFeatureMap() const {
     return out;
 }
 
+/**
+ * Map indices the prior pose says are in view of a w x h image. Caller holds mMutex.
+ *
+ * Whole mMapIndex cells are culled first, by their bounding sphere against the frustum's near and
+ * four side planes; only points in surviving cells get the exact projection test the gate has
+ * always applied. On a wall-sized map most cells are off-screen, so the per-pass cost follows what
+ * is visible rather than kMapCap.
+ */
+void MobileGS::gateMapToFrustum(const float* camFromFp16, int w, int h, std::vector<int>& out) const {
+    out.clear();
+    const glm::mat4 camFromFp = glm::make_mat4(camFromFp16);
+    const double gfx = (mFingerprintIntrinsics[0] > 0.f) ? (double)mFingerprintIntrinsics[0] : 1000.0;
+    const double gfy = (mFingerprintIntrinsics[1] > 0.f) ? (double)mFingerprintIntrinsics[1] : 1000.0;
+    const double gcx = (mFingerprintIntrinsics[0] > 0.f) ? (double)mFingerprintIntrinsics[2] : w * 0.5;
+    const double gcy = (mFingerprintIntrinsics[1] > 0.f) ? (double)mFingerprintIntrinsics[3] : h * 0.5;
+    constexpr float kNear = 0.05f;   // behind / too close to the camera
+    // Side planes through the optical centre, as x <= xr*z etc.; each normalized so a sphere's
+    // centre distance can be compared with its radius directly.
+    const float xr = (float)((w - gcx) / gfx), xl = (float)(gcx / gfx);
+    const float yb = (float)((h - gcy) / gfy), yt = (float)(gcy / gfy);
+    const float nxr = 1.0f / std::sqrt(1.0f + xr * xr), nxl = 1.0f / std::sqrt(1.0f + xl * xl);
+    const float nyb = 1.0f / std::sqrt(1.0f + yb * yb), nyt = 1.0f / std::sqrt(1.0f + yt * yt);
+    mMapIndex.forEachCell([&](const cv::Point3f& c, float r, const std::vector<int>& idx) {
+        const glm::vec4 pc = camFromFp * glm::vec4(c.x, c.y, c.z, 1.0f);
+        if (pc.z + r <= kNear) return;
+        if ((pc.x - xr * pc.z) * nxr > r || (-pc.x - xl * pc.z) * nxl > r) return;
+        if ((pc.y - yb * pc.z) * nyb > r || (-pc.y - yt * pc.z) * nyt > r) return;
+        for (int i : idx) {
+            const cv::Point3f& P = mMapPoints3D[(size_t)i];
+            const glm::vec4 pp = camFromFp * glm::vec4(P.x, P.y, P.z, 1.0f);
+            if (pp.z <= kNear) continue;
+            const float u = (float)(gfx * pp.x / pp.z + gcx);
+            const float v = (float)(gfy * pp.y / pp.z + gcy);
+            if (u >= 0.f && u < w && v >= 0.f && v < h) out.push_back(i);
+        }
+    });
+    // Cells come out in hash order; sorted so the match order (and so RANSAC's input) is stable.
+    std::sort(out.begin(), out.end());
+}
+
 void MobileGS::growMapFromReloc(const glm::mat4& camFromFp, const std::vector<cv::KeyPoint>& kps,
-                                const cv::Mat& descs, double fx, double fy, double cx, double cy) {
+                                const cv::Mat& descs, double fx, double fy, double cx, double cy,
+                                uint32_t refinePose) {
     if (descs.empty() || kps.empty() || (int)kps.size() != descs.rows) return;
-    std::lock_guard<std::mutex> lock(mMutex);
-    if (mWallKeypoints3D.size() < 8) return;                                   // need the fingerprint plane
-    if (!mMapDescriptors.empty() && mMapDescriptors.type() != descs.type()) return;
-    if (mMapPoints3D.size() != (size_t)mMapDescriptors.rows) return;  // corrupted map: bail rather than crash
-
-    // Keep the parallel arrays aligned with the points: a restored map may have carried points +
-    // descriptors but empty confidence/obs (both optional in WallFeatureMap). Without this, the add
-    // path below would desync them from mMapPoints3D and corrupt per-point confidence.
-    if (mMapConfidence.size() != mMapPoints3D.size()) mMapConfidence.resize(mMapPoints3D.size(), 1.0f);
-    if (mMapObs.size() != mMapPoints3D.size()) mMapObs.resize(mMapPoints3D.size(), 1);
+    if (!mMapWorkerEnabled.load(std::memory_order_relaxed)) {
+        maintainMap(camFromFp, kps, descs, fx, fy, cx, cy, refinePose);
+        return;
+    }
+    std::lock_guard<std::mutex> lock(mMapJobMutex);
+    if (mMapJobs.size() >= kMapJobQueueMax) mMapJobs.pop_front();   // newest evidence wins
+    mMapJobs.push_back(MapGrowJob{camFromFp, kps, descs.clone(), fx, fy, cx, cy, refinePose});
+    if (!mMapThread.joinable()) mMapThread = std::thread(&MobileGS::mapThreadFunc, this);
+    mMapJobCv.notify_one();
+}
 
-    // Confidence-prune when at capacity so the map keeps refreshing within the cap (drop points that
-    // never earned a re-observation). Compacts all four parallel arrays + the descriptor matrix.
-    const size_t kMapCap = 5000;
-    if (mMapPoints3D.size() >= kMapCap) {
-        std::vector<size_t> kept;
-        kept.reserve(mMapPoints3D.size());
-        for (size_t i = 0; i < mMapPoints3D.size(); ++i)
-            if (mMapConfidence[i] >= 0.2f) kept.push_back(i);
-        std::vector<cv::Point3f> np; np.reserve(kept.size());
-        std::vector<float> nc; nc.reserve(kept.size());
-        std::vector<int> no; no.reserve(kept.size());
-        cv::Mat nd;
-        if (!kept.empty()) {
-            nd.create((int)kept.size(), mMapDescriptors.cols, mMapDescriptors.type());
-            for (size_t idx = 0; idx < kept.size(); ++idx) {
-                size_t i = kept[idx];
-                np.push_back(mMapPoints3D[i]); nc.push_back(mMapConfidence[i]); no.push_back(mMapObs[i]);
-                mMapDescriptors.row((int)i).copyTo(nd.row((int)idx));
-            }
+void MobileGS::mapThreadFunc() {
+    // Same niceness as the head worker, below the reloc worker: nothing here is on the pose's path.
+    setpriority(PRIO_PROCESS, 0, 15);
+    for (;;) {
+        MapGrowJob job;
+        {
+            std::unique_lock<std::mutex> lock(mMapJobMutex);
+            mMapJobCv.wait(lock, [this] { return !mMapJobs.empty() || !mRelocRunning; });
+            if (!mRelocRunning) return;
+            job = std::move(mMapJobs.front());
+            mMapJobs.pop_front();
         }
-        mMapPoints3D.swap(np); mMapConfidence.swap(nc); mMapObs.swap(no); mMapDescriptors = nd;
+        maintainMap(job.camFromFp, job.kps, job.descs, job.fx, job.fy, job.cx, job.cy, job.refinePose);
     }
+}
+
+void MobileGS::maintainMap(const glm::mat4& camFromFp, const std::vector<cv::KeyPoint>& kps,
+                           const cv::Mat& descs, double fx, double fy, double cx, double cy,
+                           uint32_t refinePose) {
+    if (descs.empty() || kps.empty() || (int)kps.size() != descs.rows) return;
 
-    // Fit the wall plane (centroid + normal) from the fingerprint's 3D points (in the fingerprint frame).
-    cv::Point3f c(0.f, 0.f, 0.f);
-    for (const auto& p : mWallKeypoints3D) c += p;
-    c *= 1.0f / (float)mWallKeypoints3D.size();
-    double cov[6] = {0,0,0,0,0,0}; // xx,xy,xz,yy,yz,zz
-    for (const auto& p : mWallKeypoints3D) {
-        double dx = p.x - c.x, dy = p.y - c.y, dz = p.z - c.z;
-        cov[0]+=dx*dx; cov[1]+=dx*dy; cov[2]+=dx*dz; cov[3]+=dy*dy; cov[4]+=dy*dz; cov[5]+=dz*dz;
+    // Snapshot: the map's descriptor rows by shared view (the arena never rewrites a viewed row), the
+    // generation they belong to, the wall plane, and which points the fresh pose says are in view.
+    // Everything below up to the commit is lock-free.
+    cv::Mat mapDescs;
+    uint64_t gen;
+    glm::vec3 n, cc;
+    std::vector<int> visible;
+    std::vector<cv::Point3f> visiblePts;   // parallel to visible
+    std::shared_ptr<const VocabularyTree> bowVocab;
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        if (mWallKeypoints3D.size() < 8) return;                                   // need the fingerprint plane
+        if (!mMapDescriptors.empty() && mMapDescriptors.type() != descs.type()) return;
+        if (mMapPoints3D.size() != (size_t)mMapDescriptors.rows()) return;  // corrupted map: bail rather than crash
+        const WallPlane& wp = mWallPlane.plane();
+        if (!wp.valid) return;
+        n = glm::vec3((float)wp.normal[0], (float)wp.normal[1], (float)wp.normal[2]);
+        cc = glm::vec3((float)wp.centroid[0], (float)wp.centroid[1], (float)wp.centroid[2]);
+        mapDescs = mMapDescriptors.view();
+        gen = mMapDescGen;
+        bowVocab = vocabFor(descs.type());
+        if (!mapDescs.empty()) {
+            // The frame's size is not carried with the observation; the principal point is taken as
+            // its centre, the same assumption the gate's own default intrinsics make.
+            gateMapToFrustum(glm::value_ptr(camFromFp), (int)std::ceil(2.0 * cx), (int)std::ceil(2.0 * cy),
+                             visible);
+            visiblePts.reserve(visible.size());
+            for (int i : visible) visiblePts.push_back(mMapPoints3D[(size_t)i]);
+        }
     }
-    cv::Matx33d C(cov[0],cov[1],cov[2], cov[1],cov[3],cov[4], cov[2],cov[4],cov[5]);
-    cv::Vec3d eval; cv::Matx33d evec;
-    if (!cv::eigen(C, eval, evec)) return;
-    glm::vec3 n((float)evec(2,0), (float)evec(2,1), (float)evec(2,2));   // smallest-eigenvalue eigenvector
-    glm::vec3 cc(c.x, c.y, c.z);
 
-    // Associate detected features to the existing map by descriptor; bump confidence on re-observation.
+    // Associate detected features to the existing map. The pose was solved moments ago, so each
+    // in-view map point is asked only about the features within kMapAssocRadiusPx of where that pose
+    // projects it, with the ratio test run over that window — cost follows what is visible, not the
+    // map's size. Asked from the map's side, as the guided wall match does; a feature claimed by one
+    // point is not offered to the next, so that point's window is judged on what is still free.
+    //
+    // Only features inside the circle and unclaimed count as candidates. Two or more are ratio-tested
+    // as usual; a lone one has nothing to take a ratio against and is accepted only under the
+    // absolute kMapAssocLone* gate, or else any keypoint near a projection would re-observe it.
     std::vector<char> matched(kps.size(), 0);
-    if (mMapDescriptors.rows >= 2) {   // knnMatch(k=2) needs >=2 candidates for the Lowe ratio
-        cv::Ptr<cv::DescriptorMatcher>& matcher = (descs.type() == CV_32F) ? mL2Matcher : mMatcher;
+    std::vector<int> reobserved;
+    std::vector<int> reobservedQ;   // parallel: the feature that re-observed it
+    if (!visible.empty()) {
+        KeypointGrid grid;
+        grid.build(kps, kMapAssocRadiusPx);
+        std::vector<int> cand;
+        const float r2 = kMapAssocRadiusPx * kMapAssocRadiusPx;
+        const float loneMax = descs.type() == CV_32F ? kMapAssocLoneMaxL2 : kMapAssocLoneMaxHamming;
+        for (size_t j = 0; j < visible.size(); ++j) {
+            const cv::Point3f& P = visiblePts[j];
+            const glm::vec4 pc = camFromFp * glm::vec4(P.x, P.y, P.z, 1.0f);
+            if (pc.z <= 1e-4f) continue;
+            const float u = (float)(fx * pc.x / pc.z + cx), v = (float)(fy * pc.y / pc.z + cy);
+            grid.candidatesWithin(u, v, kMapAssocRadiusPx, cand);
+            float best = FLT_MAX, second = FLT_MAX;
+            int bestQ = -1;
+            int inCircle = 0;
+            for (int q : cand) {
+                if (matched[(size_t)q]) continue;   // claimed by an earlier point
+                const float du = kps[(size_t)q].pt.x - u, dv = kps[(size_t)q].pt.y - v;
+                if (du * du + dv * dv > r2) continue;   // the grid over-returns; the window is a circle
+                ++inCircle;
+                const float d = descdist::row(descs, q, mapDescs, visible[j]);
+                if (d < best) { second = best; best = d; bestQ = q; }
+                else if (d < second) { second = d; }
+            }
+            if (bestQ < 0) continue;
+            if (inCircle >= 2 ? !(best < kRelocLoweRatio * second) : !(best <= loneMax)) continue;
+            reobserved.push_back(visible[j]);
+            reobservedQ.push_back(bestQ);
+            matched[(size_t)bestQ] = 1;
+        }
+    }
+    // Opt-in global fallback (setMapGlobalAssocEnabled): when the projection found too little — the
+    // map is not where the pose puts it, or the gate saw nothing — the whole map is knnMatched as
+    // before, for the features still unclaimed. A local matcher, not mL2Matcher/mMatcher: on the
+    // worker this runs concurrently with the reloc pass that owns those.
+    if (mMapGlobalAssocEnabled.load(std::memory_order_relaxed) &&
+            reobserved.size() < kMapAssocMinGuided && mapDescs.rows >= 2) {   // knnMatch(k=2) needs >=2
+        cv::BFMatcher matcher(descs.type() == CV_32F ? cv::NORM_L2 : cv::NORM_HAMMING);
         std::vector<std::vector<cv::DMatch>> matches;
-        matcher->knnMatch(descs, mMapDescriptors, matches, 2);
+        matcher.knnMatch(descs, mapDescs, matches, 2);
         for (auto& m : matches) {
             if (m.size() < 2) continue;
             if (m[0].distance < kRelocLoweRatio * m[1].distance) {
                 int ti = m[0].trainIdx, qi = m[0].queryIdx;
-                if (ti >= 0 && ti < (int)mMapConfidence.size() && qi >= 0 && qi < (int)matched.size()) {
-                    mMapConfidence[ti] = std::min(1.0f, mMapConfidence[ti] + 0.1f);
-                    mMapObs[ti] += 1;
-                    matched[qi] = 1;
+                if (ti >= 0 && ti < mapDescs.rows && qi >= 0 && qi < (int)matched.size() && !matched[(size_t)qi]) {
+                    reobserved.push_back(ti);
+                    reobservedQ.push_back(qi);
+                    matched[(size_t)qi] = 1;
                 }
             }
         }
     }
 
-    // Back-project unmatched features onto the wall plane and add them, up to the cap.
+    // Back-project the unmatched features onto the wall plane: the candidate additions.
     glm::mat4 fpFromCam = glm::inverse(camFromFp);
     glm::vec3 camCenter(fpFromCam[3][0], fpFromCam[3][1], fpFromCam[3][2]);
     glm::mat3 R = glm::mat3(fpFromCam);
-    int added = 0;
+    std::vector<cv::Point3f> candPts;
+    std::vector<int> candRows;
     for (size_t i = 0; i < kps.size(); ++i) {
         if (matched[i]) continue;
-        if (mMapPoints3D.size() >= kMapCap) break;
         glm::vec3 dir = R * glm::vec3((float)((kps[i].pt.x - cx) / fx),
                                       (float)((kps[i].pt.y - cy) / fy), 1.0f);
         float denom = glm::dot(n, dir);
@@ -817,17 +1434,137 @@ void MobileGS::growMapFromReloc(const glm::mat4& camFromFp, const std::vector<cv
         float t = glm::dot(n, cc - camCenter) / denom;
         if (t <= 0.f) continue;            // plane intersection behind the camera
         glm::vec3 P = camCenter + t * dir;
-        mMapPoints3D.push_back(cv::Point3f(P.x, P.y, P.z));
+        candPts.emplace_back(P.x, P.y, P.z);
+        candRows.push_back((int)i);
+    }
+
+    const bool keyframes = mMapKeyframesEnabled.load(std::memory_order_relaxed);
+    const cv::Mat global = keyframes ? KeyframeGraph::globalDescriptor(descs) : cv::Mat();
+    // Words for the map's BoW index, quantized here rather than under the lock at commit.
+    std::vector<uint32_t> bowWords, bowNodes;
+    if (bowVocab && !candRows.empty()) bowVocab->quantize(descs, bowWords, bowNodes);
+
+    // Commit, atomically with respect to every other reader of the map.
+    std::lock_guard<std::mutex> lock(mMutex);
+    if (mMapDescGen != gen) {
+        // Restored, cleared or grown by another commit since the snapshot: the row indices above
+        // may name different points now. Dropping one frame's evidence is cheap; misattributing it
+        // is not.
+        LOGI("Map build: snapshot stale, observation dropped");
+        return;
+    }
+    // Keep the parallel arrays aligned with the points: a restored map may have carried points +
+    // descriptors but empty confidence/obs (both optional in WallFeatureMap). Without this, the add
+    // path below would desync them from mMapPoints3D and corrupt per-point confidence.
+    if (mMapConfidence.size() != mMapPoints3D.size()) mMapConfidence.resize(mMapPoints3D.size(), 1.0f);
+    if (mMapObs.size() != mMapPoints3D.size()) mMapObs.resize(mMapPoints3D.size(), 1);
+    if (mMapLastSeen.size() != mMapPoints3D.size()) mMapLastSeen.resize(mMapPoints3D.size(), mMapTick);
+    if (mMapIds.size() != mMapPoints3D.size()) { reassignMapIds(); mKeyframes.clear(); }
+    const uint32_t tick = ++mMapTick;
+    std::vector<int> observed(reobserved);   // every map index this frame saw, for the keyframe
+    // The lock's pose is still in the refiner's ring (and the wall it was solved against still
+    // loaded): this frame's sightings join the observation history.
+    const bool refine = refinePose != 0 && mRefiner.hasPose(refinePose);
+    auto refineObserve = [&](size_t mapIdx, int q) {
+        if (refine) mRefiner.observe(BundleRefiner::key(BundleRefiner::kMap, mMapIds[mapIdx]), refinePose,
+                                     kps[(size_t)q].pt.x, kps[(size_t)q].pt.y);
+    };
+
+    for (size_t r = 0; r < reobserved.size(); ++r) {
+        const int ti = reobserved[r];
+        mMapConfidence[(size_t)ti] = std::min(1.0f, mMapConfidence[(size_t)ti] + 0.1f);
+        mMapObs[(size_t)ti] += 1;
+        mMapLastSeen[(size_t)ti] = tick;
+        journalTouchMap((size_t)ti);
+        refineObserve((size_t)ti, reobservedQ[r]);
+    }
+
+    int added = 0, merged = 0;
+    std::vector<int> near;
+    for (size_t k = 0; k < candPts.size(); ++k) {
+        if (mMapPoints3D.size() >= kMapCap) break;
+        const cv::Point3f& Pm = candPts[k];
+        // Spatial dedup, the same test self-grow applies to the wall: a feature that failed the
+        // descriptor association but lands on an existing map point is a re-observation the ratio
+        // test was too strict to see, not a new point. It is merged into that point — counted as
+        // observed and kept fresh — but earns no confidence, which only a descriptor match gives.
+        mMapDedup.queryBox(Pm, kWallDedupM, near);
+        int dup = -1;
+        for (int j : near) {
+            const cv::Point3f& e = mMapPoints3D[(size_t)j];
+            if (std::abs(e.x-Pm.x) < kWallDedupM && std::abs(e.y-Pm.y) < kWallDedupM &&
+                std::abs(e.z-Pm.z) < kWallDedupM) { dup = j; break; }
+        }
+        if (dup >= 0) {
+            mMapObs[(size_t)dup] += 1;
+            mMapLastSeen[(size_t)dup] = tick;
+            journalTouchMap((size_t)dup);
+            refineObserve((size_t)dup, candRows[k]);
+            observed.push_back(dup);
+            ++merged;
+            continue;
+        }
+        mMapIndex.insert((int)mMapPoints3D.size(), Pm);
+        mMapDedup.insert((int)mMapPoints3D.size(), Pm);
+        mMapPoints3D.push_back(Pm);
         mMapConfidence.push_back(0.1f);
         mMapObs.push_back(1);
-        mMapDescriptors.push_back(descs.row((int)i));
+        mMapLastSeen.push_back(tick);
+        mMapIds.push_back(mNextMapId);
+        mMapIdToIndex[mNextMapId++] = (int)mMapPoints3D.size() - 1;
+        observed.push_back((int)mMapPoints3D.size() - 1);
+        refineObserve(mMapPoints3D.size() - 1, candRows[k]);
+        mMapDescriptors.append(descs.row(candRows[k]));
+        if (mJournalRecording) {
+            mJournalPending.map.push_back({WallJournal::kMapAdd, 0, Pm, 0.1f, 1});
+            mJournalPending.mapAdded.push_back(descs.row(candRows[k]));
+        }
+        if (mMapBowVocab && mMapBowVocab == bowVocab && !bowWords.empty())
+            mMapBow.add(mMapIds.back(), bowWords[(size_t)candRows[k]], bowNodes[(size_t)candRows[k]]);
         ++added;
     }
+    if (added > 0) ++mMapDescGen;
+    // The index was never built (the map was empty until now) or the vocabulary was swapped while
+    // this frame was being associated: build it whole.
+    if (added > 0 && bowVocab && mMapBowVocab != bowVocab) reindexMapBow();
+
+    // A keyframe for this lock, unless one already covers the pose — before the prune below, which
+    // would renumber the indices just collected. Oldest evicted at kMaxKeyframes.
+    if (keyframes && !global.empty() && observed.size() >= kKfMinPoints &&
+            !mKeyframes.hasNearby(glm::value_ptr(camFromFp), kKfMinTranslationM, kKfMinRotationDeg)) {
+        std::vector<uint32_t> ids;
+        ids.reserve(observed.size());
+        for (int i : observed) ids.push_back(mMapIds[(size_t)i]);
+        std::sort(ids.begin(), ids.end());
+        ids.erase(std::unique(ids.begin(), ids.end()), ids.end());
+        mKeyframes.add(glm::value_ptr(camFromFp), global, std::move(ids));
+        if (mKeyframes.size() > kMaxKeyframes) mKeyframes.removeOldest();
+    }
+
+    // Prune at capacity so the map keeps refreshing within the cap: drop points that never earned a
+    // re-observation, and points that have gone unseen for kMapMaxAgeTicks commits without ever
+    // becoming established. Swap-removes across the SoA columns, walking backwards so the point moved
+    // into slot i has already been judged: one row moved per drop, no rebuild.
+    size_t pruned = 0;
+    if (mMapPoints3D.size() >= kMapCap) {
+        for (size_t i = mMapPoints3D.size(); i-- > 0;) {
+            const bool stale = tick - mMapLastSeen[i] > kMapMaxAgeTicks && mMapObs[i] < kMapKeepObs;
+            if (mMapConfidence[i] < 0.2f || stale) { swapRemoveMapPoint(i); ++pruned; }
+        }
+        if (pruned > 0) {
+            ++mMapDescGen;
+            mMapIndex.rebuild(mMapPoints3D);   // swap-removal renumbered the moved survivors
+            mMapDedup.rebuild(mMapPoints3D);
+        }
+    }
 
     // Co-register the map to the fingerprint anchor + intrinsics (same frame as the points above).
     memcpy(mMapAnchorMatrix, mFingerprintAnchorMatrix, 16 * sizeof(float));
     mMapIntrinsics[0]=(float)fx; mMapIntrinsics[1]=(float)fy; mMapIntrinsics[2]=(float)cx; mMapIntrinsics[3]=(float)cy;
-    if (added > 0) LOGI("Map build: +%d pts (map now %zu)", added, mMapPoints3D.size());
+    if (mJournalRecording && mJournalPending.map.size() + mJournalDirty.size() > kJournalMaxPending)
+        dropJournalLocked("nothing appended for too long");
+    if (added > 0 || pruned > 0)
+        LOGI("Map build: +%d pts, %d merged, -%zu pruned (map now %zu)", added, merged, pruned, mMapPoints3D.size());
 }
 
 void MobileGS::tryUpdateFingerprint(const cv::Mat& grayClean,
@@ -1155,7 +1892,7 @@ void MobileGS::tryUpdateFingerprint(const cv::Mat& grayClean,
     // stands — one counts descriptor correspondences, the other counts the PnP's.
     cv::Matx33d R; cv::Vec3d t; double fx, fy, cx, cy; int inliers; int pnpMatches; long seq;
     float spread = kPromotionNotMeasured; bool trusted = false;
-    std::vector<cv::Point3f> wall;
+    WallPlane plane;
     {
         std::lock_guard<std::mutex> lock(mMutex);
         seq = mPnpResultSeq.load(std::memory_order_relaxed);
@@ -1170,7 +1907,7 @@ void MobileGS::tryUpdateFingerprint(const cv::Mat& grayClean,
         t = cv::Vec3d(M[12], M[13], M[14]);
         fx = mFingerprintIntrinsics[0]; fy = mFingerprintIntrinsics[1];
         cx = mFingerprintIntrinsics[2]; cy = mFingerprintIntrinsics[3];
-        wall = mWallKeypoints3D;
+        plane = mWallPlane.plane();
         // 3.2 — read ONCE and reuse, rather than evaluating the same predicate on both sides of the
         // lock as this did before. With a third input that moves per attempt, the reloc thread can
         // rewrite it between the two calls, which opens a window where the seq is claimed and the
@@ -1180,30 +1917,22 @@ void MobileGS::tryUpdateFingerprint(const cv::Mat& grayClean,
         if (trusted) mLastGrowSeq = seq;          // claim it (yield or not)
     }
     if (!trusted || fx <= 0 || fy <= 0 ||
-        wall.size() < 12 || wall.size() >= kMaxWallMarks) {
+        plane.count < 12 || plane.count >= kMaxWallMarks) {
         // Split so "the gate refused this pose" is distinguishable from "there is nothing to grow
         // onto" and from "the map is full". The first is tuning (E5 sets MIN_INLIER_SPREAD), the
         // second is a capture problem, the third is a hard ceiling and not a fault at all.
         mGrowOutcome.store(
-            wall.size() >= kMaxWallMarks ? kGrowAtCap : (!trusted ? kGrowUntrusted : kGrowNoGeometry),
+            plane.count >= kMaxWallMarks ? kGrowAtCap : (!trusted ? kGrowUntrusted : kGrowNoGeometry),
             std::memory_order_relaxed);
         return;
     }
 
-    // Wall plane (n·X = pdist, pdist>0) in the fingerprint frame, fit to the existing marks.
-    cv::Mat data((int)wall.size(), 3, CV_32F);
-    for (int i = 0; i < (int)wall.size(); ++i) {
-        data.at<float>(i,0) = wall[i].x; data.at<float>(i,1) = wall[i].y; data.at<float>(i,2) = wall[i].z;
-    }
-    cv::PCA pca(data, cv::Mat(), cv::PCA::DATA_AS_ROW);
-    cv::Vec3d n(pca.eigenvectors.at<float>(2,0), pca.eigenvectors.at<float>(2,1), pca.eigenvectors.at<float>(2,2));
-    cv::Vec3d cen(pca.mean.at<float>(0,0), pca.mean.at<float>(0,1), pca.mean.at<float>(0,2));
+    // Wall plane (n·X = pdist, pdist>0) in the fingerprint frame, as of the snapshot above.
     // A degenerate plane fit is the same class of refusal as degenerate intrinsics: there is
     // nothing to project promotions onto.
-    double nn = cv::norm(n);
-    if (nn < 1e-6) { mGrowOutcome.store(kGrowNoGeometry, std::memory_order_relaxed); return; }
-    n /= nn;
-    double pdist = n.dot(cen); if (pdist < 0) { n = -n; pdist = -pdist; }
+    if (!plane.valid) { mGrowOutcome.store(kGrowNoGeometry, std::memory_order_relaxed); return; }
+    const cv::Vec3d n = plane.normal;
+    const double pdist = plane.offset;
     if (pdist < 1e-3) { mGrowOutcome.store(kGrowNoGeometry, std::memory_order_relaxed); return; }
 
     // fp_from_cam = [R^T | -R^T t]: camera centre and per-pixel ray in the fingerprint frame.
@@ -1221,18 +1950,11 @@ void MobileGS::tryUpdateFingerprint(const cv::Mat& grayClean,
         double lambda = (pdist - nDotC) / denom;
         if (lambda <= 0) continue;                // intersection behind the camera
         cv::Vec3d X = C + lambda * dir;
-        cv::Point3f Xp((float)X[0], (float)X[1], (float)X[2]);
-        bool dup = false;
-        for (const auto& w : wall)
-            if (std::abs(w.x-Xp.x) < 0.01f && std::abs(w.y-Xp.y) < 0.01f && std::abs(w.z-Xp.z) < 0.01f) { dup = true; break; }
-        if (dup) continue;
-        newPts.push_back(Xp);
+        newPts.push_back(cv::Point3f((float)X[0], (float)X[1], (float)X[2]));
         newDescs.push_back(descs.row(q));
-        if (newPts.size() >= 30) break;           // cap per relock
     }
     if (newPts.empty()) {
-        // Candidates existed and every one of them was dropped: back-projected behind the camera,
-        // or deduplicated against a mark already stored.
+        // Candidates existed and every one of them was dropped: back-projected behind the camera.
         mGrowOutcome.store(kGrowNoNewPoints, std::memory_order_relaxed);
         return;
     }
@@ -1241,7 +1963,7 @@ void MobileGS::tryUpdateFingerprint(const cv::Mat& grayClean,
     int outsideN = 0, insideN = 0, bandN = 0;
     {
         std::lock_guard<std::mutex> lock(mMutex);
-        if (mWallDescriptors.type() != newDescs.type() || mWallDescriptors.cols != newDescs.cols ||
+        if (mWallDescriptors.type() != newDescs.type() || mWallDescriptors.cols() != newDescs.cols ||
             mWallKeypoints3D.size() >= kMaxWallMarks) {
             mGrowOutcome.store(
                 mWallKeypoints3D.size() >= kMaxWallMarks ? kGrowAtCap : kGrowNoGeometry,
@@ -1252,7 +1974,22 @@ void MobileGS::tryUpdateFingerprint(const cv::Mat& grayClean,
         // kMaxWallMarks-1 grow by the full per-relock batch, so the documented ceiling was really
         // ceiling + batch.
         const size_t room = kMaxWallMarks - mWallKeypoints3D.size();
-        const size_t take = std::min(room, newPts.size());
+        // Dedup against the marks already stored — and those promoted earlier in this batch, which
+        // the index sees as soon as they are inserted — through mWallIndex: a handful of hash
+        // lookups per candidate, where this was a scan of every wall mark per candidate. Done here,
+        // under the lock, because it is now cheap enough to, and checking the live wall rather than
+        // a snapshot is what makes it exact.
+        std::vector<int> near;
+        auto isDup = [&](const cv::Point3f& Xp) {
+            mWallIndex.queryBox(Xp, kWallDedupM, near);
+            for (int j : near) {
+                const cv::Point3f& w = mWallKeypoints3D[(size_t)j];
+                if (std::abs(w.x-Xp.x) < kWallDedupM && std::abs(w.y-Xp.y) < kWallDedupM &&
+                    std::abs(w.z-Xp.z) < kWallDedupM) return true;
+            }
+            return false;
+        };
+        size_t take = 0;
         // IMPLEMENTATION.md 3.4 — classify each promotion candidate with Φ, HERE, at promotion time.
         //
         // Until this landed every promoted mark was tagged BAND: correct as a refusal (an
@@ -1265,9 +2002,14 @@ void MobileGS::tryUpdateFingerprint(const cv::Mat& grayClean,
         // the old behaviour by accident — it is the same refusal, for the same reason.
         const bool canClassify = mHasDesignPlacement && mDesignHalfW > 0.0f && mDesignHalfH > 0.0f;
         int promotedOutside = 0, promotedInside = 0, promotedBand = 0;
-        for (size_t i = 0; i < take; ++i) {
+        const int firstPromotedRow = mWallDescriptors.rows();
+        for (size_t i = 0; i < newPts.size() && take < std::min<size_t>(room, kGrowBatchCap); ++i) {
+            if (isDup(newPts[i])) continue;
+            mWallIndex.insert((int)mWallKeypoints3D.size(), newPts[i]);
+            mWallPlane.add(newPts[i]);
             mWallKeypoints3D.push_back(newPts[i]);
-            mWallDescriptors.push_back(newDescs.row((int)i));
+            mWallDescriptors.append(newDescs.row((int)i));
+            ++take;
             // Keep the partition 1:1 with the points it indexes, or the reloc filter silently
             // switches itself off (its length check fails) and the whole map goes back to being
             // undifferentiated.
@@ -1288,6 +2030,14 @@ void MobileGS::tryUpdateFingerprint(const cv::Mat& grayClean,
                 mWallRegions.push_back(region);
             }
         }
+        if (take == 0) {
+            // Every candidate landed within kWallDedupM of a mark already stored.
+            mGrowOutcome.store(kGrowNoNewPoints, std::memory_order_relaxed);
+            return;
+        }
+        ++mWallDescGen;
+        indexWallRows(firstPromotedRow);   // a batch of at most kGrowBatchCap rows
+        noteWallAppended();
         // Snapshot inside the lock: these feed a log line below, and reading the containers after
         // the guard released races a concurrent restoreWallFingerprintMetric on the JNI thread.
         promoted = take;
@@ -1307,6 +2057,24 @@ void MobileGS::destroy() {
         mRelocCv.notify_all();
     }
     if (mRelocThread.joinable()) mRelocThread.join();
+    {
+        std::lock_guard<std::mutex> lock(mHeadMutex);
+        mHeadCv.notify_all();
+    }
+    if (mHeadThread.joinable()) mHeadThread.join();
+    {
+        std::lock_guard<std::mutex> lock(mMapJobMutex);
+        mMapJobCv.notify_all();
+    }
+    if (mMapThread.joinable()) mMapThread.join();
+    {
+        std::lock_guard<std::mutex> lock(mRefineMutex);
+        mRefineCv.notify_all();
+    }
+    if (mRefineThread.joinable()) mRefineThread.join();
+    // mRelocRunning is now false, so a warm-up thread exits at its next check; at most the one
+    // forward already in flight is waited out here.
+    if (mWarmUpThread.joinable()) mWarmUpThread.join();
 }
 
 void MobileGS::setViewportSize(int w, int h) {
@@ -1345,8 +2113,15 @@ void MobileGS::setEvalSyncReloc(bool enabled, int everyN) {
 }
 void MobileGS::restoreWallFingerprint(const cv::Mat& d, const std::vector<cv::Point3f>& p) {
     std::lock_guard<std::mutex> lock(mMutex);
-    mWallDescriptors = d.clone();
+    mWallDescriptors.assign(d);
+    ++mWallDescGen;
     mWallKeypoints3D = p;
+    mWallIndex.rebuild(mWallKeypoints3D);
+    mWallPlane.rebuild(mWallKeypoints3D);
+    reindexWallBow();
+    resetRefinement();
+    restartWallSync();
+    invalidateDistortionHead();
     // This path carries no partition, and the previous fingerprint's must not survive onto it: the
     // bytes would index a different point set entirely. Empty = all backbone, as before Phase 2.
     mWallRegions.clear();
@@ -1356,8 +2131,21 @@ void MobileGS::restoreWallFingerprintMetric(const cv::Mat& d, const std::vector<
                                             const float* viewMatrix16,
                                             const std::vector<uint8_t>& regions) {
     std::lock_guard<std::mutex> lock(mMutex);
-    mWallDescriptors = d.clone();
+    mWallDescriptors.assign(d);
+    commitWallFingerprintLocked(p, anchorMatrix16, intrinsics4, viewMatrix16, regions);
+}
+
+void MobileGS::commitWallFingerprintLocked(const std::vector<cv::Point3f>& p, const float* anchorMatrix16,
+                                           const float* intrinsics4, const float* viewMatrix16,
+                                           const std::vector<uint8_t>& regions) {
+    ++mWallDescGen;
     mWallKeypoints3D = p;
+    mWallIndex.rebuild(mWallKeypoints3D);
+    mWallPlane.rebuild(mWallKeypoints3D);
+    reindexWallBow();
+    resetRefinement();
+    restartWallSync();
+    invalidateDistortionHead();
     // Belt and braces over the JNI-side length check: a partition that does not index the points it
     // is stored beside is worse than no partition, and this is the last place it can be refused
     // before the reloc thread subscripts it. Empty = all backbone = pre-Phase-2 behaviour.
@@ -1376,16 +2164,29 @@ void MobileGS::restoreWallFingerprintMetric(const cv::Mat& d, const std::vector<
 
 void MobileGS::clearWallFingerprint() {
     std::lock_guard<std::mutex> lock(mMutex);
-    mWallDescriptors.release();
+    mWallDescriptors.clear();
+    ++mWallDescGen;
     mWallKeypoints3D.clear();
+    mWallIndex.clear();
+    mWallPlane.clear();
+    reindexWallBow();
+    resetRefinement();
+    restartWallSync();
     mWallRegions.clear();
     // Back to the constructed defaults, so a later project can't inherit this one's co-registration.
     static const float kIdentity16[16] = {1,0,0,0, 0,1,0,0, 0,0,1,0, 0,0,0,1};
     memcpy(mFingerprintAnchorMatrix, kIdentity16, 16 * sizeof(float));
     memset(mFingerprintIntrinsics, 0, 4 * sizeof(float));
     mHasFingerprintView = false;
+    resetProjectStateLocked();
+}
 
-    // The ARTWORK side has to go too. It used to survive, and there is no other path that clears it:
+// Everything keyed to the project rather than to its wall's data: the artwork registered against
+// it, the design placed on it, the distortion head's reference, and what the last two measured.
+// clearWallFingerprint and swapActiveWall share it, so "a different project is loaded" means the
+// same thing on both paths.
+void MobileGS::resetProjectStateLocked() {
+    // The ARTWORK side. It used to survive, and there is no other path that clears it:
     // an un-fingerprinted project would then be validated against the PREVIOUS project's artwork by
     // tryUpdateFingerprint, publishing a meaningless painting progress that reaches the user's
     // progress readout AND PoseFusion's correction strength — and, with self-grow enabled, promoting
@@ -1404,7 +2205,8 @@ void MobileGS::clearWallFingerprint() {
     mHasDesignPlacement = false;
     mDesignHalfW = 0.0f;
     mDesignHalfH = 0.0f;
-    mWallPatch.release();
+    mDistortionHead.clearFingerprint();
+    invalidateDistortionHead();
     mPaintingProgress.store(0.0f, std::memory_order_relaxed);
     // Back to "never measured", not to zero — the next project has not been looked at yet, and
     // reporting a confident 0 would be a measurement it never made.
@@ -1443,10 +2245,27 @@ void MobileGS::restoreWallFeatureMap(const cv::Mat& d, const std::vector<cv::Poi
                                      const std::vector<float>& conf, const std::vector<int>& obs,
                                      const float* anchorMatrix16, const float* intrinsics4) {
     std::lock_guard<std::mutex> lock(mMutex);
-    mMapDescriptors = d.clone();
+    mMapDescriptors.assign(d);
+    commitWallFeatureMapLocked(p, conf, obs, anchorMatrix16, intrinsics4);
+}
+
+void MobileGS::commitWallFeatureMapLocked(const std::vector<cv::Point3f>& p, const std::vector<float>& conf,
+                                          const std::vector<int>& obs, const float* anchorMatrix16,
+                                          const float* intrinsics4) {
+    ++mMapDescGen;
     mMapPoints3D = p;
+    mMapIndex.rebuild(mMapPoints3D);
+    mMapDedup.rebuild(mMapPoints3D);
     mMapConfidence = conf;
     mMapObs = obs;
+    mMapLastSeen.assign(p.size(), mMapTick);
+    reassignMapIds();
+    mKeyframes.clear();
+    {
+        // Queued observations were registered against the map being replaced.
+        std::lock_guard<std::mutex> jobLock(mMapJobMutex);
+        mMapJobs.clear();
+    }
     // Reset (not leave stale) when a map omits co-registration, so it can't inherit a previous
     // project's anchor/intrinsics.
     static const float kIdentity16[16] = {1,0,0,0, 0,1,0,0, 0,0,1,0, 0,0,0,1};
@@ -1455,120 +2274,579 @@ void MobileGS::restoreWallFeatureMap(const cv::Mat& d, const std::vector<cv::Poi
     else             memset(mMapIntrinsics, 0, 4 * sizeof(float));
 }
 
+bool MobileGS::saveWallSidecar(const std::string& path) {
+    WallSidecar::Contents c;
+    c.descCodecLevel = mDescriptorCodecLevel.load(std::memory_order_relaxed);
+    uint64_t serial;
+    {
+        // Views, not copies: the arenas never rewrite a row a view can see, so the file is written
+        // from them after the lock is dropped. Only the small columns are copied here.
+        std::lock_guard<std::mutex> lock(mMutex);
+        if (!mWallDescriptors.empty() && mWallKeypoints3D.size() == (size_t)mWallDescriptors.rows()) {
+            c.wallDescs = mWallDescriptors.view();
+            c.wallPts = mWallKeypoints3D;
+            c.wallRegions = mWallRegions;
+            memcpy(c.fpAnchor, mFingerprintAnchorMatrix, sizeof(c.fpAnchor));
+            memcpy(c.fpIntrinsics, mFingerprintIntrinsics, sizeof(c.fpIntrinsics));
+            memcpy(c.fpView, mFingerprintViewMatrix, sizeof(c.fpView));
+            c.hasFpView = mHasFingerprintView;
+        }
+        if (!mMapDescriptors.empty() && mMapPoints3D.size() == (size_t)mMapDescriptors.rows()) {
+            c.mapDescs = mMapDescriptors.view();
+            c.mapPts = mMapPoints3D;
+            c.mapConf = mMapConfidence;
+            c.mapConf.resize(mMapPoints3D.size(), 1.0f);   // defensive align, as exportWallFeatureMap
+            c.mapObs = mMapObs;
+            c.mapObs.resize(mMapPoints3D.size(), 1);
+            memcpy(c.mapAnchor, mMapAnchorMatrix, sizeof(c.mapAnchor));
+            memcpy(c.mapIntrinsics, mMapIntrinsics, sizeof(c.mapIntrinsics));
+        }
+        // This snapshot is the journal's new base: what changes while the file is written is the
+        // first batch on top of it.
+        beginJournalLocked(!c.wallDescs.empty(), !c.mapDescs.empty());
+        serial = mJournalSerial;
+    }
+    WallSidecar::Stamp stamp;
+    const std::string journal = WallJournal::pathFor(path);
+    if (!WallSidecar::write(path, c, &stamp)) {
+        std::lock_guard<std::mutex> lock(mMutex);
+        if (mJournalSerial == serial) dropJournalLocked("save failed");
+        return false;
+    }
+    // Compaction: an empty journal on the new file. With journaling off the old one is only
+    // removed, which a load would do no differently — it names the file just replaced.
+    const bool journaled = mJournalEnabled.load(std::memory_order_relaxed) && WallJournal::start(journal, stamp);
+    if (!journaled) std::remove(journal.c_str());
+    std::lock_guard<std::mutex> lock(mMutex);
+    if (journaled && mJournalSerial == serial && mJournalRecording) {
+        mJournalBase = stamp;
+        mJournalPath = journal;
+    }
+    return true;
+}
+
+bool MobileGS::loadWallSidecar(const std::string& path, bool restoreFingerprint) {
+    // Mapped and validated with no lock held; only the install below takes mMutex. The descriptor
+    // Mats are headers over the mapping, adopted by the arenas as they are.
+    WallSidecar::Contents c;
+    if (!WallSidecar::read(path, c)) return false;
+    bool wall = !c.wallDescs.empty();
+    const bool map = !c.mapDescs.empty();
+    if (wall && !restoreFingerprint) {
+        std::lock_guard<std::mutex> lock(mMutex);
+        wall = sidecarContinuesWallLocked(c);
+    }
+    if (!wall && !map) return false;
+    // The journal is replayed whether or not recording is on: it is part of what was saved.
+    const std::string journalPath = WallJournal::pathFor(path);
+    std::vector<WallJournal::Batch> journal;
+    bool journalReady = WallJournal::read(journalPath, c.stamp, journal);
+    if (!journalReady && mJournalEnabled.load(std::memory_order_relaxed))
+        journalReady = WallJournal::start(journalPath, c.stamp);
+
+    std::lock_guard<std::mutex> lock(mMutex);
+    // Checked again under the lock that installs: the live wall may have been replaced since.
+    if (wall && !restoreFingerprint) wall = sidecarContinuesWallLocked(c);
+    if (!wall && !map) return false;
+    if (wall) {
+        mWallDescriptors.adopt(c.wallDescs);
+        commitWallFingerprintLocked(c.wallPts, c.fpAnchor, c.fpIntrinsics, c.hasFpView ? c.fpView : nullptr,
+                                    c.wallRegions);
+    }
+    if (map) {
+        mMapDescriptors.adopt(c.mapDescs);
+        commitWallFeatureMapLocked(c.mapPts, c.mapConf, c.mapObs, c.mapAnchor, c.mapIntrinsics);
+    }
+    // A batch that does not fit (a journal from a build with other rules, say) stops the replay
+    // where it is. Every batch before it is whole, so that is a state some autosave saw; it is just
+    // not base + journal, so the journal is not extended from it and the next save compacts.
+    size_t replayed = 0;
+    while (replayed < journal.size() && replayJournalLocked(journal[replayed], wall, map)) ++replayed;
+    const bool intact = replayed == journal.size();
+    if (!intact) LOGE("Journal: batch %zu of %zu does not apply; replay stopped", replayed + 1, journal.size());
+    if (map && replayed > 0) {
+        mMapIndex.rebuild(mMapPoints3D);
+        mMapDedup.rebuild(mMapPoints3D);
+        reindexMapBow();
+    }
+    if (replayed > 0) LOGI("Journal: replayed %zu batches (wall %zu, map %zu)", replayed,
+                           mWallKeypoints3D.size(), mMapPoints3D.size());
+    beginJournalLocked(wall, map);
+    if (intact && journalReady && mJournalRecording) {
+        mJournalBase = c.stamp;
+        mJournalPath = journalPath;
+    }
+    return true;
+}
+
+bool MobileGS::sidecarContinuesWallLocked(const WallSidecar::Contents& c) const {
+    // The app restores the fingerprint from project.json, which holds the capture and not what
+    // self-grow and refinement added to it; the sidecar holds that, and its journal what came after.
+    // The same capture carries the same anchor and intrinsics bit for bit (only a capture or a restore
+    // writes them), and a wall only grows until it is replaced. A descriptors-only wall has no
+    // co-registration to tell one capture from another, so it is never taken on trust.
+    const size_t n = mWallKeypoints3D.size();
+    return n > 0 && mFingerprintIntrinsics[0] > 0.f && c.wallPts.size() >= n &&
+           c.wallDescs.type() == mWallDescriptors.type() && c.wallDescs.cols == mWallDescriptors.cols() &&
+           memcmp(c.fpAnchor, mFingerprintAnchorMatrix, sizeof(c.fpAnchor)) == 0 &&
+           memcmp(c.fpIntrinsics, mFingerprintIntrinsics, sizeof(c.fpIntrinsics)) == 0;
+}
+
+void MobileGS::beginJournalLocked(bool withWall, bool withMap) {
+    ++mJournalSerial;
+    mJournalPending.clear();
+    mJournalDirty.clear();
+    mJournalBase = WallSidecar::Stamp();
+    mJournalPath.clear();
+    mJournalRecording = mJournalEnabled.load(std::memory_order_relaxed);
+    // A wall without aligned generations cannot be followed row by row; journal nothing rather
+    // than a map whose wall would silently be the base's.
+    mJournalWall = withWall;
+    if (withWall && (mWallSyncEpoch == 0 || mWallRowAddGen.size() != mWallKeypoints3D.size())) mJournalRecording = false;
+    mJournalMap = withMap;
+    mJournalWallEpoch = mWallSyncEpoch;
+    mJournalWallGen = mWallSyncGen;
+}
+
+void MobileGS::dropJournalLocked(const char* why) {
+    if (mJournalRecording) LOGI("Journal: recording stopped (%s); the next save compacts", why);
+    mJournalRecording = false;
+    mJournalBase = WallSidecar::Stamp();
+    mJournalPath.clear();
+    mJournalPending.clear();
+    mJournalDirty.clear();
+}
+
+int64_t MobileGS::appendWallJournal(const std::string& sidecarPath) {
+    WallJournal::Batch b;
+    std::string path;
+    uint64_t serial;
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        if (!mJournalRecording || !mJournalBase.valid() || WallJournal::pathFor(sidecarPath) != mJournalPath) return -1;
+        if (mJournalWall && mWallSyncEpoch != mJournalWallEpoch) { dropJournalLocked("wall replaced"); return -1; }
+        path = mJournalPath;
+        serial = mJournalSerial;
+
+        // The queued adds and removes, then every marked point that survived them, at the row it
+        // now has — which is where replaying the adds and removes puts it.
+        b = std::move(mJournalPending);
+        mJournalPending.clear();
+        for (uint32_t id : mJournalDirty) {
+            auto it = mMapIdToIndex.find(id);
+            if (it == mMapIdToIndex.end() || (size_t)it->second >= mMapPoints3D.size()) continue;   // pruned
+            const size_t i = (size_t)it->second;
+            b.map.push_back({WallJournal::kMapSet, (uint32_t)i, mMapPoints3D[i],
+                             i < mMapConfidence.size() ? mMapConfidence[i] : 1.0f, i < mMapObs.size() ? mMapObs[i] : 1});
+        }
+        mJournalDirty.clear();
+        if (!b.map.empty()) {
+            if (!mJournalMap) { dropJournalLocked("map begun after the save"); return -1; }
+            b.hasMapFrame = true;
+            memcpy(b.mapAnchor, mMapAnchorMatrix, sizeof(b.mapAnchor));
+            memcpy(b.mapIntrinsics, mMapIntrinsics, sizeof(b.mapIntrinsics));
+        }
+
+        if (mJournalWall && mWallSyncGen != mJournalWallGen) {
+            const size_t n = mWallKeypoints3D.size();
+            if (mWallRowAddGen.size() != n || (size_t)mWallDescriptors.rows() != n) {
+                dropJournalLocked("wall generations misaligned");
+                return -1;
+            }
+            // As exportFingerprintDelta, with the last batch's generation as the peer's. The journal
+            // names its base by the sidecar's stamp, so no epoch. The descriptors are a view, encoded
+            // with the lock released: the arena never writes a row a view can see.
+            b.wall = FingerprintDelta::since(0, mWallSyncGen, false, mJournalWallGen, mWallKeypoints3D,
+                                             mWallDescriptors.view(), mWallRegions, mWallRowAddGen, mWallRowMoveGen);
+            b.hasWall = true;
+            mJournalWallGen = mWallSyncGen;
+        }
+    }
+
+    uint64_t bytes = 0;
+    bool ok;
+    if (b.empty()) {
+        struct stat st;
+        ok = ::stat(path.c_str(), &st) == 0;
+        bytes = ok ? (uint64_t)st.st_size : 0;
+    } else {
+        ok = WallJournal::append(path, b, bytes);
+    }
+    if (!ok) {
+        // What was taken from the queue is in no file now; only a full save can catch up.
+        std::lock_guard<std::mutex> lock(mMutex);
+        if (mJournalSerial == serial) dropJournalLocked("journal write failed");
+        return -1;
+    }
+    return (int64_t)bytes;
+}
+
+bool MobileGS::replayJournalLocked(const WallJournal::Batch& b, bool wall, bool map) {
+    // Checked whole before anything is applied, so a batch either lands or leaves no trace.
+    const FingerprintDelta& d = b.wall;
+    const bool doWall = wall && b.hasWall, doMap = map && !b.map.empty();
+    if (doWall) {
+        const size_t n = mWallKeypoints3D.size(), nAppended = d.appendedPts.size();
+        if (d.baseRows != n || !d.removed.empty() || n + nAppended > FingerprintDelta::kMaxRows) return false;
+        if (nAppended > 0 && (d.appendedDescs.type() != mWallDescriptors.type() ||
+                              d.appendedDescs.cols != mWallDescriptors.cols()))
+            return false;
+        for (uint32_t row : d.movedRows) if (row >= n) return false;
+    }
+    if (doMap) {
+        if (!b.mapAdded.empty() && (b.mapAdded.type() != mMapDescriptors.type() ||
+                                    b.mapAdded.cols != mMapDescriptors.cols()))
+            return false;
+        size_t rows = mMapPoints3D.size();
+        for (const WallJournal::MapRecord& r : b.map) {
+            if (r.op == WallJournal::kMapAdd) { ++rows; continue; }
+            if (r.row >= rows) return false;
+            if (r.op == WallJournal::kMapRemove) --rows;
+        }
+    }
+
+    if (doWall) changeWallRowsLocked(d.movedRows, d.movedPts, d.appendedPts, d.appendedDescs, d.appendedRegions);
+    if (!doMap) return true;
+    // As growMapFromReloc: a restored map may carry no confidence or observation columns.
+    mMapConfidence.resize(mMapPoints3D.size(), 1.0f);
+    mMapObs.resize(mMapPoints3D.size(), 1);
+    mMapLastSeen.resize(mMapPoints3D.size(), mMapTick);
+    int added = 0;
+    for (const WallJournal::MapRecord& r : b.map) {
+        if (r.op == WallJournal::kMapAdd) {
+            mMapPoints3D.push_back(r.pt);
+            mMapConfidence.push_back(r.conf);
+            mMapObs.push_back(r.obs);
+            mMapLastSeen.push_back(mMapTick);
+            mMapIds.push_back(mNextMapId);
+            mMapIdToIndex[mNextMapId++] = (int)mMapPoints3D.size() - 1;
+            mMapDescriptors.append(b.mapAdded.row(added++));
+        } else if (r.op == WallJournal::kMapRemove) {
+            swapRemoveMapPoint(r.row);
+        } else {
+            mMapPoints3D[r.row] = r.pt;
+            mMapConfidence[r.row] = r.conf;
+            mMapObs[r.row] = r.obs;
+        }
+    }
+    ++mMapDescGen;
+    if (b.hasMapFrame) {
+        memcpy(mMapAnchorMatrix, b.mapAnchor, sizeof(mMapAnchorMatrix));
+        memcpy(mMapIntrinsics, b.mapIntrinsics, sizeof(mMapIntrinsics));
+    }
+    return true;
+}
+
 void MobileGS::clearWallFeatureMap() {
     std::lock_guard<std::mutex> lock(mMutex);
-    mMapDescriptors.release();
+    mMapDescriptors.clear();
+    ++mMapDescGen;
     mMapPoints3D.clear();
+    mMapIndex.clear();
+    mMapDedup.clear();
     mMapConfidence.clear();
     mMapObs.clear();
+    mMapLastSeen.clear();
+    reassignMapIds();
+    mKeyframes.clear();
+    {
+        std::lock_guard<std::mutex> jobLock(mMapJobMutex);
+        mMapJobs.clear();
+    }
     // Also drop stale co-registration so a later project can't inherit it.
     static const float kIdentity16[16] = {1,0,0,0, 0,1,0,0, 0,0,1,0, 0,0,0,1};
     memcpy(mMapAnchorMatrix, kIdentity16, 16 * sizeof(float));
     memset(mMapIntrinsics, 0, 4 * sizeof(float));
 }
 
-std::vector<uint8_t> MobileGS::exportFingerprint() {
+void MobileGS::swapActiveWall(WallSlot& slot) {
+    using std::swap;
+    swap(mWallDescriptors, slot.wallDescs);
+    swap(mWallKeypoints3D, slot.wallPts);
+    swap(mWallRegions, slot.wallRegions);
+    swap(mWallIndex, slot.wallIndex);
+    swap(mWallPlane, slot.wallPlane);
+    swap(mWallBow, slot.wallBow);
+    swap(mWallBowVocab, slot.wallBowVocab);
+    swap(mFingerprintAnchorMatrix, slot.fpAnchor);
+    swap(mFingerprintIntrinsics, slot.fpIntrinsics);
+    swap(mFingerprintViewMatrix, slot.fpView);
+    swap(mHasFingerprintView, slot.hasFpView);
+
+    swap(mMapDescriptors, slot.mapDescs);
+    swap(mMapPoints3D, slot.mapPts);
+    swap(mMapConfidence, slot.mapConf);
+    swap(mMapObs, slot.mapObs);
+    swap(mMapLastSeen, slot.mapLastSeen);
+    swap(mMapIds, slot.mapIds);
+    swap(mMapIdToIndex, slot.mapIdToIndex);
+    swap(mMapIndex, slot.mapIndex);
+    swap(mMapDedup, slot.mapDedup);
+    swap(mKeyframes, slot.keyframes);
+    swap(mMapBow, slot.mapBow);
+    swap(mMapBowVocab, slot.mapBowVocab);
+    swap(mMapAnchorMatrix, slot.mapAnchor);
+    swap(mMapIntrinsics, slot.mapIntrinsics);
+
+    // Everything keyed by generation (the compact-code caches, the reloc snapshots, in-flight map
+    // commits) now describes the other wall.
+    ++mWallDescGen;
+    ++mMapDescGen;
+    // Ages restart on arrival, as on restore: a parked wall saw no commits, which is not the same
+    // as its points having gone unobserved.
+    std::fill(mMapLastSeen.begin(), mMapLastSeen.end(), mMapTick);
+    // A vocabulary loaded while the wall was parked has never indexed it.
+    if (mWallBowVocab != vocabFor(mWallDescriptors.type())) reindexWallBow();
+    if (mMapBowVocab != vocabFor(mMapDescriptors.type())) reindexMapBow();
+    // Observations and poses are in the outgoing wall's frame.
+    resetRefinement();
+    restartWallSync();
+    // The artwork, design placement and head reference are the outgoing project's, and the slot
+    // does not carry them: the app re-registers them for the project it opens, as after a restore.
+    resetProjectStateLocked();
+    dropJournalLocked("wall swapped");
+    std::lock_guard<std::mutex> jobLock(mMapJobMutex);
+    mMapJobs.clear();
+}
+
+bool MobileGS::activateWallLocked(const std::string& projectId) {
+    if (projectId.empty()) return false;
+    if (projectId == mActiveWallId) return true;
+    WallSlot incoming = emptyWallSlot();
+    const bool parked = mWallRegistry.take(projectId, incoming);
+    // Park the loaded wall under its label. An unlabelled one has nowhere to go and is dropped,
+    // exactly as a restore over it would drop it.
+    std::vector<std::string> evicted;
+    if (!mActiveWallId.empty() && (!mWallDescriptors.empty() || !mMapDescriptors.empty())) {
+        WallSlot outgoing = emptyWallSlot();
+        swapActiveWall(outgoing);
+        outgoing.global = KeyframeGraph::globalDescriptor(outgoing.wallDescs.view());
+        outgoing.globalType = outgoing.wallDescs.type();
+        mWallRegistry.put(mActiveWallId, std::move(outgoing), &evicted);
+    }
+    swapActiveWall(incoming);
+    mActiveWallId = projectId;
+    mPreselectCandidate.clear();
+    mPreselectStreak = 0;
+    mProposedWallId.clear();
+    for (const auto& id : evicted) LOGI("Wall registry: evicted '%s' (budget %zu bytes)", id.c_str(), mWallRegistry.budget());
+    LOGI("Wall registry: '%s' %s (%zu parked, %zu bytes)", projectId.c_str(),
+         parked ? "activated" : "not parked, engine left empty", mWallRegistry.size(), mWallRegistry.bytes());
+    return parked;
+}
+
+bool MobileGS::activateWall(const std::string& projectId) {
+    std::lock_guard<std::mutex> lock(mMutex);
+    return activateWallLocked(projectId);
+}
+
+void MobileGS::setActiveWallId(const std::string& projectId) {
+    std::lock_guard<std::mutex> lock(mMutex);
+    mWallRegistry.erase(projectId);   // the loaded wall is now this project's; a parked copy is stale
+    mActiveWallId = projectId;
+}
+
+void MobileGS::forgetWall(const std::string& projectId) {
+    std::lock_guard<std::mutex> lock(mMutex);
+    mWallRegistry.erase(projectId);
+}
+
+void MobileGS::setWallRegistryBudget(size_t bytes) {
     std::lock_guard<std::mutex> lock(mMutex);
-    if (mWallDescriptors.empty() || mWallKeypoints3D.empty()) return {};
-
-    // NOTE: the co-op wire format carries no Phase-2 partition, deliberately. It is a fixed,
-    // unversioned layout shared with peers that may be running an older build, so appending
-    // mWallRegions here would be read as descriptor bytes on the other end. The receiving side
-    // (alignToFingerprint) clears mWallRegions for the same reason, so a shared fingerprint is
-    // all-backbone on arrival — degraded, but correct, and the peer partitions its own once it
-    // places its own artwork. Adding a version field is what would let this change.
-    uint32_t numPoints = static_cast<uint32_t>(mWallKeypoints3D.size());
-    uint32_t descRows = static_cast<uint32_t>(mWallDescriptors.rows);
-    uint32_t descCols = static_cast<uint32_t>(mWallDescriptors.cols);
-    uint32_t descType = static_cast<uint32_t>(mWallDescriptors.type());
-    size_t descDataSize = mWallDescriptors.total() * mWallDescriptors.elemSize();
-
-    size_t totalSize = sizeof(uint32_t) * 4 +
-                       numPoints * sizeof(cv::Point3f) +
-                       descDataSize;
-
-    std::vector<uint8_t> buffer(totalSize);
-    uint8_t* ptr = buffer.data();
-
-    memcpy(ptr, &numPoints, sizeof(uint32_t)); ptr += sizeof(uint32_t);
-    memcpy(ptr, mWallKeypoints3D.data(), numPoints * sizeof(cv::Point3f)); ptr += numPoints * sizeof(cv::Point3f);
-    memcpy(ptr, &descRows, sizeof(uint32_t)); ptr += sizeof(uint32_t);
-    memcpy(ptr, &descCols, sizeof(uint32_t)); ptr += sizeof(uint32_t);
-    memcpy(ptr, &descType, sizeof(uint32_t)); ptr += sizeof(uint32_t);
-    memcpy(ptr, mWallDescriptors.data, descDataSize);
-
-    return buffer;
-}
-
-void MobileGS::alignToFingerprint(const uint8_t* data, size_t size) {
-    // Untrusted peer bytes. Validate every length in 64-bit arithmetic (Android ships 32-bit ABIs
-    // where numPoints * sizeof(Point3f) would wrap size_t) and BEFORE allocating any cv::Mat from
-    // peer-controlled dimensions. Bail on anything inconsistent rather than crash the co-op session.
-    if (!data || size < sizeof(uint32_t) * 4) return;
-
-    const uint8_t* ptr = data;
-    const uint8_t* end = data + size;
-
-    uint32_t numPoints;
-    memcpy(&numPoints, ptr, sizeof(uint32_t)); ptr += sizeof(uint32_t);
-
-    // Cap up front: even though the bounds check below rejects a numPoints larger than the buffer,
-    // an explicit ceiling documents the intent and refuses an absurd count before std::vector tries
-    // to reserve it. A real wall fingerprint is a few thousand points.
-    if (numPoints > 100000) return;
-
-    // The points block plus the 3 trailing header ints (descRows/descCols/descType) must fit.
-    uint64_t ptsBytes = static_cast<uint64_t>(numPoints) * sizeof(cv::Point3f);
-    if (static_cast<uint64_t>(end - ptr) < ptsBytes + sizeof(uint32_t) * 3) return;
-
-    std::vector<cv::Point3f> points3d(numPoints);
-    if (numPoints > 0) memcpy(points3d.data(), ptr, static_cast<size_t>(ptsBytes));
-    ptr += ptsBytes;
-
-    uint32_t descRows, descCols, descType;
-    memcpy(&descRows, ptr, sizeof(uint32_t)); ptr += sizeof(uint32_t);
-    memcpy(&descCols, ptr, sizeof(uint32_t)); ptr += sizeof(uint32_t);
-    memcpy(&descType, ptr, sizeof(uint32_t)); ptr += sizeof(uint32_t);
-
-    // Sanity-check the descriptor header before it reaches cv::Mat: a bogus type or absurd dims from a
-    // hostile peer would otherwise throw inside cv::Mat or attempt a multi-GB allocation.
-    int depth = CV_MAT_DEPTH(descType);
-    int channels = CV_MAT_CN(descType);
-    if (depth < 0 || depth > CV_64F || channels < 1 || channels > 4) return;
-    if (descRows == 0 || descCols == 0 || descRows > 100000 || descCols > 100000) return;
-
-    uint64_t descDataSize = static_cast<uint64_t>(descRows) * descCols * CV_ELEM_SIZE(descType);
-    if (static_cast<uint64_t>(end - ptr) < descDataSize) return;
-
-    cv::Mat descs(static_cast<int>(descRows), static_cast<int>(descCols), static_cast<int>(descType));
-    memcpy(descs.data, ptr, static_cast<size_t>(descDataSize));
+    std::vector<std::string> evicted;
+    mWallRegistry.setBudget(bytes, &evicted);
+    for (const auto& id : evicted) LOGI("Wall registry: evicted '%s' (budget %zu bytes)", id.c_str(), bytes);
+}
+
+/**
+ * Decide, before an attempt matches, whether the camera is looking at a parked wall rather than
+ * the loaded one. Only after a failed attempt (a working lock says the loaded wall is in view), on
+ * the previous attempt's frame, and only once the same parked wall has won kWallSelectStreak
+ * frames running — mean-pooled globals of different walls are close, and a single frame's noise
+ * must not thrash the app between them.
+ *
+ * The winner is proposed, not activated. A wall is a project's, and switching the engine under
+ * the app would leave it drawing one project's artwork against another's wall and autosaving that
+ * wall into the wrong project's files. The app takes the proposal (takeProposedWall), opens the
+ * project, and its load activates the parked wall.
+ */
+void MobileGS::preselectWall() {
+    std::lock_guard<std::mutex> lock(mMutex);
+    if (mWallRegistry.size() == 0 || mLastFrameGlobal.empty()) return;
+    const cv::Mat frameGlobal = mLastFrameGlobal;
+    const int frameType = mLastFrameGlobalType;
+    mLastFrameGlobal.release();
+    if (mLastRelocReject.load(std::memory_order_relaxed) == kRelocOk) {
+        mPreselectStreak = 0;
+        return;
+    }
+    std::string bestId;
+    float best = 0.f;
+    if (!mWallRegistry.best(frameGlobal, frameType, bestId, best)) return;
+    float active = -1.f;
+    if (!mWallDescriptors.empty() && mWallDescriptors.type() == frameType) {
+        if (mActiveWallGlobalGen != mWallDescGen) {
+            mActiveWallGlobal = KeyframeGraph::globalDescriptor(mWallDescriptors.view());
+            mActiveWallGlobalGen = mWallDescGen;
+        }
+        if (mActiveWallGlobal.cols == frameGlobal.cols) active = (float)frameGlobal.dot(mActiveWallGlobal);
+    }
+    if (best < active + kWallSelectMargin) {
+        mPreselectStreak = 0;
+        return;
+    }
+    if (bestId != mPreselectCandidate) {
+        mPreselectCandidate = bestId;
+        mPreselectStreak = 0;
+    }
+    if (++mPreselectStreak < kWallSelectStreak) return;
+    LOGI("Wall registry: frame prefers '%s' (%.3f vs %.3f loaded), proposing it", bestId.c_str(), best, active);
+    mProposedWallId = bestId;
+    mPreselectCandidate.clear();
+    mPreselectStreak = 0;
+}
+
+std::string MobileGS::takeProposedWall() {
+    std::lock_guard<std::mutex> lock(mMutex);
+    std::string id;
+    id.swap(mProposedWallId);
+    return id;
+}
+
+void MobileGS::installPeerFingerprintLocked(std::vector<cv::Point3f>&& points3d, const cv::Mat& descs,
+                                            std::vector<uint8_t>&& regions) {
+    mWallKeypoints3D = std::move(points3d);
+    mWallIndex.rebuild(mWallKeypoints3D);
+    mWallPlane.rebuild(mWallKeypoints3D);
+    // Descriptors before the BoW index: reindexWallBow reads them, and the other order indexes the
+    // outgoing wall's rows under the incoming wall's numbering.
+    mWallDescriptors.assign(descs);
+    ++mWallDescGen;
+    reindexWallBow();
+    resetRefinement();
+    restartWallSync();
+    mWallRegions = (regions.size() == mWallKeypoints3D.size()) ? std::move(regions) : std::vector<uint8_t>();
+    // This install carries no accompanying capture view or matching camera intrinsics -- it is a
+    // foreign (peer) point set. Solving PnP against it with this device's stale intrinsics, or
+    // rectifying against a capture view that belongs to unrelated local geometry, injects bad
+    // correspondences. Reset to the same "no real intrinsics yet" default restoreWallFingerprintMetric
+    // uses when it isn't given a capture view, so PnP falls back to the safe default path.
+    memset(mFingerprintIntrinsics, 0, 4 * sizeof(float));
+    mHasFingerprintView = false;
+    // Sender row i is local row i until this device's own self-grow interleaves rows of its own.
+    mPeer.installed(mWallKeypoints3D.size(), mWallSyncEpoch);
+}
 
+std::vector<uint8_t> MobileGS::exportFingerprintDelta(uint64_t epoch, uint64_t sinceGen) {
+    FingerprintDelta d;
     {
         std::lock_guard<std::mutex> lock(mMutex);
-        mWallKeypoints3D = std::move(points3d);
-        mWallDescriptors = descs.clone();
-        // A peer's fingerprint carries no partition, and the local one indexes a different point
-        // set. Empty = all backbone, i.e. pre-Phase-2 behaviour, which is the right default for a
-        // map whose design footprint this device never saw.
-        mWallRegions.clear();
-        // This install carries no accompanying capture view or matching camera intrinsics -- it is a
-        // foreign (peer) point set. Solving PnP against it with this device's stale intrinsics, or
-        // rectifying against a capture view that belongs to unrelated local geometry, injects bad
-        // correspondences. Reset to the same "no real intrinsics yet" default restoreWallFingerprintMetric
-        // uses when it isn't given a capture view, so PnP falls back to the safe default path.
-        memset(mFingerprintIntrinsics, 0, 4 * sizeof(float));
-        mHasFingerprintView = false;
-    }
+        const size_t n = mWallKeypoints3D.size();
+        if (n == 0 || (size_t)mWallDescriptors.rows() != n) return {};
+        // A wall no replacement has touched since construction has no epoch yet.
+        if (mWallSyncEpoch == 0 || mWallRowAddGen.size() != n) restartWallSync();
+        // Generation 0 is never a wall's, so it asks for everything; so does a generation from the
+        // future, which only a peer confused about which wall it holds can name.
+        const bool incremental = epoch == mWallSyncEpoch && sinceGen > 0 && sinceGen <= mWallSyncGen;
+        if (incremental && sinceGen == mWallSyncGen) return {};
+        // The descriptors are a view, not a copy: the arena never writes a row a view can see, so
+        // they are encoded below with the lock released.
+        d = FingerprintDelta::since(mWallSyncEpoch, mWallSyncGen, !incremental, sinceGen, mWallKeypoints3D,
+                                    mWallDescriptors.view(), mWallRegions, mWallRowAddGen, mWallRowMoveGen);
+    }
+    return d.encode();
+}
+
+bool MobileGS::applyFingerprintDelta(const uint8_t* data, size_t size) {
+    FingerprintDelta d;
+    const bool parsed = FingerprintDelta::decode(data, size, d);
+    const size_t appendedN = d.appendedPts.size(), movedN = d.movedRows.size();
+    size_t wallNow = 0;
     {
-        // Trigger the relocalization worker to start searching. mRelocRequested/mRelocCv are paired
-        // under mRelocMutex (see scheduleRelocCheck) -- mMutex does not guard them, so setting the
-        // flag there and never notifying leaves the worker parked in mRelocCv.wait(...) forever.
-        std::lock_guard<std::mutex> lock(mRelocMutex);
-        mRelocRequested = true;
+        std::lock_guard<std::mutex> lock(mMutex);
+        // Whatever cannot be applied leaves this wall with no usable base, so the next request asks
+        // for a full record rather than for another delta on top of a state we never reached.
+        auto refuse = [this](const char* why) {
+            LOGE("Co-op: fingerprint delta refused (%s); next sync is a full transfer", why);
+            mPeer.forget();
+            return false;
+        };
+        if (!parsed) return refuse("malformed");
+        std::vector<uint32_t> movedLocal;
+        if (const char* why = mPeer.check(d, mWallSyncEpoch, mWallKeypoints3D.size(), mWallDescriptors.type(),
+                                          mWallDescriptors.cols(), movedLocal))
+            return refuse(why);
+
+        size_t first = 0;
+        if (d.full()) {
+            std::vector<uint8_t> regions;
+            if (d.flags & FingerprintDelta::kRegions) regions = std::move(d.appendedRegions);
+            installPeerFingerprintLocked(std::move(d.appendedPts), d.appendedDescs, std::move(regions));
+        } else {
+            first = changeWallRowsLocked(movedLocal, d.movedPts, d.appendedPts, d.appendedDescs, d.appendedRegions);
+        }
+        mPeer.applied(d, first);
+        wallNow = mWallKeypoints3D.size();
     }
-    mRelocCv.notify_one();
-    LOGI("Co-op: Received fingerprint with %u points. Relocalization triggered.", numPoints);
+    if (d.full()) {
+        // A new wall wants a search, and the request is paired under mRelocMutex, not mMutex (see
+        // scheduleRelocCheck): setting the flag under mMutex without a notify leaves the worker parked.
+        {
+            std::lock_guard<std::mutex> lock(mRelocMutex);
+            mRelocRequested = true;
+        }
+        mRelocCv.notify_one();
+    }
+    LOGI("Co-op: applied %s fingerprint gen %llu (%zu appended, %zu moved; wall now %zu)",
+         d.full() ? "full" : "delta", (unsigned long long)d.newGen, appendedN, movedN, wallNow);
+    return true;
 }
+
+size_t MobileGS::changeWallRowsLocked(const std::vector<uint32_t>& movedRows, const std::vector<cv::Point3f>& movedPts,
+                                     const std::vector<cv::Point3f>& appendedPts, const cv::Mat& appendedDescs,
+                                     const std::vector<uint8_t>& appendedRegions) {
+    const uint64_t gen = mWallSyncGen + 1;
+    for (size_t i = 0; i < movedRows.size(); ++i) {
+        mWallKeypoints3D[movedRows[i]] = movedPts[i];
+        mWallRowMoveGen[movedRows[i]] = gen;
+    }
+    const size_t first = mWallKeypoints3D.size(), nAppended = appendedPts.size();
+    if (nAppended > 0) {
+        mWallDescriptors.append(appendedDescs);
+        mWallKeypoints3D.insert(mWallKeypoints3D.end(), appendedPts.begin(), appendedPts.end());
+        // Keep a partition 1:1 with its points: the recorded region where there is one, and BAND —
+        // never backbone — where there is not, as self-grow does with no placement.
+        if (!mWallRegions.empty()) {
+            const bool sent = appendedRegions.size() == nAppended;
+            for (size_t i = 0; i < nAppended; ++i) mWallRegions.push_back(sent ? appendedRegions[i] : kRegionBand);
+        }
+        ++mWallDescGen;
+        indexWallRows((int)first);
+    }
+    if (!movedRows.empty()) {
+        mWallIndex.rebuild(mWallKeypoints3D);
+        mWallPlane.rebuild(mWallKeypoints3D);
+    } else {
+        for (size_t i = first; i < mWallKeypoints3D.size(); ++i) {
+            mWallIndex.insert((int)i, mWallKeypoints3D[i]);
+            mWallPlane.add(mWallKeypoints3D[i]);
+        }
+    }
+    if (!movedRows.empty() || nAppended > 0) {
+        mWallSyncGen = gen;
+        mWallRowAddGen.resize(mWallKeypoints3D.size(), gen);
+        mWallRowMoveGen.resize(mWallKeypoints3D.size(), 0);
+    }
+    return first;
+}
+
+void MobileGS::getPeerFingerprintBase(uint64_t& epoch, uint64_t& gen) const {
+    std::lock_guard<std::mutex> lock(mMutex);
+    const bool valid = mPeer.holds(mWallSyncEpoch);
+    epoch = valid ? mPeer.epoch : 0;
+    gen = valid ? mPeer.gen : 0;
+}
+
 bool MobileGS::relocWantsFrame() {
     if (!mRelocEnabled) return false;
     // EVAL SYNC MODE deliberately does NOT filter by cadence here, and the cost of that is real:
@@ -1639,19 +2917,216 @@ void MobileGS::scheduleRelocCheck(const cv::Mat& f) {
     mRelocCv.notify_one();
 }
 
-extern MobileGS* gSlamEngine;
-namespace mobilegs {
-    std::vector<uint8_t> exportFingerprint() {
-        if (gSlamEngine) return gSlamEngine->exportFingerprint();
-        return {};
+bool MobileGS::loadSuperPoint(const std::vector<uchar>& onnxBytes) {
+    const bool ok = mSuperPoint.load(onnxBytes);
+    if (ok) scheduleModelWarmUp(kWarmSuperPoint);
+    return ok;
+}
+bool MobileGS::loadDistortionHead(const std::vector<uchar>& onnxBytes) {
+    const bool ok = mDistortionHead.load(onnxBytes);
+    if (ok) scheduleModelWarmUp(kWarmDistortionHead);
+    return ok;
+}
+bool MobileGS::loadVocabulary(const std::vector<uchar>& bytes) {
+    // Parsed outside the lock; only the pointer swap and the reindex run under it.
+    auto vocab = std::make_shared<VocabularyTree>();
+    if (!vocab->load(bytes)) return false;
+    std::lock_guard<std::mutex> lock(mMutex);
+    if (vocab->descType() == CV_32F) mVocabFloat = vocab;
+    else                             mVocabBinary = vocab;
+    reindexWallBow();
+    reindexMapBow();
+    LOGI("Vocabulary: %zu words; wall %zu / map %zu indexed", vocab->wordCount(), mWallBow.size(),
+         mMapBow.size());
+    return true;
+}
+bool MobileGS::loadLowLightEnhancer(const std::vector<uchar>& onnxBytes) {
+    const bool ok = mEnhancer.load(onnxBytes);
+    if (ok) scheduleModelWarmUp(kWarmEnhancer);
+    return ok;
+}
+
+void MobileGS::scheduleModelWarmUp(unsigned models) {
+    std::lock_guard<std::mutex> lock(mWarmUpMutex);
+    mWarmUpPending |= models;
+    if (mWarmUpRunning) return; // the live thread re-reads mWarmUpPending before it exits
+    // A finished thread is still joinable; it has already released mWarmUpMutex for the last time,
+    // so this join returns immediately rather than deadlocking on the lock held here.
+    if (mWarmUpThread.joinable()) mWarmUpThread.join();
+    mWarmUpRunning = true;
+    mWarmUpThread = std::thread(&MobileGS::warmUpThreadFunc, this);
+}
+
+void MobileGS::warmUpThreadFunc() {
+    // Same niceness as the reloc worker: this is background work, and the three loads it follows
+    // usually land while the AR session is still starting up on the render thread.
+    setpriority(PRIO_PROCESS, 0, 10);
+    for (;;) {
+        unsigned models;
+        {
+            std::lock_guard<std::mutex> lock(mWarmUpMutex);
+            models = mWarmUpPending;
+            mWarmUpPending = 0;
+            if (models == 0 || !mRelocRunning) {
+                mWarmUpRunning = false;
+                return;
+            }
+        }
+        if (models & kWarmSuperPoint)     mSuperPoint.warmUp();
+        if (models & kWarmDistortionHead) mDistortionHead.warmUp();
+        if (models & kWarmEnhancer)       mEnhancer.warmUp();
+    }
+}
+
+/**
+ * One distortion-head evaluation and everything it publishes. [crop] empty means the pass had no
+ * patch or no correspondences to centre a crop on, so no attempt happened at all.
+ */
+void MobileGS::applyDistortionHead(const cv::Mat& crop, const cv::Rect& cropRect, long passSeq, uint64_t epoch) {
+    // The head's readings below are published under mHeadMutex, so a wall change either lands
+    // before the epoch check (and the result is dropped) or after the stores (and resets them).
+    if (crop.empty()) {
+        // Still a confidence statement, never a progress one.
+        std::lock_guard<std::mutex> lock(mHeadMutex);
+        if (epoch == mHeadEpoch.load(std::memory_order_relaxed)) decayCorroboration();
+        return;
+    }
+    std::array<float, 13> dist{};
+    if (!mDistortionHead.run(crop, dist)) {
+        // Head refused to run — no information either way.
+        std::lock_guard<std::mutex> lock(mHeadMutex);
+        if (epoch == mHeadEpoch.load(std::memory_order_relaxed)) decayCorroboration();
+        return;
+    }
+    std::lock_guard<std::mutex> lock(mHeadMutex);
+    if (epoch != mHeadEpoch.load(std::memory_order_relaxed)) {
+        LOGI("DistortionHead: pass %ld result dropped, wall changed while it ran", passSeq);
+        return;
     }
-    void alignToFingerprint(const uint8_t* data, size_t size) {
-        if (gSlamEngine) gSlamEngine->alignToFingerprint(data, size);
+    std::copy(dist.begin(), dist.end(), mHeadOut);
+    mHeadOutSeq = passSeq;
+    mHeadOutEpoch = epoch;
+    mHeadOutRect = cropRect;
+    const float matchability = dist[11], coverage = dist[12];
+    if (matchability > 0.5f) {
+        // A trusted look at the wall: it measures BOTH channels, and they are different
+        // quantities. Coverage says how much of the design is realized (progress);
+        // matchability says how much to trust this frame (confidence).
+        mPaintingProgress.store(coverage, std::memory_order_relaxed);
+        mCorroborationConfidence.store(matchability, std::memory_order_relaxed);
+    } else {
+        // The head looked and did not recognize the wall. That is a statement about THIS
+        // FRAME, not about the mural, so only confidence decays. Decaying progress here
+        // is what made a three-frame glitch read as the mural being un-painted.
+        decayCorroboration();
     }
+    LOGI("DistortionHead: pass %ld match %.2f coverage %.2f tilt %.0f log2scale %.2f",
+         passSeq, matchability, coverage, dist[8], dist[9]);
+}
+
+void MobileGS::postDistortionHeadJob(cv::Mat crop, const cv::Rect& cropRect, long passSeq, uint64_t epoch) {
+    std::lock_guard<std::mutex> lock(mHeadMutex);
+    if (epoch != mHeadEpoch.load(std::memory_order_relaxed)) return;   // cut around the previous wall
+    mHeadJobCrop = std::move(crop);  // replaces any job still waiting: only the newest matters
+    mHeadJobRect = cropRect;
+    mHeadJobSeq = passSeq;
+    mHeadJobEpoch = epoch;
+    mHeadJobPending = true;
+    if (!mHeadThread.joinable()) mHeadThread = std::thread(&MobileGS::headThreadFunc, this);
+    mHeadCv.notify_one();
 }
 
-bool MobileGS::loadSuperPoint(const std::vector<uchar>& onnxBytes) { return mSuperPoint.load(onnxBytes); }
-bool MobileGS::loadLowLightEnhancer(const std::vector<uchar>& onnxBytes) { return mEnhancer.load(onnxBytes); }
+void MobileGS::headThreadFunc() {
+    // Below the reloc worker (10): this is the one piece of the pass the pose does not wait on.
+    setpriority(PRIO_PROCESS, 0, 15);
+    auto lastRun = std::chrono::steady_clock::time_point();
+    for (;;) {
+        cv::Mat crop;
+        cv::Rect rect;
+        long seq;
+        uint64_t epoch;
+        {
+            std::unique_lock<std::mutex> lock(mHeadMutex);
+            mHeadCv.wait(lock, [this] { return mHeadJobPending || !mRelocRunning; });
+            if (!mRelocRunning) return;
+            // Rate limit by sleeping out the interval BEFORE taking the job, so whatever crop is
+            // newest when the interval ends is the one that runs.
+            const float hz = mHeadRateHz.load(std::memory_order_relaxed);
+            if (hz > 0.0f) {
+                const auto next = lastRun + std::chrono::microseconds((long)(1e6f / hz));
+                mHeadCv.wait_until(lock, next, [this] { return !mRelocRunning; });
+                if (!mRelocRunning) return;
+            }
+            crop = std::move(mHeadJobCrop);
+            rect = mHeadJobRect;
+            seq = mHeadJobSeq;
+            epoch = mHeadJobEpoch;
+            mHeadJobPending = false;
+        }
+        lastRun = std::chrono::steady_clock::now();
+        applyDistortionHead(crop, rect, seq, epoch);
+    }
+}
+
+void MobileGS::invalidateDistortionHead() {
+    std::lock_guard<std::mutex> lock(mHeadMutex);
+    mHeadEpoch.fetch_add(1, std::memory_order_relaxed);
+    mHeadJobPending = false;  // a crop of the previous wall
+    mHeadJobCrop.release();
+    mHeadOutSeq = -1;
+}
+
+/**
+ * The head's corners are the fingerprint patch's TL,TR,BR,BL corners displaced into the current
+ * crop, as offsets normalized by the patch size (docs/DISTORTION_HEAD.md §2). That gives crop <-
+ * patch; the two scalings either side make it current image <- fingerprint image:
+ *   - the crop is a side x side square at cropRect, resized to kPatch for the head;
+ *   - the patch is the WHOLE fingerprint capture frame scaled to kPatch x kPatch (MainViewModel's
+ *     grayPatchBytes). Its size is not stored, so it is taken as twice the principal point — the
+ *     same assumption the map gate's default intrinsics make about the frame.
+ */
+bool MobileGS::headPriorHomography(long passSeq, uint64_t headEpoch, const float* fpIntrinsics4, cv::Mat& Hcur_fp,
+                                   double& tiltDeg) const {
+    if (fpIntrinsics4[0] <= 0.f || fpIntrinsics4[2] <= 0.f || fpIntrinsics4[3] <= 0.f) return false;
+    float dist[13];
+    cv::Rect rect;
+    {
+        std::lock_guard<std::mutex> lock(mHeadMutex);
+        // Another wall's corners would warp this pass toward where the previous wall was.
+        if (mHeadOutSeq < 0 || mHeadOutEpoch != headEpoch || passSeq - mHeadOutSeq > kHeadPriorMaxAge) return false;
+        std::copy(mHeadOut, mHeadOut + 13, dist);
+        rect = mHeadOutRect;
+    }
+    if (rect.width <= 0 || !(dist[11] >= kHeadPriorMinMatchability)) return false;
+
+    const float P = (float)DistortionHead::kPatch;
+    const cv::Point2f src[4] = {{0, 0}, {P, 0}, {P, P}, {0, P}};
+    cv::Point2f dst[4];
+    for (int i = 0; i < 4; ++i) {
+        dst[i] = src[i] + cv::Point2f(dist[2 * i] * P, dist[2 * i + 1] * P);
+        if (!std::isfinite(dst[i].x) || !std::isfinite(dst[i].y)) return false;
+    }
+    cv::Mat Hcrop = cv::getPerspectiveTransform(src, dst);   // crop(kPatch) <- patch
+    // A fold or near-collapse means the regression is nonsense, confidence notwithstanding.
+    const double det = Hcrop.at<double>(0, 0) * Hcrop.at<double>(1, 1)
+                     - Hcrop.at<double>(0, 1) * Hcrop.at<double>(1, 0);
+    if (!(det > 1e-3)) return false;
+
+    const double s = (double)rect.width / (double)P;
+    const cv::Matx33d A(s, 0, rect.x, 0, s, rect.y, 0, 0, 1);                     // current <- crop
+    const cv::Matx33d B(P / (2.0 * fpIntrinsics4[2]), 0, 0,
+                        0, P / (2.0 * fpIntrinsics4[3]), 0, 0, 0, 1);              // patch <- fp image
+    Hcur_fp = cv::Mat(A * cv::Matx33d(Hcrop) * B);
+    tiltDeg = std::abs((double)dist[8]);
+    return true;
+}
+
+void MobileGS::getDistortionHeadResult(float* out15) const {
+    std::lock_guard<std::mutex> lock(mHeadMutex);
+    std::copy(mHeadOut, mHeadOut + 13, out15);
+    out15[13] = (float)mHeadOutSeq;
+    out15[14] = (float)mRelocPassSeq.load(std::memory_order_relaxed);
+}
 // Teleological SLAM, stage 1: store the TARGET artwork as the validator reference. Its features +
 // metric 3D describe "what the wall should become"; tryUpdateFingerprint (stage 2) uses them to decide
 // which new real paint-marks to promote into the live fingerprint as the original marks get covered.
@@ -1765,10 +3240,10 @@ void MobileGS::setWallPatch(const cv::Mat& img) {
     if (img.channels() == 4)      cv::cvtColor(img, gray, cv::COLOR_RGBA2GRAY);
     else if (img.channels() == 3) cv::cvtColor(img, gray, cv::COLOR_RGB2GRAY);
     else                          gray = img;
-    cv::Mat patch;
-    cv::resize(gray, patch, cv::Size(DistortionHead::kPatch, DistortionHead::kPatch));
-    std::lock_guard<std::mutex> lock(mMutex);
-    mWallPatch = patch.clone(); // raw gray, no CLAHE (the head's SuperPoint was trained on raw gray)
+    // Raw gray, no CLAHE (the head's SuperPoint was trained on raw gray). The head owns the patch
+    // and preprocesses it here, once, rather than each reloc pass snapshotting and re-normalizing it.
+    mDistortionHead.setFingerprint(gray);
+    invalidateDistortionHead();   // corners regressed against the old patch
 }
 
 bool MobileGS::getSuperPointFeatures(const cv::Mat& image, std::vector<cv::KeyPoint>& kps, cv::Mat& descs) {
@@ -1954,8 +3429,14 @@ MobileGS::FingerprintData MobileGS::generateFingerprint(
 
     {
         std::lock_guard<std::mutex> lock(mMutex);
-        mWallDescriptors  = fd.descriptors.clone();
+        mWallDescriptors.assign(fd.descriptors);
+        ++mWallDescGen;
         mWallKeypoints3D  = std::move(pts3d);
+        mWallIndex.rebuild(mWallKeypoints3D);
+        mWallPlane.rebuild(mWallKeypoints3D);
+        reindexWallBow();
+        resetRefinement();
+        restartWallSync();
         // The depth path supplies no partition. Clearing rather than leaving the previous
         // fingerprint's is not optional: those bytes index a point set that no longer exists.
         mWallRegions.clear();
@@ -8,25 +8,113 @@
 #define LOGD(...) __android_log_print(ANDROID_LOG_DEBUG, "SuperPoint", __VA_ARGS__)
 #define LOGE(...) __android_log_print(ANDROID_LOG_ERROR, "SuperPoint", __VA_ARGS__)
 
-bool SuperPointDetector::load(const std::vector<uchar>& onnxBytes) {
-    std::lock_guard<std::mutex> lock(mMutex);
+bool SuperPointDetector::load(const std::vector<uchar>& onnxBytes,
+                              const InferenceBackend::Options& opts,
+                              int poolSize) {
+    poolSize = std::max(1, std::min(kMaxPoolSize, poolSize));
+    // Build the replacement pool before taking the lock: parsing the ONNX graph is the slow part,
+    // and doing it under mPoolMutex would stall every detect for the whole reload.
+    std::vector<std::unique_ptr<Instance>> fresh;
+    for (int i = 0; i < poolSize; ++i) {
+        auto inst = std::make_unique<Instance>();
+        inst->backend = InferenceBackend::create(opts.kind);
+        if (!inst->backend->load(onnxBytes, opts) || inst->backend->empty()) {
+            LOGE("SuperPoint: failed to load ONNX (instance %d of %d)", i + 1, poolSize);
+            fresh.clear();
+            break;
+        }
+        fresh.push_back(std::move(inst));
+    }
+
+    std::unique_lock<std::mutex> lock(mPoolMutex);
     mLoaded = false;
-    try {
-        mNet = cv::dnn::readNetFromONNX(onnxBytes);
-        mNet.setPreferableBackend(cv::dnn::DNN_BACKEND_DEFAULT);
-        if (cv::ocl::haveOpenCL()) {
-            mNet.setPreferableTarget(cv::dnn::DNN_TARGET_OPENCL);
-            LOGD("SuperPoint: using OpenCL backend");
-        } else {
-            mNet.setPreferableTarget(cv::dnn::DNN_TARGET_CPU);
-            LOGD("SuperPoint: OpenCL unavailable, using CPU backend");
+    // Never free an instance a detect is still running on.
+    mPoolCv.wait(lock, [this] { return mFree.size() == mPool.size(); });
+    mPool = std::move(fresh);
+    mFree.clear();
+    for (auto& inst : mPool) mFree.push_back(inst.get());
+    mLoaded = !mPool.empty();
+    mBatchSupport = kBatchUnknown; // a different export may well differ; warmUp() probes it
+    if (mLoaded) LOGD("SuperPoint: %zu instance(s) on %s", mPool.size(), mPool[0]->backend->name());
+    lock.unlock();
+    mPoolCv.notify_all();
+    return mLoaded;
+}
+
+SuperPointDetector::Instance* SuperPointDetector::acquire() {
+    std::unique_lock<std::mutex> lock(mPoolMutex);
+    mPoolCv.wait(lock, [this] { return !mFree.empty() || mPool.empty(); });
+    if (mPool.empty()) return nullptr;
+    Instance* inst = mFree.back();
+    mFree.pop_back();
+    return inst;
+}
+
+void SuperPointDetector::release(Instance* inst) {
+    {
+        std::lock_guard<std::mutex> lock(mPoolMutex);
+        mFree.push_back(inst);
+    }
+    // notify_all, not notify_one: a pending load() waits for ALL instances, and a single wake-up
+    // could land on it and be spent while a detect that could have run stays asleep.
+    mPoolCv.notify_all();
+}
+
+bool SuperPointDetector::warmUp() {
+    if (!mLoaded) return false;
+    bool allOk = true;
+    // By index and by identity, so every instance is warmed exactly once even while detects are
+    // checking instances in and out around this loop.
+    for (size_t i = 0;; ++i) {
+        Instance* inst = nullptr;
+        {
+            std::unique_lock<std::mutex> lock(mPoolMutex);
+            if (i >= mPool.size()) break;
+            Instance* want = mPool[i].get();
+            mPoolCv.wait(lock, [&] {
+                return i >= mPool.size() || mPool[i].get() != want ||
+                       std::find(mFree.begin(), mFree.end(), want) != mFree.end();
+            });
+            // Reloaded underneath us: the new pool is queued for its own warm-up by the loader.
+            if (i >= mPool.size() || mPool[i].get() != want) break;
+            mFree.erase(std::find(mFree.begin(), mFree.end(), want));
+            inst = want;
         }
-        bool ok = !mNet.empty();
-        mLoaded = ok;
-        return ok;
+        inst->input = cv::Mat::zeros(kWarmUpH, kWarmUpW, CV_32F);
+        inst->backend->setInput(inference::wrapGrayAsBlob(inst->input));
+        const bool ok = inst->backend->forward(inst->outputs);
+        LOGD("SuperPoint: warm-up %zu %s in %.1f ms", i, ok ? "done" : "FAILED",
+             inst->backend->lastForwardMs());
+        // The batch probe runs once, on the first instance that warmed: every instance holds the
+        // same graph, so one answer covers the pool.
+        if (ok && mBatchSupport.load(std::memory_order_relaxed) == kBatchUnknown) probeBatch(*inst);
+        allOk = allOk && ok;
+        release(inst);
+    }
+    return allOk;
+}
+
+void SuperPointDetector::probeBatch(Instance& inst) {
+    // A [2,1,H,W] zero blob at the warm-up shape. A graph exported with a fixed batch of 1 either
+    // throws or answers for item 0 only; anything else batches. Decided here, on a single-item
+    // forward that just succeeded on this instance, so the answer is about the export and not a
+    // transient failure in the middle of a reloc pass.
+    const int sz[4] = {kBatchProbe, 1, kWarmUpH, kWarmUpW};
+    bool batched = false;
+    try {
+        inst.input.create(4, sz, CV_32F);
+        inst.input.setTo(0.0f);
+        inst.backend->setInput(inst.input);
+        const cv::Mat* semiPtr = nullptr;
+        const cv::Mat* descPtr = nullptr;
+        batched = inst.backend->forward(inst.outputs) &&
+                  findOutputs(inst.outputs, semiPtr, descPtr) &&
+                  semiPtr->size[0] == kBatchProbe && descPtr->size[0] == kBatchProbe;
     } catch (...) {
-        return false;
+        batched = false;
     }
+    mBatchSupport.store(batched ? kBatchYes : kBatchNo, std::memory_order_relaxed);
+    LOGD("SuperPoint: batched forward %s by this model", batched ? "supported" : "unsupported");
 }
 
 bool SuperPointDetector::detect(const cv::Mat& gray,
@@ -37,103 +125,220 @@ bool SuperPointDetector::detect(const cv::Mat& gray,
     return detect(gray, kps, descs, cv::Mat(), scoreThresh, maxKps);
 }
 
-bool SuperPointDetector::detect(const cv::Mat& gray,
-                                std::vector<cv::KeyPoint>& kps,
-                                cv::Mat& descs,
-                                const cv::Mat& mask,
-                                float scoreThresh,
-                                int   maxKps) {
-    if (!mLoaded) return false;
-    std::lock_guard<std::mutex> lock(mMutex);
-    if (mNet.empty()) return false;
-
-    cv::Mat input;
-    cv::Mat resizedMask;
-    float scaleX = 1.0f, scaleY = 1.0f;
+SuperPointDetector::Prepared SuperPointDetector::prepare(const cv::Mat& gray, const cv::Mat& mask) {
+    Prepared p;
     if (gray.cols > 640 || gray.rows > 480) {
         int targetW = 640;
         int targetH = 480;
-        cv::resize(gray, input, cv::Size(targetW, targetH), 0, 0, cv::INTER_AREA);
+        cv::resize(gray, p.input, cv::Size(targetW, targetH), 0, 0, cv::INTER_AREA);
         if (!mask.empty()) {
-            cv::resize(mask, resizedMask, cv::Size(targetW, targetH), 0, 0, cv::INTER_NEAREST);
+            cv::resize(mask, p.mask, cv::Size(targetW, targetH), 0, 0, cv::INTER_NEAREST);
         }
-        scaleX = (float)gray.cols / (float)targetW;
-        scaleY = (float)gray.rows / (float)targetH;
+        p.scaleX = (float)gray.cols / (float)targetW;
+        p.scaleY = (float)gray.rows / (float)targetH;
     } else {
         int targetW = (gray.cols / 8) * 8;
         int targetH = (gray.rows / 8) * 8;
         if (targetW != gray.cols || targetH != gray.rows) {
-            cv::resize(gray, input, cv::Size(targetW, targetH), 0, 0, cv::INTER_AREA);
+            cv::resize(gray, p.input, cv::Size(targetW, targetH), 0, 0, cv::INTER_AREA);
             if (!mask.empty()) {
-                cv::resize(mask, resizedMask, cv::Size(targetW, targetH), 0, 0, cv::INTER_NEAREST);
+                cv::resize(mask, p.mask, cv::Size(targetW, targetH), 0, 0, cv::INTER_NEAREST);
             }
-            scaleX = (float)gray.cols / (float)targetW;
-            scaleY = (float)gray.rows / (float)targetH;
+            p.scaleX = (float)gray.cols / (float)targetW;
+            p.scaleY = (float)gray.rows / (float)targetH;
         } else {
-            input = gray;
-            resizedMask = mask;
+            p.input = gray;
+            p.mask = mask;
         }
     }
+    return p;
+}
 
-    cv::Mat f;
-    input.convertTo(f, CV_32F, 1.0 / 255.0);
-    cv::Mat blob = cv::dnn::blobFromImage(f);
+bool SuperPointDetector::findOutputs(const std::vector<cv::Mat>& outputs,
+                                     const cv::Mat*& semiPtr, const cv::Mat*& descPtr) {
+    semiPtr = nullptr;
+    descPtr = nullptr;
+    for (const cv::Mat& o : outputs) {
+        if (o.dims < 4) continue;
+        LOGD("SuperPoint: Output shape [%d, %d, %d, %d]", o.size[0], o.size[1], o.size[2], o.size[3]);
+        if (o.size[1] == 65)  semiPtr = &o;
+        if (o.size[1] == 256) descPtr = &o;
+    }
 
-    try {
-        mNet.setInput(blob);
-        std::vector<cv::String> outNames = mNet.getUnconnectedOutLayersNames();
-        std::vector<cv::Mat> outputs;
-        mNet.forward(outputs, outNames);
+    if (!semiPtr) LOGE("SuperPoint: heatmap output (65 channels) not found");
+    if (!descPtr) LOGE("SuperPoint: descriptor output (256 channels) not found");
+
+    return semiPtr && descPtr;
+}
+
+bool SuperPointDetector::decode(const cv::Mat& semi, const cv::Mat& desc, const Prepared& p,
+                                std::vector<cv::KeyPoint>& kps, cv::Mat& descs,
+                                float scoreThresh, int maxKps) {
+    kps.clear();
+    extractKeypoints(semi, kps, scoreThresh, maxKps);
+
+    if (!p.mask.empty()) {
+        std::vector<cv::KeyPoint> filtered;
+        for (const auto& kp : kps) {
+            int ix = static_cast<int>(kp.pt.x);
+            int iy = static_cast<int>(kp.pt.y);
+            if (ix >= 0 && ix < p.mask.cols && iy >= 0 && iy < p.mask.rows) {
+                if (p.mask.at<uchar>(iy, ix) > 0) filtered.push_back(kp);
+            }
+        }
+        kps = std::move(filtered);
+    }
+
+    if (kps.empty()) return false;
+
+    // Sample descriptors while keypoints are still in network-input space
+    // (the descriptor tensor is at input/8 resolution). Only after sampling
+    // do we rescale the keypoints back to original image space for the caller.
+    descs = cv::Mat();
+    sampleDescriptors(desc, kps, descs);
+
+    if (p.scaleX != 1.0f || p.scaleY != 1.0f) {
+        for (auto& kp : kps) { kp.pt.x *= p.scaleX; kp.pt.y *= p.scaleY; }
+    }
+    return true;
+}
 
-        if (outputs.empty()) {
+bool SuperPointDetector::detect(const cv::Mat& gray,
+                                std::vector<cv::KeyPoint>& kps,
+                                cv::Mat& descs,
+                                const cv::Mat& mask,
+                                float scoreThresh,
+                                int   maxKps) {
+    if (!mLoaded) return false;
+    Lease lease(*this);
+    Instance* inst = lease.inst;
+    if (!inst) return false;
+
+    const Prepared p = prepare(gray, mask);
+
+    // Into the instance's own buffer: convertTo reuses it whenever the shape matches the last
+    // detect on this instance, which for the camera path is every time.
+    p.input.convertTo(inst->input, CV_32F, 1.0 / 255.0);
+    // One channel: the float image already IS the [1,1,H,W] blob; bind it without blobFromImage's copy.
+    cv::Mat blob = inference::wrapGrayAsBlob(inst->input);
+
+    try {
+        inst->backend->setInput(blob);
+        std::vector<cv::Mat>& outputs = inst->outputs;
+        if (!inst->backend->forward(outputs) || outputs.empty()) {
             LOGE("SuperPoint: forward() produced no outputs");
             return false;
         }
-
         const cv::Mat* semiPtr = nullptr;
         const cv::Mat* descPtr = nullptr;
-        for (const cv::Mat& o : outputs) {
-            if (o.dims < 4) continue;
-            LOGD("SuperPoint: Output shape [%d, %d, %d, %d]", o.size[0], o.size[1], o.size[2], o.size[3]);
-            if (o.size[1] == 65)  semiPtr = &o;
-            if (o.size[1] == 256) descPtr = &o;
-        }
+        if (!findOutputs(outputs, semiPtr, descPtr)) return false;
+        return decode(*semiPtr, *descPtr, p, kps, descs, scoreThresh, maxKps);
+    } catch (...) {
+        return false;
+    }
+}
 
-        if (!semiPtr) LOGE("SuperPoint: heatmap output (65 channels) not found");
-        if (!descPtr) LOGE("SuperPoint: descriptor output (256 channels) not found");
+namespace {
+// Item [i] of an [N,C,H,W] tensor as a [1,C,H,W] header over the same memory.
+cv::Mat batchItem(const cv::Mat& t, int i) {
+    const int sz[4] = {1, t.size[1], t.size[2], t.size[3]};
+    const size_t plane = (size_t)t.size[1] * t.size[2] * t.size[3];
+    return cv::Mat(4, sz, CV_32F, const_cast<float*>(t.ptr<float>()) + plane * (size_t)i);
+}
+} // namespace
 
-        if (!semiPtr || !descPtr) return false;
+int SuperPointDetector::detectBatch(const std::vector<cv::Mat>& grays,
+                                    std::vector<std::vector<cv::KeyPoint>>& kps,
+                                    std::vector<cv::Mat>& descs,
+                                    std::vector<bool>& ok,
+                                    float scoreThresh,
+                                    int   maxKps) {
+    const size_t n = grays.size();
+    kps.assign(n, {});
+    descs.assign(n, cv::Mat());
+    ok.assign(n, false);
+    if (!mLoaded || n == 0) return 0;
+    Lease lease(*this);
+    Instance* inst = lease.inst;
+    if (!inst) return 0;
 
-        kps.clear();
-        extractKeypoints(*semiPtr, kps, scoreThresh, maxKps);
+    std::vector<Prepared> prep(n);
+    for (size_t i = 0; i < n; ++i) {
+        if (!grays[i].empty()) prep[i] = prepare(grays[i], cv::Mat());
+    }
+
+    // Each item in its own try, so one bad forward costs that item only, as a detect() would.
+    auto runOne = [&](size_t i) {
+        try {
+            prep[i].input.convertTo(inst->input, CV_32F, 1.0 / 255.0);
+            inst->backend->setInput(inference::wrapGrayAsBlob(inst->input));
+            const cv::Mat* semiPtr = nullptr;
+            const cv::Mat* descPtr = nullptr;
+            if (!inst->backend->forward(inst->outputs) || !findOutputs(inst->outputs, semiPtr, descPtr)) return;
+            ok[i] = decode(*semiPtr, *descPtr, prep[i], kps[i], descs[i], scoreThresh, maxKps);
+        } catch (...) {
+            ok[i] = false;
+        }
+    };
+    // Batch only on a model warmUp() has seen batch; unprobed or fixed-batch ones run singly.
+    const bool batching = mBatchSupport.load(std::memory_order_relaxed) == kBatchYes;
 
-        if (!resizedMask.empty()) {
-            std::vector<cv::KeyPoint> filtered;
-            for (const auto& kp : kps) {
-                int ix = static_cast<int>(kp.pt.x);
-                int iy = static_cast<int>(kp.pt.y);
-                if (ix >= 0 && ix < resizedMask.cols && iy >= 0 && iy < resizedMask.rows) {
-                    if (resizedMask.at<uchar>(iy, ix) > 0) filtered.push_back(kp);
+    // Group by PREPARED shape, not input shape: anything over 640x480 is resized down to exactly
+    // that, so a 2x-upscaled frame and the plain frame usually land in the same group.
+    std::vector<char> done(n, 0);
+    for (size_t i = 0; i < n; ++i) {
+        if (done[i] || prep[i].input.empty()) continue;
+        const cv::Size shape = prep[i].input.size();
+        std::vector<size_t> group;
+        for (size_t j = i; j < n; ++j) {
+            if (!done[j] && !prep[j].input.empty() && prep[j].input.size() == shape) {
+                group.push_back(j);
+                done[j] = 1;
+            }
+        }
+        if (group.size() == 1 || !batching) {
+            for (size_t j : group) runOne(j);
+            continue;
+        }
+        bool batchedOk = false;
+        try {
+            const int sz[4] = {(int)group.size(), 1, shape.height, shape.width};
+            inst->input.create(4, sz, CV_32F);
+            for (size_t g = 0; g < group.size(); ++g) {
+                cv::Mat plane(shape, CV_32F, inst->input.ptr<float>() + (size_t)g * shape.area());
+                prep[group[g]].input.convertTo(plane, CV_32F, 1.0 / 255.0);
+            }
+            inst->backend->setInput(inst->input);
+            const cv::Mat* semiPtr = nullptr;
+            const cv::Mat* descPtr = nullptr;
+            const bool fwd = inst->backend->forward(inst->outputs) &&
+                             findOutputs(inst->outputs, semiPtr, descPtr) &&
+                             semiPtr->size[0] == (int)group.size() &&
+                             descPtr->size[0] == (int)group.size();
+            if (fwd) {
+                for (size_t g = 0; g < group.size(); ++g) {
+                    const size_t j = group[g];
+                    ok[j] = decode(batchItem(*semiPtr, (int)g), batchItem(*descPtr, (int)g), prep[j],
+                                   kps[j], descs[j], scoreThresh, maxKps);
                 }
+                batchedOk = true;
             }
-            kps = std::move(filtered);
+        } catch (...) {
+            batchedOk = false;
         }
-
-        if (kps.empty()) return false;
-
-        // Sample descriptors while keypoints are still in network-input space
-        // (the descriptor tensor is at input/8 resolution). Only after sampling
-        // do we rescale the keypoints back to original image space for the caller.
-        descs = cv::Mat();
-        sampleDescriptors(*descPtr, kps, descs);
-
-        if (scaleX != 1.0f || scaleY != 1.0f) {
-            for (auto& kp : kps) { kp.pt.x *= scaleX; kp.pt.y *= scaleY; }
+        if (!batchedOk) {
+            // The model batched at warm-up, so this is this forward failing, not the export: answer
+            // the group one item at a time and keep batching the next one.
+            LOGD("SuperPoint: batched forward of %zu failed; running items singly", group.size());
+            for (size_t j : group) {
+                ok[j] = false;
+                kps[j].clear();
+                descs[j] = cv::Mat();
+                runOne(j);
+            }
         }
-        return true;
-    } catch (...) {
-        return false;
     }
+    return (int)std::count(ok.begin(), ok.end(), true);
 }
 
 void SuperPointDetector::extractKeypoints(const cv::Mat& semiTensor, std::vector<cv::KeyPoint>& kps, float thresh, int maxKps) {
@@ -0,0 +1,112 @@
+#include "include/VocabularyTree.h"
+#include "include/DescriptorDistance.h"
+#include <android/log.h>
+#include <algorithm>
+#include <cfloat>
+#include <cstring>
+
+#define LOGD(...) __android_log_print(ANDROID_LOG_DEBUG, "VocabularyTree", __VA_ARGS__)
+#define LOGE(...) __android_log_print(ANDROID_LOG_ERROR, "VocabularyTree", __VA_ARGS__)
+
+bool VocabularyTree::load(const std::vector<uchar>& bytes) {
+    mCentroids.release();
+    mChildren.clear();
+    mDepth.clear();
+    mWordOfNode.clear();
+    mWordIdf.clear();
+    mDescType = -1;
+
+    // Asset bytes, but validated like peer bytes: every length in 64-bit and checked before the
+    // cv::Mat is allocated, so a truncated or mismatched file is refused rather than read past.
+    const uint8_t* p = bytes.data();
+    const uint8_t* end = p + bytes.size();
+    auto get = [&](void* dst, size_t len) {
+        if ((size_t)(end - p) < len) return false;
+        memcpy(dst, p, len);
+        p += len;
+        return true;
+    };
+    char magic[4];
+    uint32_t version = 0, branching = 0, depth = 0, cols = 0, nodeCount = 0;
+    int32_t type = -1;
+    if (!get(magic, 4) || memcmp(magic, "GXVT", 4) != 0) { LOGE("bad magic"); return false; }
+    if (!get(&version, 4) || version != 1) { LOGE("unsupported version %u", version); return false; }
+    if (!get(&branching, 4) || !get(&depth, 4) || !get(&type, 4) || !get(&cols, 4) || !get(&nodeCount, 4))
+        return false;
+    if ((type != CV_32F && type != CV_8U) || cols == 0 || cols > 4096 || branching < 2 || depth == 0 ||
+        depth > 16 || nodeCount < 2) {
+        LOGE("bad header (type %d cols %u k %u L %u nodes %u)", type, cols, branching, depth, nodeCount);
+        return false;
+    }
+    const uint64_t elem = (type == CV_32F) ? 4u : 1u;
+    const uint64_t record = 4u + 4u + (uint64_t)cols * elem;
+    if ((uint64_t)(end - p) != record * (uint64_t)nodeCount) {
+        LOGE("size mismatch: %zu bytes for %u nodes", (size_t)(end - p), nodeCount);
+        return false;
+    }
+
+    cv::Mat centroids((int)nodeCount, (int)cols, type);
+    std::vector<std::vector<uint32_t>> children(nodeCount);
+    std::vector<int> nodeDepth(nodeCount, 0);
+    std::vector<float> idfOfNode(nodeCount, 0.0f);
+    for (uint32_t i = 0; i < nodeCount; ++i) {
+        uint32_t parent;
+        float idf;
+        get(&parent, 4);
+        get(&idf, 4);
+        get(centroids.ptr((int)i), (size_t)cols * (size_t)elem);
+        if (i == 0) {
+            if (parent != UINT32_MAX) { LOGE("node 0 is not the root"); return false; }
+            continue;
+        }
+        if (parent >= i) { LOGE("node %u precedes its parent %u", i, parent); return false; }
+        nodeDepth[i] = nodeDepth[parent] + 1;
+        if (nodeDepth[i] > (int)depth) { LOGE("node %u deeper than %u", i, depth); return false; }
+        children[parent].push_back(i);
+        idfOfNode[i] = idf;
+    }
+
+    std::vector<uint32_t> wordOfNode(nodeCount, UINT32_MAX);
+    std::vector<float> wordIdf;
+    for (uint32_t i = 1; i < nodeCount; ++i) {
+        if (!children[i].empty()) continue;
+        wordOfNode[i] = (uint32_t)wordIdf.size();
+        wordIdf.push_back(idfOfNode[i]);
+    }
+    if (wordIdf.empty()) return false;
+
+    mCentroids = centroids;
+    mChildren = std::move(children);
+    mDepth = std::move(nodeDepth);
+    mWordOfNode = std::move(wordOfNode);
+    mWordIdf = std::move(wordIdf);
+    mDescType = type;
+    mDirectDepth = std::max(1, (int)depth - kDirectLevelsUp);
+    LOGD("loaded: %s x%u, k=%u L=%u, %zu words", type == CV_32F ? "float" : "binary", cols, branching,
+         depth, mWordIdf.size());
+    return true;
+}
+
+void VocabularyTree::quantize(const cv::Mat& descs, std::vector<uint32_t>& words,
+                              std::vector<uint32_t>& nodes) const {
+    words.clear();
+    nodes.clear();
+    if (!compatible(descs)) return;
+    words.resize((size_t)descs.rows);
+    nodes.resize((size_t)descs.rows);
+    for (int r = 0; r < descs.rows; ++r) {
+        uint32_t node = 0, direct = 0;
+        while (!mChildren[node].empty()) {
+            float best = FLT_MAX;
+            uint32_t next = mChildren[node].front();
+            for (uint32_t c : mChildren[node]) {
+                const float d = descdist::row(descs, r, mCentroids, (int)c);
+                if (d < best) { best = d; next = c; }
+            }
+            node = next;
+            if (mDepth[node] <= mDirectDepth) direct = node;
+        }
+        words[(size_t)r] = mWordOfNode[node];
+        nodes[(size_t)r] = direct;
+    }
+}
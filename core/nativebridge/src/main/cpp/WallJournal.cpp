@@ -0,0 +1,207 @@
+#include "include/WallJournal.h"
+#include <android/log.h>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <fstream>
+#include <iterator>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define LOGD(...) __android_log_print(ANDROID_LOG_DEBUG, "WallJournal", __VA_ARGS__)
+#define LOGE(...) __android_log_print(ANDROID_LOG_ERROR, "WallJournal", __VA_ARGS__)
+
+// Fields are written and read with memcpy: every Android ABI is little-endian, which is what the
+// format specifies, and cv::Point3f is three packed floats.
+static_assert(sizeof(cv::Point3f) == 3 * sizeof(float), "points are written as 3 floats");
+
+namespace {
+
+constexpr size_t kHeaderBytes = 32;
+constexpr size_t kFrameBytes = 8;
+constexpr size_t kRecordBytes = 2 * 4 + sizeof(cv::Point3f) + 4 + 4;
+constexpr uint32_t kMapFrame = 1u << 0;
+
+struct Reader {
+    const uint8_t* p;
+    const uint8_t* end;
+    bool take(void* dst, size_t n) {
+        if ((size_t)(end - p) < n) return false;
+        memcpy(dst, p, n);
+        p += n;
+        return true;
+    }
+};
+
+bool validDescShape(int32_t type, uint32_t cols) {
+    const int depth = CV_MAT_DEPTH(type), channels = CV_MAT_CN(type);
+    return depth >= 0 && depth <= CV_64F && channels >= 1 && channels <= 4 && cols > 0 && cols <= 4096;
+}
+
+}  // namespace
+
+std::vector<uint8_t> WallJournal::Batch::encode() const {
+    const std::vector<uint8_t> wallBytes = hasWall ? wall.encode() : std::vector<uint8_t>();
+    uint32_t nAdds = 0;
+    for (const MapRecord& r : map) nAdds += r.op == kMapAdd ? 1 : 0;
+    const bool withDescs = nAdds > 0 && mapAdded.rows == (int)nAdds && mapAdded.isContinuous();
+    if (nAdds > 0 && !withDescs) return {};   // never a map point without its descriptor
+    if (hasWall && wallBytes.empty()) return {};
+
+    const int32_t descType = withDescs ? mapAdded.type() : -1;
+    const uint32_t descCols = withDescs ? (uint32_t)mapAdded.cols : 0;
+    const size_t descBytes = withDescs ? mapAdded.total() * mapAdded.elemSize() : 0;
+    const uint32_t flags = hasMapFrame ? kMapFrame : 0u;
+    const uint32_t nWall = (uint32_t)wallBytes.size(), nOps = (uint32_t)map.size();
+
+    std::vector<uint8_t> out(4 + wallBytes.size() + 4 + (hasMapFrame ? 20 * sizeof(float) : 0) + 4 * 4 +
+                             map.size() * kRecordBytes + descBytes);
+    uint8_t* p = out.data();
+    auto put = [&](const void* src, size_t len) { if (len) memcpy(p, src, len); p += len; };
+    put(&nWall, 4);
+    put(wallBytes.data(), wallBytes.size());
+    put(&flags, 4);
+    if (hasMapFrame) {
+        put(mapAnchor, sizeof(mapAnchor));
+        put(mapIntrinsics, sizeof(mapIntrinsics));
+    }
+    put(&descType, 4); put(&descCols, 4); put(&nOps, 4); put(&nAdds, 4);
+    for (const MapRecord& r : map) {
+        put(&r.op, 4); put(&r.row, 4); put(&r.pt, sizeof(cv::Point3f)); put(&r.conf, 4); put(&r.obs, 4);
+    }
+    put(withDescs ? mapAdded.data : nullptr, descBytes);
+    return out;
+}
+
+bool WallJournal::Batch::decode(const uint8_t* data, size_t size, Batch& out) {
+    out.clear();
+    if (!data) return false;
+    Reader r{data, data + size};
+    uint32_t nWall = 0, flags = 0, descCols = 0, nOps = 0, nAdds = 0;
+    int32_t descType = -1;
+    if (!r.take(&nWall, 4) || nWall > (size_t)(r.end - r.p)) return false;
+    if (nWall > 0) {
+        if (!FingerprintDelta::decode(r.p, nWall, out.wall) || out.wall.full()) return false;
+        out.hasWall = true;
+        r.p += nWall;
+    }
+    if (!r.take(&flags, 4)) return false;
+    if (flags & kMapFrame) {
+        if (!r.take(out.mapAnchor, sizeof(out.mapAnchor)) || !r.take(out.mapIntrinsics, sizeof(out.mapIntrinsics)))
+            return false;
+        out.hasMapFrame = true;
+    }
+    if (!r.take(&descType, 4) || !r.take(&descCols, 4) || !r.take(&nOps, 4) || !r.take(&nAdds, 4)) return false;
+    if (nOps > kMaxOps || nAdds > nOps) return false;
+    if (nAdds > 0 && !validDescShape(descType, descCols)) return false;
+    const uint64_t descBytes = nAdds > 0 ? (uint64_t)nAdds * descCols * CV_ELEM_SIZE(descType) : 0;
+    if ((uint64_t)(r.end - r.p) != (uint64_t)nOps * kRecordBytes + descBytes) return false;
+
+    out.map.resize(nOps);
+    uint32_t adds = 0;
+    for (MapRecord& m : out.map) {
+        r.take(&m.op, 4); r.take(&m.row, 4); r.take(&m.pt, sizeof(cv::Point3f)); r.take(&m.conf, 4); r.take(&m.obs, 4);
+        if (m.op != kMapAdd && m.op != kMapRemove && m.op != kMapSet) return false;
+        adds += m.op == kMapAdd ? 1 : 0;
+    }
+    if (adds != nAdds) return false;
+    if (nAdds > 0) {
+        out.mapAdded.create((int)nAdds, (int)descCols, descType);
+        r.take(out.mapAdded.data, (size_t)descBytes);
+    }
+    return true;
+}
+
+std::string WallJournal::pathFor(const std::string& sidecarPath) {
+    static const std::string kExt = ".gxws";
+    if (sidecarPath.size() > kExt.size() &&
+            sidecarPath.compare(sidecarPath.size() - kExt.size(), kExt.size(), kExt) == 0)
+        return sidecarPath.substr(0, sidecarPath.size() - kExt.size()) + ".gxwj";
+    return sidecarPath + ".gxwj";
+}
+
+bool WallJournal::start(const std::string& path, const WallSidecar::Stamp& base) {
+    uint8_t header[kHeaderBytes] = {};
+    const uint32_t version = kVersion;
+    memcpy(header, "GXWJ", 4);
+    memcpy(header + 4, &version, 4);
+    memcpy(header + 8, &base.crc, 4);
+    memcpy(header + 16, &base.bytes, 8);
+    const std::string tmp = path + ".tmp";
+    std::ofstream f(tmp, std::ios::binary | std::ios::trunc);
+    f.write(reinterpret_cast<const char*>(header), kHeaderBytes);
+    f.close();
+    if (!f || std::rename(tmp.c_str(), path.c_str()) != 0) {
+        LOGE("cannot start %s", path.c_str());
+        std::remove(tmp.c_str());
+        return false;
+    }
+    return true;
+}
+
+bool WallJournal::append(const std::string& path, const Batch& b, uint64_t& fileBytes) {
+    const std::vector<uint8_t> payload = b.encode();
+    if (payload.empty()) return false;
+    // One write of frame and payload, so a kill tears at most this batch.
+    std::vector<uint8_t> frame(kFrameBytes + payload.size());
+    const uint32_t len = (uint32_t)payload.size(), crc = WallSidecar::crc32(payload.data(), payload.size());
+    memcpy(frame.data(), &len, 4);
+    memcpy(frame.data() + 4, &crc, 4);
+    memcpy(frame.data() + kFrameBytes, payload.data(), payload.size());
+
+    // No O_CREAT: a journal only ever follows start(), and one deleted since has no base to extend.
+    const int fd = ::open(path.c_str(), O_WRONLY | O_APPEND | O_CLOEXEC);
+    if (fd < 0) { LOGE("cannot open %s", path.c_str()); return false; }
+    size_t done = 0;
+    while (done < frame.size()) {
+        const ssize_t n = ::write(fd, frame.data() + done, frame.size() - done);
+        if (n <= 0) break;
+        done += (size_t)n;
+    }
+    // A killed app loses nothing the kernel has; this is for the phone that dies with it.
+    const bool ok = done == frame.size() && ::fdatasync(fd) == 0;
+    struct stat st;
+    fileBytes = (ok && fstat(fd, &st) == 0) ? (uint64_t)st.st_size : 0;
+    ::close(fd);
+    if (!ok) LOGE("append to %s failed", path.c_str());
+    return ok;
+}
+
+bool WallJournal::read(const std::string& path, const WallSidecar::Stamp& base, std::vector<Batch>& out) {
+    out.clear();
+    std::ifstream f(path, std::ios::binary);
+    if (!f) return false;
+    const std::vector<uint8_t> bytes((std::istreambuf_iterator<char>(f)), std::istreambuf_iterator<char>());
+    f.close();
+    uint32_t version = 0, crc = 0;
+    uint64_t baseBytes = 0;
+    if (bytes.size() < kHeaderBytes || memcmp(bytes.data(), "GXWJ", 4) != 0) return false;
+    memcpy(&version, bytes.data() + 4, 4);
+    memcpy(&crc, bytes.data() + 8, 4);
+    memcpy(&baseBytes, bytes.data() + 16, 8);
+    if (version != kVersion) { LOGE("unsupported version %u", version); return false; }
+    if (crc != base.crc || baseBytes != base.bytes) { LOGD("%s extends another sidecar; ignored", path.c_str()); return false; }
+
+    size_t at = kHeaderBytes;
+    while (bytes.size() - at >= kFrameBytes) {
+        uint32_t len = 0, sum = 0;
+        memcpy(&len, bytes.data() + at, 4);
+        memcpy(&sum, bytes.data() + at + 4, 4);
+        if (len > bytes.size() - at - kFrameBytes) break;
+        const uint8_t* payload = bytes.data() + at + kFrameBytes;
+        Batch b;
+        if (WallSidecar::crc32(payload, len) != sum || !Batch::decode(payload, len, b)) break;
+        out.push_back(std::move(b));
+        at += kFrameBytes + len;
+    }
+    if (at < bytes.size()) {
+        LOGE("%s: dropping %zu bytes after batch %zu", path.c_str(), bytes.size() - at, out.size());
+        if (::truncate(path.c_str(), (off_t)at) != 0) {
+            // Appending after garbage would strand every later batch behind it.
+            LOGE("cannot truncate %s", path.c_str());
+            out.clear();
+            return false;
+        }
+    }
+    return true;
+}
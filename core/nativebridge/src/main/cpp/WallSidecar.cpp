@@ -0,0 +1,365 @@
+#include "include/WallSidecar.h"
+#include "include/DescriptorCodec.h"
+#include <android/log.h>
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <fstream>
+#include <memory>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define LOGD(...) __android_log_print(ANDROID_LOG_DEBUG, "WallSidecar", __VA_ARGS__)
+#define LOGE(...) __android_log_print(ANDROID_LOG_ERROR, "WallSidecar", __VA_ARGS__)
+
+// Fields are written and read with memcpy: every Android ABI is little-endian, which is what the
+// format specifies, and cv::Point3f is three packed floats, which is what a points section holds.
+static_assert(sizeof(cv::Point3f) == 3 * sizeof(float), "points are written as N x 3 floats");
+
+namespace {
+
+constexpr size_t kHeaderBytes = 32;
+constexpr size_t kEntryBytes = 32;
+constexpr uint32_t kMaxSections = 64;
+
+// CRC-32 (IEEE, the zip one), so a file can be checked with any stock tool.
+uint32_t crc32Update(uint32_t crc, const uint8_t* p, size_t n) {
+    static const struct Table {
+        uint32_t t[256];
+        Table() {
+            for (uint32_t i = 0; i < 256; ++i) {
+                uint32_t c = i;
+                for (int k = 0; k < 8; ++k) c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+                t[i] = c;
+            }
+        }
+    } table;
+    crc = ~crc;
+    for (size_t i = 0; i < n; ++i) crc = table.t[(crc ^ p[i]) & 0xFF] ^ (crc >> 8);
+    return ~crc;
+}
+
+uint64_t alignUp(uint64_t v, uint64_t a) { return (v + a - 1) / a * a; }
+
+struct Mapping {
+    void* base;
+    size_t len;
+    Mapping(void* b, size_t l) : base(b), len(l) {}
+    ~Mapping() { munmap(base, len); }
+};
+
+/**
+ * Hands cv::Mat::create one fixed region of a mapping instead of fresh memory, and holds the mapping
+ * until OpenCV's refcount releases that region: the Mat (and every header copied from it — the
+ * arena's views) then keeps the file mapped with no bookkeeping outside OpenCV. One instance per
+ * wrapped region; it deletes itself with the region's UMatData.
+ */
+class MappedRegionAllocator : public cv::MatAllocator {
+public:
+    MappedRegionAllocator(std::shared_ptr<Mapping> mapping, uchar* data, size_t bytes)
+        : mMapping(std::move(mapping)), mData(data), mBytes(bytes) {}
+
+    cv::UMatData* allocate(int dims, const int* sizes, int type, void*, size_t* step,
+                           cv::AccessFlag, cv::UMatUsageFlags) const override {
+        size_t total = CV_ELEM_SIZE(type);
+        for (int i = dims - 1; i >= 0; --i) {
+            if (step) step[i] = total;
+            total *= (size_t)sizes[i];
+        }
+        if (total != mBytes) return nullptr;
+        cv::UMatData* u = new cv::UMatData(this);
+        u->data = u->origdata = mData;
+        u->size = total;
+        return u;
+    }
+    bool allocate(cv::UMatData*, cv::AccessFlag, cv::UMatUsageFlags) const override { return false; }
+    void deallocate(cv::UMatData* u) const override {
+        if (!u) return;
+        delete u;
+        delete this;
+    }
+
+private:
+    std::shared_ptr<Mapping> mMapping;
+    uchar* mData;
+    size_t mBytes;
+};
+
+cv::Mat wrapMapped(const std::shared_ptr<Mapping>& mapping, uint8_t* data, int rows, int cols, int type) {
+    cv::Mat m;
+    m.allocator = new MappedRegionAllocator(mapping, data, (size_t)rows * (size_t)cols * CV_ELEM_SIZE(type));
+    m.create(rows, cols, type);
+    // The UMatData remembers its allocator; the header must not, or a later create() on a copy of it
+    // (DescriptorArena re-creates its store after a clear) would hand the region out a second time.
+    m.allocator = nullptr;
+    return m.data == data ? m : cv::Mat();
+}
+
+struct SectionRef {
+    bool present = false;
+    int type = -1;
+    uint32_t rows = 0, cols = 0;
+    uint8_t* data = nullptr;
+    uint64_t bytes = 0;
+    bool is(int t, uint32_t r, uint32_t c) const { return present && type == t && rows == r && cols == c; }
+};
+
+}  // namespace
+
+bool WallSidecar::write(const std::string& path, const Contents& c, Stamp* stamp) {
+    // A section's entry describes the matrix it stands for; a coded one's payload is the stream, so
+    // the two are carried separately.
+    struct Out {
+        uint32_t id;
+        cv::Mat m;
+        std::vector<uint8_t> coded;
+        const uint8_t* data() const { return coded.empty() ? m.data : coded.data(); }
+        uint64_t bytes() const { return coded.empty() ? (uint64_t)m.total() * m.elemSize() : coded.size(); }
+    };
+    std::vector<Out> sections;
+    bool anyCoded = false;
+    auto add = [&](Section id, const cv::Mat& m) {
+        if (!m.empty()) sections.push_back({(uint32_t)id, m.isContinuous() ? m : m.clone(), {}});
+    };
+    auto addDescs = [&](Section raw, Section coded, const cv::Mat& m) {
+        float err = 0.f;
+        std::vector<uint8_t> stream = DescriptorCodec::encode(m, c.descCodecLevel, &err);
+        if (stream.empty()) { add(raw, m); return; }
+        LOGD("section %u coded: %zu of %zu bytes, worst row error %.4f", (uint32_t)coded, stream.size(),
+             m.total() * m.elemSize(), err);
+        sections.push_back({(uint32_t)coded, m, std::move(stream)});
+        anyCoded = true;
+    };
+    const int nw = c.wallDescs.rows;
+    if (nw > 0 && (size_t)nw == c.wallPts.size()) {
+        addDescs(kWallDescs, kWallDescsCoded, c.wallDescs);
+        add(kWallPoints, cv::Mat(nw, 3, CV_32F, (void*)c.wallPts.data()));
+        if (c.wallRegions.size() == (size_t)nw)
+            add(kWallRegions, cv::Mat(1, nw, CV_8U, (void*)c.wallRegions.data()));
+        add(kFpAnchor, cv::Mat(1, 16, CV_32F, (void*)c.fpAnchor));
+        add(kFpIntrinsics, cv::Mat(1, 4, CV_32F, (void*)c.fpIntrinsics));
+        if (c.hasFpView) add(kFpView, cv::Mat(1, 16, CV_32F, (void*)c.fpView));
+    }
+    const int nm = c.mapDescs.rows;
+    if (nm > 0 && (size_t)nm == c.mapPts.size()) {
+        addDescs(kMapDescs, kMapDescsCoded, c.mapDescs);
+        add(kMapPoints, cv::Mat(nm, 3, CV_32F, (void*)c.mapPts.data()));
+        if (c.mapConf.size() == (size_t)nm) add(kMapConfidence, cv::Mat(1, nm, CV_32F, (void*)c.mapConf.data()));
+        if (c.mapObs.size() == (size_t)nm) add(kMapObs, cv::Mat(1, nm, CV_32S, (void*)c.mapObs.data()));
+        add(kMapAnchor, cv::Mat(1, 16, CV_32F, (void*)c.mapAnchor));
+        add(kMapIntrinsics, cv::Mat(1, 4, CV_32F, (void*)c.mapIntrinsics));
+    }
+    if (sections.empty()) return false;
+
+    const uint32_t count = (uint32_t)sections.size();
+    std::vector<uint8_t> table(kEntryBytes * count, 0);
+    uint64_t offset = alignUp(kHeaderBytes + table.size(), kAlign);
+    for (uint32_t i = 0; i < count; ++i) {
+        const cv::Mat& m = sections[i].m;
+        const int32_t type = m.type();
+        const uint32_t rows = (uint32_t)m.rows, cols = (uint32_t)m.cols;
+        const uint64_t bytes = sections[i].bytes();
+        uint8_t* e = table.data() + kEntryBytes * i;
+        memcpy(e, &sections[i].id, 4);
+        memcpy(e + 4, &type, 4);
+        memcpy(e + 8, &rows, 4);
+        memcpy(e + 12, &cols, 4);
+        memcpy(e + 16, &offset, 8);
+        memcpy(e + 24, &bytes, 8);
+        offset = alignUp(offset + bytes, kAlign);
+    }
+    const uint64_t fileBytes = offset;
+
+    const std::string tmp = path + ".tmp";
+    std::ofstream f(tmp, std::ios::binary | std::ios::trunc);
+    if (!f) { LOGE("cannot open %s", tmp.c_str()); return false; }
+    static const uint8_t kZeros[kAlign] = {};
+    uint32_t crc = 0;
+    uint64_t at = kHeaderBytes;
+    auto emit = [&](const uint8_t* p, size_t n) {
+        f.write(reinterpret_cast<const char*>(p), (std::streamsize)n);
+        crc = crc32Update(crc, p, n);
+        at += n;
+    };
+    auto padTo = [&](uint64_t to) { while (at < to) emit(kZeros, (size_t)std::min<uint64_t>(kAlign, to - at)); };
+
+    f.write(reinterpret_cast<const char*>(kZeros), kHeaderBytes);   // placeholder until the crc is known
+    emit(table.data(), table.size());
+    for (const auto& s : sections) {
+        padTo(alignUp(at, kAlign));
+        emit(s.data(), (size_t)s.bytes());
+    }
+    padTo(fileBytes);
+
+    uint8_t header[kHeaderBytes] = {};
+    // Version 1 readers would skip a coded section and find no descriptors; naming version 2 only
+    // when one is present keeps uncoded files readable by them.
+    const uint32_t version = anyCoded ? kVersion : 1u, align = kAlign;
+    memcpy(header, "GXWS", 4);
+    memcpy(header + 4, &version, 4);
+    memcpy(header + 8, &count, 4);
+    memcpy(header + 12, &crc, 4);
+    memcpy(header + 16, &fileBytes, 8);
+    memcpy(header + 24, &align, 4);
+    f.seekp(0);
+    f.write(reinterpret_cast<const char*>(header), kHeaderBytes);
+    f.close();
+    if (!f || std::rename(tmp.c_str(), path.c_str()) != 0) {
+        LOGE("write of %s failed", path.c_str());
+        std::remove(tmp.c_str());
+        return false;
+    }
+    LOGD("wrote %s: %u sections, %llu bytes (wall %d, map %d rows)", path.c_str(), count,
+         (unsigned long long)fileBytes, nw, nm);
+    if (stamp) *stamp = Stamp{crc, fileBytes};
+    return true;
+}
+
+uint32_t WallSidecar::crc32(const uint8_t* p, size_t n, uint32_t crc) {
+    return crc32Update(crc, p, n);
+}
+
+bool WallSidecar::read(const std::string& path, Contents& out) {
+    const int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return false;
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size < (off_t)kHeaderBytes || (uint64_t)st.st_size > (uint64_t)SIZE_MAX) {
+        ::close(fd);
+        return false;
+    }
+    const size_t len = (size_t)st.st_size;
+    // Private and writable: pages the arena writes (swapRemove) are copied on write, the file never is.
+    void* base = mmap(nullptr, len, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+    ::close(fd);   // the mapping holds its own reference to the file
+    if (base == MAP_FAILED) { LOGE("mmap of %s failed", path.c_str()); return false; }
+    const auto mapping = std::make_shared<Mapping>(base, len);
+    uint8_t* const p = static_cast<uint8_t*>(base);
+
+    uint32_t version = 0, count = 0, crc = 0, align = 0;
+    uint64_t fileBytes = 0;
+    memcpy(&version, p + 4, 4);
+    memcpy(&count, p + 8, 4);
+    memcpy(&crc, p + 12, 4);
+    memcpy(&fileBytes, p + 16, 8);
+    memcpy(&align, p + 24, 4);
+    if (memcmp(p, "GXWS", 4) != 0) { LOGE("bad magic"); return false; }
+    if (version < 1 || version > kVersion) { LOGE("unsupported version %u", version); return false; }
+    if (fileBytes != (uint64_t)len || count == 0 || count > kMaxSections || align < 16 || align > 4096 ||
+        (align & (align - 1)) != 0 || kHeaderBytes + (uint64_t)count * kEntryBytes > (uint64_t)len) {
+        LOGE("bad header (%u sections, align %u, %llu of %zu bytes)", count, align,
+             (unsigned long long)fileBytes, len);
+        return false;
+    }
+    // Reads every page of the mapping, once; see the header for why the whole file is checked here.
+    if (crc32Update(0, p + kHeaderBytes, len - kHeaderBytes) != crc) { LOGE("checksum mismatch"); return false; }
+
+    const uint64_t tableEnd = kHeaderBytes + (uint64_t)count * kEntryBytes;
+    SectionRef sec[kMapDescsCoded + 1];
+    for (uint32_t i = 0; i < count; ++i) {
+        const uint8_t* e = p + kHeaderBytes + (size_t)i * kEntryBytes;
+        uint32_t id, rows, cols;
+        int32_t type;
+        uint64_t offset, bytes;
+        memcpy(&id, e, 4);
+        memcpy(&type, e + 4, 4);
+        memcpy(&rows, e + 8, 4);
+        memcpy(&cols, e + 12, 4);
+        memcpy(&offset, e + 16, 8);
+        memcpy(&bytes, e + 24, 8);
+        if (id >= sizeof(sec) / sizeof(sec[0])) continue;   // a later writer's section
+        if (sec[id].present) { LOGE("section %u repeated", id); return false; }
+        if (type != CV_8U && type != CV_32F && type != CV_32S) { LOGE("section %u type %d", id, type); return false; }
+        // A coded section's entry is the decoded shape; its bytes are the stream, checked by decode.
+        const bool coded = id == kWallDescsCoded || id == kMapDescsCoded;
+        const uint64_t plain = (uint64_t)rows * cols * (uint64_t)CV_ELEM_SIZE(type);
+        if (rows == 0 || cols == 0 || rows > (uint32_t)INT32_MAX || cols > 4096 ||
+            (coded ? bytes == 0 : bytes != plain) || offset % align != 0 ||
+            offset < tableEnd || offset > (uint64_t)len || bytes > (uint64_t)len - offset) {
+            LOGE("section %u out of bounds", id);
+            return false;
+        }
+        sec[id].present = true;
+        sec[id].type = type;
+        sec[id].rows = rows;
+        sec[id].cols = cols;
+        sec[id].data = p + offset;
+        sec[id].bytes = bytes;
+    }
+
+    Contents c;
+    c.stamp = Stamp{crc, fileBytes};
+    auto floats = [&](Section id, float* dst, uint32_t n) {
+        if (!sec[id].present) return true;
+        if (!sec[id].is(CV_32F, 1, n)) return false;
+        memcpy(dst, sec[id].data, n * sizeof(float));
+        return true;
+    };
+    auto points = [&](Section id, uint32_t n, std::vector<cv::Point3f>& dst) {
+        if (!sec[id].is(CV_32F, n, 3)) return false;
+        dst.resize(n);
+        memcpy(dst.data(), sec[id].data, (size_t)n * sizeof(cv::Point3f));
+        return true;
+    };
+    auto descriptors = [&](Section id) {
+        const SectionRef& s = sec[id];
+        return s.present && (s.type == CV_8U || s.type == CV_32F);
+    };
+    // Either form of a descriptor set, never both. The raw one is wrapped in place over the mapping;
+    // a coded one decodes into owned memory.
+    auto descSection = [&](Section raw, Section coded, cv::Mat& dst) {
+        if (sec[raw].present && sec[coded].present) { LOGE("section %u both raw and coded", raw); return false; }
+        const Section used = sec[coded].present ? coded : raw;
+        const SectionRef& s = sec[used];
+        if (used == raw) {
+            dst = wrapMapped(mapping, s.data, (int)s.rows, (int)s.cols, s.type);
+        } else if (!DescriptorCodec::decode(s.data, (size_t)s.bytes, (int)s.rows, (int)s.cols, s.type, dst)) {
+            LOGE("section %u does not decode", coded);
+            dst.release();
+        }
+        return !dst.empty();
+    };
+
+    const Section wallUsed = sec[kWallDescsCoded].present ? kWallDescsCoded : kWallDescs;
+    const Section mapUsed = sec[kMapDescsCoded].present ? kMapDescsCoded : kMapDescs;
+
+    if (descriptors(wallUsed)) {
+        const uint32_t n = sec[wallUsed].rows;
+        if (!points(kWallPoints, n, c.wallPts) || !floats(kFpAnchor, c.fpAnchor, 16) ||
+            !floats(kFpIntrinsics, c.fpIntrinsics, 4) || !floats(kFpView, c.fpView, 16)) {
+            LOGE("fingerprint sections disagree");
+            return false;
+        }
+        c.hasFpView = sec[kFpView].present;
+        if (sec[kWallRegions].present) {
+            if (!sec[kWallRegions].is(CV_8U, 1, n)) { LOGE("regions disagree with points"); return false; }
+            c.wallRegions.assign(sec[kWallRegions].data, sec[kWallRegions].data + n);
+        }
+        if (!descSection(kWallDescs, kWallDescsCoded, c.wallDescs)) return false;
+    }
+    if (descriptors(mapUsed)) {
+        const uint32_t n = sec[mapUsed].rows;
+        if (!points(kMapPoints, n, c.mapPts) || !floats(kMapAnchor, c.mapAnchor, 16) ||
+            !floats(kMapIntrinsics, c.mapIntrinsics, 4)) {
+            LOGE("map sections disagree");
+            return false;
+        }
+        if (sec[kMapConfidence].present) {
+            if (!sec[kMapConfidence].is(CV_32F, 1, n)) { LOGE("confidence disagrees with points"); return false; }
+            const float* f = reinterpret_cast<const float*>(sec[kMapConfidence].data);
+            c.mapConf.assign(f, f + n);
+        }
+        if (sec[kMapObs].present) {
+            if (!sec[kMapObs].is(CV_32S, 1, n)) { LOGE("obs disagree with points"); return false; }
+            const int32_t* o = reinterpret_cast<const int32_t*>(sec[kMapObs].data);
+            c.mapObs.assign(o, o + n);
+        }
+        if (!descSection(kMapDescs, kMapDescsCoded, c.mapDescs)) return false;
+    }
+    if (c.wallDescs.empty() && c.mapDescs.empty()) return false;
+    LOGD("mapped %s: wall %d, map %d rows", path.c_str(), c.wallDescs.rows, c.mapDescs.rows);
+    out = std::move(c);
+    return true;
+}
@@ -0,0 +1,74 @@
+#ifndef GRAFFITIXR_BOW_INDEX_H
+#define GRAFFITIXR_BOW_INDEX_H
+
+#include <algorithm>
+#include <cstdint>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+/**
+ * Bag-of-words index over one point set (the wall's marks, or the map's points), in the words and
+ * direct-index nodes of a VocabularyTree:
+ *
+ *  - the INVERTED file, word -> entities whose descriptor quantized to it, answers "which stored
+ *    points could this frame be looking at" by voting, without touching a descriptor;
+ *  - the DIRECT index, node -> entities, answers "which stored points could this one query
+ *    descriptor match" for the correspondence search.
+ *
+ * Entities are whatever the owner keys its points by: wall row indices (the wall is only ever
+ * replaced whole or appended to), map point IDs (the map renumbers on prune). Per-entity lists are
+ * short, so removal is a linear erase.
+ *
+ * Not thread-safe; MobileGS keeps both indexes under mMutex beside the points they describe.
+ */
+class BowIndex {
+public:
+    void clear() {
+        mInverted.clear();
+        mDirect.clear();
+        mEntity.clear();
+    }
+
+    size_t size() const { return mEntity.size(); }
+
+    void add(uint32_t entity, uint32_t word, uint32_t node) {
+        if (!mEntity.emplace(entity, std::make_pair(word, node)).second) return;
+        mInverted[word].push_back(entity);
+        mDirect[node].push_back(entity);
+    }
+
+    void remove(uint32_t entity) {
+        auto it = mEntity.find(entity);
+        if (it == mEntity.end()) return;
+        erase(mInverted, it->second.first, entity);
+        erase(mDirect, it->second.second, entity);
+        mEntity.erase(it);
+    }
+
+    /** Entities quantized to [word] / filed under direct-index [node]; null when there are none. */
+    const std::vector<uint32_t>* wordEntities(uint32_t word) const { return find(mInverted, word); }
+    const std::vector<uint32_t>* nodeEntities(uint32_t node) const { return find(mDirect, node); }
+
+private:
+    using Lists = std::unordered_map<uint32_t, std::vector<uint32_t>>;
+
+    static const std::vector<uint32_t>* find(const Lists& lists, uint32_t key) {
+        auto it = lists.find(key);
+        return it == lists.end() ? nullptr : &it->second;
+    }
+
+    static void erase(Lists& lists, uint32_t key, uint32_t entity) {
+        auto it = lists.find(key);
+        if (it == lists.end()) return;
+        auto& v = it->second;
+        v.erase(std::remove(v.begin(), v.end(), entity), v.end());
+        if (v.empty()) lists.erase(it);
+    }
+
+    Lists mInverted;
+    Lists mDirect;
+    std::unordered_map<uint32_t, std::pair<uint32_t, uint32_t>> mEntity;   // -> (word, node)
+};
+
+#endif  // GRAFFITIXR_BOW_INDEX_H
@@ -0,0 +1,140 @@
+#pragma once
+#include <opencv2/core.hpp>
+#include <algorithm>
+#include <cstdint>
+#include <deque>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * Observation history and a small bundle adjustment for the points the engine places once and
+ * otherwise never revisits: self-grown wall marks and feature-map points, both back-projected onto
+ * the fitted plane from a single view. That placement inherits the plane's error and the one pose's
+ * error; every later lock that re-observes the point is evidence of where it really is, and until
+ * now was only counted (mMapObs).
+ *
+ * Locked poses go into a short ring (kMaxPoses). Each point keeps its last kMaxObsPerPoint
+ * observations — pose id and pixel — so memory is bounded by the point count. Points are keyed by
+ * kind and a stable id: wall marks by row (the wall is only appended to between replacements, and a
+ * replacement clears everything here), map points by map point ID (which survive swap-removal).
+ *
+ * solve() is alternation — every point by Gauss-Newton over its own observations, then every pose
+ * over its own — with a Huber kernel. That IS sparse bundle adjustment's structure, solved by block
+ * coordinate descent instead of a Schur complement: with a handful of poses and 3x3 / 6x6 blocks it
+ * converges in a few sweeps and needs no sparse linear algebra. Fixed points (the captured
+ * fingerprint marks) hold the gauge: they are never moved, and a pose is refined only when enough
+ * of them pin it; with too few, poses stay put and the solve is structure-only.
+ *
+ * Not thread-safe; MobileGS keeps it under mMutex and runs solve() on a snapshot with no lock held.
+ */
+class BundleRefiner {
+public:
+    enum Kind : uint32_t { kWall = 0, kMap = 1 };
+    static uint64_t key(Kind kind, uint32_t id) { return ((uint64_t)kind << 32) | id; }
+    static Kind kindOf(uint64_t k) { return (Kind)(k >> 32); }
+    static uint32_t idOf(uint64_t k) { return (uint32_t)k; }
+
+    struct Pose {
+        uint32_t id = 0;
+        cv::Matx33d R;       // camera_from_fp, OpenCV camera frame
+        cv::Vec3d t;
+        double fx = 0, fy = 0, cx = 0, cy = 0;
+    };
+    struct Obs {
+        uint32_t pose;
+        float u, v;
+    };
+    /** A snapshot to solve: points parallel to keys/fixed/obs. */
+    struct Problem {
+        std::vector<Pose> poses;
+        std::vector<uint64_t> keys;
+        std::vector<cv::Point3f> pts;
+        std::vector<char> fixed;
+        std::vector<std::vector<Obs>> obs;
+    };
+
+    /** Forget every pose and observation. Pose ids keep counting, so a stale id never resolves. */
+    void clear() {
+        mPoses.clear();
+        mTracks.clear();
+        mPosesSinceSolve = 0;
+    }
+
+    /** Record a locked pose (column-major camera_from_fp, as MobileGS publishes it). Never returns 0. */
+    uint32_t addPose(const float* camFromFp16, double fx, double fy, double cx, double cy) {
+        Pose p;
+        p.id = ++mNextPoseId;
+        for (int r = 0; r < 3; ++r) {
+            for (int c = 0; c < 3; ++c) p.R(r, c) = camFromFp16[c * 4 + r];
+            p.t[r] = camFromFp16[12 + r];
+        }
+        p.fx = fx; p.fy = fy; p.cx = cx; p.cy = cy;
+        mPoses.push_back(p);
+        if (mPoses.size() > kMaxPoses) mPoses.pop_front();
+        ++mPosesSinceSolve;
+        return p.id;
+    }
+
+    bool hasPose(uint32_t id) const {
+        for (const auto& p : mPoses) if (p.id == id) return true;
+        return false;
+    }
+
+    void observe(uint64_t k, uint32_t pose, float u, float v) {
+        std::vector<Obs>& track = mTracks[k];
+        for (const Obs& o : track) if (o.pose == pose) return;   // one view, one observation
+        if (track.size() >= kMaxObsPerPoint) track.erase(track.begin());
+        track.push_back(Obs{pose, u, v});
+    }
+
+    void forget(uint64_t k) { mTracks.erase(k); }
+
+    size_t posesSinceSolve() const { return mPosesSinceSolve; }
+
+    /**
+     * Every free track seen from at least [minViews] poses still in the ring (a fixed one from any), with its position and fixed
+     * flag from [resolve](key, Point3f&, bool& fixed) -> bool. Observations of poses that have left
+     * the ring are dropped from the tracks as they are walked, and a track [resolve] refuses (its
+     * point is gone) is dropped whole.
+     */
+    template <class Resolve>
+    void snapshot(Problem& out, size_t minViews, Resolve resolve) {
+        out = Problem();
+        out.poses.assign(mPoses.begin(), mPoses.end());
+        mPosesSinceSolve = 0;
+        for (auto it = mTracks.begin(); it != mTracks.end();) {
+            std::vector<Obs>& track = it->second;
+            track.erase(std::remove_if(track.begin(), track.end(),
+                                       [this](const Obs& o) { return !hasPose(o.pose); }),
+                        track.end());
+            cv::Point3f X;
+            bool fixed = false;
+            if (track.empty() || !resolve(it->first, X, fixed)) { it = mTracks.erase(it); continue; }
+            // A fixed point needs no second view to be useful: one observation already pins a pose.
+            if (track.size() >= (fixed ? 1 : minViews)) {
+                out.keys.push_back(it->first);
+                out.pts.push_back(X);
+                out.fixed.push_back(fixed ? 1 : 0);
+                out.obs.push_back(track);
+            }
+            ++it;
+        }
+    }
+
+    /**
+     * Refine [p] in place: [iters] sweeps of points then poses. Reports the robust RMS reprojection
+     * error over all observations before and after, in pixels.
+     */
+    static void solve(Problem& p, int iters, double huberPx, double& rmsBefore, double& rmsAfter);
+
+    static constexpr size_t kMaxPoses = 20;
+    static constexpr size_t kMaxObsPerPoint = 8;
+    // A pose is refined only when this many of its observations are of fixed points.
+    static constexpr size_t kMinFixedPerPose = 6;
+
+private:
+    std::deque<Pose> mPoses;   // oldest first
+    std::unordered_map<uint64_t, std::vector<Obs>> mTracks;
+    uint32_t mNextPoseId = 0;
+    size_t mPosesSinceSolve = 0;
+};
@@ -0,0 +1,116 @@
+#ifndef GRAFFITIXR_DESCRIPTOR_ARENA_H
+#define GRAFFITIXR_DESCRIPTOR_ARENA_H
+
+#include <algorithm>
+#include <opencv2/core.hpp>
+
+/**
+ * Row storage for a growing descriptor set: one contiguous buffer with spare capacity, appended to
+ * in amortised O(1), removed from by swap-with-last, and read through a zero-copy cv::Mat view.
+ *
+ * The wall fingerprint and the feature map both grow a row at a time (self-grow, growMapFromReloc).
+ * As bare cv::Mats every push_back that outran the allocation copied the whole matrix, and pruning
+ * rebuilt it outright. Here the buffer doubles when full and pruning moves one row per removal.
+ *
+ * view() shares the buffer, which is what lets the reloc snapshot match against the map (and the
+ * wall) outside mMutex without cloning it. That is safe because of one invariant: no row a live view
+ * can see is ever written in place. append() only writes past the end of every view taken so far, and
+ * growth moves to a fresh buffer the old views keep alive. swapRemove() is the one in-place write, so
+ * it first detaches onto a private copy whenever a view still holds the buffer.
+ *
+ * Not thread-safe; the owner serializes every call (MobileGS holds mMutex). A view, once taken, may be
+ * read on any thread with no lock at all.
+ */
+class DescriptorArena {
+public:
+    int rows() const { return mRows; }
+    int cols() const { return mStore.cols; }
+    int type() const { return mStore.type(); }
+    bool empty() const { return mRows == 0; }
+    int capacity() const { return mStore.rows; }
+
+    /** The live rows as a continuous Mat header over the arena's buffer; empty Mat when there are none. */
+    cv::Mat view() const { return mRows > 0 ? mStore.rowRange(0, mRows) : cv::Mat(); }
+
+    void clear() {
+        mStore.release();
+        mRows = 0;
+    }
+
+    /** Replace the contents with a copy of [m] (any N x D matrix; empty clears). */
+    void assign(const cv::Mat& m) {
+        clear();
+        if (m.empty()) return;
+        mStore.create(std::max(m.rows, kMinCapacity), m.cols, m.type());
+        m.copyTo(mStore.rowRange(0, m.rows));
+        mRows = m.rows;
+    }
+
+    /**
+     * Take [m] as the buffer itself, no copy: for rows that already live somewhere stable, such as a
+     * memory-mapped sidecar (WallSidecar). [m]'s refcount keeps that storage alive, so views behave
+     * as with any buffer. The arena starts full, so the first append moves to an allocated buffer; a
+     * swapRemove with no view outstanding writes [m] in place, which its owner must allow. A
+     * non-continuous [m] is copied instead.
+     */
+    void adopt(const cv::Mat& m) {
+        if (!m.isContinuous()) { assign(m); return; }
+        clear();
+        if (m.empty()) return;
+        mStore = m;
+        mRows = m.rows;
+    }
+
+    void reserve(int rows) {
+        if (rows <= capacity() || mStore.empty()) return;
+        regrow(rows);
+    }
+
+    /**
+     * Append every row of [m]. An empty arena adopts [m]'s shape; otherwise a column or type mismatch
+     * is refused (false) rather than silently reinterpreted — callers already gate on both.
+     */
+    bool append(const cv::Mat& m) {
+        if (m.empty()) return true;
+        if (mStore.empty()) {
+            mStore.create(std::max(m.rows, kMinCapacity), m.cols, m.type());
+        } else if (m.cols != mStore.cols || m.type() != mStore.type()) {
+            return false;
+        } else if (mRows + m.rows > capacity()) {
+            regrow(std::max(mRows + m.rows, capacity() * 2));
+        }
+        m.copyTo(mStore.rowRange(mRows, mRows + m.rows));
+        mRows += m.rows;
+        return true;
+    }
+
+    /** Overwrite row [i] with the last row and drop the last. Order is not preserved. */
+    void swapRemove(int i) {
+        if (i < 0 || i >= mRows) return;
+        if (shared()) regrow(capacity());     // a view still reads these rows: write a private copy
+        const int last = mRows - 1;
+        if (i != last) mStore.row(last).copyTo(mStore.row(i));
+        --mRows;
+    }
+
+private:
+    static constexpr int kMinCapacity = 64;
+
+    // Another Mat header (a view handed out earlier) still references the buffer. Read atomically:
+    // views are released on other threads. A stale "shared" only costs an unneeded copy, and nothing
+    // can start sharing concurrently because only the owner, under its lock, hands out views.
+    bool shared() const {
+        return mStore.u && CV_XADD(&mStore.u->refcount, 0) > 1;
+    }
+
+    void regrow(int newCapacity) {
+        cv::Mat grown(newCapacity, mStore.cols, mStore.type());
+        if (mRows > 0) mStore.rowRange(0, mRows).copyTo(grown.rowRange(0, mRows));
+        mStore = grown;
+    }
+
+    cv::Mat mStore;
+    int mRows = 0;
+};
+
+#endif  // GRAFFITIXR_DESCRIPTOR_ARENA_H
@@ -0,0 +1,44 @@
+#pragma once
+#include <opencv2/core.hpp>
+#include <cstdint>
+#include <vector>
+
+/**
+ * Compact encodings of a descriptor set for persistence (the wall sidecar's coded sections,
+ * docs/data_formats.md §4). Descriptors are most of a saved project, and neither kind gives the ZIP
+ * step anything to work with: SuperPoint rows are float noise and ORB rows are already bits.
+ *
+ *  - SuperPoint (N x D CV_32F, L2-normalised). Level 1 stores IEEE half floats: half the bytes,
+ *    relative error under 2^-11. Level 2 stores int8 with one float scale per kBlock elements of a
+ *    row: about a quarter of the bytes. It is lossy but bounded. encode() measures each row's L2
+ *    reconstruction error and, should any exceed kMaxRowError, writes level 1 instead. By the
+ *    triangle inequality a match distance then moves by at most twice that.
+ *  - ORB (N x 32 CV_8U). Lossless at any level: every bit through an adaptive binary range coder
+ *    with one probability per bit position. ORB's bit tests are chosen for balance, so this buys
+ *    little, and encode() returns nothing when it buys nothing.
+ *
+ * Stream: u32 Method, then the method's payload. The shape travels beside it (the section entry), so
+ * decode() is told what to produce and checks the payload against it. That includes a range-coded
+ * stream, whose output per byte of input is bounded by the coder's adaptation rate.
+ */
+class DescriptorCodec {
+public:
+    enum Method : uint32_t {
+        kFloat16 = 1,     // rows x cols u16
+        kInt8Block = 2,   // rows x blocks f32 scales, then rows x cols i8
+        kBitRange = 3,    // range-coded bits, row-major, most significant bit first
+    };
+
+    /**
+     * [descs] coded at [level] (1 or 2; anything else codes nothing). Empty when the level does not
+     * apply to the descriptor type or coding would not save bytes. [maxRowError], when given, gets
+     * the worst row's L2 reconstruction error (0 for lossless methods).
+     */
+    static std::vector<uint8_t> encode(const cv::Mat& descs, int level, float* maxRowError = nullptr);
+
+    /** Decode into a fresh rows x cols Mat of [type]. False on any stream that does not fit. */
+    static bool decode(const uint8_t* data, size_t size, int rows, int cols, int type, cv::Mat& out);
+
+    static constexpr int kBlock = 32;
+    static constexpr float kMaxRowError = 0.02f;
+};
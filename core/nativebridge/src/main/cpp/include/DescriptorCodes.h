@@ -0,0 +1,51 @@
+#ifndef GRAFFITIXR_DESCRIPTOR_CODES_H
+#define GRAFFITIXR_DESCRIPTOR_CODES_H
+
+#include <opencv2/core.hpp>
+
+/**
+ * Compact matching codes for SuperPoint descriptors: one sign bit per dimension, packed MSB-first
+ * into bytes, so a 256-float (1 KB) descriptor becomes a 32-byte code matched by Hamming distance.
+ *
+ * Sign binarization rather than a PCA projection because it needs no fitted parameters: SuperPoint's
+ * descriptors are L2-normalized and roughly zero-centred per dimension, so the sign alone keeps most
+ * of the angular structure, and there is no offline-fitted projection shipped alongside
+ * superpoint.onnx for a PCA path to load. A learned projection would slot in here as a second
+ * encoder with the same output contract.
+ *
+ * These are MATCHING codes, never storage: the float descriptors stay the source of truth for the
+ * fingerprint blob, self-grow and the map, so turning compact matching off restores exactly the
+ * previous behaviour and nothing persisted ever depends on it.
+ *
+ * The packed layout deliberately matches ORB's (CV_8U, 32 columns for 256 dims), which means a code
+ * and an ORB descriptor are type-compatible and will knnMatch without complaint. The caller must
+ * only ever compare codes with codes — see MobileGS::runRelocPass, which decides compactness from
+ * the FLOAT wall descriptors before any code exists.
+ */
+namespace desccodes {
+
+/** Dimensions must be a multiple of 8; SuperPoint's 256 is. */
+inline bool canBinarize(const cv::Mat& f32) {
+    return !f32.empty() && f32.type() == CV_32F && f32.cols % 8 == 0;
+}
+
+/** N x D CV_32F -> N x D/8 CV_8U. Empty in, empty out; a non-binarizable input also yields empty. */
+inline cv::Mat binarize(const cv::Mat& f32) {
+    if (!canBinarize(f32)) return cv::Mat();
+    cv::Mat codes(f32.rows, f32.cols / 8, CV_8U);
+    for (int r = 0; r < f32.rows; ++r) {
+        const float* src = f32.ptr<float>(r);
+        uchar* dst = codes.ptr<uchar>(r);
+        for (int b = 0; b < codes.cols; ++b) {
+            const float* s = src + b * 8;
+            dst[b] = (uchar)(((s[0] > 0.f) << 7) | ((s[1] > 0.f) << 6) | ((s[2] > 0.f) << 5) |
+                             ((s[3] > 0.f) << 4) | ((s[4] > 0.f) << 3) | ((s[5] > 0.f) << 2) |
+                             ((s[6] > 0.f) << 1) |  (s[7] > 0.f));
+        }
+    }
+    return codes;
+}
+
+} // namespace desccodes
+
+#endif // GRAFFITIXR_DESCRIPTOR_CODES_H
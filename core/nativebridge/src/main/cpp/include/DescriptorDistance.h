@@ -0,0 +1,34 @@
+#ifndef GRAFFITIXR_DESCRIPTOR_DISTANCE_H
+#define GRAFFITIXR_DESCRIPTOR_DISTANCE_H
+
+#include <cmath>
+#include <opencv2/core.hpp>
+
+/**
+ * Distance between one row of [a] and one row of [b], for the places that match a few candidates
+ * by hand (a gated window, an index list) where building a cv::Mat to hand to knnMatch would cost
+ * more than the comparison. L2 for float (SuperPoint), Hamming for CV_8U (ORB and the compact
+ * codes) — the same pairing mL2Matcher / mMatcher encode. The caller has already checked that the
+ * two types and widths agree.
+ */
+namespace descdist {
+
+inline float row(const cv::Mat& a, int ra, const cv::Mat& b, int rb) {
+    const int n = a.cols;
+    if (a.type() == CV_32F) {
+        const float* pa = a.ptr<float>(ra);
+        const float* pb = b.ptr<float>(rb);
+        float acc = 0.0f;
+        for (int k = 0; k < n; ++k) { const float d = pa[k] - pb[k]; acc += d * d; }
+        return std::sqrt(acc);
+    }
+    const uchar* pa = a.ptr<uchar>(ra);
+    const uchar* pb = b.ptr<uchar>(rb);
+    int acc = 0;
+    for (int k = 0; k < n; ++k) acc += __builtin_popcount((unsigned)(pa[k] ^ pb[k]));
+    return (float)acc;
+}
+
+} // namespace descdist
+
+#endif // GRAFFITIXR_DESCRIPTOR_DISTANCE_H
@@ -1,9 +1,10 @@
 #pragma once
 #include <opencv2/opencv.hpp>
 #include <opencv2/dnn.hpp>
-#include <opencv2/core/ocl.hpp>
+#include "InferenceBackend.h"
 #include <array>
 #include <atomic>
+#include <memory>
 #include <mutex>
 #include <vector>
 
@@ -22,16 +23,39 @@ class DistortionHead {
 public:
     DistortionHead() = default;
 
-    bool load(const std::vector<uchar>& onnxBytes);
+    bool load(const std::vector<uchar>& onnxBytes,
+              const InferenceBackend::Options& opts = InferenceBackend::Options());
     bool isLoaded() const { return mLoaded; }
 
-    /** Two gray images → distortion[13]. Images are resized to kPatch and scaled to [0,1] inside. */
-    bool run(const cv::Mat& grayCur, const cv::Mat& grayFp, std::array<float, 13>& out);
+    /**
+     * Fix the fingerprint-side input (the canonical wall patch). It is resized and scaled to [0,1]
+     * here, once, and bound as image_fp on every run() after — the patch only changes when the
+     * project's fingerprint does, so redoing that half of the input work per pass was pure waste.
+     * Independent of load(): a patch set before the model arrives is used once it does.
+     */
+    void setFingerprint(const cv::Mat& grayFp);
+    void clearFingerprint();
+    bool hasFingerprint() const { return mHasFp; }
+
+    /** Current gray crop (+ the fixed fingerprint) → distortion[13]. False with no fingerprint set. */
+    bool run(const cv::Mat& grayCur, std::array<float, 13>& out);
+
+    /** One throwaway forward at kPatch x kPatch so the first real run() isn't the cold one. */
+    bool warmUp();
 
     static constexpr int kPatch = 256;
 
 private:
-    cv::dnn::Net      mNet;
+    std::unique_ptr<InferenceBackend> mBackend;
     std::mutex        mMutex;
     std::atomic<bool> mLoaded{false};
+
+    // Guarded by mMutex. mFp is the preprocessed fingerprint input, kept alive because the blob
+    // bound to image_fp only views it. The current side reuses mCur/mCurF so a pass allocates
+    // nothing. The export is one joint graph (both views go through the shared backbone inside
+    // it), so the preprocessed patch is what there is to cache; a two-tower export with desc_fp
+    // as a graph input would let the fingerprint's backbone features be cached here as well.
+    cv::Mat mFp;
+    cv::Mat mCur, mCurF;
+    std::atomic<bool> mHasFp{false};
 };
@@ -0,0 +1,101 @@
+#pragma once
+#include <opencv2/core.hpp>
+#include <cstdint>
+#include <vector>
+
+/**
+ * The co-op fingerprint on the wire as a change set: what a peer that already holds generation
+ * baseGen of this wall needs to reach newGen (docs/data_formats.md §5). A full transfer is the same
+ * record with kFull set, no base, and every row appended — so there is one format to parse, and it
+ * carries what the old unversioned blob could not: a version, the wall's identity, and the partition.
+ *
+ * Self-grow appends a few dozen marks per relock and refinement nudges a handful more; the old path
+ * re-sent the whole wall for either. Here an append costs its point, descriptor and region byte, a
+ * move costs its row and point, and nothing else crosses the hotspot.
+ *
+ * Rows are the sender's. [epoch] names one wall on the sender: any replacement (capture, restore,
+ * a peer install, a registry swap) starts a new epoch, and a delta applies only to a receiver at the
+ * same epoch and baseGen. Removals are swap-with-last on the sender's rows, applied in order before
+ * the moves and the appends.
+ *
+ * Layout, little-endian:
+ *   char[4] "GXFD"; u32 version (1); u32 flags (kFull | kRegions); u32 reserved (0)
+ *   u64 epoch; u64 baseGen; u64 newGen
+ *   u32 baseRows; u32 removedCount; u32 movedCount; u32 appendedCount
+ *   i32 descType; u32 descCols
+ *   removedCount x u32 row
+ *   movedCount x { u32 row; f32 x, y, z }
+ *   appendedCount x f32 x, y, z
+ *   appendedCount x descCols descriptor elements
+ *   appendedCount x u8 region, when kRegions
+ * The bytes come from a peer, so decode() checks every count and size in 64-bit before it allocates.
+ */
+struct FingerprintDelta {
+    enum Flags : uint32_t {
+        kFull = 1u << 0,      // replace the wall outright; baseGen and baseRows are 0
+        kRegions = 1u << 1,   // appended rows carry Footprint::Region bytes
+    };
+
+    uint32_t flags = 0;
+    uint64_t epoch = 0;
+    uint64_t baseGen = 0;
+    uint64_t newGen = 0;
+    uint32_t baseRows = 0;    // the sender's row count at baseGen, which the receiver must match
+
+    std::vector<uint32_t> removed;
+    std::vector<uint32_t> movedRows;
+    std::vector<cv::Point3f> movedPts;
+    std::vector<cv::Point3f> appendedPts;
+    cv::Mat appendedDescs;    // appendedPts.size() x D, or empty with no appends
+    std::vector<uint8_t> appendedRegions;
+
+    bool full() const { return (flags & kFull) != 0; }
+
+    /**
+     * The sender's side: the record taking a peer at [sinceGen] of wall [epoch] to [newGen], read off
+     * the wall's parallel columns. Append generations never decrease down the rows, so the peer's
+     * rows are a prefix; earlier rows moved after sinceGen go as moves. [full] sends every row.
+     * [descs] is referenced, not copied. [regions] may be empty (no partition).
+     */
+    static FingerprintDelta since(uint64_t epoch, uint64_t newGen, bool full, uint64_t sinceGen,
+                                  const std::vector<cv::Point3f>& pts, const cv::Mat& descs,
+                                  const std::vector<uint8_t>& regions, const std::vector<uint64_t>& addGen,
+                                  const std::vector<uint64_t>& moveGen);
+
+    /**
+     * The receiver's side: which sender wall and generation the local wall holds, and the local row
+     * each sender row landed in. The two numberings part as soon as this device self-grows rows of
+     * its own between syncs, so moves are remapped through rowMap and appends extend it.
+     */
+    struct Peer {
+        uint64_t epoch = 0;        // sender epoch and generation held; 0 asks for a full record
+        uint64_t gen = 0;
+        uint64_t localEpoch = 0;   // the local wall's epoch at install; any local replacement voids it
+        std::vector<uint32_t> rowMap;
+
+        /** The next sync must be a full transfer. */
+        void forget() { epoch = 0; gen = 0; }
+        /** A base to ask a delta on, while the local wall is still the one installed. */
+        bool holds(uint64_t localWallEpoch) const { return epoch != 0 && localEpoch == localWallEpoch; }
+        /** A full record became [rows] local rows, 1:1, on local wall [localWallEpoch]. */
+        void installed(size_t rows, uint64_t localWallEpoch);
+        /**
+         * Null when [d] applies to a local wall of [localRows] rows, [descType] x [descCols], at
+         * [localWallEpoch], with its moved rows translated into [movedLocal]; otherwise why not.
+         * A full record only needs rows.
+         */
+        const char* check(const FingerprintDelta& d, uint64_t localWallEpoch, size_t localRows, int descType,
+                          int descCols, std::vector<uint32_t>& movedLocal) const;
+        /** [d] was applied, its appends landing from local row [firstLocal] (incremental only). */
+        void applied(const FingerprintDelta& d, size_t firstLocal);
+    };
+
+    std::vector<uint8_t> encode() const;
+
+    /** Parse untrusted bytes into [out]. False, with [out] unspecified, on any inconsistency. */
+    static bool decode(const uint8_t* data, size_t size, FingerprintDelta& out);
+
+    static constexpr uint32_t kVersion = 1;
+    // A real wall is a few thousand marks.
+    static constexpr uint32_t kMaxRows = 100000;
+};
@@ -0,0 +1,86 @@
+#pragma once
+#include <opencv2/opencv.hpp>
+#include <opencv2/dnn.hpp>
+#include <atomic>
+#include <memory>
+#include <string>
+#include <vector>
+
+/**
+ * The one place a neural model in this engine touches an inference runtime.
+ *
+ * SuperPointDetector, DistortionHead and LowLightEnhancer used to each call readNetFromONNX and
+ * pick their own backend/target inline — three copies of the same OpenCL-or-CPU decision, any of
+ * which could drift from the others. They now hold an InferenceBackend and say only what they want
+ * (InferenceBackend::Options); which runtime answers is decided here.
+ *
+ * Only OpenCV DNN is implemented. It is the runtime the build already links (OpenCV::opencv_java5
+ * via Prefab); an ONNX Runtime / XNNPACK CPU path would be a second implementation of this
+ * interface plus a Prefab dependency, and a Kind value for it is deliberately NOT reserved until
+ * that dependency exists — an enum entry that silently falls back to OpenCV would make a
+ * side-by-side benchmark report two identical runtimes as two different ones.
+ *
+ * Not thread-safe: a backend is one graph with one set of bound inputs. Callers serialize on their
+ * own mutex exactly as they did around the bare cv::dnn::Net.
+ */
+class InferenceBackend {
+public:
+    enum class Kind {
+        Auto,            // OpenCL target when the device has it, else CPU — the pre-abstraction behaviour
+        OpenCvDnnOpenCL, // force the OpenCL target (falls back to CPU, logged, when OpenCL is absent)
+        OpenCvDnnCpu,    // force the CPU target; the honest baseline for a side-by-side timing
+    };
+
+    struct Options {
+        Kind kind = Kind::Auto;
+        // Worker threads for this model's forward. <= 0 leaves OpenCV's process-wide pool alone
+        // (the default, and what every model did before). OpenCV has no per-net thread setting, so
+        // a positive value is applied around forward() under a process-wide lock and restored after
+        // — see OpenCvDnnBackend::forward for why that lock is needed.
+        int numThreads = 0;
+    };
+
+    virtual ~InferenceBackend() = default;
+
+    /** Load from an in-memory ONNX buffer (the AAssetManager read in GraffitiJNI.cpp). */
+    virtual bool load(const std::vector<uchar>& onnxBytes, const Options& opts) = 0;
+    virtual bool empty() const = 0;
+
+    /**
+     * Bind [blob] to the named input ("" = the graph's only input). The Mat header is retained,
+     * not its pixels copied: the caller must keep [blob]'s data alive until forward() returns.
+     */
+    virtual void setInput(const cv::Mat& blob, const std::string& name = std::string()) = 0;
+
+    /** Forward to the named outputs ({} = every unconnected output, in graph order). */
+    virtual bool forward(std::vector<cv::Mat>& outputs,
+                         const std::vector<std::string>& outNames = {}) = 0;
+
+    /** Short runtime/target label for logs and benchmarks, e.g. "opencv-dnn/opencl". */
+    virtual const char* name() const = 0;
+
+    /** Wall-clock ms of the most recent successful forward(); -1 until one has run. */
+    float lastForwardMs() const { return mLastForwardMs.load(std::memory_order_relaxed); }
+
+    static std::unique_ptr<InferenceBackend> create(Kind kind);
+
+protected:
+    std::atomic<float> mLastForwardMs{-1.0f};
+};
+
+namespace inference {
+
+/**
+ * View a continuous single-channel CV_32F image as a [1,1,H,W] NCHW blob WITHOUT copying.
+ *
+ * For one channel NCHW and HWC are the same bytes, so blobFromImage's copy is pure overhead; this
+ * is the input binding SuperPoint and the distortion head use. The returned Mat shares [f32]'s
+ * buffer — keep [f32] alive for as long as the blob is bound.
+ */
+inline cv::Mat wrapGrayAsBlob(const cv::Mat& f32) {
+    CV_Assert(f32.type() == CV_32F && f32.isContinuous());
+    const int sz[4] = {1, 1, f32.rows, f32.cols};
+    return cv::Mat(4, sz, CV_32F, const_cast<uchar*>(f32.data));
+}
+
+} // namespace inference
@@ -0,0 +1,202 @@
+#ifndef GRAFFITIXR_KEYFRAME_GRAPH_H
+#define GRAFFITIXR_KEYFRAME_GRAPH_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+#include <opencv2/core.hpp>
+
+/**
+ * Keyframes over the persistent feature map: which locked views saw which map points, and how much
+ * any two views overlap (covisibility).
+ *
+ * The map is otherwise a flat point set, and the only way into it is geometric — the frustum gate
+ * under the last reloc pose. With no pose (a cold start, or a prior too stale for the gate to find
+ * anything) the map could not be used at all. A keyframe adds the missing handle: a compact global
+ * descriptor of what the view looked like. Retrieval scores the live frame against every keyframe,
+ * keeps the best few, widens each by its strongest covisible neighbours (views of the same stretch
+ * of wall from elsewhere), and hands back only their points to match against.
+ *
+ * The global descriptor is mean pooling — the normalized mean of the view's local descriptors, ORB
+ * bits read as ±1 — which is cheap and needs nothing trained. It ranks keyframes of one wall well
+ * enough to choose a few hundred points out of thousands; it is not a place recognizer across walls.
+ *
+ * Points are referred to by stable map point IDs, not map indices, because pruning swap-removes and
+ * so renumbers. A pruned point is forgotten (forgetPoint) from the inverted point -> keyframe list;
+ * the keyframes' own lists keep the stale ID and the caller's ID lookup simply misses it.
+ *
+ * Not thread-safe; MobileGS keeps it under mMutex with the map it describes.
+ */
+class KeyframeGraph {
+public:
+    struct Keyframe {
+        uint32_t id = 0;
+        float camFromFp[16];                         // column-major, OpenCV camera frame
+        cv::Mat global;                              // 1 x D CV_32F, unit length
+        std::vector<uint32_t> points;                // map point IDs observed
+        std::unordered_map<uint32_t, int> covis;     // keyframe id -> shared point count at link time
+    };
+
+    void clear() {
+        mFrames.clear();
+        mPointFrames.clear();
+    }
+
+    size_t size() const { return mFrames.size(); }
+
+    /** Mean-pooled global descriptor of N x D local descriptors (CV_32F, or CV_8U bit-packed). */
+    static cv::Mat globalDescriptor(const cv::Mat& descs) {
+        if (descs.empty()) return cv::Mat();
+        cv::Mat g;
+        if (descs.type() == CV_32F) {
+            cv::reduce(descs, g, 0, cv::REDUCE_AVG, CV_32F);
+        } else if (descs.type() == CV_8U) {
+            g = cv::Mat::zeros(1, descs.cols * 8, CV_32F);
+            float* gp = g.ptr<float>(0);
+            for (int r = 0; r < descs.rows; ++r) {
+                const uchar* d = descs.ptr<uchar>(r);
+                for (int b = 0; b < descs.cols; ++b)
+                    for (int k = 0; k < 8; ++k) gp[b * 8 + k] += (d[b] & (0x80 >> k)) ? 1.f : -1.f;
+            }
+        } else {
+            return cv::Mat();
+        }
+        const double nrm = cv::norm(g);
+        if (nrm < 1e-9) return cv::Mat();
+        return g * (1.0 / nrm);
+    }
+
+    /** True when a keyframe already sits within [maxTransM] and [maxRotDeg] of the pose. */
+    bool hasNearby(const float* camFromFp16, float maxTransM, float maxRotDeg) const {
+        const double cosMax = std::cos(maxRotDeg * CV_PI / 180.0);
+        for (const auto& kf : mFrames) {
+            if (centreDistance(kf.camFromFp, camFromFp16) > maxTransM) continue;
+            if (rotationCos(kf.camFromFp, camFromFp16) < cosMax) continue;
+            return true;
+        }
+        return false;
+    }
+
+    /**
+     * Add a keyframe and link it into the covisibility graph: every existing keyframe sharing at
+     * least one point gets an edge weighted by the shared count. Returns the new keyframe's id.
+     */
+    uint32_t add(const float* camFromFp16, const cv::Mat& global, std::vector<uint32_t> points) {
+        Keyframe kf;
+        kf.id = mNextId++;
+        std::copy(camFromFp16, camFromFp16 + 16, kf.camFromFp);
+        kf.global = global.clone();
+        kf.points = std::move(points);
+        for (uint32_t pid : kf.points) {
+            std::vector<uint32_t>& seenBy = mPointFrames[pid];
+            for (uint32_t other : seenBy) ++kf.covis[other];
+            seenBy.push_back(kf.id);
+        }
+        for (const auto& e : kf.covis) {
+            Keyframe* o = find(e.first);
+            if (o) o->covis[kf.id] = e.second;
+        }
+        mFrames.push_back(std::move(kf));
+        return mFrames.back().id;
+    }
+
+    /** Drop the oldest keyframe and every reference to it. */
+    void removeOldest() {
+        if (mFrames.empty()) return;
+        const Keyframe& kf = mFrames.front();
+        for (uint32_t pid : kf.points) {
+            auto it = mPointFrames.find(pid);
+            if (it == mPointFrames.end()) continue;
+            auto& v = it->second;
+            v.erase(std::remove(v.begin(), v.end(), kf.id), v.end());
+            if (v.empty()) mPointFrames.erase(it);
+        }
+        for (const auto& e : kf.covis) {
+            Keyframe* o = find(e.first);
+            if (o) o->covis.erase(kf.id);
+        }
+        mFrames.erase(mFrames.begin());
+    }
+
+    /** The map point was pruned: stop linking new keyframes through it. */
+    void forgetPoint(uint32_t pid) { mPointFrames.erase(pid); }
+
+    /**
+     * Point IDs seen by the [k] keyframes most similar to [global], each widened by its
+     * [neighbours] strongest covisible keyframes. Deduplicated; empty if nothing scores above zero.
+     */
+    void retrieve(const cv::Mat& global, int k, int neighbours, std::vector<uint32_t>& out) const {
+        out.clear();
+        if (global.empty() || mFrames.empty()) return;
+        std::vector<std::pair<float, size_t>> scored;
+        scored.reserve(mFrames.size());
+        for (size_t i = 0; i < mFrames.size(); ++i) {
+            const cv::Mat& g = mFrames[i].global;
+            if (g.cols != global.cols) continue;
+            const float s = (float)global.dot(g);
+            if (s > 0.f) scored.emplace_back(s, i);
+        }
+        const size_t top = std::min(scored.size(), (size_t)std::max(0, k));
+        std::partial_sort(scored.begin(), scored.begin() + top, scored.end(),
+                          [](const std::pair<float, size_t>& a, const std::pair<float, size_t>& b) {
+                              return a.first > b.first;
+                          });
+        std::unordered_set<uint32_t> chosen;
+        for (size_t i = 0; i < top; ++i) {
+            const Keyframe& kf = mFrames[scored[i].second];
+            chosen.insert(kf.id);
+            std::vector<std::pair<int, uint32_t>> nb;
+            for (const auto& e : kf.covis) nb.emplace_back(e.second, e.first);
+            const size_t nTop = std::min(nb.size(), (size_t)std::max(0, neighbours));
+            std::partial_sort(nb.begin(), nb.begin() + nTop, nb.end(),
+                              [](const std::pair<int, uint32_t>& a, const std::pair<int, uint32_t>& b) {
+                                  return a.first > b.first;
+                              });
+            for (size_t j = 0; j < nTop; ++j) chosen.insert(nb[j].second);
+        }
+        std::unordered_set<uint32_t> seen;
+        for (const auto& kf : mFrames) {
+            if (!chosen.count(kf.id)) continue;
+            for (uint32_t pid : kf.points)
+                if (seen.insert(pid).second) out.push_back(pid);
+        }
+    }
+
+private:
+    Keyframe* find(uint32_t id) {
+        for (auto& kf : mFrames) if (kf.id == id) return &kf;
+        return nullptr;
+    }
+
+    // Camera centre in the fingerprint frame is -Rᵀt; distance between two poses' centres.
+    static double centreDistance(const float* a, const float* b) {
+        double d2 = 0.0;
+        for (int r = 0; r < 3; ++r) {
+            double ca = 0.0, cb = 0.0;
+            for (int c = 0; c < 3; ++c) {
+                ca -= a[r * 4 + c] * a[12 + c];   // (Rᵀ)[r][c] = R[c][r] = m[r*4 + c] column-major
+                cb -= b[r * 4 + c] * b[12 + c];
+            }
+            d2 += (ca - cb) * (ca - cb);
+        }
+        return std::sqrt(d2);
+    }
+
+    // cos of the relative rotation angle: (trace(Ra Rbᵀ) - 1) / 2.
+    static double rotationCos(const float* a, const float* b) {
+        double tr = 0.0;
+        for (int col = 0; col < 3; ++col)
+            for (int row = 0; row < 3; ++row) tr += (double)a[col * 4 + row] * b[col * 4 + row];
+        return (tr - 1.0) * 0.5;
+    }
+
+    std::vector<Keyframe> mFrames;   // oldest first
+    std::unordered_map<uint32_t, std::vector<uint32_t>> mPointFrames;   // point id -> keyframe ids
+    uint32_t mNextId = 0;
+};
+
+#endif  // GRAFFITIXR_KEYFRAME_GRAPH_H
@@ -1,7 +1,9 @@
 #pragma once
 #include <opencv2/opencv.hpp>
 #include <opencv2/dnn.hpp>
+#include "InferenceBackend.h"
 #include <atomic>
+#include <memory>
 #include <mutex>
 #include <vector>
 
@@ -9,14 +11,136 @@ class LowLightEnhancer {
 public:
     LowLightEnhancer() = default;
 
-    bool load(const std::vector<uchar>& onnxBytes);
+    bool load(const std::vector<uchar>& onnxBytes,
+              const InferenceBackend::Options& opts = InferenceBackend::Options());
     bool isLoaded() const { return mLoaded; }
 
     // input/output: CV_8UC3 RGB. Returns false if model not loaded or inference fails.
     bool enhance(const cv::Mat& input, cv::Mat& output);
 
+    // Same network, but returns only the enhanced LUMA (CV_8UC1, input size) — for callers that
+    // convert to gray straight after enhancing, which is every feature path. Skips building and
+    // upsampling a three-channel frame that would be collapsed to one channel on the next line.
+    //
+    // [viewMatrix] (column-major 4x4 VIO view, or null) opts the call into the temporal curve
+    // cache described below. Pass it only for a continuous camera stream whose pose is tracking;
+    // null always runs the network and leaves the cache alone, so one-off images (a captured
+    // bitmap, a fingerprint source) never borrow — or overwrite — the live stream's curves.
+    bool enhanceLuma(const cv::Mat& input, cv::Mat& grayOut, const float* viewMatrix = nullptr);
+
+    // One throwaway forward at the inference size, so the first dark frame isn't also the cold one.
+    bool warmUp();
+
+    // Every frame is resized to this before inference (and back after), so it is the only shape
+    // the graph ever sees.
+    static constexpr int kInferW = 600;
+    static constexpr int kInferH = 400;
+
+    // Temporal curve cache. Zero-DCE's output is a per-pixel curve applied to the input, and for
+    // consecutive frames of the same wall under the same light that curve barely moves — so the
+    // last one is kept and re-applied to the new frame (a few whole-plane multiply-adds) until the
+    // frame's mean luma or the camera pose has drifted past these bounds, or it has simply been
+    // reused too long. Any one of them forces a fresh forward, which refreshes the cache.
+    static constexpr float kCacheMaxLumaDelta = 0.04f;  // mean luma, [0,1] input scale
+    static constexpr float kCacheMaxTranslationM = 0.10f;
+    static constexpr float kCacheMaxRotationDeg = 8.0f;
+    static constexpr int   kCacheMaxReuses = 30;
+
+    // Out of every enhanceLuma call that offered a pose, how many were served from the cache.
+    int cacheHits() const { return mCacheHits.load(std::memory_order_relaxed); }
+    int cacheMisses() const { return mCacheMisses.load(std::memory_order_relaxed); }
+
 private:
-    cv::dnn::Net      mNet;
+    // Resize + normalize [input] into mFloat, the inference-size frame both paths start from.
+    void prepare(const cv::Mat& input);
+    // CHW blob from mFloat + forward; on success planes[0..2] are R,G,B float views into the
+    // output. Caller holds mMutex; the views are valid until the next forward.
+    bool infer(cv::Mat planes[3]);
+
+    // Capture the curve from the forward infer() just ran: the graph's own 24-channel curve
+    // parameters when it exports them (official Zero-DCE does, as its last output), else the
+    // per-pixel gain enhanced/input that the curve amounted to on this frame.
+    void refreshCache(const cv::Mat planes[3], float meanLuma, const float* viewMatrix);
+    bool cacheUsable(float meanLuma, const float* viewMatrix) const;
+    // Apply the cached curve to mFloat (already resized by the caller) into mCached[0..2].
+    void applyCache(cv::Mat planes[3]);
+
+    std::unique_ptr<InferenceBackend> mBackend;
     std::mutex        mMutex;
     std::atomic<bool> mLoaded{false};
+
+    // Per-frame working buffers, reused across calls (guarded by mMutex). Every frame reaches the
+    // network at kInferW x kInferH, so after the first call none of these reallocates.
+    cv::Mat mResized, mFloat, mBlob, mResult, mLuma, mLuma8;
+    cv::Mat mPlanes8[3];
+    std::vector<cv::Mat> mOutputs;
+
+    // Curve cache (guarded by mMutex). Exactly one of mCurves / mGain is populated while
+    // mCacheValid: mCurves holds Zero-DCE's 8 iterations x RGB parameter planes, mGain the
+    // fallback per-channel gain for graphs that only export the enhanced image.
+    bool    mCacheValid = false;
+    cv::Mat mCurves;             // [1,24,H,W] CV_32F, cloned out of the forward's outputs
+    cv::Mat mGain[3];
+    cv::Mat mInPlanes[3], mCached[3], mTerm;
+    float   mCacheLuma = 0.0f;
+    float   mCacheView[16] = {};
+    int     mCacheReuses = 0;
+    std::atomic<int> mCacheHits{0};
+    std::atomic<int> mCacheMisses{0};
+};
+
+/**
+ * Classical low-light tiers: cheaper stand-ins for the network above, on CV_8UC1 luma.
+ *
+ * Both exist for the dark frames that would otherwise reach feature detection with only
+ * normalizeForFeatures' CLAHE — no Zero-DCE model loaded, or the network too slow on a throttled
+ * device to be worth its latency. [out] may alias [gray].
+ */
+namespace lowlight {
+
+// Adaptive gamma through a 256-entry LUT: the exponent is picked so the frame's mean maps to
+// mid-gray, then cv::LUT applies it. Sub-millisecond at camera resolution. A plain gamma rather than
+// a log curve because the exponent can be fitted to the frame; the LUT is rebuilt only when it moves.
+void gammaLuma(const cv::Mat& gray, cv::Mat& out);
+
+// Single-scale Retinex with the illumination estimated by a self-guided filter (He et al.) at
+// quarter resolution: out = in * clamp(target / illumination). The guided filter keeps edges out of
+// the illumination estimate, which is what stops the halos a Gaussian-blur Retinex draws around
+// exactly the high-contrast paint edges the detector is looking for.
+void retinexLuma(const cv::Mat& gray, cv::Mat& out);
+
+} // namespace lowlight
+
+/**
+ * Picks which low-light tier a dark reloc frame goes through, from what each tier has actually
+ * cost and actually bought on recent frames.
+ *
+ * The rule is "cheapest tier that keeps most of the best tier's detections": every tier keeps an
+ * EMA of its wall-clock cost and of the keypoints detected on the frames it enhanced, and choose()
+ * returns the lowest-cost tier whose feature EMA is within kRetainFraction of the best. A tier whose
+ * cost EMA exceeds kMaxTierMs (a throttled device running the network) drops out, except the two
+ * classical floors that can't meaningfully exceed it. Because consecutive frames differ, the
+ * comparison is only meaningful in aggregate: unsampled tiers are tried first, and every
+ * kExploreEvery-th choice visits the next tier round-robin so a stale EMA gets refreshed.
+ *
+ * Single-threaded: owned and driven by the reloc thread (MobileGS::runRelocPass).
+ */
+class LowLightTierSelector {
+public:
+    enum Tier { kTierNone = 0, kTierGamma, kTierRetinex, kTierNetwork, kTierCount };
+
+    Tier choose(bool networkAvailable);
+    void report(Tier tier, float ms, int features);
+
+    static constexpr float kRetainFraction = 0.9f;
+    static constexpr float kMaxTierMs = 60.0f;
+    static constexpr int   kMinSamples = 3;
+    static constexpr int   kExploreEvery = 24;
+    static constexpr float kEmaAlpha = 0.2f;
+
+private:
+    struct Stats { float ms = 0.0f; float features = 0.0f; int samples = 0; };
+    Stats mStats[kTierCount];
+    int   mChoices = 0;
+    int   mExploreCursor = 0;
 };
@@ -5,16 +5,32 @@
 #include "SuperPointDetector.h"
 #include "DistortionHead.h"
 #include "LowLightEnhancer.h"
+#include "DescriptorCodes.h"
+#include "VoxelHash.h"
+#include "PlaneModel.h"
+#include "DescriptorArena.h"
+#include "KeyframeGraph.h"
+#include "VocabularyTree.h"
+#include "BowIndex.h"
+#include "WallRegistry.h"
+#include "BundleRefiner.h"
+#include "WallSidecar.h"
+#include "FingerprintDelta.h"
+#include "WallJournal.h"
+#include <algorithm>
 #include <cmath>
 #include <limits>
 #include <mutex>
 #include <vector>
 #include <unordered_map>
+#include <unordered_set>
 #include <string>
 #include <thread>
 #include <atomic>
 #include <chrono>
 #include <condition_variable>
+#include <deque>
+#include <memory>
 #include <GLES3/gl3.h>
 
 #include "NativeUtil.h"
@@ -71,11 +87,94 @@ public:
     // Phase 3b: pack the live feature map (points/descriptors/confidence/obs + co-registration) into a
     // self-describing little-endian blob for .gxr persistence; empty if there's no map. Race-free (one lock).
     std::vector<uint8_t> exportWallFeatureMap() const;
+    // Binary sidecar (WallSidecar.h): write the fingerprint and the feature map to one file beside
+    // project.json, or load it back by mmap — the descriptors are adopted in place, not copied. Load
+    // replaces the map when the file has one, and the fingerprint when restoreFingerprint is set or
+    // the file's is the live one grown further (the app restores the capture from project.json, and
+    // the growth and its journal live here). False when nothing was written/loaded.
+    bool saveWallSidecar(const std::string& path);
+    bool loadWallSidecar(const std::string& path, bool restoreFingerprint);
+    // Mutation journal beside the sidecar (WallJournal.h). While enabled, map adds, prunes,
+    // refinements and re-observations, and the wall's self-grown and refined marks, are recorded
+    // from each save or load on; appendWallJournal writes what was recorded since its last call as
+    // one batch and returns the journal's size, or -1 when the journal cannot extend the file (never
+    // saved or loaded, or the map or the journaled wall replaced since), which asks for a save.
+    // saveWallSidecar compacts (a fresh sidecar, an empty journal); loadWallSidecar replays the
+    // journal whether or not recording is on. Default OFF, so autosaves rewrite the sidecar; the app
+    // turns it on at start.
+    void setMutationJournalEnabled(bool e) { mJournalEnabled.store(e, std::memory_order_relaxed); }
+    int64_t appendWallJournal(const std::string& sidecarPath);
+    // Code the sidecar's descriptor sections (DescriptorCodec.h): 1 stores SuperPoint as half floats,
+    // 2 as block-scaled int8 within DescriptorCodec::kMaxRowError; ORB is range-coded losslessly at
+    // either. 0 (the default) writes them raw. Lossy levels move stored descriptors, so they want
+    // measuring against reloc rate before they ship; a coded file needs a build that reads version 2.
+    void setDescriptorCompression(int level) {
+        mDescriptorCodecLevel.store(std::max(0, std::min(2, level)), std::memory_order_relaxed);
+    }
+    // Multi-wall registry (WallRegistry.h). The loaded wall — fingerprint, map and their indexes —
+    // can be labelled with a project ID; activating another ID parks the loaded wall under its
+    // label and swaps the requested one in, with no JNI round trip and no index rebuild. Returns
+    // false when the ID isn't parked: the engine is then left empty and labelled, and the caller
+    // restores into it as before. Parked walls are evicted least-recently-used over the budget.
+    bool activateWall(const std::string& projectId);
+    void setActiveWallId(const std::string& projectId);
+    std::string getActiveWallId() const { std::lock_guard<std::mutex> lock(mMutex); return mActiveWallId; }
+    void forgetWall(const std::string& projectId);
+    void setWallRegistryBudget(size_t bytes);
+    size_t getWallRegistryBytes() const { std::lock_guard<std::mutex> lock(mMutex); return mWallRegistry.bytes(); }
+    // Let failed reloc attempts propose a wall: when the frame's global descriptor prefers a parked
+    // wall over the loaded one by kWallSelectMargin, kWallSelectStreak attempts running, that wall's
+    // ID is left for takeProposedWall. Nothing is switched here; the app opens the project and its
+    // load calls activateWall. Default OFF.
+    void setWallPreselectEnabled(bool e) { mWallPreselectEnabled.store(e, std::memory_order_relaxed); }
+    // The wall pre-selection last proposed, cleared by the read; empty when there is none. Any
+    // activateWall also clears it.
+    std::string takeProposedWall();
     // Phase 2b: gate live map-matching in relocThreadFunc. Default OFF — ships inert until validated.
     void setMapRelocEnabled(bool e) { mMapRelocEnabled.store(e, std::memory_order_relaxed); }
     // Phase 3: passively grow the feature map from reloc-locked frames. Default OFF, and independent of
     // the match flag (accumulate without matching, or match a persisted map without growing).
     void setMapBuildEnabled(bool e) { mMapBuildEnabled.store(e, std::memory_order_relaxed); }
+    // Hand map growth to a low-priority maintenance worker instead of running it on the reloc thread
+    // after each lock. Default OFF: the map then trails the locks it is built from by however far the
+    // worker is behind, which is harmless for a reloc backbone but wants measuring before it ships.
+    void setMapWorkerEnabled(bool e) { mMapWorkerEnabled.store(e, std::memory_order_relaxed); }
+    // Map growth associates observations to map points by projecting the in-view points with the
+    // freshly solved pose. This re-enables the old whole-map knnMatch as a fallback when that finds
+    // fewer than kMapAssocMinGuided re-observations. Default OFF: its cost scales with the map.
+    void setMapGlobalAssocEnabled(bool e) { mMapGlobalAssocEnabled.store(e, std::memory_order_relaxed); }
+    // Record keyframes (pose, global descriptor, observed map points, covisibility) as the map is
+    // maintained, and let a reloc pass the frustum gate cannot serve — no prior pose yet, or a prior
+    // whose gate finds nothing — match the map points of the best-retrieved keyframes instead.
+    // Default OFF; only meaningful with map reloc on.
+    void setMapKeyframesEnabled(bool e) { mMapKeyframesEnabled.store(e, std::memory_order_relaxed); }
+    // Cold relocalization through a bag-of-words vocabulary (loadVocabulary): with no recent lock,
+    // wall correspondences come from the direct index (only marks sharing a vocabulary node are
+    // ratio-tested) and map candidates from inverted-file votes, instead of brute force over the
+    // wall and nothing at all from the map. Default OFF, and inert until a vocabulary is loaded.
+    void setBowRelocEnabled(bool e) { mBowRelocEnabled.store(e, std::memory_order_relaxed); }
+    // Record where each lock saw self-grown wall marks and map points, and every kRefineEveryPoses
+    // locks bundle-adjust them against the recent poses on a low-priority worker (BundleRefiner.h),
+    // writing the refined positions back. Default OFF: moves stored points, so it wants measuring
+    // against reprojection error and lock rate before it ships.
+    void setPointRefinementEnabled(bool e) { mPointRefinementEnabled.store(e, std::memory_order_relaxed); }
+    // Match SuperPoint fingerprints and the map on 32-byte sign codes (DescriptorCodes.h) with
+    // Hamming distance instead of 1 KB float rows with L2. Default OFF: the codes trade some
+    // ratio-test discrimination for a 32x smaller per-pass snapshot and matcher working set, and
+    // that trade wants measuring on device before it is the default. ORB fingerprints ignore it.
+    void setCompactMatchEnabled(bool e) { mCompactMatchEnabled.store(e, std::memory_order_relaxed); }
+    // Route dark reloc frames through LowLightTierSelector (gamma LUT / guided Retinex / Zero-DCE,
+    // picked by measured cost and feature yield) instead of "Zero-DCE if loaded, else nothing".
+    // Default OFF: the selector's choice moves reloc inputs around, which wants device validation.
+    void setLowLightTiersEnabled(bool e) { mLowLightTiersEnabled.store(e, std::memory_order_relaxed); }
+    // Run the distortion head on its own low-priority worker at most [hz] times a second, fed the
+    // latest reloc crop, instead of inline before PnP. <= 0 (the default) keeps it inline. The
+    // head's outputs are slow-moving diagnostics, so the pose need not wait on them.
+    void setDistortionHeadRate(float hz) { mHeadRateHz.store(hz, std::memory_order_relaxed); }
+    // Use the distortion head's predicted homography as a reloc prior: it seeds the rectifying warp
+    // and confines wall matching to a window around each fingerprint point's predicted location.
+    // Default OFF; only a recent, confident head result is trusted (see headPriorHomography).
+    void setHeadPriorEnabled(bool e) { mHeadPriorEnabled.store(e, std::memory_order_relaxed); }
     /**
      * Why the last relocalization attempt failed to publish a pose. Ordered by how early the gate
      * sits in the pipeline, so the largest value reached is the furthest the attempt got.
@@ -213,6 +312,11 @@ public:
 
     /** Hard ceiling on stored wall marks — a memory guard on the self-grow append. */
     static constexpr size_t kMaxWallMarks = 5000;
+    // Self-grow promotes at most this many marks per relock.
+    static constexpr size_t kGrowBatchCap = 30;
+    // Two marks closer than this on every axis are the same mark (self-grow and map-side dedup),
+    // and the cell size of the hashes that answer that question.
+    static constexpr float kWallDedupM = 0.01f;
 
     /**
      * Why the SPATIALLY-CONSTRAINED corroboration match did or did not run this attempt.
@@ -284,6 +388,8 @@ public:
      */
     static constexpr float kRelocLoweRatio = 0.75f;
     static constexpr float kCorrobLoweRatio = 0.85f;
+    // Fewest wall + map correspondences a reloc attempt will hand to solvePnPRansac.
+    static constexpr size_t kRelocMinCorr = 8;
 
     /**
      * How many separate gated attempts must corroborate a design feature before it counts toward
@@ -409,6 +515,10 @@ public:
     bool relocWantsFrame();
     void getAnchorTransform(float* outMat16) const;
     void getRelocResult(float* out19) const;       // [0..15]=pnpMat,16=inliers,17=matches,18=seq
+    // The distortion head's latest distortion[13] in [0..12], [13] = the reloc pass (relocPassSeq)
+    // whose crop produced it, [14] = the newest reloc pass, so [14]-[13] is how stale [0..12] is.
+    // [13] is -1 until the head has produced anything.
+    void getDistortionHeadResult(float* out15) const;
     void getFingerprintAnchor(float* out16) const;
     void setArtworkFingerprint(const cv::Mat& composite, const uint8_t* depthData, int depthW, int depthH, int depthStride, const float* intrinsics4, const float* viewMat16);
     // Detect the same features generateFingerprint would (SuperPoint/ORB-1000, masked) and return their
@@ -434,7 +544,10 @@ public:
     FingerprintData generateFingerprint(const cv::Mat& image, const cv::Mat& mask, const uint8_t* depthData, int depthW, int depthH, int depthStride, const float* intrinsics, const float* viewMat);
 
     bool loadSuperPoint(const std::vector<uchar>& onnxBytes);
-    bool loadDistortionHead(const std::vector<uchar>& onnxBytes) { return mDistortionHead.load(onnxBytes); }
+    bool loadDistortionHead(const std::vector<uchar>& onnxBytes);
+    // VocabularyTree asset bytes. The descriptor type picks the slot (float for SuperPoint, binary
+    // for ORB); the wall and map indexes are rebuilt against it. False if the bytes don't parse.
+    bool loadVocabulary(const std::vector<uchar>& bytes);
     // Canonical fingerprint patch (the marks) the distortion head compares the live crop against.
     // Stored as a raw 256x256 gray (NO CLAHE — the head's frozen SuperPoint was trained on raw gray).
     void setWallPatch(const cv::Mat& img);
@@ -522,8 +635,26 @@ public:
     }
 
     // Collaboration methods
-    std::vector<uint8_t> exportFingerprint();
-    void alignToFingerprint(const uint8_t* data, size_t size);
+    /**
+     * The fingerprint as a FingerprintDelta for a peer holding generation [sinceGen] of wall
+     * [epoch]: the rows appended and moved since then, or a full record when the peer names another
+     * epoch, generation 0, or a generation this wall never had. Empty when the peer is already
+     * current, or there is no fingerprint.
+     */
+    std::vector<uint8_t> exportFingerprintDelta(uint64_t epoch, uint64_t sinceGen);
+
+    /**
+     * Apply a peer's FingerprintDelta: a full record replaces the wall outright;
+     * an incremental one applies only on top of the base it names. False on anything that does not
+     * fit, after which getPeerFingerprintBase reports no base, so the next request is for a full.
+     */
+    bool applyFingerprintDelta(const uint8_t* data, size_t size);
+
+    /**
+     * The peer wall this one was last brought up to ([epoch], [gen]), for the next request; 0, 0 when
+     * there is none, or the wall has been replaced locally since.
+     */
+    void getPeerFingerprintBase(uint64_t& epoch, uint64_t& gen) const;
 
     void destroy();
     std::mutex& getMutex() { return mMutex; }
@@ -552,11 +683,43 @@ private:
     // and the VIO baseline between the current and fingerprint-capture views, plus the viewing
     // obliquity in degrees. False if no fingerprint view is stored or the geometry is degenerate.
     bool computeRectifyHomography(const float* viewCur16, cv::Mat& Hcur_fp, cv::Mat& Hfp_cur, double& obliquityDeg);
+    // Current-image <- fingerprint-image homography from the head's latest corners, or false when
+    // there is no result recent (kHeadPriorMaxAge passes) and confident (kHeadPriorMinMatchability)
+    // enough to steer matching. tiltDeg is the head's own tilt estimate, used as the obliquity.
+    bool headPriorHomography(long passSeq, uint64_t headEpoch, const float* fpIntrinsics4, cv::Mat& Hcur_fp,
+                             double& tiltDeg) const;
+    static constexpr long  kHeadPriorMaxAge = 2;
+    static constexpr float kHeadPriorMinMatchability = 0.7f;
+    // Guided-window half-size in current-image pixels. Wide enough to absorb the camera motion
+    // between the pass the head saw and this one, which the prior does not model.
+    static constexpr float kHeadPriorWindowPx = 32.0f;
+    // A guided pass yielding fewer wall correspondences than this is redone unguided: the prior
+    // only ever narrows the search, and a wrong one must cost one extra match, never the lock.
+    static constexpr size_t kHeadPriorMinCorr = 12;
     // Phase 3 passive builder: on a reloc lock, back-project the frame's features onto the wall plane
     // (fit from the fingerprint points) to get 3D points in the fingerprint frame, associate to the map
-    // by descriptor (bump confidence) or add new (capped). Co-registers the map to the fingerprint anchor.
+    // by projection under the fresh pose and descriptor (bump confidence) or add new (capped). Co-registers the map to the fingerprint anchor.
+    // With the map worker on (setMapWorkerEnabled) this only queues the observation for mMapThread.
+    // refinePose is the BundleRefiner pose this lock was recorded as (0: none), so the map's
+    // re-observations and additions join the observation history too.
     void growMapFromReloc(const glm::mat4& camFromFp, const std::vector<cv::KeyPoint>& kps,
-                          const cv::Mat& descs, double fx, double fy, double cx, double cy);
+                          const cv::Mat& descs, double fx, double fy, double cx, double cy,
+                          uint32_t refinePose);
+    // The work itself, on whichever thread runs it: snapshot the map under mMutex, associate and
+    // back-project against the snapshot with no lock held, then commit — re-observations, merges,
+    // additions, the confidence/age prune — in one mMutex section. A commit whose snapshot went
+    // stale (the map was restored, cleared or changed by another commit) is dropped whole.
+    void maintainMap(const glm::mat4& camFromFp, const std::vector<cv::KeyPoint>& kps,
+                     const cv::Mat& descs, double fx, double fy, double cx, double cy,
+                     uint32_t refinePose);
+    void mapThreadFunc();
+    struct MapGrowJob {
+        glm::mat4 camFromFp;
+        std::vector<cv::KeyPoint> kps;
+        cv::Mat descs;   // owned copy: the pass reuses its buffers
+        double fx, fy, cx, cy;
+        uint32_t refinePose;
+    };
 
     mutable std::mutex mMutex;
     std::atomic<bool> mIsArCoreTracking{false};
@@ -568,9 +731,68 @@ private:
     DistortionHead mDistortionHead;
     LowLightEnhancer mEnhancer;
     static constexpr float kLowLightThreshold = 0.35f;
+    std::atomic<bool> mLowLightTiersEnabled{false};
+    LowLightTierSelector mLowLightTiers;  // reloc thread only
+
+    // Load-time warm-up. Every load* above queues its model here after a successful load, and one
+    // background thread runs each queued model's warmUp() — a throwaway forward at the shape the
+    // reloc pass will use — so the first-run graph setup lands at app start instead of as a
+    // multi-hundred-ms hitch the first time the user points at the wall.
+    //
+    // Its own thread, not the loader's: the JNI loaders hold gEngineMutex for the whole load, and a
+    // warm-up under that lock would stall every per-frame JNI call behind it. There is no persisted
+    // compiled-graph cache to go with this: OpenCV DNN (the only InferenceBackend) rebuilds its
+    // graph from the ONNX bytes on every load and has nothing to serialize.
+    enum WarmUpModel : unsigned { kWarmSuperPoint = 1u, kWarmDistortionHead = 2u, kWarmEnhancer = 4u };
+    void scheduleModelWarmUp(unsigned models);
+    void warmUpThreadFunc();
+    std::thread mWarmUpThread;
+    std::mutex  mWarmUpMutex;        // guards the two fields below and the (re)start of the thread
+    unsigned    mWarmUpPending = 0;  // WarmUpModel bits queued but not yet taken by the thread
+    bool        mWarmUpRunning = false;
+
+    // Distortion head evaluation (setDistortionHeadRate). Inline or on mHeadThread, every result goes
+    // through applyDistortionHead, which is then the only writer of progress/confidence while the
+    // head is loaded. The worker keeps only the NEWEST crop: a crop that waited out the rate limit
+    // behind a newer one is stale information, not a backlog. An empty crop is a real job meaning
+    // "the pass could not centre a crop", so the decay it calls for stays on the same thread.
+    //
+    // A result is only good for the wall it was computed against. mHeadEpoch counts the walls: every
+    // clear, restore, swap and new patch bumps it (invalidateDistortionHead), a pass records the
+    // epoch beside its wall snapshot, and a result from an older epoch is dropped at publish rather
+    // than landing on the next wall's progress, confidence and head prior.
+    void applyDistortionHead(const cv::Mat& crop, const cv::Rect& cropRect, long passSeq, uint64_t epoch);
+    void postDistortionHeadJob(cv::Mat crop, const cv::Rect& cropRect, long passSeq, uint64_t epoch);
+    void headThreadFunc();
+    void invalidateDistortionHead();
+    std::atomic<float>      mHeadRateHz{0.0f};
+    std::atomic<bool>       mHeadPriorEnabled{false};
+    std::atomic<long>       mRelocPassSeq{0};
+    std::thread             mHeadThread;
+    mutable std::mutex      mHeadMutex;   // guards the job, the published result, and the thread start
+    std::condition_variable mHeadCv;
+    cv::Mat                 mHeadJobCrop;
+    cv::Rect                mHeadJobRect;   // where the crop was cut from the pass's gray
+    long                    mHeadJobSeq = 0;
+    uint64_t                mHeadJobEpoch = 0;
+    bool                    mHeadJobPending = false;
+    float                   mHeadOut[13] = {};
+    long                    mHeadOutSeq = -1;
+    uint64_t                mHeadOutEpoch = 0;
+    cv::Rect                mHeadOutRect;
+    // Written under mHeadMutex; atomic so the reloc snapshot can read it under mMutex alone.
+    std::atomic<uint64_t>   mHeadEpoch{1};
 
-    cv::Mat mWallDescriptors;
+    DescriptorArena mWallDescriptors;
     std::vector<cv::Point3f> mWallKeypoints3D;
+    // Uniform-grid hash over mWallKeypoints3D (kWallDedupM cells) for self-grow dedup. Rebuilt by
+    // every writer that replaces the wall (restores, align, generateFingerprint), cleared with it, and
+    // appended to on promotion.
+    VoxelHash mWallIndex{kWallDedupM};
+    // Running-moment plane fit over mWallKeypoints3D, maintained alongside mWallIndex. The rectifying
+    // warp, map growth and self-grow read the plane from here instead of each refitting every mark;
+    // plane() re-solves only after a write. Guarded by mMutex like the points themselves.
+    PlaneModel mWallPlane;
     // IMPLEMENTATION.md Phase 2 — the footprint partition, parallel to mWallKeypoints3D. One
     // Footprint::Region ordinal per point. EMPTY means "no partition" and is read as all-backbone,
     // so a pre-Phase-2 fingerprint relocalizes exactly as it does on main. Always either empty or
@@ -634,16 +856,220 @@ private:
     // --- Persistent wall feature map (lean reloc backbone; docs/RELOC_MAP_DESIGN.md) ---
     // Co-registered to the fingerprint anchor. Phase 2a stores it; reloc matching (Phase 2b) is gated
     // separately, so today this is inert state with no effect on relocalization.
-    cv::Mat mMapDescriptors;
+    // Struct-of-arrays: row i of mMapDescriptors and entry i of the three vectors are one map point.
+    // Every removal goes through swapRemoveMapPoint so the columns move together (mMapLastSeen, below,
+    // is one more).
+    DescriptorArena mMapDescriptors;
     std::vector<cv::Point3f> mMapPoints3D;
     std::vector<float> mMapConfidence;
     std::vector<int> mMapObs;
     float mMapAnchorMatrix[16] = {1,0,0,0, 0,1,0,0, 0,0,1,0, 0,0,0,1};
     float mMapIntrinsics[4] = {0,0,0,0};
+    // Everything a fingerprint / map restore does once its descriptors are in the arena — assigned
+    // from JNI bytes, or adopted from a mapped sidecar. Caller holds mMutex.
+    void commitWallFingerprintLocked(const std::vector<cv::Point3f>& points3d, const float* anchorMatrix16,
+                                     const float* intrinsics4, const float* viewMatrix16,
+                                     const std::vector<uint8_t>& regions);
+    void commitWallFeatureMapLocked(const std::vector<cv::Point3f>& points3d, const std::vector<float>& confidence,
+                                    const std::vector<int>& obs, const float* anchorMatrix16,
+                                    const float* intrinsics4);
     // Phase 2b flag: when true, relocThreadFunc also matches the frustum-gated map and merges those
     // correspondences into PnP. Default OFF so the map has zero effect on reloc until device-validated.
     std::atomic<bool> mMapRelocEnabled{false};
     std::atomic<bool> mMapBuildEnabled{false};
+    // Map maintenance worker (setMapWorkerEnabled). A bounded queue of the newest observations:
+    // when the worker falls behind, the oldest is dropped — the map loses one frame's evidence, the
+    // pass never waits. Lock order is mMutex before mMapJobMutex, and the worker never holds both.
+    static constexpr size_t kMapCap = 5000;
+    static constexpr size_t kMapJobQueueMax = 4;
+    // A point neither matched nor merged for this many maintenance commits, and seen fewer than
+    // kMapKeepObs times in all, is pruned at capacity even if its confidence is above the floor.
+    static constexpr uint32_t kMapMaxAgeTicks = 900;
+    static constexpr int kMapKeepObs = 3;
+    std::atomic<bool>       mMapWorkerEnabled{false};
+    // Projection-guided association: the pixel window around each in-view map point's projection
+    // under the fresh pose, and the guided yield below which the opt-in global knnMatch runs.
+    static constexpr float  kMapAssocRadiusPx = 8.0f;
+    static constexpr size_t kMapAssocMinGuided = 8;
+    // A window holding a single unclaimed feature has no second-best for the ratio test, so that
+    // feature must instead be close in absolute terms: L2 between unit SuperPoint rows (SuperGlue's
+    // mutual-NN threshold), Hamming bits of a 256-bit ORB row (ORB-SLAM's TH_LOW).
+    static constexpr float  kMapAssocLoneMaxL2 = 0.7f;
+    static constexpr float  kMapAssocLoneMaxHamming = 50.0f;
+    std::atomic<bool>       mMapGlobalAssocEnabled{false};
+    std::thread             mMapThread;
+    std::mutex              mMapJobMutex;   // guards mMapJobs and the thread start
+    std::condition_variable mMapJobCv;
+    std::deque<MapGrowJob>  mMapJobs;
+    // Maintenance commits so far, and the commit each map point was last re-observed in (the fifth
+    // SoA column). Both under mMutex. Not persisted: a restored map starts every point at "now".
+    uint32_t                mMapTick = 0;
+    std::vector<uint32_t>   mMapLastSeen;
+
+    // Keyframes and covisibility over the map (setMapKeyframesEnabled; KeyframeGraph.h). Map points
+    // carry a stable ID (one more SoA column) because keyframes must outlive the swap-removals that
+    // renumber indices; mMapIdToIndex resolves one to the other. IDs are reassigned and keyframes
+    // dropped on restore and clear — neither is persisted, so keyframes cover this session's locks.
+    std::atomic<bool>       mMapKeyframesEnabled{false};
+    std::vector<uint32_t>   mMapIds;
+    std::unordered_map<uint32_t, int> mMapIdToIndex;
+    uint32_t                mNextMapId = 0;
+    KeyframeGraph           mKeyframes;
+    void reassignMapIds();   // caller holds mMutex
+    // A lock becomes a keyframe only if no keyframe is this close already and it saw enough points.
+    static constexpr float  kKfMinTranslationM = 0.20f;
+    static constexpr float  kKfMinRotationDeg = 15.0f;
+    static constexpr size_t kKfMinPoints = 20;
+    static constexpr size_t kMaxKeyframes = 256;
+    // Retrieval: best-scoring keyframes, each widened by this many covisible neighbours.
+    static constexpr int    kKfRetrieve = 3;
+    static constexpr int    kKfNeighbours = 2;
+
+    // Bag-of-words indexes (setBowRelocEnabled; VocabularyTree.h, BowIndex.h). One vocabulary per
+    // descriptor type, swapped whole under mMutex and shared by pointer so a pass quantizes outside
+    // the lock. Each index remembers the vocabulary it was built with (null: not built), which is
+    // what a pass compares before trusting its entities. Wall entities are row indices, map
+    // entities map point IDs. Both are maintained wherever mWallIndex / the map IDs are.
+    std::shared_ptr<const VocabularyTree> mVocabFloat;
+    std::shared_ptr<const VocabularyTree> mVocabBinary;
+    std::atomic<bool>       mBowRelocEnabled{false};
+    BowIndex                mWallBow;
+    BowIndex                mMapBow;
+    std::shared_ptr<const VocabularyTree> mWallBowVocab;
+    std::shared_ptr<const VocabularyTree> mMapBowVocab;
+    std::shared_ptr<const VocabularyTree> vocabFor(int descType) const;   // caller holds mMutex
+    void reindexWallBow();   // caller holds mMutex
+    void reindexMapBow();    // caller holds mMutex
+    void indexWallRows(int from);   // caller holds mMutex; rows [from, end) were just appended
+    // Inverted lists longer than this are stop words and don't vote; at most this many of the
+    // best-voted map points go to the map pass.
+    static constexpr size_t kBowStopWordList = 200;
+    static constexpr size_t kBowMaxMapCandidates = 1000;
+
+    // Multi-wall registry (activateWall). All under mMutex. The active wall's global descriptor is
+    // cached by wall generation; the frame's is left by each attempt for the next one's
+    // pre-selection, and consumed by it, so every frame votes once.
+    WallRegistry            mWallRegistry;
+    std::string             mActiveWallId;
+    std::atomic<bool>       mWallPreselectEnabled{false};
+    std::atomic<int>        mDescriptorCodecLevel{0};   // saveWallSidecar; see setDescriptorCompression
+    cv::Mat                 mActiveWallGlobal;
+    uint64_t                mActiveWallGlobalGen = ~0ull;
+    cv::Mat                 mLastFrameGlobal;
+    int                     mLastFrameGlobalType = -1;
+    std::string             mPreselectCandidate;
+    int                     mPreselectStreak = 0;
+    std::string             mProposedWallId;
+    static constexpr float  kWallSelectMargin = 0.05f;
+    static constexpr int    kWallSelectStreak = 3;
+    // Point refinement (setPointRefinementEnabled). mRefiner is under mMutex with the points it
+    // refers to. Rows of the wall below mWallFixedRows are the captured marks — the frame everything
+    // else is registered to — and are never moved. Replacing or swapping the wall restarts
+    // refinement (resetRefinement), and bumps mRefineEpoch so a solve or a pass that snapshotted the
+    // old wall commits nothing. The worker follows the map worker's pattern: started lazily, one
+    // pending request, below the reloc thread's priority.
+    std::atomic<bool>       mPointRefinementEnabled{false};
+    BundleRefiner           mRefiner;
+    size_t                  mWallFixedRows = 0;
+    uint64_t                mRefineEpoch = 0;
+    void resetRefinement();   // caller holds mMutex
+    // Co-op fingerprint sync (exportFingerprintDelta). mWallSyncGen counts the wall's mutations within
+    // mWallSyncEpoch, which restarts (restartWallSync) wherever the wall is replaced outright — the
+    // same places that reset refinement. Per row: the generation it was appended at, which is
+    // non-decreasing down the rows because the wall is only appended to between replacements, and the
+    // last generation a refinement moved it at. mPeer is the receiving side (FingerprintDelta::Peer):
+    // the sender's epoch and generation this wall last matched, this wall's own epoch at install, and
+    // the local row each sender row landed in (this device's self-grow interleaves its own).
+    uint64_t                mWallSyncEpoch = 0;
+    uint64_t                mWallSyncGen = 0;
+    std::vector<uint64_t>   mWallRowAddGen;
+    std::vector<uint64_t>   mWallRowMoveGen;
+    FingerprintDelta::Peer  mPeer;
+    void restartWallSync();   // caller holds mMutex
+    void noteWallAppended();   // caller holds mMutex; rows past mWallRowAddGen's end are new
+    void installPeerFingerprintLocked(std::vector<cv::Point3f>&& points3d, const cv::Mat& descs,
+                                      std::vector<uint8_t>&& regions);   // caller holds mMutex
+    // Move and append wall rows as one mutation (one generation, indexes kept current): the peer
+    // delta and the journal replay. Rows are local and checked by the caller. Returns the first
+    // appended row.
+    size_t changeWallRowsLocked(const std::vector<uint32_t>& movedRows, const std::vector<cv::Point3f>& movedPts,
+                                const std::vector<cv::Point3f>& appendedPts, const cv::Mat& appendedDescs,
+                                const std::vector<uint8_t>& appendedRegions);   // caller holds mMutex
+
+    // Mutation journal (setMutationJournalEnabled), all under mMutex. Recording starts at the snapshot
+    // a save writes, or at the state a load leaves, and mJournalBase names that file once it is
+    // written. Map adds and removes queue in order in mJournalPending; a change to a point's
+    // position, confidence or observations only marks its ID, and appendWallJournal writes the
+    // point's value then. The wall needs no hooks: its rows carry the co-op generations, so a batch
+    // is every row appended or moved after mJournalWallGen. Anything the format cannot say (the map
+    // or the journaled wall replaced, the IDs reassigned, a write failed) stops recording until the
+    // next save.
+    std::atomic<bool>       mJournalEnabled{false};
+    bool                    mJournalRecording = false;
+    WallSidecar::Stamp      mJournalBase;
+    std::string             mJournalPath;         // the journal file beside that sidecar
+    uint64_t                mJournalSerial = 0;   // bumped by each save and load, so a late one can't win
+    bool                    mJournalWall = false;  // the base's wall is this wall
+    bool                    mJournalMap = false;   // the base held a map to replay onto
+    uint64_t                mJournalWallEpoch = 0;
+    uint64_t                mJournalWallGen = 0;
+    WallJournal::Batch      mJournalPending;
+    std::unordered_set<uint32_t> mJournalDirty;   // map IDs
+    static constexpr size_t kJournalMaxPending = 200000;   // queued map records before recording gives up
+    void beginJournalLocked(bool withWall, bool withMap);   // caller holds mMutex
+    // Same capture (anchor, intrinsics) as the live metric wall, with at least its rows.
+    bool sidecarContinuesWallLocked(const WallSidecar::Contents& c) const;   // caller holds mMutex
+    void dropJournalLocked(const char* why);                 // caller holds mMutex
+    void journalTouchMap(size_t i) {                         // caller holds mMutex
+        if (mJournalRecording && i < mMapIds.size()) mJournalDirty.insert(mMapIds[i]);
+    }
+    bool replayJournalLocked(const WallJournal::Batch& b, bool wall, bool map);   // caller holds mMutex
+    std::thread             mRefineThread;
+    std::mutex              mRefineMutex;   // guards mRefineRequested and the thread start
+    std::condition_variable mRefineCv;
+    bool                    mRefineRequested = false;
+    void requestRefinement();
+    void refineThreadFunc();
+    void refinePoints();
+    static constexpr size_t kRefineEveryPoses = 10;
+    static constexpr size_t kRefineMinViews = 3;
+    static constexpr int    kRefineIters = 5;
+    static constexpr double kRefineHuberPx = 2.0;
+    // A refined point that moved further than this is taken for a diverged solve, not a correction.
+    static constexpr float  kRefineMaxShiftM = 0.05f;
+
+    WallSlot emptyWallSlot() const { return WallSlot(kWallDedupM, kMapCellM, kWallDedupM); }
+    void swapActiveWall(WallSlot& slot);          // caller holds mMutex
+    void resetProjectStateLocked();               // caller holds mMutex
+    bool activateWallLocked(const std::string& projectId);   // caller holds mMutex
+    void preselectWall();
+
+    // Voxel hash over mMapPoints3D in the fingerprint (anchor) frame, for gateMapToFrustum. Holds
+    // indices, so it is rebuilt whenever the map is renumbered (restore, prune) and appended to as
+    // growMapFromReloc adds points. The reloc snapshot shares mMapDescriptors' buffer through view()
+    // instead of cloning it; DescriptorArena keeps that safe (it detaches before any in-place write).
+    static constexpr float kMapCellM = 0.25f;
+    VoxelHash mMapIndex{kMapCellM};
+    // Fine hash over the same points, for growMapFromReloc's spatial dedup (kWallDedupM cells).
+    VoxelHash mMapDedup{kWallDedupM};
+    void gateMapToFrustum(const float* camFromFp16, int w, int h, std::vector<int>& out) const;
+    // Remove map point i by moving the last point into its slot, across all the SoA columns. Leaves
+    // mMapIndex / mMapDedup stale (the last point was renumbered) — callers rebuild them once after a
+    // batch, and bump mMapDescGen.
+    void swapRemoveMapPoint(size_t i);
+
+    // Compact matching codes (setCompactMatchEnabled), cached beside the float descriptors they are
+    // derived from. Every write to mWallDescriptors / mMapDescriptors bumps its generation under
+    // mMutex, and runRelocPass rebuilds a cache only when the generation it was built from is stale,
+    // so the steady-state cost of compact matching is nothing: a rebuild assigns a fresh Mat rather
+    // than writing into the old one, so a pass may hold the cached header past the lock.
+    std::atomic<bool> mCompactMatchEnabled{false};
+    uint64_t mWallDescGen = 0;
+    uint64_t mMapDescGen = 0;
+    cv::Mat  mWallCodes;
+    cv::Mat  mMapCodes;
+    uint64_t mWallCodesGen = ~0ull;
+    uint64_t mMapCodesGen = ~0ull;
 
     float mAnchorMatrix[16];
 
@@ -705,7 +1131,6 @@ private:
     /** Fixed RANSAC seed for reproducible replay, or <0 for "leave the RNG alone" (default). */
     std::atomic<long long> mEvalRngSeed{-1};
     long mLastGrowSeq = 0;
-    cv::Mat mWallPatch; // raw 256x256 gray canonical patch for the distortion head (desc_fp source)
     // VIO view snapshot captured alongside the reloc frame, so the rectifying warp matches that frame.
     float mRelocViewMatrix[16] = {1,0,0,0, 0,1,0,0, 0,0,1,0, 0,0,0,1};
     // Written by updateLightLevel() on the caller's thread, read (unlocked) by the reloc worker
@@ -0,0 +1,103 @@
+#ifndef GRAFFITIXR_PLANE_MODEL_H
+#define GRAFFITIXR_PLANE_MODEL_H
+
+#include <cmath>
+#include <cstddef>
+#include <vector>
+#include <opencv2/core.hpp>
+
+/**
+ * Least-squares plane through a growing point set, kept as running first and second moments.
+ *
+ * The wall's plane is needed by the rectifying warp, map growth and self-grow, and each used to refit
+ * it from every wall point — a PCA over up to kMaxWallMarks points, several times a pass — although
+ * the wall only ever changes by whole replacement (restore / clear / re-capture) or by appending
+ * promoted marks. So: add() is O(1), the 3x3 eigen-solve runs only when something was added since the
+ * last solve, and a replacement is one rebuild().
+ *
+ * The fit is the PCA one it replaces: the centroid, and the covariance's smallest-eigenvalue axis as
+ * the normal. Moments are accumulated in double about nothing (not about a running mean); wall
+ * coordinates are metres within a few metres of the fingerprint camera, where that loses nothing a
+ * float PCA kept.
+ */
+struct WallPlane {
+    bool valid = false;
+    size_t count = 0;
+    cv::Vec3d centroid;
+    // Unit normal, oriented so offset = normal·centroid >= 0: the plane sits in front of the
+    // fingerprint camera whose frame the points are in. Callers that need offset > 0 still check.
+    cv::Vec3d normal;
+    double offset = 0.0;
+    // RMS point-to-plane distance over every point in the fit — sqrt of the smallest eigenvalue. How
+    // flat the "wall" actually is; a large value means the plane is a poor model of the marks.
+    double rms = 0.0;
+};
+
+class PlaneModel {
+public:
+    void clear() {
+        mN = 0;
+        for (double& v : mS1) v = 0.0;
+        for (double& v : mS2) v = 0.0;
+        mDirty = true;
+    }
+
+    void rebuild(const std::vector<cv::Point3f>& pts) {
+        clear();
+        for (const auto& p : pts) add(p);
+    }
+
+    /** Non-finite points are skipped: one NaN would poison every moment for good. */
+    void add(const cv::Point3f& p) {
+        if (!std::isfinite(p.x) || !std::isfinite(p.y) || !std::isfinite(p.z)) return;
+        const double x = p.x, y = p.y, z = p.z;
+        ++mN;
+        mS1[0] += x; mS1[1] += y; mS1[2] += z;
+        mS2[0] += x * x; mS2[1] += x * y; mS2[2] += x * z;
+        mS2[3] += y * y; mS2[4] += y * z; mS2[5] += z * z;
+        mDirty = true;
+    }
+
+    size_t count() const { return mN; }
+
+    /** The current fit, re-solved only if points were added or replaced since the last call. */
+    const WallPlane& plane() {
+        if (mDirty) solve();
+        return mPlane;
+    }
+
+private:
+    void solve() {
+        mDirty = false;
+        mPlane = WallPlane();
+        mPlane.count = mN;
+        if (mN < 3) return;
+        const double inv = 1.0 / (double)mN;
+        const cv::Vec3d c(mS1[0] * inv, mS1[1] * inv, mS1[2] * inv);
+        const cv::Matx33d C(mS2[0] * inv - c[0] * c[0], mS2[1] * inv - c[0] * c[1], mS2[2] * inv - c[0] * c[2],
+                            mS2[1] * inv - c[0] * c[1], mS2[3] * inv - c[1] * c[1], mS2[4] * inv - c[1] * c[2],
+                            mS2[2] * inv - c[0] * c[2], mS2[4] * inv - c[1] * c[2], mS2[5] * inv - c[2] * c[2]);
+        cv::Vec3d eval;
+        cv::Matx33d evec;
+        if (!cv::eigen(C, eval, evec)) return;
+        cv::Vec3d n(evec(2, 0), evec(2, 1), evec(2, 2));   // eigen() sorts descending: row 2 = smallest
+        const double nn = cv::norm(n);
+        if (nn < 1e-6) return;
+        n /= nn;
+        double d = n.dot(c);
+        if (d < 0) { n = -n; d = -d; }
+        mPlane.valid = true;
+        mPlane.centroid = c;
+        mPlane.normal = n;
+        mPlane.offset = d;
+        mPlane.rms = std::sqrt(std::max(0.0, eval[2]));
+    }
+
+    size_t mN = 0;
+    double mS1[3] = {0, 0, 0};
+    double mS2[6] = {0, 0, 0, 0, 0, 0};  // xx, xy, xz, yy, yz, zz
+    bool mDirty = true;
+    WallPlane mPlane;
+};
+
+#endif  // GRAFFITIXR_PLANE_MODEL_H
@@ -1,21 +1,51 @@
 #pragma once
 #include <opencv2/opencv.hpp>
 #include <opencv2/dnn.hpp>
-#include <opencv2/core/ocl.hpp>
+#include "InferenceBackend.h"
 #include <atomic>
+#include <condition_variable>
+#include <memory>
 #include <mutex>
 #include <vector>
 
 /**
- * SuperPoint neural feature detector using OpenCV DNN (ONNX backend).
+ * SuperPoint neural feature detector (ONNX, run through InferenceBackend).
+ *
+ * Holds a small POOL of network instances rather than one net behind one mutex. The reloc worker,
+ * the capture-curation overlay (getFingerprintKeypoints) and the depth-off fingerprint builder
+ * (getSuperPointFeatures) all detect, and with a single net each of them stalled the others for a
+ * whole forward — a curation preview froze relocalization for as long as it ran. detect() checks out
+ * a free instance, runs on that instance's own input/output buffers, and hands it back; callers only
+ * wait when every instance is busy.
  */
 class SuperPointDetector {
 public:
     SuperPointDetector() = default;
 
-    bool load(const std::vector<uchar>& onnxBytes);
+    /**
+     * Build [poolSize] independent instances from the same bytes (clamped to [1, kMaxPoolSize]).
+     * Each instance carries its own copy of the weights, so the default covers the two callers that
+     * actually overlap — the reloc worker and one UI-side detect — and no more. A reload waits for
+     * every checked-out instance to come back before replacing the pool.
+     */
+    bool load(const std::vector<uchar>& onnxBytes,
+              const InferenceBackend::Options& opts = InferenceBackend::Options(),
+              int poolSize = kDefaultPoolSize);
+    static constexpr int kDefaultPoolSize = 2;
+    static constexpr int kMaxPoolSize = 4;
     bool isLoaded() const { return mLoaded; }
 
+    /**
+     * One throwaway forward per instance at kWarmUpW x kWarmUpH (the shape every camera frame is
+     * resized to), so the backend's first-run graph setup and allocations are paid here and not
+     * inside the first reloc pass. Each instance is checked out for its own warm-up, so a detect that
+     * arrives mid-warm-up waits for (or takes) an already-warm one rather than paying the cold cost
+     * a second time. True if every instance warmed.
+     */
+    bool warmUp();
+    static constexpr int kWarmUpW = 640;
+    static constexpr int kWarmUpH = 480;
+
     /** Original detection (no mask) */
     bool detect(const cv::Mat& gray,
                 std::vector<cv::KeyPoint>& kps,
@@ -31,10 +61,71 @@ public:
                 float scoreThresh = 0.005f,
                 int   maxKps      = 500);
 
+    /**
+     * Detect on several images with as few forward passes as possible: images whose PREPARED shape
+     * (after the same resize detect() applies) matches are stacked into one [N,1,H,W] blob and run
+     * together, then decoded per item. One batched forward amortises kernel dispatch and weight
+     * reads that N sequential small ones pay N times.
+     *
+     * Per-item results mirror detect(): ok[i] is what detect(grays[i], ...) would have returned.
+     * Whether the model batches at all is decided once, by a probe in warmUp(); until then, and for
+     * a model exported with a fixed batch of 1, every item gets its own forward. A batched forward
+     * that fails anyway is retried item by item, so the answer never depends on the export.
+     * @return how many items succeeded.
+     */
+    int detectBatch(const std::vector<cv::Mat>& grays,
+                    std::vector<std::vector<cv::KeyPoint>>& kps,
+                    std::vector<cv::Mat>& descs,
+                    std::vector<bool>& ok,
+                    float scoreThresh = 0.005f,
+                    int   maxKps      = 500);
+
 private:
-    cv::dnn::Net       mNet;
-    std::mutex         mMutex;
-    std::atomic<bool>  mLoaded{false};
+    // A gray image resized to a network-legal shape, with the factors that map back to the caller's.
+    struct Prepared {
+        cv::Mat input;
+        cv::Mat mask;
+        float scaleX = 1.0f, scaleY = 1.0f;
+    };
+    static Prepared prepare(const cv::Mat& gray, const cv::Mat& mask);
+    static bool findOutputs(const std::vector<cv::Mat>& outputs,
+                            const cv::Mat*& semiPtr, const cv::Mat*& descPtr);
+    bool decode(const cv::Mat& semi, const cv::Mat& desc, const Prepared& p,
+                std::vector<cv::KeyPoint>& kps, cv::Mat& descs, float scoreThresh, int maxKps);
+
+    // Whether the loaded graph takes a batch dimension: set by warmUp()'s probe, reset by load().
+    enum BatchSupport : int { kBatchUnknown, kBatchYes, kBatchNo };
+    std::atomic<int> mBatchSupport{kBatchUnknown};
+    static constexpr int kBatchProbe = 2;
+
+    struct Instance {
+        std::unique_ptr<InferenceBackend> backend;
+        cv::Mat              input;    // CV_32F network input, reused across detects of one shape
+        std::vector<cv::Mat> outputs;  // forward() outputs; views into this instance's net
+    };
+
+    // One [kBatchProbe,1,H,W] forward on a checked-out, freshly warmed instance.
+    void probeBatch(Instance& inst);
+
+    // Checkout: blocks until an instance is free. Null when nothing is loaded.
+    Instance* acquire();
+    void release(Instance* inst);
+    // RAII over acquire/release, so an exception inside a detect can't leak an instance and
+    // permanently shrink the pool.
+    struct Lease {
+        SuperPointDetector& owner;
+        Instance* inst;
+        explicit Lease(SuperPointDetector& o) : owner(o), inst(o.acquire()) {}
+        ~Lease() { if (inst) owner.release(inst); }
+        Lease(const Lease&) = delete;
+        Lease& operator=(const Lease&) = delete;
+    };
+
+    std::vector<std::unique_ptr<Instance>> mPool;
+    std::vector<Instance*>  mFree;      // subset of mPool not currently checked out
+    std::mutex              mPoolMutex; // guards mPool and mFree
+    std::condition_variable mPoolCv;
+    std::atomic<bool>       mLoaded{false};
 
     void extractKeypoints(const cv::Mat& semiTensor,
                           std::vector<cv::KeyPoint>& kps,
@@ -0,0 +1,61 @@
+#pragma once
+#include <opencv2/core.hpp>
+#include <cstdint>
+#include <vector>
+
+/**
+ * Hierarchical k-means vocabulary (a vocabulary tree) for bag-of-words place recognition, trained
+ * offline on wall imagery by scripts/vocabulary/build_vocabulary.py and shipped as an asset —
+ * bow_superpoint.voc for SuperPoint's 256-float descriptors, bow_orb.voc for ORB's 32 bytes.
+ * Optional: inert unless the asset is present, like the distortion head.
+ *
+ * A descriptor is quantized by descending from the root, at each level taking the nearest child
+ * centroid (L2 for float, Hamming for binary — descdist::row), to a leaf: its WORD. On the way down
+ * it also passes the node kDirectLevelsUp above the leaf, which is what the DIRECT index files it
+ * under: two descriptors sharing that node are likely correspondences, and the direct index makes
+ * "which stored marks could this query match" a hash lookup instead of a scan of the fingerprint.
+ *
+ * Asset layout, little-endian:
+ *   char[4] "GXVT"; u32 version (1); u32 branching; u32 depth; i32 descType (CV_32F | CV_8U);
+ *   u32 descCols; u32 nodeCount;
+ *   nodeCount x { u32 parent (0xFFFFFFFF for the root, node 0); f32 idf (leaves; 0 elsewhere);
+ *                 descCols x elemSize bytes of centroid (the root's is ignored) }
+ * Parents precede their children, so the tree is rebuilt in one pass.
+ *
+ * Immutable once loaded, so a loaded tree is shared by pointer and read from any thread.
+ */
+class VocabularyTree {
+public:
+    bool load(const std::vector<uchar>& bytes);
+    bool isLoaded() const { return !mWordOfNode.empty(); }
+
+    int descType() const { return mDescType; }
+    int descCols() const { return mCentroids.cols; }
+    size_t wordCount() const { return mWordIdf.size(); }
+
+    /** Same type and width as the centroids — anything else would be quantized as nonsense. */
+    bool compatible(const cv::Mat& descs) const {
+        return isLoaded() && !descs.empty() && descs.type() == mDescType && descs.cols == mCentroids.cols;
+    }
+
+    /**
+     * Word and direct-index node per row of [descs]. Both vectors are resized to descs.rows; an
+     * incompatible input leaves them empty.
+     */
+    void quantize(const cv::Mat& descs, std::vector<uint32_t>& words, std::vector<uint32_t>& nodes) const;
+
+    float idf(uint32_t word) const { return word < mWordIdf.size() ? mWordIdf[word] : 0.0f; }
+
+    // ORB-SLAM's choice for a 6-level tree: fine enough to prune most candidates, coarse enough that
+    // a true correspondence quantized to a sibling leaf still shares the node.
+    static constexpr int kDirectLevelsUp = 2;
+
+private:
+    cv::Mat mCentroids;                             // one row per node
+    std::vector<std::vector<uint32_t>> mChildren;   // per node
+    std::vector<int> mDepth;                        // per node; root = 0
+    std::vector<uint32_t> mWordOfNode;              // per node; leaves only, else UINT32_MAX
+    std::vector<float> mWordIdf;                    // per word
+    int mDescType = -1;
+    int mDirectDepth = 1;
+};
@@ -0,0 +1,92 @@
+#ifndef GRAFFITIXR_VOXEL_HASH_H
+#define GRAFFITIXR_VOXEL_HASH_H
+
+#include <cmath>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+#include <opencv2/core.hpp>
+
+/**
+ * Uniform-grid hash over 3D points, keyed by integer cell coordinates. Stores INDICES into a point
+ * array the caller owns; it never copies the points, so it has to be told about every change to that
+ * array (insert on append, rebuild after anything that renumbers).
+ *
+ * A hash rather than an octree because both point sets it indexes (the wall fingerprint, the feature
+ * map) live on one wall: they are a thin sheet, not a volume, and an octree over a sheet spends most
+ * of its depth subdividing empty space. The hash only ever holds occupied cells, so walking it costs
+ * O(occupied cells) regardless of where on the wall the points are.
+ *
+ * Like KeypointGrid, queries guarantee only one direction: every point that could satisfy the test
+ * is returned, possibly with extras from the same cells, and the caller applies the exact test.
+ */
+class VoxelHash {
+public:
+    explicit VoxelHash(float cellSize = 0.25f) : mCell(cellSize > 0.0f ? cellSize : 0.25f) {}
+
+    float cellSize() const { return mCell; }
+    size_t cellCount() const { return mCells.size(); }
+
+    void clear() { mCells.clear(); }
+
+    void rebuild(const std::vector<cv::Point3f>& pts) {
+        mCells.clear();
+        for (int i = 0; i < (int)pts.size(); ++i) insert(i, pts[(size_t)i]);
+    }
+
+    /** Non-finite points are not indexed: they can't be near anything, and would hash to garbage. */
+    void insert(int idx, const cv::Point3f& p) {
+        if (!std::isfinite(p.x) || !std::isfinite(p.y) || !std::isfinite(p.z)) return;
+        mCells[key(cellOf(p.x), cellOf(p.y), cellOf(p.z))].push_back(idx);
+    }
+
+    /** Indices of every point whose cell touches the axis-aligned cube of half-side [r] about [p]. */
+    void queryBox(const cv::Point3f& p, float r, std::vector<int>& out) const {
+        out.clear();
+        if (mCells.empty() || !(r >= 0.0f)) return;
+        if (!std::isfinite(p.x) || !std::isfinite(p.y) || !std::isfinite(p.z)) return;
+        const int x0 = cellOf(p.x - r), x1 = cellOf(p.x + r);
+        const int y0 = cellOf(p.y - r), y1 = cellOf(p.y + r);
+        const int z0 = cellOf(p.z - r), z1 = cellOf(p.z + r);
+        for (int x = x0; x <= x1; ++x)
+            for (int y = y0; y <= y1; ++y)
+                for (int z = z0; z <= z1; ++z) {
+                    auto it = mCells.find(key(x, y, z));
+                    if (it != mCells.end()) out.insert(out.end(), it->second.begin(), it->second.end());
+                }
+    }
+
+    /**
+     * Visit every occupied cell as (centre, bounding-sphere radius, indices). The caller culls whole
+     * cells by the sphere — e.g. against a view frustum — and only then looks at their points.
+     */
+    template <typename F>
+    void forEachCell(F&& visit) const {
+        const float half = 0.5f * mCell;
+        const float radius = half * 1.7320508f;  // half the cube's diagonal
+        for (const auto& kv : mCells) {
+            const cv::Point3f centre(((float)unpack(kv.first, 42) + 0.5f) * mCell,
+                                     ((float)unpack(kv.first, 21) + 0.5f) * mCell,
+                                     ((float)unpack(kv.first, 0) + 0.5f) * mCell);
+            visit(centre, radius, kv.second);
+        }
+    }
+
+private:
+    // 21 bits per axis, two's complement: +-2^20 cells, i.e. +-262 km at 25 cm — no wall gets close.
+    static constexpr int64_t kMask = (1LL << 21) - 1;
+
+    int cellOf(float v) const { return (int)std::floor(v / mCell); }
+    static int64_t key(int x, int y, int z) {
+        return (((int64_t)x & kMask) << 42) | (((int64_t)y & kMask) << 21) | ((int64_t)z & kMask);
+    }
+    static int unpack(int64_t k, int shift) {
+        const int64_t v = (k >> shift) & kMask;
+        return (int)(v >= (1LL << 20) ? v - (1LL << 21) : v);  // sign-extend the 21-bit field
+    }
+
+    float mCell;
+    std::unordered_map<int64_t, std::vector<int>> mCells;
+};
+
+#endif  // GRAFFITIXR_VOXEL_HASH_H
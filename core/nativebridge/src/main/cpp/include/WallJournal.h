@@ -0,0 +1,94 @@
+#pragma once
+#include "FingerprintDelta.h"
+#include "WallSidecar.h"
+#include <opencv2/core.hpp>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * Append-only journal of what changed in the wall and the feature map since the sidecar was written
+ * (docs/data_formats.md §6). An autosave appends one batch, which is the few points added, pruned,
+ * refined or re-observed since the last one, instead of rewriting megabytes of descriptors. An
+ * explicit save compacts: it writes a fresh sidecar and starts an empty journal on it. A restore maps
+ * the sidecar and replays the journal on top.
+ *
+ * The journal names the sidecar it extends (WallSidecar::Stamp) and is ignored beside any other: a
+ * kill between the sidecar's rename and the journal's restart leaves the new sidecar and a stale
+ * journal, and the stale one is then discarded. Each batch is framed by its length and CRC-32, so
+ * a batch a kill cut short is dropped and the file truncated to the last whole one. A batch is the
+ * unit of replay, so a restore lands on the state of one particular autosave, never between two.
+ *
+ * A batch, in the engine's own rows:
+ *  - wall: a GXFD change set (FingerprintDelta) with no epoch, whose base is the row count when the
+ *    batch began. It holds marks appended since then and earlier marks refinement moved. The wall
+ *    only grows between replacements, and a replacement ends the journal.
+ *  - map: adds and swap-removes in the order they happened, then one kMapSet per surviving point
+ *    whose position, confidence or observation count changed. The set records carry the point's
+ *    row at the end of the batch. Per-lock confidence bumps coalesce into one record per point per
+ *    batch rather than one per lock.
+ *
+ * Layout, little-endian:
+ *   header: char[4] "GXWJ"; u32 version (1); u32 base crc; u32 reserved; u64 base bytes; u64 reserved
+ *   per batch: u32 payloadBytes; u32 crc32(payload); payload
+ *   payload: u32 wallBytes; wallBytes of GXFD; u32 flags (kMapFrame);
+ *            [f32 x 16 map anchor; f32 x 4 map intrinsics, when kMapFrame];
+ *            i32 descType; u32 descCols; u32 opCount; u32 addCount;
+ *            opCount x { u32 op; u32 row; f32 x, y, z; f32 confidence; i32 obs };
+ *            addCount x descCols descriptor elements, one row per kMapAdd in order
+ */
+class WallJournal {
+public:
+    enum MapOp : uint32_t {
+        kMapAdd = 1,      // append a point (row unused); its descriptor is the next added row
+        kMapRemove = 2,   // swap-remove [row]
+        kMapSet = 3,      // overwrite [row]'s position, confidence and observation count
+    };
+
+    struct MapRecord {
+        uint32_t op = 0;
+        uint32_t row = 0;
+        cv::Point3f pt;
+        float conf = 0.f;
+        int32_t obs = 0;
+    };
+
+    struct Batch {
+        bool hasWall = false;
+        FingerprintDelta wall;          // local rows; see above
+        std::vector<MapRecord> map;
+        cv::Mat mapAdded;               // one descriptor row per kMapAdd
+        bool hasMapFrame = false;       // the map's co-registration as of the batch
+        float mapAnchor[16] = {1,0,0,0, 0,1,0,0, 0,0,1,0, 0,0,0,1};
+        float mapIntrinsics[4] = {0,0,0,0};
+
+        bool empty() const { return !hasWall && map.empty(); }
+        void clear() { *this = Batch(); }
+        std::vector<uint8_t> encode() const;
+        /** Parse a payload. False on any inconsistency; every count is checked before allocation. */
+        static bool decode(const uint8_t* data, size_t size, Batch& out);
+    };
+
+    /** The journal beside sidecar [sidecarPath]: its .gxws extension, if any, becomes .gxwj. */
+    static std::string pathFor(const std::string& sidecarPath);
+
+    /** Start an empty journal on [base] at [path], replacing whatever was there (.tmp + rename). */
+    static bool start(const std::string& path, const WallSidecar::Stamp& base);
+
+    /**
+     * Append [b] and flush it to the device. [fileBytes] gets the journal's size after it. False
+     * when the file is missing or the write failed. A failed write may leave a torn batch, which
+     * the next read drops.
+     */
+    static bool append(const std::string& path, const Batch& b, uint64_t& fileBytes);
+
+    /**
+     * Every whole batch of the journal at [path], when it extends [base]. False, with [out] empty,
+     * when it is missing, stale or not a journal. A torn or corrupt tail ends the read and is cut
+     * off the file, so the next append follows the last good batch.
+     */
+    static bool read(const std::string& path, const WallSidecar::Stamp& base, std::vector<Batch>& out);
+
+    static constexpr uint32_t kVersion = 1;
+    static constexpr uint32_t kMaxOps = 1u << 20;
+};
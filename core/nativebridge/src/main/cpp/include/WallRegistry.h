@@ -0,0 +1,187 @@
+#ifndef GRAFFITIXR_WALL_REGISTRY_H
+#define GRAFFITIXR_WALL_REGISTRY_H
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include <opencv2/core.hpp>
+#include "BowIndex.h"
+#include "DescriptorArena.h"
+#include "KeyframeGraph.h"
+#include "PlaneModel.h"
+#include "VocabularyTree.h"
+#include "VoxelHash.h"
+
+/**
+ * Everything MobileGS holds for one wall — the fingerprint, the feature map, and every index built
+ * over them — as one movable value. The engine swaps a slot's members with its own to switch walls,
+ * so parking one wall and activating another is a handful of container swaps: no descriptor is
+ * copied and no index is rebuilt.
+ *
+ * The hashes carry their cell sizes, so a slot is constructed with the engine's.
+ */
+struct WallSlot {
+    WallSlot(float wallCell, float mapCell, float dedupCell)
+        : wallIndex(wallCell), mapIndex(mapCell), mapDedup(dedupCell) {}
+
+    // Fingerprint
+    DescriptorArena wallDescs;
+    std::vector<cv::Point3f> wallPts;
+    std::vector<uint8_t> wallRegions;
+    VoxelHash wallIndex;
+    PlaneModel wallPlane;
+    BowIndex wallBow;
+    std::shared_ptr<const VocabularyTree> wallBowVocab;
+    float fpAnchor[16] = {1,0,0,0, 0,1,0,0, 0,0,1,0, 0,0,0,1};
+    float fpIntrinsics[4] = {0,0,0,0};
+    float fpView[16] = {1,0,0,0, 0,1,0,0, 0,0,1,0, 0,0,0,1};
+    bool hasFpView = false;
+
+    // Feature map
+    DescriptorArena mapDescs;
+    std::vector<cv::Point3f> mapPts;
+    std::vector<float> mapConf;
+    std::vector<int> mapObs;
+    std::vector<uint32_t> mapLastSeen;
+    std::vector<uint32_t> mapIds;
+    std::unordered_map<uint32_t, int> mapIdToIndex;
+    VoxelHash mapIndex;
+    VoxelHash mapDedup;
+    KeyframeGraph keyframes;
+    BowIndex mapBow;
+    std::shared_ptr<const VocabularyTree> mapBowVocab;
+    float mapAnchor[16] = {1,0,0,0, 0,1,0,0, 0,0,1,0, 0,0,0,1};
+    float mapIntrinsics[4] = {0,0,0,0};
+
+    // Pre-selection: the wall's mean-pooled descriptor (KeyframeGraph::globalDescriptor) and the
+    // descriptor type it pools, since an ORB and a SuperPoint global are both 256 wide.
+    cv::Mat global;
+    int globalType = -1;
+
+    size_t bytes = 0;        // footprint() when parked
+    uint64_t lastUsed = 0;   // registry clock when parked or last scored best
+};
+
+/**
+ * Parked walls keyed by project ID, under a memory budget with least-recently-used eviction.
+ *
+ * The active wall lives in MobileGS's own members, not here, and is not charged to the budget;
+ * a wall enters the registry when another is activated over it and leaves when it is activated
+ * again. Footprints are estimates: descriptor arenas by capacity, the point columns by payload,
+ * hashes and indexes by a per-entry constant. Close enough to keep a phone's worth of walls from
+ * growing without bound, which is all the budget is for.
+ *
+ * Not thread-safe; MobileGS keeps it under mMutex.
+ */
+class WallRegistry {
+public:
+    size_t size() const { return mSlots.size(); }
+    size_t bytes() const { return mBytes; }
+    size_t budget() const { return mBudget; }
+    bool contains(const std::string& id) const { return mSlots.count(id) != 0; }
+
+    /** Set the budget and evict down to it. Evicted IDs are appended to [evicted] when given. */
+    void setBudget(size_t bytes, std::vector<std::string>* evicted = nullptr) {
+        mBudget = bytes;
+        evictToBudget(evicted);
+    }
+
+    /**
+     * Park [slot] under [id], replacing any slot already there, then evict least-recently-used
+     * slots until the budget holds — possibly this one, if it alone is over budget.
+     */
+    void put(const std::string& id, WallSlot&& slot, std::vector<std::string>* evicted = nullptr) {
+        erase(id);
+        slot.bytes = footprint(slot);
+        slot.lastUsed = ++mClock;
+        mBytes += slot.bytes;
+        mSlots.emplace(id, std::move(slot));
+        evictToBudget(evicted);
+    }
+
+    /** Move the slot for [id] into [out] and drop it from the registry. False if not parked. */
+    bool take(const std::string& id, WallSlot& out) {
+        auto it = mSlots.find(id);
+        if (it == mSlots.end()) return false;
+        mBytes -= it->second.bytes;
+        out = std::move(it->second);
+        mSlots.erase(it);
+        return true;
+    }
+
+    void erase(const std::string& id) {
+        auto it = mSlots.find(id);
+        if (it == mSlots.end()) return;
+        mBytes -= it->second.bytes;
+        mSlots.erase(it);
+    }
+
+    void clear() {
+        mSlots.clear();
+        mBytes = 0;
+    }
+
+    /**
+     * The parked wall whose global descriptor best matches [global] (pooled from descriptors of
+     * [type]), and its cosine score. The winner counts as used, so a wall the camera keeps looking
+     * at is the last to be evicted. False when no slot of that type scores above zero.
+     */
+    bool best(const cv::Mat& global, int type, std::string& outId, float& outScore) {
+        if (global.empty()) return false;
+        WallSlot* winner = nullptr;
+        float bestScore = 0.f;
+        for (auto& e : mSlots) {
+            const WallSlot& s = e.second;
+            if (s.globalType != type || s.global.cols != global.cols) continue;
+            const float score = (float)global.dot(s.global);
+            if (score > bestScore) {
+                bestScore = score;
+                winner = &e.second;
+                outId = e.first;
+            }
+        }
+        if (!winner) return false;
+        winner->lastUsed = ++mClock;
+        outScore = bestScore;
+        return true;
+    }
+
+    static size_t footprint(const WallSlot& s) {
+        constexpr size_t kPerHashEntry = 16;   // bucket + node overhead, roughly, per indexed item
+        auto arena = [](const DescriptorArena& a) {
+            return a.capacity() > 0 ? (size_t)a.capacity() * (size_t)a.cols() * CV_ELEM_SIZE(a.type()) : 0;
+        };
+        size_t b = arena(s.wallDescs) + arena(s.mapDescs);
+        b += (s.wallPts.size() + s.mapPts.size()) * sizeof(cv::Point3f);
+        b += s.wallRegions.size();
+        b += s.mapConf.size() * sizeof(float) + s.mapObs.size() * sizeof(int);
+        b += (s.mapLastSeen.size() + s.mapIds.size()) * sizeof(uint32_t);
+        b += (s.wallPts.size() + 2 * s.mapPts.size() + s.mapIdToIndex.size()) * kPerHashEntry;
+        b += (s.wallBow.size() + s.mapBow.size()) * 3 * kPerHashEntry;
+        b += s.keyframes.size() * 4096;   // pose + global + point list, for a typical keyframe
+        b += s.global.total() * s.global.elemSize();
+        return b;
+    }
+
+private:
+    void evictToBudget(std::vector<std::string>* evicted) {
+        while (mBytes > mBudget && !mSlots.empty()) {
+            auto lru = mSlots.begin();
+            for (auto it = mSlots.begin(); it != mSlots.end(); ++it)
+                if (it->second.lastUsed < lru->second.lastUsed) lru = it;
+            if (evicted) evicted->push_back(lru->first);
+            mBytes -= lru->second.bytes;
+            mSlots.erase(lru);
+        }
+    }
+
+    std::unordered_map<std::string, WallSlot> mSlots;
+    size_t mBytes = 0;
+    size_t mBudget = 64u << 20;
+    uint64_t mClock = 0;
+};
+
+#endif  // GRAFFITIXR_WALL_REGISTRY_H
@@ -0,0 +1,106 @@
+#pragma once
+#include <opencv2/core.hpp>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * The wall's binary sidecar: the fingerprint and the feature map in one versioned, little-endian
+ * file beside project.json (docs/data_formats.md §4), laid out so loading it maps the file rather
+ * than parsing it. project.json only names the file.
+ *
+ * The JSON route it replaces costs, per descriptor byte: a base64-ish decode into a Kotlin ByteArray,
+ * a JNI copy, and a cv::Mat clone in the restore — three passes over tens of megabytes for a large
+ * SuperPoint map. Here the descriptor sections are wrapped in place as cv::Mat headers over the
+ * mapping, and the mapping lives exactly as long as the last Mat that references it (the arena that
+ * adopts it, and any view the reloc thread took). Only the small per-point columns are copied out.
+ *
+ * Layout, little-endian, every section at a kAlign-aligned offset so a mapped row is as aligned as
+ * an allocated one:
+ *   char[4] "GXWS"; u32 version (1); u32 sectionCount; u32 crc32 of every byte after the header;
+ *   u64 fileBytes; u32 alignment (kAlign); u32 reserved (0)
+ *   sectionCount x { u32 id (Section); i32 cvType; u32 rows; u32 cols; u64 offset; u64 bytes }
+ *   section payloads, zero-padded to the alignment
+ * A reader refuses a version it does not know and skips section ids it does not, so a section can
+ * be added without a version bump as long as older readers may ignore it.
+ *
+ * Version 2 adds the coded descriptor sections (Contents::descCodecLevel, DescriptorCodec): the
+ * entry gives the decoded type and shape, the payload is the codec stream, and its bytes are the
+ * stream's length. Those sections cannot be ignored, so a file holding one says version 2; one
+ * without says 1 and stays readable by older builds. A coded set decodes into owned memory, not a
+ * mapped view: fewer bytes to read and ship, one decode pass to restore.
+ *
+ * The file is as untrusted as an imported .gxr (it travels inside one): every header field, offset
+ * and size is checked in 64-bit before anything is wrapped, and the checksum before anything is
+ * read. That checksum covers the whole file, so a load reads every page once: the mapping saves the
+ * copies, not the read, and nothing is paged in lazily. Per-section checksums verified on first
+ * touch would defer that read, but only by letting the reloc thread match against bytes nothing
+ * has vouched for yet. The mapping is private and writable, so the arena may swap-remove rows in place without the
+ * file ever changing.
+ */
+class WallSidecar {
+public:
+    /** Names one written file: its checksum and size. A journal (WallJournal.h) records the one it extends. */
+    struct Stamp {
+        uint32_t crc = 0;
+        uint64_t bytes = 0;
+        bool valid() const { return bytes != 0; }
+        bool operator==(const Stamp& o) const { return crc == o.crc && bytes == o.bytes; }
+    };
+
+    enum Section : uint32_t {
+        kWallDescs = 1,       // N x D, CV_8U (ORB) or CV_32F (SuperPoint)
+        kWallPoints = 2,      // N x 3 CV_32F, fingerprint-anchor frame
+        kWallRegions = 3,     // 1 x N CV_8U, Footprint::Region per point; absent = all backbone
+        kFpAnchor = 4,        // 1 x 16 CV_32F, column-major
+        kFpIntrinsics = 5,    // 1 x 4 CV_32F, fx fy cx cy
+        kFpView = 6,          // 1 x 16 CV_32F, GL world->camera at capture; absent = unknown
+        kWallDescsCoded = 7,  // kWallDescs as a DescriptorCodec stream; never beside it
+        kMapDescs = 16,
+        kMapPoints = 17,
+        kMapConfidence = 18,  // 1 x N CV_32F
+        kMapObs = 19,         // 1 x N CV_32S
+        kMapAnchor = 20,
+        kMapIntrinsics = 21,
+        kMapDescsCoded = 22,
+    };
+
+    struct Contents {
+        cv::Mat wallDescs;                 // mapped when read; empty = no fingerprint in the file
+        std::vector<cv::Point3f> wallPts;
+        std::vector<uint8_t> wallRegions;
+        float fpAnchor[16] = {1,0,0,0, 0,1,0,0, 0,0,1,0, 0,0,0,1};
+        float fpIntrinsics[4] = {0,0,0,0};
+        float fpView[16] = {1,0,0,0, 0,1,0,0, 0,0,1,0, 0,0,0,1};
+        bool hasFpView = false;
+
+        cv::Mat mapDescs;                  // mapped when read; empty = no map in the file
+        std::vector<cv::Point3f> mapPts;
+        std::vector<float> mapConf;
+        std::vector<int> mapObs;
+        float mapAnchor[16] = {1,0,0,0, 0,1,0,0, 0,0,1,0, 0,0,0,1};
+        float mapIntrinsics[4] = {0,0,0,0};
+
+        // Write only: DescriptorCodec level for the descriptor sections (0 = raw, 1 = half float,
+        // 2 = block int8; ORB is range-coded at either). Irrelevant to read.
+        int descCodecLevel = 0;
+
+        Stamp stamp;                       // set by read
+    };
+
+    /**
+     * Write [c] to [path] through a sibling .tmp and a rename, so a crash never leaves a torn file
+     * where a good one was. A descriptor set whose point column disagrees with it is left out.
+     * [stamp], when given, names the file written.
+     */
+    static bool write(const std::string& path, const Contents& c, Stamp* stamp = nullptr);
+
+    /** Map and validate [path] into [out]. False, with [out] untouched, on any inconsistency. */
+    static bool read(const std::string& path, Contents& out);
+
+    /** CRC-32 (IEEE) of [n] bytes at [p], continuing from [crc]. */
+    static uint32_t crc32(const uint8_t* p, size_t n, uint32_t crc = 0);
+
+    static constexpr uint32_t kVersion = 2;   // the newest this build reads; see above
+    static constexpr uint32_t kAlign = 64;
+};
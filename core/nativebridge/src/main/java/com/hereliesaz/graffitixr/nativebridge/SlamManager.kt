@@ -16,6 +16,7 @@ import com.hereliesaz.graffitixr.common.sensor.ImuSample
 import com.hereliesaz.graffitixr.common.sensor.PixelFormat
 import com.hereliesaz.graffitixr.common.util.NativeLibLoader
 import com.hereliesaz.graffitixr.common.wearable.WearableManager
+import java.io.File
 import java.nio.ByteBuffer
 import java.nio.ByteOrder
 import javax.inject.Inject
@@ -412,10 +413,89 @@ class SlamManager @Inject constructor(
     fun clearWallFeatureMap() = nativeClearWallFeatureMap()
     /** Live wall-feature-map point count — diagnostic. */
     fun getMapPointCount(): Int = nativeGetMapPointCount()
+    /**
+     * Switch the engine to [projectId]'s wall. The loaded wall (fingerprint, map and their indexes)
+     * is parked under its own ID and the requested one swapped in, with no restore round trip.
+     * False when [projectId] isn't parked: native is then empty and labelled [projectId], and the
+     * caller restores the fingerprint and map as before.
+     */
+    fun activateWall(projectId: String): Boolean = nativeActivateWall(projectId)
+    /** Label the loaded wall with [projectId], e.g. after restoring or capturing it. */
+    fun setActiveWallId(projectId: String) = nativeSetActiveWallId(projectId)
+    /** The loaded wall's project ID; empty if unlabelled. */
+    fun getActiveWallId(): String = nativeGetActiveWallId()
+    /** Drop [projectId]'s parked wall, e.g. when the project is deleted. */
+    fun forgetWall(projectId: String) = nativeForgetWall(projectId)
+    /** Memory budget for parked walls; least-recently-used are evicted over it. Default 64 MB. */
+    fun setWallRegistryBudget(bytes: Long) = nativeSetWallRegistryBudget(bytes)
+    /** Estimated bytes held by parked walls — diagnostic. */
+    fun getWallRegistryBytes(): Long = nativeGetWallRegistryBytes()
+    /**
+     * Let failed relocalization attempts propose the parked wall whose global descriptor matches
+     * the camera view best. Proposals only: read them with [takeProposedWall]. Default OFF.
+     */
+    fun setWallPreselectEnabled(enabled: Boolean) = nativeSetWallPreselectEnabled(enabled)
+    /**
+     * The project ID pre-selection last proposed, consumed by the read; empty when there is none.
+     * The engine is not switched: open the project and [activateWall] swaps its parked wall in.
+     */
+    fun takeProposedWall(): String = nativeTakeProposedWall()
     /** Phase 2b: enable live map-matching in reloc. Default OFF — experimental until device-validated. */
     fun setMapRelocEnabled(enabled: Boolean) = nativeSetMapRelocEnabled(enabled)
     /** Phase 3: passively grow the feature map from reloc-locked frames. Default OFF; independent of matching. */
     fun setMapBuildEnabled(enabled: Boolean) = nativeSetMapBuildEnabled(enabled)
+    /**
+     * Run map growth (association, merging, pruning) on a low-priority background worker fed from
+     * reloc locks, instead of on the reloc thread after each publish. Default OFF.
+     */
+    fun setMapWorkerEnabled(enabled: Boolean) = nativeSetMapWorkerEnabled(enabled)
+    /**
+     * Map growth associates observations by projecting in-view map points with the fresh reloc pose.
+     * This adds the old whole-map descriptor match as a fallback when that finds too little.
+     * Default OFF.
+     */
+    fun setMapGlobalAssocEnabled(enabled: Boolean) = nativeSetMapGlobalAssocEnabled(enabled)
+    /**
+     * Record map keyframes and their covisibility as the map is built. When relocalization has no
+     * usable pose prior, it can then match the points of the best-retrieved keyframes. Only takes
+     * effect with map reloc on. Default OFF.
+     */
+    fun setMapKeyframesEnabled(enabled: Boolean) = nativeSetMapKeyframesEnabled(enabled)
+    /**
+     * Relocalize cold (before the first lock, or after a failed attempt) through a bag-of-words
+     * vocabulary: candidate correspondences come from vocabulary lookups instead of brute force over
+     * the fingerprint and map. Default OFF, and inert unless [loadVocabulary] found an asset.
+     */
+    fun setBowRelocEnabled(enabled: Boolean) = nativeSetBowRelocEnabled(enabled)
+    /**
+     * Record where each lock saw self-grown wall marks and map points, and periodically
+     * bundle-adjust them against the recent locked poses on a background thread, with the captured
+     * marks held fixed. Refines points placed from a single view. Default OFF.
+     */
+    fun setPointRefinementEnabled(enabled: Boolean) = nativeSetPointRefinementEnabled(enabled)
+    /**
+     * Match SuperPoint fingerprints and the feature map on 32-byte sign codes (Hamming) instead of
+     * 256-float rows (L2). Default OFF; matching only — nothing persisted changes, and ORB
+     * fingerprints ignore it.
+     */
+    fun setCompactMatchEnabled(enabled: Boolean) = nativeSetCompactMatchEnabled(enabled)
+    /**
+     * Enhance dark reloc frames with whichever low-light tier (gamma LUT, guided-filter Retinex or
+     * the Zero-DCE model) has recently given the most features per millisecond, instead of always
+     * running the model when it is loaded. Works with no model loaded. Default OFF.
+     */
+    fun setLowLightTiersEnabled(enabled: Boolean) = nativeSetLowLightTiersEnabled(enabled)
+    /**
+     * Evaluate the distortion head on its own background worker at most [hz] times a second instead
+     * of inline before PnP publishes. <= 0 (the default) keeps it inline.
+     */
+    fun setDistortionHeadRate(hz: Float) = nativeSetDistortionHeadRate(hz)
+    /**
+     * Let a confident distortion-head result steer relocalization: its homography seeds the
+     * rectifying warp and limits wall matching to a window around each predicted point, falling
+     * back to unguided matching when that yields too little. Default OFF.
+     */
+    fun setHeadPriorEnabled(enabled: Boolean) = nativeSetHeadPriorEnabled(enabled)
 
     /**
      * Phase 3b: read the in-native feature map back as a [WallFeatureMap] for .gxr persistence, or null
@@ -444,6 +524,48 @@ class SlamManager @Inject constructor(
         }
     }
 
+    /**
+     * Write the wall fingerprint and feature map to [file], the project's binary sidecar
+     * (`docs/data_formats.md` §4). Descriptors are written straight from native memory. False
+     * when there is nothing to write or the write failed; the previous file is then untouched.
+     */
+    fun saveWallSidecar(file: File): Boolean = nativeSaveWallSidecar(file.absolutePath)
+
+    /**
+     * Load [file] by memory-mapping it; the descriptors are used in place rather than copied. The
+     * feature map is replaced when the file carries one. The fingerprint is replaced when
+     * [restoreFingerprint] is set, or when the file's is the live one grown further: same anchor and
+     * intrinsics, at least as many marks. The app restores the capture from `project.json`, and
+     * what self-grow added since, with its journal, is only here. False, with native untouched,
+     * when the file is missing, fails its checksum or does not validate.
+     */
+    fun loadWallSidecar(file: File, restoreFingerprint: Boolean = false): Boolean =
+        nativeLoadWallSidecar(file.absolutePath, restoreFingerprint)
+
+    /**
+     * Compress the descriptors [saveWallSidecar] writes: 1 stores SuperPoint as half floats, 2 as
+     * block-scaled int8 with a bounded per-row error; ORB is entropy-coded losslessly at either.
+     * 0, the default, writes them raw. Loading decodes either form. A compressed sidecar is only
+     * readable by builds that know sidecar version 2.
+     */
+    fun setDescriptorCompression(level: Int) = nativeSetDescriptorCompression(level)
+
+    /**
+     * Record map and fingerprint changes for [appendWallJournal] from the next [saveWallSidecar]
+     * or [loadWallSidecar] on. Default off; the app turns it on at start. Loading replays an
+     * existing journal either way.
+     */
+    fun setMutationJournalEnabled(enabled: Boolean) = nativeSetMutationJournalEnabled(enabled)
+
+    /**
+     * Append what changed since the last call to the journal beside the sidecar [file]
+     * (`docs/data_formats.md` §6): a few kilobytes where [saveWallSidecar] rewrites every
+     * descriptor. Returns the journal's size in bytes, or -1 when the journal cannot extend the
+     * file: journaling is off, the file was not the last one saved or loaded, or the map or
+     * fingerprint has been replaced since. -1 asks for a [saveWallSidecar], which also compacts.
+     */
+    fun appendWallJournal(file: File): Long = nativeAppendWallJournal(file.absolutePath)
+
     fun setArtworkFingerprint(
         bitmap: Bitmap,
         depthBuffer: ByteBuffer?,
@@ -596,6 +718,11 @@ class SlamManager @Inject constructor(
     fun loadSuperPoint(assetManager: AssetManager): Boolean = nativeLoadSuperPoint(assetManager)
     /** Optional distortion head (docs/DISTORTION_HEAD.md). False (inert) if the asset isn't bundled. */
     fun loadDistortionHead(assetManager: AssetManager): Boolean = nativeLoadDistortionHead(assetManager)
+    /**
+     * Optional bag-of-words vocabularies (bow_superpoint.voc / bow_orb.voc, built by
+     * scripts/vocabulary/build_vocabulary.py). False (inert) if neither is bundled.
+     */
+    fun loadVocabulary(assetManager: AssetManager): Boolean = nativeLoadVocabulary(assetManager)
     fun loadLowLightEnhancer(assetManager: AssetManager) = nativeLoadLowLightEnhancer(assetManager)
 
 
@@ -619,15 +746,35 @@ class SlamManager @Inject constructor(
 
     /** Pose fusion (B): [0..15]=pnpMat, [16]=inlierCount, [17]=matchCount, [18]=seq. */
     fun getRelocResult(): FloatArray { val o = FloatArray(19); nativeGetRelocResult(o); return o }
+    /**
+     * The distortion head's latest outputs: [0..12] = distortion[13] (corners, pose, matchability,
+     * coverage), [13] = the reloc pass that produced them (-1 = none yet), [14] = the newest reloc
+     * pass. With the head on its worker, [14] - [13] is how many passes old the outputs are.
+     */
+    fun getDistortionHeadResult(): FloatArray { val o = FloatArray(15); nativeGetDistortionHeadResult(o); return o }
 
     /** Pose fusion (B): the anchor model matrix captured in the fingerprint world frame. */
     fun getFingerprintAnchor(): FloatArray { val o = FloatArray(16); nativeGetFingerprintAnchor(o); return o }
 
-    fun exportFingerprint(): ByteArray? = nativeExportFingerprint()
-    fun alignToFingerprint(data: ByteArray) = nativeAlignToFingerprint(data)
+    /**
+     * The co-op fingerprint as a versioned change set (docs/data_formats.md §5) for a peer that
+     * holds generation [sinceGen] of wall [epoch] — from [getPeerFingerprintBase] on its side. Only
+     * the marks self-grow appended and refinement moved since then; the whole wall when the peer
+     * names another wall or generation 0. Null when the peer is already current or there is no
+     * fingerprint.
+     */
+    fun exportFingerprintDelta(epoch: Long = 0L, sinceGen: Long = 0L): ByteArray? =
+        nativeExportFingerprintDelta(epoch, sinceGen)
+
+    /**
+     * Apply bytes from a peer's [exportFingerprintDelta]. A full record replaces the wall
+     * outright. False when a delta does not fit the base this wall holds, after which
+     * [getPeerFingerprintBase] reports none and the next request fetches the whole wall.
+     */
+    fun applyFingerprintDelta(data: ByteArray): Boolean = nativeApplyFingerprintDelta(data)
 
-    /** Co-op alias: align local SLAM state to the peer's fingerprint bytes. */
-    fun alignToPeer(fingerprint: ByteArray) = alignToFingerprint(fingerprint)
+    /** (epoch, generation) of the peer wall last applied here, or (0, 0) when there is none. */
+    fun getPeerFingerprintBase(): LongArray { val o = LongArray(2); nativeGetPeerFingerprintBase(o); return o }
 
     fun startSensorCollection() {
         collectionJob?.cancel()
@@ -760,6 +907,7 @@ class SlamManager @Inject constructor(
     private external fun nativeSetArCoreTrackingState(isTracking: Boolean)
     private external fun nativeLoadSuperPoint(assetManager: AssetManager): Boolean
     private external fun nativeLoadDistortionHead(assetManager: AssetManager): Boolean
+    private external fun nativeLoadVocabulary(assetManager: AssetManager): Boolean
     private external fun nativeLoadLowLightEnhancer(assetManager: AssetManager)
     private external fun nativeUpdateAnchorTransform(transform: FloatArray)
     private external fun nativeUpdateDeviceMotion(angularVel: FloatArray, linearVel: FloatArray)
@@ -772,9 +920,11 @@ class SlamManager @Inject constructor(
     private external fun nativeGetStageTimings(out: FloatArray)
     private external fun nativeSetStageEnabled(stage: Int, enabled: Boolean)
     private external fun nativeGetRelocResult(out: FloatArray)
+    private external fun nativeGetDistortionHeadResult(out: FloatArray)
     private external fun nativeGetFingerprintAnchor(out: FloatArray)
-    private external fun nativeExportFingerprint(): ByteArray?
-    private external fun nativeAlignToFingerprint(data: ByteArray)
+    private external fun nativeExportFingerprintDelta(epoch: Long, sinceGen: Long): ByteArray?
+    private external fun nativeApplyFingerprintDelta(data: ByteArray): Boolean
+    private external fun nativeGetPeerFingerprintBase(out: LongArray)
     private external fun nativeSetWallFingerprint(
         bitmap: Bitmap, mask: Bitmap?,
         depthBuffer: ByteBuffer,
@@ -797,9 +947,31 @@ class SlamManager @Inject constructor(
     private external fun nativeClearWallFeatureMap()
     private external fun nativeClearWallFingerprint()
     private external fun nativeGetMapPointCount(): Int
+    private external fun nativeActivateWall(projectId: String): Boolean
+    private external fun nativeSetActiveWallId(projectId: String)
+    private external fun nativeGetActiveWallId(): String
+    private external fun nativeForgetWall(projectId: String)
+    private external fun nativeSetWallRegistryBudget(bytes: Long)
+    private external fun nativeGetWallRegistryBytes(): Long
+    private external fun nativeSetWallPreselectEnabled(enabled: Boolean)
+    private external fun nativeTakeProposedWall(): String
     private external fun nativeSetMapRelocEnabled(enabled: Boolean)
     private external fun nativeSetMapBuildEnabled(enabled: Boolean)
+    private external fun nativeSetMapWorkerEnabled(enabled: Boolean)
+    private external fun nativeSetMapGlobalAssocEnabled(enabled: Boolean)
+    private external fun nativeSetMapKeyframesEnabled(enabled: Boolean)
+    private external fun nativeSetBowRelocEnabled(enabled: Boolean)
+    private external fun nativeSetPointRefinementEnabled(enabled: Boolean)
+    private external fun nativeSetCompactMatchEnabled(enabled: Boolean)
+    private external fun nativeSetLowLightTiersEnabled(enabled: Boolean)
+    private external fun nativeSetDistortionHeadRate(hz: Float)
+    private external fun nativeSetHeadPriorEnabled(enabled: Boolean)
     private external fun nativeExportWallFeatureMap(): ByteArray?
+    private external fun nativeSaveWallSidecar(path: String): Boolean
+    private external fun nativeLoadWallSidecar(path: String, restoreFingerprint: Boolean): Boolean
+    private external fun nativeSetDescriptorCompression(level: Int)
+    private external fun nativeSetMutationJournalEnabled(enabled: Boolean)
+    private external fun nativeAppendWallJournal(path: String): Long
     private external fun nativeSetArtworkFingerprint(
         bitmap: Bitmap, depthBuffer: ByteBuffer?,
         depthW: Int, depthH: Int, depthStride: Int,
@@ -0,0 +1,171 @@
+#include "BundleRefiner.h"
+#include <opencv2/calib3d.hpp>
+#include <gtest/gtest.h>
+#include <cmath>
+#include <random>
+
+namespace {
+
+constexpr double kF = 500.0, kCx = 320.0, kCy = 240.0;
+
+// camera_from_fp for a camera turned [yaw] radians about y, centred at (camX, 0, 0).
+BundleRefiner::Pose pose(uint32_t id, double camX, double yaw = 0.0) {
+    BundleRefiner::Pose p;
+    p.id = id;
+    const double c = std::cos(yaw), s = std::sin(yaw);
+    p.R = cv::Matx33d(c, 0, s, 0, 1, 0, -s, 0, c);
+    p.t = -(p.R * cv::Vec3d(camX, 0, 0));
+    p.fx = kF; p.fy = kF; p.cx = kCx; p.cy = kCy;
+    return p;
+}
+
+BundleRefiner::Obs project(const BundleRefiner::Pose& p, const cv::Point3f& X) {
+    const cv::Vec3d Xc = p.R * cv::Vec3d(X.x, X.y, X.z) + p.t;
+    return {p.id, (float)(p.fx * Xc[0] / Xc[2] + p.cx), (float)(p.fy * Xc[1] / Xc[2] + p.cy)};
+}
+
+std::vector<cv::Point3f> scene(size_t n, uint32_t seed) {
+    std::mt19937 rng(seed);
+    std::uniform_real_distribution<float> xy(-0.8f, 0.8f), z(2.0f, 3.0f);
+    std::vector<cv::Point3f> pts(n);
+    for (auto& X : pts) X = cv::Point3f(xy(rng), xy(rng), z(rng));
+    return pts;
+}
+
+// Five views of [truth]; the first [fixedCount] points are fixed.
+BundleRefiner::Problem problem(const std::vector<cv::Point3f>& truth, size_t fixedCount) {
+    BundleRefiner::Problem p;
+    for (uint32_t j = 0; j < 5; ++j) p.poses.push_back(pose(j + 1, 0.15 * j - 0.3, 0.03 * j));
+    for (size_t i = 0; i < truth.size(); ++i) {
+        p.keys.push_back(BundleRefiner::key(BundleRefiner::kMap, (uint32_t)i));
+        p.pts.push_back(truth[i]);
+        p.fixed.push_back(i < fixedCount ? 1 : 0);
+        std::vector<BundleRefiner::Obs> obs;
+        for (const auto& P : p.poses) obs.push_back(project(P, truth[i]));
+        p.obs.push_back(obs);
+    }
+    return p;
+}
+
+double dist(const cv::Point3f& a, const cv::Point3f& b) {
+    const cv::Point3f d = a - b;
+    return std::sqrt((double)d.dot(d));
+}
+
+}  // namespace
+
+TEST(BundleRefinerTest, SolveMovesFreePointsBackOntoTheirRays) {
+    const auto truth = scene(30, 3);
+    auto p = problem(truth, 10);
+    std::mt19937 rng(9);
+    std::uniform_real_distribution<float> jitter(-0.05f, 0.05f);
+    for (size_t i = 10; i < truth.size(); ++i) p.pts[i] += cv::Point3f(jitter(rng), jitter(rng), jitter(rng));
+
+    double before = 0, after = 0;
+    BundleRefiner::solve(p, 10, 2.0, before, after);
+    EXPECT_GT(before, 1.0);
+    EXPECT_LT(after, 1e-2);
+    for (size_t i = 0; i < 10; ++i) EXPECT_EQ(p.pts[i], truth[i]) << "fixed point " << i << " moved";
+    for (size_t i = 10; i < truth.size(); ++i) EXPECT_LT(dist(p.pts[i], truth[i]), 1e-3) << "point " << i;
+}
+
+TEST(BundleRefinerTest, PosePinnedByFixedPointsIsCorrected) {
+    const auto truth = scene(20, 5);
+    auto p = problem(truth, truth.size());
+    const BundleRefiner::Pose exact = p.poses[2];
+    cv::Matx33d dR;
+    cv::Rodrigues(cv::Vec3d(0.01, -0.008, 0.005), dR);
+    p.poses[2].R = dR * p.poses[2].R;
+    p.poses[2].t += cv::Vec3d(0.02, -0.01, 0.03);
+
+    double before = 0, after = 0;
+    BundleRefiner::solve(p, 10, 2.0, before, after);
+    EXPECT_LT(after, before);
+    EXPECT_LT(after, 1e-2);
+    EXPECT_LT(cv::norm(p.poses[2].t - exact.t), 1e-3);
+    EXPECT_LT(cv::norm(p.poses[2].R - exact.R), 1e-3);
+    for (size_t i = 0; i < truth.size(); ++i) EXPECT_EQ(p.pts[i], truth[i]);
+}
+
+TEST(BundleRefinerTest, UnpinnedPosesAreLeftAlone) {
+    const auto truth = scene(20, 7);
+    auto p = problem(truth, BundleRefiner::kMinFixedPerPose - 1);
+    p.poses[1].t += cv::Vec3d(0.05, 0, 0);
+    const cv::Vec3d moved = p.poses[1].t;
+    double before = 0, after = 0;
+    BundleRefiner::solve(p, 5, 2.0, before, after);
+    EXPECT_EQ(p.poses[1].t, moved);
+}
+
+TEST(BundleRefinerTest, SnapshotKeepsMultiViewTracksOfLivePoses) {
+    BundleRefiner br;
+    const float I[16] = {1,0,0,0, 0,1,0,0, 0,0,1,0, 0,0,0,1};
+    const uint32_t first = br.addPose(I, kF, kF, kCx, kCy);
+    const uint32_t second = br.addPose(I, kF, kF, kCx, kCy);
+    EXPECT_NE(first, 0u);
+    EXPECT_EQ(br.posesSinceSolve(), 2u);
+
+    const uint64_t twoViews = BundleRefiner::key(BundleRefiner::kMap, 1);
+    const uint64_t oneView = BundleRefiner::key(BundleRefiner::kMap, 2);
+    const uint64_t fixedOne = BundleRefiner::key(BundleRefiner::kWall, 3);
+    const uint64_t gone = BundleRefiner::key(BundleRefiner::kMap, 4);
+    br.observe(twoViews, first, 1, 1);
+    br.observe(twoViews, first, 9, 9);     // same view again: ignored
+    br.observe(twoViews, second, 2, 2);
+    br.observe(oneView, second, 3, 3);
+    br.observe(fixedOne, first, 4, 4);
+    br.observe(gone, first, 5, 5);
+    br.observe(gone, second, 5, 5);
+
+    auto resolve = [&](uint64_t k, cv::Point3f& X, bool& fixed) {
+        if (k == gone) return false;
+        X = cv::Point3f((float)BundleRefiner::idOf(k), 0, 1);
+        fixed = BundleRefiner::kindOf(k) == BundleRefiner::kWall;
+        return true;
+    };
+    BundleRefiner::Problem p;
+    br.snapshot(p, 2, resolve);
+    EXPECT_EQ(br.posesSinceSolve(), 0u);
+    ASSERT_EQ(p.poses.size(), 2u);
+    ASSERT_EQ(p.keys.size(), 2u);
+    for (size_t i = 0; i < p.keys.size(); ++i) {
+        if (p.keys[i] == twoViews) {
+            ASSERT_EQ(p.obs[i].size(), 2u);
+            EXPECT_FLOAT_EQ(p.obs[i][0].u, 1.0f);
+            EXPECT_FALSE(p.fixed[i]);
+        } else {
+            EXPECT_EQ(p.keys[i], fixedOne);
+            EXPECT_TRUE(p.fixed[i]);
+        }
+    }
+
+    // Poses leaving the ring take their observations with them; ids keep counting.
+    for (size_t k = 0; k < BundleRefiner::kMaxPoses; ++k) br.addPose(I, kF, kF, kCx, kCy);
+    EXPECT_FALSE(br.hasPose(first));
+    EXPECT_FALSE(br.hasPose(second));
+    br.snapshot(p, 1, resolve);
+    EXPECT_TRUE(p.keys.empty());
+    br.clear();
+    EXPECT_NE(br.addPose(I, kF, kF, kCx, kCy), first);
+}
+
+TEST(BundleRefinerTest, TracksKeepOnlyTheLatestObservations) {
+    BundleRefiner br;
+    const float I[16] = {1,0,0,0, 0,1,0,0, 0,0,1,0, 0,0,0,1};
+    const uint64_t k = BundleRefiner::key(BundleRefiner::kMap, 7);
+    std::vector<uint32_t> ids;
+    for (size_t i = 0; i < BundleRefiner::kMaxObsPerPoint + 3; ++i) {
+        ids.push_back(br.addPose(I, kF, kF, kCx, kCy));
+        br.observe(k, ids.back(), (float)i, 0);
+    }
+    BundleRefiner::Problem p;
+    br.snapshot(p, 2, [](uint64_t, cv::Point3f& X, bool& fixed) { X = {0, 0, 1}; fixed = false; return true; });
+    ASSERT_EQ(p.obs.size(), 1u);
+    ASSERT_EQ(p.obs[0].size(), BundleRefiner::kMaxObsPerPoint);
+    EXPECT_EQ(p.obs[0].front().pose, ids[3]);
+    EXPECT_EQ(p.obs[0].back().pose, ids.back());
+
+    br.forget(k);
+    br.snapshot(p, 1, [](uint64_t, cv::Point3f& X, bool& fixed) { X = {0, 0, 1}; fixed = false; return true; });
+    EXPECT_TRUE(p.keys.empty());
+}
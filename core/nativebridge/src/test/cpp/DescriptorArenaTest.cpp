@@ -0,0 +1,119 @@
+#include "DescriptorArena.h"
+#include <gtest/gtest.h>
+#include <set>
+
+namespace {
+
+// Row r of an ORB-shaped set holds the byte (r + seed) in every column, so rows are recognisable.
+cv::Mat rowsFrom(int first, int count, int cols = 32) {
+    cv::Mat m(count, cols, CV_8U);
+    for (int r = 0; r < count; ++r) m.row(r).setTo(cv::Scalar((first + r) & 0xFF));
+    return m;
+}
+
+int tag(const cv::Mat& m, int r) { return m.at<uchar>(r, 0); }
+
+bool sameBytes(const cv::Mat& a, const cv::Mat& b) {
+    if (a.rows != b.rows || a.cols != b.cols || a.type() != b.type()) return false;
+    for (int r = 0; r < a.rows; ++r)
+        if (memcmp(a.ptr(r), b.ptr(r), (size_t)a.cols * a.elemSize()) != 0) return false;
+    return true;
+}
+
+}  // namespace
+
+TEST(DescriptorArenaTest, AppendGrowsGeometricallyAndKeepsRows) {
+    DescriptorArena arena;
+    std::set<const uchar*> buffers;
+    for (int i = 0; i < 1000; ++i) {
+        ASSERT_TRUE(arena.append(rowsFrom(i, 1)));
+        buffers.insert(arena.view().data);
+    }
+    EXPECT_EQ(arena.rows(), 1000);
+    EXPECT_GE(arena.capacity(), 1000);
+    // 64, 128, ..., 1024: a handful of moves, not one per append.
+    EXPECT_LE(buffers.size(), 6u);
+    const cv::Mat v = arena.view();
+    EXPECT_TRUE(v.isContinuous());
+    for (int r = 0; r < 1000; ++r) EXPECT_EQ(tag(v, r), r & 0xFF);
+}
+
+TEST(DescriptorArenaTest, AppendRefusesAShapeMismatch) {
+    DescriptorArena arena;
+    ASSERT_TRUE(arena.append(rowsFrom(0, 3)));
+    EXPECT_FALSE(arena.append(rowsFrom(0, 1, 16)));
+    EXPECT_FALSE(arena.append(cv::Mat(1, 32, CV_32F, cv::Scalar(0))));
+    EXPECT_TRUE(arena.append(cv::Mat()));
+    EXPECT_EQ(arena.rows(), 3);
+    EXPECT_EQ(arena.type(), CV_8U);
+    EXPECT_EQ(arena.cols(), 32);
+}
+
+TEST(DescriptorArenaTest, ViewIsStableAcrossAppendAndGrowth) {
+    DescriptorArena arena;
+    arena.append(rowsFrom(0, 10));
+    const cv::Mat before = arena.view();
+    const cv::Mat expected = before.clone();
+    arena.append(rowsFrom(10, 500));   // outgrows the buffer the view holds
+    EXPECT_TRUE(sameBytes(before, expected));
+    EXPECT_EQ(arena.rows(), 510);
+    EXPECT_TRUE(sameBytes(arena.view().rowRange(0, 10), expected));
+}
+
+TEST(DescriptorArenaTest, SwapRemoveMovesTheLastRowIn) {
+    DescriptorArena arena;
+    arena.append(rowsFrom(0, 5));
+    arena.swapRemove(1);
+    ASSERT_EQ(arena.rows(), 4);
+    const cv::Mat v = arena.view();
+    EXPECT_EQ(tag(v, 0), 0);
+    EXPECT_EQ(tag(v, 1), 4);
+    EXPECT_EQ(tag(v, 2), 2);
+    EXPECT_EQ(tag(v, 3), 3);
+    arena.swapRemove(3);   // the last row itself
+    EXPECT_EQ(arena.rows(), 3);
+    arena.swapRemove(-1);
+    arena.swapRemove(3);
+    EXPECT_EQ(arena.rows(), 3);
+}
+
+TEST(DescriptorArenaTest, SwapRemoveNeverWritesARowAViewCanSee) {
+    DescriptorArena arena;
+    arena.append(rowsFrom(0, 8));
+    cv::Mat held = arena.view();
+    const cv::Mat expected = held.clone();
+    arena.swapRemove(0);
+    EXPECT_TRUE(sameBytes(held, expected));
+    EXPECT_NE(arena.view().data, held.data);   // detached onto a private copy
+    EXPECT_EQ(tag(arena.view(), 0), 7);
+
+    // With no view left outstanding, the next removal writes in place.
+    held.release();
+    const uchar* buffer = arena.view().data;   // this temporary view dies with the statement
+    arena.swapRemove(0);
+    EXPECT_EQ(arena.view().data, buffer);
+    EXPECT_EQ(tag(arena.view(), 0), 6);
+}
+
+TEST(DescriptorArenaTest, AssignCopiesAndAdoptShares) {
+    const cv::Mat src = rowsFrom(0, 20);
+    DescriptorArena copied, adopted;
+    copied.assign(src);
+    adopted.adopt(src);
+    EXPECT_NE(copied.view().data, src.data);
+    EXPECT_EQ(adopted.view().data, src.data);
+    EXPECT_EQ(adopted.capacity(), 20);
+    EXPECT_TRUE(sameBytes(copied.view(), src));
+
+    // The adopted buffer is full: the first append moves off it and leaves it untouched.
+    const cv::Mat expected = src.clone();
+    adopted.append(rowsFrom(20, 1));
+    EXPECT_NE(adopted.view().data, src.data);
+    EXPECT_TRUE(sameBytes(src, expected));
+    EXPECT_EQ(adopted.rows(), 21);
+    EXPECT_EQ(tag(adopted.view(), 20), 20);
+
+    copied.assign(cv::Mat());
+    EXPECT_TRUE(copied.empty());
+    EXPECT_TRUE(copied.view().empty());
+}
@@ -0,0 +1,147 @@
+#include "DescriptorCodec.h"
+#include <gtest/gtest.h>
+#include <cstring>
+#include <random>
+
+namespace {
+
+cv::Mat unitRows(int rows, int cols, uint32_t seed, float norm = 1.0f) {
+    std::mt19937 rng(seed);
+    std::normal_distribution<float> g;
+    cv::Mat m(rows, cols, CV_32F);
+    for (int r = 0; r < rows; ++r) {
+        float n = 0.f;
+        for (int c = 0; c < cols; ++c) n += (m.at<float>(r, c) = g(rng)) * m.at<float>(r, c);
+        for (int c = 0; c < cols; ++c) m.at<float>(r, c) *= norm / std::sqrt(n);
+    }
+    return m;
+}
+
+// ORB-shaped rows, each bit set with probability 1/8: something for the range coder to save.
+cv::Mat sparseBits(int rows, uint32_t seed) {
+    std::mt19937 rng(seed);
+    cv::Mat m(rows, 32, CV_8U);
+    for (int r = 0; r < rows; ++r)
+        for (int c = 0; c < 32; ++c) m.at<uchar>(r, c) = (uchar)(rng() & rng() & rng());
+    return m;
+}
+
+uint32_t method(const std::vector<uint8_t>& s) {
+    uint32_t m = 0;
+    if (s.size() >= 4) memcpy(&m, s.data(), 4);
+    return m;
+}
+
+double l2(const cv::Mat& a, int i, const cv::Mat& b, int j) {
+    double s = 0;
+    for (int c = 0; c < a.cols; ++c) {
+        const double d = (double)a.at<float>(i, c) - b.at<float>(j, c);
+        s += d * d;
+    }
+    return std::sqrt(s);
+}
+
+// The worst change in any pairwise distance, over every pair of rows.
+double worstDistanceShift(const cv::Mat& before, const cv::Mat& after) {
+    double worst = 0;
+    for (int i = 0; i < before.rows; ++i)
+        for (int j = i + 1; j < before.rows; ++j)
+            worst = std::max(worst, std::abs(l2(after, i, after, j) - l2(before, i, before, j)));
+    return worst;
+}
+
+}  // namespace
+
+TEST(DescriptorCodecTest, SuperPointMatchDistancesMoveWithinTwiceTheRowBound) {
+    const cv::Mat d = unitRows(120, 256, 1);
+    for (int level : {1, 2}) {
+        float err = -1.f;
+        const auto s = DescriptorCodec::encode(d, level, &err);
+        ASSERT_FALSE(s.empty()) << "level " << level;
+        EXPECT_EQ(method(s), level == 1 ? (uint32_t)DescriptorCodec::kFloat16 : (uint32_t)DescriptorCodec::kInt8Block);
+        cv::Mat back;
+        ASSERT_TRUE(DescriptorCodec::decode(s.data(), s.size(), d.rows, d.cols, CV_32F, back));
+        for (int r = 0; r < d.rows; ++r) EXPECT_LE(l2(back, r, d, r), err + 1e-6) << "row " << r;
+        EXPECT_LE(err, DescriptorCodec::kMaxRowError);
+        EXPECT_LE(worstDistanceShift(d, back), 2.0 * DescriptorCodec::kMaxRowError) << "level " << level;
+    }
+    // Level 2 is the smaller of the two: a quarter of raw and a float per block.
+    EXPECT_LT(DescriptorCodec::encode(d, 2).size(), DescriptorCodec::encode(d, 1).size());
+    EXPECT_LE(DescriptorCodec::encode(d, 2).size(), 4 + d.total() + (size_t)d.rows * 8 * sizeof(float));
+}
+
+TEST(DescriptorCodecTest, RowsOutsideTheInt8BoundFallBackToHalfFloat) {
+    // Unnormalised: int8 steps scale with the row, and a norm-10 row's error is ten times a unit one's.
+    const cv::Mat d = unitRows(20, 256, 2, 10.0f);
+    float err = -1.f;
+    const auto s = DescriptorCodec::encode(d, 2, &err);
+    ASSERT_FALSE(s.empty());
+    EXPECT_EQ(method(s), (uint32_t)DescriptorCodec::kFloat16);
+    cv::Mat back;
+    ASSERT_TRUE(DescriptorCodec::decode(s.data(), s.size(), d.rows, d.cols, CV_32F, back));
+    EXPECT_LE(worstDistanceShift(d, back), 2.0 * err + 1e-5);
+}
+
+TEST(DescriptorCodecTest, OrbRoundTripIsBitExact) {
+    const cv::Mat d = sparseBits(300, 3);
+    for (int level : {1, 2}) {
+        float err = -1.f;
+        const auto s = DescriptorCodec::encode(d, level, &err);
+        ASSERT_FALSE(s.empty());
+        EXPECT_EQ(method(s), (uint32_t)DescriptorCodec::kBitRange);
+        EXPECT_EQ(err, 0.f);
+        EXPECT_LT(s.size(), d.total());
+        cv::Mat back;
+        ASSERT_TRUE(DescriptorCodec::decode(s.data(), s.size(), d.rows, d.cols, CV_8U, back));
+        ASSERT_EQ(back.type(), CV_8U);
+        EXPECT_EQ(0, memcmp(back.data, d.data, d.total()));
+    }
+}
+
+TEST(DescriptorCodecTest, NothingToGainCodesNothing) {
+    std::mt19937 rng(4);
+    cv::Mat orb(200, 32, CV_8U);
+    for (int r = 0; r < orb.rows; ++r)
+        for (int c = 0; c < 32; ++c) orb.at<uchar>(r, c) = (uchar)rng();
+    EXPECT_TRUE(DescriptorCodec::encode(orb, 2).empty()) << "balanced bits do not compress";
+    EXPECT_TRUE(DescriptorCodec::encode(unitRows(4, 8, 5), 0).empty());
+    EXPECT_TRUE(DescriptorCodec::encode(unitRows(4, 8, 5), 3).empty());
+    EXPECT_TRUE(DescriptorCodec::encode(cv::Mat(), 1).empty());
+    EXPECT_TRUE(DescriptorCodec::encode(cv::Mat(4, 8, CV_32S, cv::Scalar(1)), 1).empty());
+}
+
+TEST(DescriptorCodecTest, DecodeRefusesStreamsThatDoNotFit) {
+    const cv::Mat sp = unitRows(10, 256, 6);
+    const cv::Mat orb = sparseBits(100, 7);
+    const auto half = DescriptorCodec::encode(sp, 1), int8 = DescriptorCodec::encode(sp, 2);
+    const auto bits = DescriptorCodec::encode(orb, 1);
+    cv::Mat out;
+
+    // The fixed-size methods: any other length, shape or type.
+    for (const auto* s : {&half, &int8}) {
+        for (size_t n : {(size_t)0, (size_t)3, (size_t)4, s->size() - 1})
+            EXPECT_FALSE(DescriptorCodec::decode(s->data(), n, sp.rows, sp.cols, CV_32F, out)) << n;
+        EXPECT_FALSE(DescriptorCodec::decode(s->data(), s->size(), sp.rows + 1, sp.cols, CV_32F, out));
+        EXPECT_FALSE(DescriptorCodec::decode(s->data(), s->size(), sp.rows, sp.cols, CV_8U, out));
+    }
+    EXPECT_FALSE(DescriptorCodec::decode(bits.data(), bits.size(), orb.rows, orb.cols, CV_32F, out));
+    EXPECT_FALSE(DescriptorCodec::decode(half.data(), half.size(), 0, sp.cols, CV_32F, out));
+    auto unknown = half;
+    unknown[0] = 9;
+    EXPECT_FALSE(DescriptorCodec::decode(unknown.data(), unknown.size(), sp.rows, sp.cols, CV_32F, out));
+
+    // A truncated range-coded stream decodes to wrong bits, never out of bounds, and one too short
+    // for its shape to have come from the encoder is refused outright.
+    for (size_t n = 4; n < bits.size(); n += 7) {
+        cv::Mat m;
+        if (DescriptorCodec::decode(bits.data(), n, orb.rows, orb.cols, CV_8U, m)) {
+            ASSERT_EQ(m.rows, orb.rows);
+            ASSERT_EQ(m.cols, orb.cols);
+        }
+    }
+    EXPECT_FALSE(DescriptorCodec::decode(bits.data(), 8, orb.rows, orb.cols, CV_8U, out)) << "under 5 payload bytes";
+    EXPECT_FALSE(DescriptorCodec::decode(bits.data(), 4 + 5, 100000, 32, CV_8U, out)) << "past the expansion bound";
+    cv::Mat truncated;
+    ASSERT_TRUE(DescriptorCodec::decode(bits.data(), bits.size() / 2, orb.rows, orb.cols, CV_8U, truncated));
+    EXPECT_NE(0, memcmp(truncated.data, orb.data, orb.total()));
+}
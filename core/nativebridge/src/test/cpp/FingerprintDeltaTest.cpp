@@ -0,0 +1,238 @@
+#include "FingerprintDelta.h"
+#include <gtest/gtest.h>
+
+namespace {
+
+// A wall as MobileGS keeps it for sync: parallel columns plus per-row append and move generations.
+struct Wall {
+    uint64_t epoch = 77;
+    uint64_t gen = 1;
+    std::vector<cv::Point3f> pts;
+    cv::Mat descs;
+    std::vector<uint8_t> regions;
+    std::vector<uint64_t> addGen, moveGen;
+
+    void append(int n, float tag) {
+        ++gen;
+        for (int i = 0; i < n; ++i) {
+            const int row = (int)pts.size();
+            pts.emplace_back(tag, (float)row, 0.f);
+            cv::Mat d(1, 4, CV_32F, cv::Scalar(tag + row));
+            descs.push_back(d);
+            regions.push_back((uint8_t)(row % 3));
+            addGen.push_back(gen);
+            moveGen.push_back(0);
+        }
+    }
+    void move(const std::vector<uint32_t>& rows, float dz) {
+        ++gen;
+        for (uint32_t r : rows) {
+            pts[r].z += dz;
+            moveGen[r] = gen;
+        }
+    }
+    FingerprintDelta since(bool full, uint64_t sinceGen) const {
+        return FingerprintDelta::since(epoch, gen, full, sinceGen, pts, descs, regions, addGen, moveGen);
+    }
+};
+
+// What the receiving MobileGS does with a checked delta: install a full one, or move and append.
+struct Guest {
+    uint64_t epoch = 5;   // the local wall's own sync epoch
+    std::vector<cv::Point3f> pts;
+    cv::Mat descs;
+    FingerprintDelta::Peer peer;
+
+    const char* apply(const std::vector<uint8_t>& wire) {
+        FingerprintDelta d;
+        if (!FingerprintDelta::decode(wire.data(), wire.size(), d)) return "malformed";
+        std::vector<uint32_t> movedLocal;
+        if (const char* why = peer.check(d, epoch, pts.size(), descs.type(), descs.cols, movedLocal)) {
+            peer.forget();
+            return why;
+        }
+        size_t first = 0;
+        if (d.full()) {
+            pts = d.appendedPts;
+            descs = d.appendedDescs.clone();
+            ++epoch;   // an install is a replacement
+            peer.installed(pts.size(), epoch);
+        } else {
+            for (size_t i = 0; i < movedLocal.size(); ++i) pts[movedLocal[i]] = d.movedPts[i];
+            first = pts.size();
+            pts.insert(pts.end(), d.appendedPts.begin(), d.appendedPts.end());
+            if (!d.appendedPts.empty()) descs.push_back(d.appendedDescs);
+        }
+        peer.applied(d, first);
+        return nullptr;
+    }
+    void selfGrow(int n) {
+        for (int i = 0; i < n; ++i) {
+            pts.emplace_back(-1.f, (float)pts.size(), 0.f);
+            descs.push_back(cv::Mat(1, 4, CV_32F, cv::Scalar(-1)));
+        }
+    }
+};
+
+// Every sender row, found through the guest's row map.
+void expectMirrors(const Wall& w, const Guest& g) {
+    ASSERT_EQ(g.peer.rowMap.size(), w.pts.size());
+    for (size_t r = 0; r < w.pts.size(); ++r) {
+        const uint32_t l = g.peer.rowMap[r];
+        ASSERT_LT(l, g.pts.size());
+        EXPECT_EQ(g.pts[l], w.pts[r]) << "sender row " << r;
+        EXPECT_FLOAT_EQ(g.descs.at<float>((int)l, 0), w.descs.at<float>((int)r, 0)) << "sender row " << r;
+    }
+}
+
+}  // namespace
+
+TEST(FingerprintDeltaTest, EncodeDecodeRoundTrip) {
+    Wall w;
+    w.append(6, 1.f);
+    const uint64_t base = w.gen;
+    w.move({1, 4}, 0.5f);
+    w.append(3, 2.f);
+    const FingerprintDelta d = w.since(false, base);
+    EXPECT_FALSE(d.full());
+    EXPECT_EQ(d.baseRows, 6u);
+    EXPECT_EQ(d.movedRows, std::vector<uint32_t>({1, 4}));
+    EXPECT_EQ(d.appendedPts.size(), 3u);
+
+    const auto wire = d.encode();
+    FingerprintDelta out;
+    ASSERT_TRUE(FingerprintDelta::decode(wire.data(), wire.size(), out));
+    EXPECT_EQ(out.flags, d.flags);
+    EXPECT_EQ(out.epoch, w.epoch);
+    EXPECT_EQ(out.baseGen, base);
+    EXPECT_EQ(out.newGen, w.gen);
+    EXPECT_EQ(out.baseRows, 6u);
+    EXPECT_EQ(out.movedRows, d.movedRows);
+    EXPECT_EQ(out.movedPts, d.movedPts);
+    EXPECT_EQ(out.appendedPts, d.appendedPts);
+    EXPECT_EQ(out.appendedRegions, d.appendedRegions);
+    ASSERT_EQ(out.appendedDescs.rows, 3);
+    for (int r = 0; r < 3; ++r) EXPECT_FLOAT_EQ(out.appendedDescs.at<float>(r, 3), d.appendedDescs.at<float>(r, 3));
+
+    const FingerprintDelta full = w.since(true, 0);
+    EXPECT_TRUE(full.full());
+    EXPECT_EQ(full.baseRows, 0u);
+    EXPECT_TRUE(full.movedRows.empty());
+    EXPECT_EQ(full.appendedPts.size(), w.pts.size());
+}
+
+TEST(FingerprintDeltaTest, DecodeRefusesEveryTruncationAndBadHeader) {
+    Wall w;
+    w.append(4, 1.f);
+    const uint64_t base = w.gen;
+    w.move({2}, 0.1f);
+    w.append(2, 2.f);
+    const auto wire = w.since(false, base).encode();
+    FingerprintDelta out;
+    for (size_t n = 0; n < wire.size(); ++n)
+        EXPECT_FALSE(FingerprintDelta::decode(wire.data(), n, out)) << "truncated to " << n;
+    auto longer = wire;
+    longer.push_back(0);
+    EXPECT_FALSE(FingerprintDelta::decode(longer.data(), longer.size(), out));
+    EXPECT_FALSE(FingerprintDelta::decode(nullptr, wire.size(), out));
+
+    auto patched = [&](size_t at, uint32_t v) {
+        auto b = wire;
+        memcpy(b.data() + at, &v, 4);
+        return FingerprintDelta::decode(b.data(), b.size(), out);
+    };
+    auto bad = wire;
+    bad[3] = 'X';
+    EXPECT_FALSE(FingerprintDelta::decode(bad.data(), bad.size(), out)) << "magic";
+    EXPECT_FALSE(patched(4, FingerprintDelta::kVersion + 1)) << "version";
+    EXPECT_FALSE(patched(8, FingerprintDelta::kFull)) << "full with a base";
+    // u32 baseRows at 40, then removed, moved, appended counts; descType at 56, descCols at 60.
+    EXPECT_FALSE(patched(40, FingerprintDelta::kMaxRows + 1)) << "baseRows";
+    EXPECT_FALSE(patched(52, FingerprintDelta::kMaxRows + 1)) << "appended";
+    EXPECT_FALSE(patched(52, 3)) << "appended count disagrees with the payload";
+    EXPECT_FALSE(patched(56, 7 << 3 | 5)) << "descType, 8 channels";
+    EXPECT_FALSE(patched(60, 0)) << "descCols";
+    EXPECT_TRUE(FingerprintDelta::decode(wire.data(), wire.size(), out));
+}
+
+TEST(FingerprintDeltaTest, GuestThatSelfGrewRemapsMovesAndAppends) {
+    Wall w;
+    w.append(10, 1.f);
+    Guest g;
+    ASSERT_EQ(g.apply(w.since(true, 0).encode()), nullptr);
+    expectMirrors(w, g);
+    const uint64_t localEpoch = g.epoch;
+
+    // The guest's own self-grow lands after the sender's rows, so the next appends do not.
+    g.selfGrow(3);
+    const uint64_t base = w.gen;
+    w.move({1, 9}, 0.25f);
+    w.append(2, 2.f);
+    ASSERT_EQ(g.apply(w.since(false, base).encode()), nullptr);
+    EXPECT_EQ(g.epoch, localEpoch);
+    EXPECT_EQ(g.pts.size(), 15u);
+    EXPECT_EQ(g.peer.rowMap[10], 13u);
+    EXPECT_EQ(g.peer.rowMap[11], 14u);
+    expectMirrors(w, g);
+    EXPECT_TRUE(g.peer.holds(g.epoch));
+    EXPECT_EQ(g.peer.gen, w.gen);
+
+    // A move of a row the sender appended after install goes through the map, not row for row.
+    g.selfGrow(1);
+    const uint64_t base2 = w.gen;
+    w.move({11}, -0.5f);
+    w.append(1, 3.f);
+    ASSERT_EQ(g.apply(w.since(false, base2).encode()), nullptr);
+    EXPECT_EQ(g.peer.rowMap[12], 16u);
+    expectMirrors(w, g);
+    EXPECT_EQ(g.pts[15].x, -1.f) << "the guest's own rows are untouched";
+}
+
+TEST(FingerprintDeltaTest, PeerRefusesWhatItsBaseCannotTake) {
+    Wall w;
+    w.append(8, 1.f);
+    Guest g;
+    ASSERT_EQ(g.apply(w.since(true, 0).encode()), nullptr);
+    const uint64_t base = w.gen;
+    w.move({3}, 0.1f);
+    w.append(2, 2.f);
+    const FingerprintDelta good = w.since(false, base);
+    std::vector<uint32_t> moved;
+    auto check = [&](const FingerprintDelta& d) {
+        return g.peer.check(d, g.epoch, g.pts.size(), CV_32F, 4, moved);
+    };
+    ASSERT_EQ(check(good), nullptr);
+    EXPECT_EQ(moved, std::vector<uint32_t>({3}));
+
+    FingerprintDelta d = good;
+    d.baseGen = base - 1;
+    EXPECT_STREQ(check(d), "base mismatch");
+    d = good;
+    d.epoch = w.epoch + 1;
+    EXPECT_STREQ(check(d), "base mismatch");
+    EXPECT_STREQ(g.peer.check(good, g.epoch + 1, g.pts.size(), CV_32F, 4, moved), "base mismatch")
+        << "the local wall was replaced since install";
+    d = good;
+    d.baseRows = 7;
+    EXPECT_STREQ(check(d), "row count mismatch");
+    d = good;
+    d.removed = {2};
+    EXPECT_STREQ(check(d), "removals");
+    EXPECT_STREQ(g.peer.check(good, g.epoch, g.pts.size(), CV_8U, 32, moved), "descriptor shape");
+    EXPECT_STREQ(g.peer.check(good, g.epoch, FingerprintDelta::kMaxRows - 1, CV_32F, 4, moved), "too large");
+    d = good;
+    d.movedRows = {8};
+    EXPECT_STREQ(check(d), "moved row out of range");
+    EXPECT_STREQ(g.peer.check(good, g.epoch, 3, CV_32F, 4, moved), "moved row out of range")
+        << "mapped past the local wall";
+    FingerprintDelta empty;
+    empty.flags = FingerprintDelta::kFull;
+    EXPECT_STREQ(check(empty), "empty");
+
+    // A refusal leaves no base, so the next request is for a full record; a full one recovers.
+    EXPECT_STREQ(g.apply(d.encode()), "moved row out of range");
+    EXPECT_FALSE(g.peer.holds(g.epoch));
+    EXPECT_STREQ(g.apply(good.encode()), "base mismatch");
+    ASSERT_EQ(g.apply(w.since(true, 0).encode()), nullptr);
+    expectMirrors(w, g);
+}
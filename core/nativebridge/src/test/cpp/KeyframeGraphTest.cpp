@@ -0,0 +1,137 @@
+#include "KeyframeGraph.h"
+#include <gtest/gtest.h>
+#include <algorithm>
+
+namespace {
+
+// Column-major camFromFp: a rotation of [yawDeg] about y, camera centre at (cx, cy, cz).
+std::vector<float> pose(float cx, float cy, float cz, float yawDeg = 0.0f) {
+    const float a = yawDeg * (float)CV_PI / 180.0f, cs = std::cos(a), sn = std::sin(a);
+    // R (row-major) = [cs 0 sn; 0 1 0; -sn 0 cs]; t = -R c.
+    const float R[9] = {cs, 0, sn, 0, 1, 0, -sn, 0, cs};
+    const float c[3] = {cx, cy, cz};
+    std::vector<float> m(16, 0.0f);
+    for (int r = 0; r < 3; ++r) {
+        for (int k = 0; k < 3; ++k) m[k * 4 + r] = R[r * 3 + k];
+        m[12 + r] = -(R[r * 3] * c[0] + R[r * 3 + 1] * c[1] + R[r * 3 + 2] * c[2]);
+    }
+    m[15] = 1.0f;
+    return m;
+}
+
+// A unit 1 x 4 global descriptor along [axis].
+cv::Mat unitGlobal(int axis) {
+    cv::Mat g = cv::Mat::zeros(1, 4, CV_32F);
+    g.at<float>(0, axis) = 1.0f;
+    return g;
+}
+
+std::vector<uint32_t> sorted(std::vector<uint32_t> v) {
+    std::sort(v.begin(), v.end());
+    return v;
+}
+
+}  // namespace
+
+TEST(KeyframeGraphTest, GlobalDescriptorIsTheUnitMean) {
+    cv::Mat f(2, 3, CV_32F);
+    const float vals[6] = {1, 0, 0, 0, 1, 0};
+    memcpy(f.data, vals, sizeof(vals));
+    const cv::Mat g = KeyframeGraph::globalDescriptor(f);
+    ASSERT_EQ(g.cols, 3);
+    EXPECT_NEAR(g.at<float>(0, 0), std::sqrt(0.5f), 1e-6f);
+    EXPECT_NEAR(g.at<float>(0, 1), std::sqrt(0.5f), 1e-6f);
+    EXPECT_NEAR(g.at<float>(0, 2), 0.0f, 1e-6f);
+
+    // ORB bits read as +-1: 0xF0 in every byte is (+1 x4, -1 x4) per byte, so unit = +-1/sqrt(256).
+    const cv::Mat orb(5, 32, CV_8U, cv::Scalar(0xF0));
+    const cv::Mat go = KeyframeGraph::globalDescriptor(orb);
+    ASSERT_EQ(go.cols, 256);
+    EXPECT_NEAR(go.at<float>(0, 0), 1.0f / 16.0f, 1e-6f);
+    EXPECT_NEAR(go.at<float>(0, 7), -1.0f / 16.0f, 1e-6f);
+    EXPECT_NEAR(cv::norm(go), 1.0, 1e-5);
+
+    EXPECT_TRUE(KeyframeGraph::globalDescriptor(cv::Mat()).empty());
+    EXPECT_TRUE(KeyframeGraph::globalDescriptor(cv::Mat::zeros(3, 4, CV_32F)).empty());
+    EXPECT_TRUE(KeyframeGraph::globalDescriptor(cv::Mat::zeros(3, 4, CV_32S)).empty());
+}
+
+TEST(KeyframeGraphTest, CovisibilityCountsSharedPointsBothWays) {
+    KeyframeGraph g;
+    const auto p = pose(0, 0, 0);
+    EXPECT_EQ(g.add(p.data(), unitGlobal(0), {1, 2, 3, 4}), 0u);
+    EXPECT_EQ(g.add(p.data(), unitGlobal(1), {3, 4, 5}), 1u);
+    EXPECT_EQ(g.add(p.data(), unitGlobal(2), {9}), 2u);
+    EXPECT_EQ(g.size(), 3u);
+
+    // Retrieval by a's descriptor with one neighbour brings in b (two shared points), not c.
+    std::vector<uint32_t> out;
+    g.retrieve(unitGlobal(0), 1, 1, out);
+    EXPECT_EQ(sorted(out), std::vector<uint32_t>({1, 2, 3, 4, 5}));
+    // Without neighbours, a alone.
+    g.retrieve(unitGlobal(0), 1, 0, out);
+    EXPECT_EQ(sorted(out), std::vector<uint32_t>({1, 2, 3, 4}));
+    // From b's side the edge is the same one.
+    g.retrieve(unitGlobal(1), 1, 1, out);
+    EXPECT_EQ(sorted(out), std::vector<uint32_t>({1, 2, 3, 4, 5}));
+}
+
+TEST(KeyframeGraphTest, RetrieveRanksBySimilarityAndSkipsNonPositive) {
+    KeyframeGraph g;
+    const auto p = pose(0, 0, 0);
+    g.add(p.data(), unitGlobal(0), {10});
+    g.add(p.data(), unitGlobal(1), {11});
+    g.add(p.data(), unitGlobal(0) * -1.0, {12});
+
+    cv::Mat q = cv::Mat::zeros(1, 4, CV_32F);
+    q.at<float>(0, 0) = 0.8f;
+    q.at<float>(0, 1) = 0.6f;
+    std::vector<uint32_t> out;
+    g.retrieve(q, 1, 0, out);
+    EXPECT_EQ(out, std::vector<uint32_t>({10}));
+    g.retrieve(q, 5, 0, out);
+    EXPECT_EQ(sorted(out), std::vector<uint32_t>({10, 11}));   // the opposite view never scores
+
+    g.retrieve(cv::Mat::zeros(1, 8, CV_32F), 5, 0, out);        // width mismatch: nothing
+    EXPECT_TRUE(out.empty());
+}
+
+TEST(KeyframeGraphTest, RemoveOldestAndForgetPointUnlink) {
+    KeyframeGraph g;
+    const auto p = pose(0, 0, 0);
+    g.add(p.data(), unitGlobal(0), {1, 2});
+    g.add(p.data(), unitGlobal(1), {2, 3});
+    g.removeOldest();
+    EXPECT_EQ(g.size(), 1u);
+    std::vector<uint32_t> out;
+    g.retrieve(unitGlobal(1), 1, 4, out);
+    EXPECT_EQ(sorted(out), std::vector<uint32_t>({2, 3}));   // no edge left to the removed frame
+
+    // Point 3 is pruned: a new keyframe seeing it is not linked through it.
+    g.forgetPoint(3);
+    g.add(p.data(), unitGlobal(2), {3, 7});
+    g.retrieve(unitGlobal(2), 1, 4, out);
+    EXPECT_EQ(sorted(out), std::vector<uint32_t>({3, 7}));
+    // Point 2 still links them.
+    g.add(p.data(), unitGlobal(3), {2});
+    g.retrieve(unitGlobal(3), 1, 4, out);
+    EXPECT_EQ(sorted(out), std::vector<uint32_t>({2, 3}));
+
+    g.clear();
+    EXPECT_EQ(g.size(), 0u);
+    g.removeOldest();   // no-op on empty
+}
+
+TEST(KeyframeGraphTest, HasNearbyChecksCentreAndRotation) {
+    KeyframeGraph g;
+    const auto base = pose(1.0f, 0.5f, -2.0f, 10.0f);
+    g.add(base.data(), unitGlobal(0), {});
+
+    const auto close = pose(1.05f, 0.5f, -2.0f, 12.0f);
+    const auto far = pose(1.5f, 0.5f, -2.0f, 10.0f);
+    const auto turned = pose(1.0f, 0.5f, -2.0f, 40.0f);
+    EXPECT_TRUE(g.hasNearby(close.data(), 0.1f, 5.0f));
+    EXPECT_FALSE(g.hasNearby(far.data(), 0.1f, 5.0f));
+    EXPECT_FALSE(g.hasNearby(turned.data(), 0.1f, 5.0f));
+    EXPECT_TRUE(g.hasNearby(turned.data(), 0.1f, 31.0f));
+}
@@ -0,0 +1,90 @@
+#include "PlaneModel.h"
+#include <gtest/gtest.h>
+#include <limits>
+#include <random>
+
+namespace {
+
+// Points on the plane n·x = d, spread over a 2 m x 2 m patch, displaced along n by N(0, sigma).
+std::vector<cv::Point3f> planePoints(const cv::Vec3d& n, double d, size_t count, double sigma, uint32_t seed) {
+    std::mt19937 rng(seed);
+    std::uniform_real_distribution<double> u(-1.0, 1.0);
+    std::normal_distribution<double> g(0.0, sigma > 0.0 ? sigma : 1.0);
+    // Two axes spanning the plane.
+    const cv::Vec3d a = std::abs(n[0]) < 0.9 ? cv::Vec3d(1, 0, 0) : cv::Vec3d(0, 1, 0);
+    cv::Vec3d e1 = a - n * n.dot(a);
+    e1 /= cv::norm(e1);
+    const cv::Vec3d e2 = n.cross(e1);
+    std::vector<cv::Point3f> pts;
+    for (size_t i = 0; i < count; ++i) {
+        const cv::Vec3d p = n * (d + (sigma > 0.0 ? g(rng) : 0.0)) + e1 * u(rng) + e2 * u(rng);
+        pts.emplace_back((float)p[0], (float)p[1], (float)p[2]);
+    }
+    return pts;
+}
+
+const cv::Vec3d kNormal = [] { cv::Vec3d n(0.2, -0.1, 1.0); return n / cv::norm(n); }();
+
+}  // namespace
+
+TEST(PlaneModelTest, FitsAnExactPlane) {
+    PlaneModel model;
+    model.rebuild(planePoints(kNormal, 2.0, 200, 0.0, 1));
+    const WallPlane& p = model.plane();
+    ASSERT_TRUE(p.valid);
+    EXPECT_EQ(p.count, 200u);
+    EXPECT_NEAR(std::abs(p.normal.dot(kNormal)), 1.0, 1e-6);
+    EXPECT_NEAR(p.offset, 2.0, 1e-4);
+    EXPECT_NEAR(p.normal.dot(p.centroid), p.offset, 1e-9);
+    EXPECT_LT(p.rms, 1e-4);
+}
+
+TEST(PlaneModelTest, NormalIsOrientedSoOffsetIsNonNegative) {
+    PlaneModel model;
+    // The same plane described from the other side: n·x = -2 with n flipped is n·x = 2.
+    model.rebuild(planePoints(-kNormal, -2.0, 100, 0.0, 2));
+    const WallPlane& p = model.plane();
+    ASSERT_TRUE(p.valid);
+    EXPECT_GE(p.offset, 0.0);
+    EXPECT_NEAR(p.normal.dot(kNormal), 1.0, 1e-6);
+}
+
+TEST(PlaneModelTest, RmsMeasuresThickness) {
+    PlaneModel model;
+    model.rebuild(planePoints(kNormal, 1.5, 20000, 0.01, 3));
+    const WallPlane& p = model.plane();
+    ASSERT_TRUE(p.valid);
+    EXPECT_NEAR(p.rms, 0.01, 0.001);
+    EXPECT_NEAR(p.offset, 1.5, 0.001);
+}
+
+TEST(PlaneModelTest, IncrementalAddMatchesRebuild) {
+    const auto pts = planePoints(kNormal, 3.0, 300, 0.005, 4);
+    PlaneModel incremental, rebuilt;
+    incremental.rebuild(std::vector<cv::Point3f>(pts.begin(), pts.begin() + 100));
+    ASSERT_TRUE(incremental.plane().valid);   // solve once, then grow past it
+    for (size_t i = 100; i < pts.size(); ++i) incremental.add(pts[i]);
+    rebuilt.rebuild(pts);
+
+    const WallPlane& a = incremental.plane();
+    const WallPlane& b = rebuilt.plane();
+    EXPECT_EQ(a.count, b.count);
+    EXPECT_NEAR(a.normal.dot(b.normal), 1.0, 1e-9);
+    EXPECT_NEAR(a.offset, b.offset, 1e-9);
+    EXPECT_NEAR(a.rms, b.rms, 1e-9);
+}
+
+TEST(PlaneModelTest, DegenerateAndNonFiniteInputs) {
+    PlaneModel model;
+    EXPECT_FALSE(model.plane().valid);
+    const float nan = std::numeric_limits<float>::quiet_NaN();
+    model.rebuild({{0, 0, 1}, {1, 0, 1}, {nan, 0, 1}});
+    EXPECT_EQ(model.count(), 2u);
+    EXPECT_FALSE(model.plane().valid);   // two points are not a plane
+    model.add({0, 1, 1});
+    EXPECT_TRUE(model.plane().valid);
+    EXPECT_NEAR(model.plane().offset, 1.0, 1e-6);
+    model.clear();
+    EXPECT_EQ(model.count(), 0u);
+    EXPECT_FALSE(model.plane().valid);
+}
@@ -0,0 +1,24 @@
+#pragma once
+#include <gtest/gtest.h>
+#include <cstdint>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+// Scratch files for the tests of the on-disk formats (sidecar, journal).
+namespace testfiles {
+
+inline std::string tempPath(const char* name) { return ::testing::TempDir() + name; }
+
+inline std::vector<uint8_t> readBytes(const std::string& path) {
+    std::ifstream f(path, std::ios::binary);
+    return std::vector<uint8_t>(std::istreambuf_iterator<char>(f), {});
+}
+
+inline void writeBytes(const std::string& path, const std::vector<uint8_t>& b) {
+    std::ofstream f(path, std::ios::binary | std::ios::trunc);
+    f.write(reinterpret_cast<const char*>(b.data()), (std::streamsize)b.size());
+}
+
+}  // namespace testfiles
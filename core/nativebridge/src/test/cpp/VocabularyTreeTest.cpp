@@ -0,0 +1,165 @@
+#include "VocabularyTree.h"
+#include "BowIndex.h"
+#include <gtest/gtest.h>
+#include <cstring>
+
+namespace {
+
+struct Node {
+    uint32_t parent;
+    float idf;
+    std::vector<float> centroid;   // descCols values; bytes for CV_8U are taken from the low byte
+};
+
+// A GXVT asset as VocabularyTree.h lays it out.
+std::vector<uchar> asset(const std::vector<Node>& nodes, int32_t type, uint32_t cols, uint32_t branching,
+                         uint32_t depth, const char* magic = "GXVT", uint32_t version = 1) {
+    std::vector<uchar> out;
+    auto put = [&](const void* p, size_t n) {
+        const uchar* b = static_cast<const uchar*>(p);
+        out.insert(out.end(), b, b + n);
+    };
+    const uint32_t count = (uint32_t)nodes.size();
+    put(magic, 4);
+    put(&version, 4); put(&branching, 4); put(&depth, 4); put(&type, 4); put(&cols, 4); put(&count, 4);
+    for (const Node& n : nodes) {
+        put(&n.parent, 4);
+        put(&n.idf, 4);
+        for (uint32_t c = 0; c < cols; ++c) {
+            const float v = c < n.centroid.size() ? n.centroid[c] : 0.0f;
+            if (type == CV_32F) {
+                put(&v, 4);
+            } else {
+                const uchar b = (uchar)v;
+                put(&b, 1);
+            }
+        }
+    }
+    return out;
+}
+
+constexpr uint32_t kRoot = 0xFFFFFFFFu;
+
+// Two levels, two branches, 2-D float centroids: words 0..3 are the quadrants (-,-) (-,+) (+,-) (+,+).
+std::vector<Node> quadrantTree() {
+    return {
+        {kRoot, 0.f, {0, 0}},
+        {0, 0.f, {-1, 0}}, {0, 0.f, {1, 0}},
+        {1, 0.5f, {-1, -1}}, {1, 0.6f, {-1, 1}},
+        {2, 0.7f, {1, -1}}, {2, 0.8f, {1, 1}},
+    };
+}
+
+cv::Mat floatRows(std::initializer_list<std::pair<float, float>> rows) {
+    cv::Mat m((int)rows.size(), 2, CV_32F);
+    int r = 0;
+    for (const auto& p : rows) { m.at<float>(r, 0) = p.first; m.at<float>(r, 1) = p.second; ++r; }
+    return m;
+}
+
+}  // namespace
+
+TEST(VocabularyTreeTest, QuantizesToLeafWordAndDirectNode) {
+    VocabularyTree voc;
+    ASSERT_TRUE(voc.load(asset(quadrantTree(), CV_32F, 2, 2, 2)));
+    EXPECT_TRUE(voc.isLoaded());
+    EXPECT_EQ(voc.wordCount(), 4u);
+    EXPECT_EQ(voc.descType(), CV_32F);
+    EXPECT_EQ(voc.descCols(), 2);
+    EXPECT_FLOAT_EQ(voc.idf(1), 0.6f);
+    EXPECT_FLOAT_EQ(voc.idf(99), 0.0f);
+
+    std::vector<uint32_t> words, nodes;
+    voc.quantize(floatRows({{-0.9f, 0.8f}, {0.7f, -0.6f}, {2.f, 3.f}}), words, nodes);
+    EXPECT_EQ(words, std::vector<uint32_t>({1, 2, 3}));
+    // depth 2 - kDirectLevelsUp clamps to level 1: the first split.
+    EXPECT_EQ(nodes, std::vector<uint32_t>({1, 2, 2}));
+}
+
+TEST(VocabularyTreeTest, BinaryTreeUsesHamming) {
+    // One byte per descriptor: 0x00 and 0xFF at level 1, leaves below each.
+    const std::vector<Node> nodes = {
+        {kRoot, 0.f, {0}},
+        {0, 0.f, {0x00}}, {0, 0.f, {0xFF}},
+        {1, 1.f, {0x00}}, {1, 1.f, {0x03}},
+        {2, 1.f, {0xFF}}, {2, 1.f, {0xFC}},
+    };
+    VocabularyTree voc;
+    ASSERT_TRUE(voc.load(asset(nodes, CV_8U, 1, 2, 2)));
+    cv::Mat d(3, 1, CV_8U);
+    d.at<uchar>(0, 0) = 0x01;   // 1 bit from both 0x00 and 0x03: the tie goes to the first leaf
+    d.at<uchar>(1, 0) = 0x07;   // 1 bit from 0x03
+    d.at<uchar>(2, 0) = 0xF8;   // 1 bit from 0xFC
+    std::vector<uint32_t> words, dn;
+    voc.quantize(d, words, dn);
+    EXPECT_EQ(words, std::vector<uint32_t>({0, 1, 3}));
+    EXPECT_EQ(dn, std::vector<uint32_t>({1, 1, 2}));
+}
+
+TEST(VocabularyTreeTest, IncompatibleInputQuantizesToNothing) {
+    VocabularyTree voc;
+    ASSERT_TRUE(voc.load(asset(quadrantTree(), CV_32F, 2, 2, 2)));
+    std::vector<uint32_t> words{7}, nodes{7};
+    voc.quantize(cv::Mat(2, 3, CV_32F, cv::Scalar(0)), words, nodes);
+    EXPECT_TRUE(words.empty());
+    EXPECT_TRUE(nodes.empty());
+    EXPECT_FALSE(voc.compatible(cv::Mat(2, 2, CV_8U, cv::Scalar(0))));
+    EXPECT_FALSE(voc.compatible(cv::Mat()));
+}
+
+TEST(VocabularyTreeTest, LoadRejectsMalformedAssets) {
+    const auto good = asset(quadrantTree(), CV_32F, 2, 2, 2);
+    VocabularyTree voc;
+
+    EXPECT_FALSE(voc.load(asset(quadrantTree(), CV_32F, 2, 2, 2, "GXVX")));
+    EXPECT_FALSE(voc.load(asset(quadrantTree(), CV_32F, 2, 2, 2, "GXVT", 2)));
+    EXPECT_FALSE(voc.load(asset(quadrantTree(), CV_32S, 2, 2, 2)));
+    EXPECT_FALSE(voc.load(asset(quadrantTree(), CV_32F, 2, 1, 2)));    // branching < 2
+    EXPECT_FALSE(voc.load(asset(quadrantTree(), CV_32F, 2, 2, 1)));    // leaves deeper than declared
+
+    // Truncated by one byte, and one byte too long.
+    std::vector<uchar> bytes(good.begin(), good.end() - 1);
+    EXPECT_FALSE(voc.load(bytes));
+    bytes = good;
+    bytes.push_back(0);
+    EXPECT_FALSE(voc.load(bytes));
+    EXPECT_FALSE(voc.load({}));
+
+    auto nodes = quadrantTree();
+    nodes[0].parent = 0;                  // node 0 is not the root
+    EXPECT_FALSE(voc.load(asset(nodes, CV_32F, 2, 2, 2)));
+    nodes = quadrantTree();
+    nodes[3].parent = 5;                  // a child before its parent
+    EXPECT_FALSE(voc.load(asset(nodes, CV_32F, 2, 2, 2)));
+
+    // A refused load leaves the tree unloaded, even after a good one.
+    ASSERT_TRUE(voc.load(good));
+    EXPECT_FALSE(voc.load(bytes));
+    EXPECT_FALSE(voc.isLoaded());
+    EXPECT_EQ(voc.wordCount(), 0u);
+}
+
+TEST(BowIndexTest, AddRemoveKeepsBothListsInStep) {
+    BowIndex idx;
+    idx.add(10, 1, 100);
+    idx.add(11, 1, 101);
+    idx.add(12, 2, 100);
+    idx.add(10, 3, 103);   // already filed: ignored
+    EXPECT_EQ(idx.size(), 3u);
+    ASSERT_NE(idx.wordEntities(1), nullptr);
+    EXPECT_EQ(*idx.wordEntities(1), std::vector<uint32_t>({10, 11}));
+    EXPECT_EQ(*idx.nodeEntities(100), std::vector<uint32_t>({10, 12}));
+    EXPECT_EQ(idx.wordEntities(3), nullptr);
+
+    idx.remove(10);
+    EXPECT_EQ(*idx.wordEntities(1), std::vector<uint32_t>({11}));
+    EXPECT_EQ(*idx.nodeEntities(100), std::vector<uint32_t>({12}));
+    idx.remove(11);
+    EXPECT_EQ(idx.wordEntities(1), nullptr);   // emptied lists are dropped
+    EXPECT_EQ(idx.nodeEntities(101), nullptr);
+    idx.remove(99);
+    EXPECT_EQ(idx.size(), 1u);
+    idx.clear();
+    EXPECT_EQ(idx.size(), 0u);
+    EXPECT_EQ(idx.nodeEntities(100), nullptr);
+}
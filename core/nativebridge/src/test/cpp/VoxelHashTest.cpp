@@ -0,0 +1,102 @@
+#include "VoxelHash.h"
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <limits>
+#include <random>
+
+namespace {
+
+std::vector<cv::Point3f> randomPoints(size_t n, float lo, float hi, uint32_t seed) {
+    std::mt19937 rng(seed);
+    std::uniform_real_distribution<float> u(lo, hi);
+    std::vector<cv::Point3f> pts(n);
+    for (auto& p : pts) p = cv::Point3f(u(rng), u(rng), u(rng));
+    return pts;
+}
+
+bool inBox(const cv::Point3f& p, const cv::Point3f& c, float r) {
+    return std::abs(p.x - c.x) <= r && std::abs(p.y - c.y) <= r && std::abs(p.z - c.z) <= r;
+}
+
+}  // namespace
+
+TEST(VoxelHashTest, QueryBoxReturnsEveryPointInsideTheBox) {
+    // Straddles zero on every axis, so negative cells (floor, not truncation) are exercised.
+    const auto pts = randomPoints(2000, -2.0f, 2.0f, 7);
+    VoxelHash hash(0.25f);
+    hash.rebuild(pts);
+
+    std::mt19937 rng(11);
+    std::uniform_real_distribution<float> u(-2.5f, 2.5f), ur(0.0f, 0.6f);
+    std::vector<int> out;
+    for (int q = 0; q < 200; ++q) {
+        const cv::Point3f c(u(rng), u(rng), u(rng));
+        const float r = ur(rng);
+        hash.queryBox(c, r, out);
+        std::vector<int> sorted = out;
+        std::sort(sorted.begin(), sorted.end());
+        EXPECT_EQ(std::adjacent_find(sorted.begin(), sorted.end()), sorted.end()) << "duplicate index";
+        for (int i = 0; i < (int)pts.size(); ++i) {
+            if (inBox(pts[(size_t)i], c, r)) {
+                EXPECT_TRUE(std::binary_search(sorted.begin(), sorted.end(), i)) << "missed point " << i;
+            }
+        }
+    }
+}
+
+TEST(VoxelHashTest, InsertAfterRebuildIsFound) {
+    auto pts = randomPoints(100, 0.0f, 1.0f, 3);
+    VoxelHash hash(0.1f);
+    hash.rebuild(pts);
+    pts.emplace_back(-3.05f, 0.5f, 0.5f);
+    hash.insert((int)pts.size() - 1, pts.back());
+
+    std::vector<int> out;
+    hash.queryBox(pts.back(), 0.01f, out);
+    EXPECT_NE(std::find(out.begin(), out.end(), (int)pts.size() - 1), out.end());
+}
+
+TEST(VoxelHashTest, NonFinitePointsAreNotIndexedOrQueried) {
+    const float nan = std::numeric_limits<float>::quiet_NaN();
+    const float inf = std::numeric_limits<float>::infinity();
+    VoxelHash hash(0.25f);
+    hash.rebuild({{nan, 0, 0}, {0, inf, 0}, {0.1f, 0.1f, 0.1f}});
+    EXPECT_EQ(hash.cellCount(), 1u);
+
+    std::vector<int> out;
+    hash.queryBox({0, 0, 0}, 1.0f, out);
+    EXPECT_EQ(out, std::vector<int>({2}));
+    hash.queryBox({nan, 0, 0}, 1.0f, out);
+    EXPECT_TRUE(out.empty());
+    hash.queryBox({0, 0, 0}, nan, out);
+    EXPECT_TRUE(out.empty());
+}
+
+TEST(VoxelHashTest, ForEachCellCoversEveryPointWithinItsSphere) {
+    const auto pts = randomPoints(500, -1.0f, 1.0f, 5);
+    VoxelHash hash(0.2f);
+    hash.rebuild(pts);
+
+    size_t seen = 0, cells = 0;
+    hash.forEachCell([&](const cv::Point3f& centre, float radius, const std::vector<int>& idx) {
+        ++cells;
+        for (int i : idx) {
+            const cv::Point3f d = pts[(size_t)i] - centre;
+            EXPECT_LE(std::sqrt(d.dot(d)), radius + 1e-5f);
+            ++seen;
+        }
+    });
+    EXPECT_EQ(cells, hash.cellCount());
+    EXPECT_EQ(seen, pts.size());
+}
+
+TEST(VoxelHashTest, ClearEmptiesAndBadCellSizeFallsBack) {
+    VoxelHash hash(-1.0f);
+    EXPECT_FLOAT_EQ(hash.cellSize(), 0.25f);
+    hash.rebuild(randomPoints(10, 0.0f, 1.0f, 1));
+    hash.clear();
+    EXPECT_EQ(hash.cellCount(), 0u);
+    std::vector<int> out{1, 2, 3};
+    hash.queryBox({0.5f, 0.5f, 0.5f}, 1.0f, out);
+    EXPECT_TRUE(out.empty());
+}
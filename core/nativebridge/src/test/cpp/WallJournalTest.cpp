@@ -0,0 +1,289 @@
+#include "WallJournal.h"
+#include "TestFiles.h"
+#include <gtest/gtest.h>
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <unordered_map>
+#include <unordered_set>
+
+namespace {
+
+using namespace testfiles;
+
+cv::Mat descRow(std::mt19937& rng) {
+    cv::Mat m(1, 32, CV_8U);
+    for (int c = 0; c < 32; ++c) m.at<uchar>(0, c) = (uchar)rng();
+    return m;
+}
+
+// The engine's map and wall columns, and its recording of them, cut down to what the journal sees:
+// adds and swap-removes queue in order, other changes mark the point's ID, and a batch ends with one
+// set per marked survivor at its row as of then. The wall records append and move generations.
+struct Engine {
+    std::vector<cv::Point3f> pts;
+    std::vector<float> conf;
+    std::vector<int32_t> obs;
+    std::vector<cv::Mat> descs;
+    std::vector<uint32_t> ids;
+    std::unordered_map<uint32_t, size_t> idToIndex;
+    uint32_t nextId = 1;
+
+    std::vector<cv::Point3f> wallPts;
+    cv::Mat wallDescs;
+    std::vector<uint64_t> addGen, moveGen;
+    uint64_t gen = 1, journalGen = 1;
+
+    WallJournal::Batch pending;
+    std::unordered_set<uint32_t> dirty;
+
+    void add(const cv::Point3f& p, const cv::Mat& d) {
+        pts.push_back(p); conf.push_back(0.1f); obs.push_back(1); descs.push_back(d.clone());
+        ids.push_back(nextId); idToIndex[nextId++] = pts.size() - 1;
+        pending.map.push_back({WallJournal::kMapAdd, 0, p, 0.1f, 1});
+        pending.mapAdded.push_back(d);
+    }
+    void remove(size_t i) {
+        pending.map.push_back({WallJournal::kMapRemove, (uint32_t)i, {}, 0.f, 0});
+        idToIndex.erase(ids[i]);
+        const size_t last = pts.size() - 1;
+        if (i != last) {
+            pts[i] = pts[last]; conf[i] = conf[last]; obs[i] = obs[last]; descs[i] = descs[last]; ids[i] = ids[last];
+            idToIndex[ids[i]] = i;
+        }
+        pts.pop_back(); conf.pop_back(); obs.pop_back(); descs.pop_back(); ids.pop_back();
+    }
+    void observe(size_t i, const cv::Point3f& p) {
+        pts[i] = p; conf[i] += 0.05f; ++obs[i];
+        dirty.insert(ids[i]);
+    }
+    void growWall(const cv::Point3f& p, const cv::Mat& d) {
+        ++gen;
+        wallPts.push_back(p); wallDescs.push_back(d); addGen.push_back(gen); moveGen.push_back(0);
+    }
+    void refineWall(size_t row, const cv::Point3f& p) {
+        wallPts[row] = p;
+        moveGen[row] = ++gen;
+    }
+    WallJournal::Batch take() {
+        WallJournal::Batch b = std::move(pending);
+        pending.clear();
+        for (uint32_t id : dirty) {
+            auto it = idToIndex.find(id);
+            if (it == idToIndex.end()) continue;
+            const size_t i = it->second;
+            b.map.push_back({WallJournal::kMapSet, (uint32_t)i, pts[i], conf[i], obs[i]});
+        }
+        dirty.clear();
+        if (gen != journalGen) {
+            b.wall = FingerprintDelta::since(0, gen, false, journalGen, wallPts, wallDescs, {}, addGen, moveGen);
+            b.hasWall = true;
+            journalGen = gen;
+        }
+        return b;
+    }
+};
+
+// What a load does with a batch: the wall's moves and appends, then the map records in order.
+void replay(const WallJournal::Batch& b, Engine& e) {
+    if (b.hasWall) {
+        ASSERT_EQ(b.wall.baseRows, e.wallPts.size());
+        for (size_t k = 0; k < b.wall.movedRows.size(); ++k) e.wallPts[b.wall.movedRows[k]] = b.wall.movedPts[k];
+        for (size_t k = 0; k < b.wall.appendedPts.size(); ++k) {
+            e.wallPts.push_back(b.wall.appendedPts[k]);
+            e.wallDescs.push_back(b.wall.appendedDescs.row((int)k));
+        }
+    }
+    int added = 0;
+    for (const WallJournal::MapRecord& r : b.map) {
+        if (r.op == WallJournal::kMapAdd) {
+            e.pts.push_back(r.pt); e.conf.push_back(r.conf); e.obs.push_back(r.obs);
+            e.descs.push_back(b.mapAdded.row(added++).clone());
+            e.ids.push_back(0);
+        } else if (r.op == WallJournal::kMapRemove) {
+            ASSERT_LT(r.row, e.pts.size());
+            const size_t last = e.pts.size() - 1;
+            e.pts[r.row] = e.pts[last]; e.conf[r.row] = e.conf[last]; e.obs[r.row] = e.obs[last];
+            e.descs[r.row] = e.descs[last];
+            e.pts.pop_back(); e.conf.pop_back(); e.obs.pop_back(); e.descs.pop_back(); e.ids.pop_back();
+        } else {
+            ASSERT_LT(r.row, e.pts.size());
+            e.pts[r.row] = r.pt; e.conf[r.row] = r.conf; e.obs[r.row] = r.obs;
+        }
+    }
+}
+
+void expectSameState(const Engine& a, const Engine& b) {
+    ASSERT_EQ(a.pts.size(), b.pts.size());
+    for (size_t i = 0; i < a.pts.size(); ++i) {
+        EXPECT_EQ(a.pts[i], b.pts[i]) << "map row " << i;
+        EXPECT_EQ(a.conf[i], b.conf[i]) << "map row " << i;
+        EXPECT_EQ(a.obs[i], b.obs[i]) << "map row " << i;
+        EXPECT_EQ(0, memcmp(a.descs[i].data, b.descs[i].data, 32)) << "map row " << i;
+    }
+    ASSERT_EQ(a.wallPts.size(), b.wallPts.size());
+    for (size_t i = 0; i < a.wallPts.size(); ++i) EXPECT_EQ(a.wallPts[i], b.wallPts[i]) << "wall row " << i;
+    ASSERT_EQ(a.wallDescs.rows, b.wallDescs.rows);
+    if (a.wallDescs.rows > 0) EXPECT_EQ(0, memcmp(a.wallDescs.data, b.wallDescs.data, a.wallDescs.total()));
+}
+
+// A base of 30 map points and a 10-mark wall, journaled from that state on.
+Engine base(std::mt19937& rng) {
+    Engine e;
+    for (int i = 0; i < 30; ++i) e.add({0.1f * i, 0.f, 1.f}, descRow(rng));
+    for (int i = 0; i < 10; ++i) e.growWall({0.f, 0.1f * i, 1.f}, descRow(rng));
+    e.pending.clear();
+    e.journalGen = e.gen;
+    return e;
+}
+
+// Three autosaves' worth of adds, prunes, re-observations and wall growth and refinement, each
+// appended as the engine would. The file's size after the last append goes to [bytes].
+void recordThreeBatches(Engine& live, std::mt19937& rng, const std::string& path, uint64_t& bytes) {
+    for (int batch = 0; batch < 3; ++batch) {
+        for (int k = 0; k < 6; ++k) live.add({1.f + batch, 0.2f * k, 1.f}, descRow(rng));
+        live.remove((size_t)(rng() % live.pts.size()));
+        live.remove(live.pts.size() - 1);
+        for (int k = 0; k < 5; ++k) live.observe((size_t)(rng() % live.pts.size()), {(float)k, (float)batch, 2.f});
+        live.add({9.f, 9.f, (float)batch}, descRow(rng));
+        live.observe(live.pts.size() - 1, {8.f, 8.f, 8.f});   // added and then changed in one batch
+        live.growWall({0.5f, 0.5f, (float)batch}, descRow(rng));
+        live.refineWall((size_t)batch, {-1.f, (float)batch, 1.f});
+        ASSERT_TRUE(WallJournal::append(path, live.take(), bytes));
+    }
+}
+
+const WallSidecar::Stamp kBase{0x1234abcdu, 4096};
+
+}  // namespace
+
+TEST(WallJournalTest, ReplayedBatchesReproduceTheLiveState) {
+    std::mt19937 rng(1);
+    const std::string path = tempPath("replay.gxwj");
+    Engine live = base(rng);
+    Engine restored = live;
+    ASSERT_TRUE(WallJournal::start(path, kBase));
+    uint64_t bytes = 0;
+    recordThreeBatches(live, rng, path, bytes);
+    EXPECT_EQ(bytes, readBytes(path).size());
+
+    std::vector<WallJournal::Batch> batches;
+    ASSERT_TRUE(WallJournal::read(path, kBase, batches));
+    ASSERT_EQ(batches.size(), 3u);
+    for (const auto& b : batches) {
+        EXPECT_TRUE(b.hasWall);
+        replay(b, restored);
+    }
+    expectSameState(live, restored);
+    std::remove(path.c_str());
+}
+
+TEST(WallJournalTest, TornTailIsCutOffAndTheNextAppendFollowsTheLastWholeBatch) {
+    std::mt19937 rng(2);
+    const std::string path = tempPath("torn.gxwj");
+    Engine live = base(rng);
+    Engine restored = live;
+    ASSERT_TRUE(WallJournal::start(path, kBase));
+    uint64_t bytes = 0;
+    recordThreeBatches(live, rng, path, bytes);
+
+    // A fourth batch the kill cut short: its frame and half its payload.
+    Engine lost = live;
+    lost.add({7.f, 7.f, 7.f}, descRow(rng));
+    uint64_t whole = 0;
+    ASSERT_TRUE(WallJournal::append(path, lost.take(), whole));
+    std::vector<uint8_t> file = readBytes(path);
+    file.resize(bytes + (whole - bytes) / 2);
+    writeBytes(path, file);
+
+    std::vector<WallJournal::Batch> batches;
+    ASSERT_TRUE(WallJournal::read(path, kBase, batches));
+    ASSERT_EQ(batches.size(), 3u);
+    EXPECT_EQ(readBytes(path).size(), bytes) << "truncated to the last whole batch";
+    for (const auto& b : batches) replay(b, restored);
+    expectSameState(live, restored);
+
+    // Recording resumes from the live state the three batches reproduce.
+    live.add({6.f, 6.f, 6.f}, descRow(rng));
+    live.observe(0, {5.f, 5.f, 5.f});
+    const uint64_t fourth = bytes;
+    ASSERT_TRUE(WallJournal::append(path, live.take(), bytes));
+    ASSERT_TRUE(WallJournal::read(path, kBase, batches));
+    ASSERT_EQ(batches.size(), 4u);
+    replay(batches.back(), restored);
+    expectSameState(live, restored);
+
+    // A whole frame whose payload fails its checksum is dropped the same way: the fourth batch
+    // again, one payload bit flipped.
+    file = readBytes(path);
+    const size_t good = file.size();
+    const std::vector<uint8_t> frame(file.begin() + (long)fourth, file.end());
+    file.insert(file.end(), frame.begin(), frame.end());
+    file.back() ^= 0x01;
+    writeBytes(path, file);
+    ASSERT_TRUE(WallJournal::read(path, kBase, batches));
+    EXPECT_EQ(batches.size(), 4u);
+    EXPECT_EQ(readBytes(path).size(), good);
+    std::remove(path.c_str());
+}
+
+TEST(WallJournalTest, JournalOnAnotherSidecarIsIgnored) {
+    std::mt19937 rng(3);
+    const std::string path = tempPath("stale.gxwj");
+    Engine live = base(rng);
+    ASSERT_TRUE(WallJournal::start(path, kBase));
+    uint64_t bytes = 0;
+    recordThreeBatches(live, rng, path, bytes);
+
+    std::vector<WallJournal::Batch> batches;
+    EXPECT_FALSE(WallJournal::read(path, WallSidecar::Stamp{kBase.crc, kBase.bytes + 1}, batches));
+    EXPECT_FALSE(WallJournal::read(path, WallSidecar::Stamp{kBase.crc ^ 1u, kBase.bytes}, batches));
+    EXPECT_TRUE(batches.empty());
+    EXPECT_EQ(readBytes(path).size(), bytes) << "a stale journal is left for the next start to replace";
+
+    // Restarting empties it, on the new base.
+    const WallSidecar::Stamp next{0x55u, 8192};
+    ASSERT_TRUE(WallJournal::start(path, next));
+    ASSERT_TRUE(WallJournal::read(path, next, batches));
+    EXPECT_TRUE(batches.empty());
+    std::remove(path.c_str());
+
+    // No journal to extend: append never creates one.
+    EXPECT_FALSE(WallJournal::append(path, live.take(), bytes));
+    EXPECT_FALSE(WallJournal::read(path, next, batches));
+}
+
+TEST(WallJournalTest, BatchesThatCannotReplayAreNotWritten) {
+    WallJournal::Batch b;
+    b.map.push_back({WallJournal::kMapAdd, 0, {1.f, 2.f, 3.f}, 0.1f, 1});
+    EXPECT_TRUE(b.encode().empty()) << "a map add without its descriptor";
+
+    std::mt19937 rng(4);
+    b.mapAdded = descRow(rng);
+    b.map.push_back({WallJournal::kMapSet, 0, {4.f, 5.f, 6.f}, 0.3f, 2});
+    b.hasMapFrame = true;
+    b.mapIntrinsics[0] = 500.f;
+    std::vector<uint8_t> bytes = b.encode();
+    ASSERT_FALSE(bytes.empty());
+    WallJournal::Batch back;
+    ASSERT_TRUE(WallJournal::Batch::decode(bytes.data(), bytes.size(), back));
+    ASSERT_EQ(back.map.size(), 2u);
+    EXPECT_EQ(back.map[1].pt, cv::Point3f(4.f, 5.f, 6.f));
+    EXPECT_TRUE(back.hasMapFrame);
+    EXPECT_EQ(back.mapIntrinsics[0], 500.f);
+
+    EXPECT_FALSE(WallJournal::Batch::decode(bytes.data(), bytes.size() - 1, back));
+    std::vector<uint8_t> extra = bytes;
+    extra.push_back(0);
+    EXPECT_FALSE(WallJournal::Batch::decode(extra.data(), extra.size(), back));
+    // The first record's op: after the wall length, flags, frame and the four counts.
+    std::vector<uint8_t> badOp = bytes;
+    badOp[4 + 4 + 20 * 4 + 16] = 9;
+    EXPECT_FALSE(WallJournal::Batch::decode(badOp.data(), badOp.size(), back));
+}
+
+TEST(WallJournalTest, PathSitsBesideTheSidecar) {
+    EXPECT_EQ(WallJournal::pathFor("/p/1/wall.gxws"), "/p/1/wall.gxwj");
+    EXPECT_EQ(WallJournal::pathFor("/p/1/wall"), "/p/1/wall.gxwj");
+    EXPECT_EQ(WallJournal::pathFor(".gxws"), ".gxws.gxwj");
+}
@@ -0,0 +1,114 @@
+#include "WallRegistry.h"
+#include <gtest/gtest.h>
+#include <algorithm>
+
+namespace {
+
+// A wall of [rows] float descriptors whose global descriptor points along [axis].
+WallSlot slot(int rows, int axis = 0, int cols = 8) {
+    WallSlot s(0.01f, 0.25f, 0.01f);
+    cv::Mat d(rows, cols, CV_32F, cv::Scalar(0));
+    for (int r = 0; r < rows; ++r) d.at<float>(r, axis) = 1.0f;
+    s.wallDescs.assign(d);
+    s.wallPts.assign((size_t)rows, cv::Point3f(0.1f * axis, 0, 0));
+    s.global = KeyframeGraph::globalDescriptor(s.wallDescs.view());
+    s.globalType = CV_32F;
+    return s;
+}
+
+cv::Mat unit(int axis, int cols = 8) {
+    cv::Mat g(1, cols, CV_32F, cv::Scalar(0));
+    g.at<float>(0, axis) = 1.0f;
+    return g;
+}
+
+}  // namespace
+
+TEST(WallRegistryTest, PutAndTakeMoveTheSlot) {
+    WallRegistry reg;
+    reg.put("a", slot(100, 1));
+    EXPECT_TRUE(reg.contains("a"));
+    EXPECT_EQ(reg.size(), 1u);
+    EXPECT_GT(reg.bytes(), 0u);
+
+    WallSlot out(0.01f, 0.25f, 0.01f);
+    EXPECT_FALSE(reg.take("b", out));
+    ASSERT_TRUE(reg.take("a", out));
+    EXPECT_EQ(out.wallDescs.rows(), 100);
+    EXPECT_EQ(out.wallPts.size(), 100u);
+    EXPECT_FLOAT_EQ(out.wallPts[0].x, 0.1f);
+    EXPECT_FALSE(reg.contains("a"));
+    EXPECT_EQ(reg.bytes(), 0u);
+}
+
+TEST(WallRegistryTest, ReplacingAndErasingKeepTheByteCount) {
+    WallRegistry reg;
+    reg.put("a", slot(100));
+    const size_t one = reg.bytes();
+    reg.put("a", slot(100));
+    EXPECT_EQ(reg.size(), 1u);
+    EXPECT_EQ(reg.bytes(), one);
+    reg.put("b", slot(400));
+    EXPECT_GT(reg.bytes(), 2 * one);
+    reg.erase("a");
+    reg.erase("missing");
+    EXPECT_EQ(reg.bytes(), WallRegistry::footprint(slot(400)));
+    reg.clear();
+    EXPECT_EQ(reg.size(), 0u);
+    EXPECT_EQ(reg.bytes(), 0u);
+}
+
+TEST(WallRegistryTest, EvictsLeastRecentlyUsedOverBudget) {
+    WallRegistry reg;
+    const size_t one = WallRegistry::footprint(slot(100));
+    reg.setBudget(2 * one + one / 2);
+    std::vector<std::string> evicted;
+    reg.put("a", slot(100, 0), &evicted);
+    reg.put("b", slot(100, 1), &evicted);
+    EXPECT_TRUE(evicted.empty());
+
+    // Scoring best touches "a", so "b" is now the least recently used.
+    std::string id;
+    float score = 0.f;
+    ASSERT_TRUE(reg.best(unit(0), CV_32F, id, score));
+    EXPECT_EQ(id, "a");
+    reg.put("c", slot(100, 2), &evicted);
+    EXPECT_EQ(evicted, std::vector<std::string>({"b"}));
+    EXPECT_TRUE(reg.contains("a"));
+    EXPECT_TRUE(reg.contains("c"));
+    EXPECT_LE(reg.bytes(), reg.budget());
+
+    // A wall over the budget on its own evicts itself.
+    evicted.clear();
+    reg.setBudget(one);
+    EXPECT_EQ(reg.size(), 1u);
+    reg.put("big", slot(1000, 3), &evicted);
+    EXPECT_NE(std::find(evicted.begin(), evicted.end(), "big"), evicted.end());
+    EXPECT_FALSE(reg.contains("big"));
+    EXPECT_LE(reg.bytes(), reg.budget());
+}
+
+TEST(WallRegistryTest, BestMatchesOnlyComparableGlobals) {
+    WallRegistry reg;
+    reg.put("x", slot(50, 0));
+    reg.put("y", slot(50, 1));
+    WallSlot orb(0.01f, 0.25f, 0.01f);
+    orb.global = unit(2);
+    orb.globalType = CV_8U;
+    reg.put("orb", std::move(orb));
+
+    std::string id;
+    float score = 0.f;
+    ASSERT_TRUE(reg.best(unit(1), CV_32F, id, score));
+    EXPECT_EQ(id, "y");
+    EXPECT_NEAR(score, 1.0f, 1e-5f);
+
+    // The ORB wall points the same way at the same width, but pools another descriptor type.
+    EXPECT_FALSE(reg.best(unit(2), CV_32F, id, score));
+    ASSERT_TRUE(reg.best(unit(2), CV_8U, id, score));
+    EXPECT_EQ(id, "orb");
+    // Orthogonal to every wall, a different width, or empty: no winner.
+    EXPECT_FALSE(reg.best(unit(5), CV_32F, id, score));
+    EXPECT_FALSE(reg.best(unit(0, 16), CV_32F, id, score));
+    EXPECT_FALSE(reg.best(cv::Mat(), CV_32F, id, score));
+}
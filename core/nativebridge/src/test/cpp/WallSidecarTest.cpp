@@ -0,0 +1,239 @@
+#include "WallSidecar.h"
+#include "DescriptorCodec.h"
+#include "TestFiles.h"
+#include <gtest/gtest.h>
+#include <cstdio>
+#include <cstring>
+#include <random>
+
+namespace {
+
+using namespace testfiles;
+
+// Re-sign an edited file, so the edit reaches the checks behind the checksum.
+void restamp(std::vector<uint8_t>& b) {
+    const uint32_t crc = WallSidecar::crc32(b.data() + 32, b.size() - 32);
+    memcpy(b.data() + 12, &crc, 4);
+}
+
+cv::Mat unitRows(int rows, int cols, uint32_t seed) {
+    std::mt19937 rng(seed);
+    std::normal_distribution<float> g;
+    cv::Mat m(rows, cols, CV_32F);
+    for (int r = 0; r < rows; ++r) {
+        float n = 0.f;
+        for (int c = 0; c < cols; ++c) n += (m.at<float>(r, c) = g(rng)) * m.at<float>(r, c);
+        for (int c = 0; c < cols; ++c) m.at<float>(r, c) /= std::sqrt(n);
+    }
+    return m;
+}
+
+// ORB-shaped rows with most bits clear, so the range coder has something to save.
+cv::Mat sparseBits(int rows, uint32_t seed) {
+    std::mt19937 rng(seed);
+    cv::Mat m(rows, 32, CV_8U);
+    for (int r = 0; r < rows; ++r)
+        for (int c = 0; c < 32; ++c) m.at<uchar>(r, c) = (uchar)((rng() & rng() & rng()) & 0xFF);
+    return m;
+}
+
+WallSidecar::Contents contents() {
+    WallSidecar::Contents c;
+    c.wallDescs = unitRows(40, 256, 1);
+    for (int i = 0; i < 40; ++i) {
+        c.wallPts.emplace_back(0.01f * i, -0.02f * i, 1.5f);
+        c.wallRegions.push_back((uint8_t)(i % 3));
+    }
+    for (int i = 0; i < 16; ++i) { c.fpAnchor[i] = 0.5f * i; c.fpView[i] = -0.25f * i; }
+    c.fpIntrinsics[0] = 500; c.fpIntrinsics[1] = 501; c.fpIntrinsics[2] = 320; c.fpIntrinsics[3] = 240;
+    c.hasFpView = true;
+    c.mapDescs = sparseBits(25, 2);
+    for (int i = 0; i < 25; ++i) {
+        c.mapPts.emplace_back(-0.1f * i, 0.3f, 2.0f + 0.01f * i);
+        c.mapConf.push_back(0.04f * i);
+        c.mapObs.push_back(i + 1);
+    }
+    c.mapIntrinsics[0] = 450;
+    return c;
+}
+
+bool same(const cv::Mat& a, const cv::Mat& b) {
+    if (a.rows != b.rows || a.cols != b.cols || a.type() != b.type()) return false;
+    for (int r = 0; r < a.rows; ++r)
+        if (memcmp(a.ptr(r), b.ptr(r), (size_t)a.cols * a.elemSize()) != 0) return false;
+    return true;
+}
+
+// Byte offset of section [id]'s table entry.
+size_t entryOf(const std::vector<uint8_t>& b, uint32_t id) {
+    uint32_t count;
+    memcpy(&count, b.data() + 8, 4);
+    for (uint32_t i = 0; i < count; ++i) {
+        uint32_t e;
+        memcpy(&e, b.data() + 32 + 32 * (size_t)i, 4);
+        if (e == id) return 32 + 32 * (size_t)i;
+    }
+    return 0;
+}
+
+uint32_t version(const std::vector<uint8_t>& b) {
+    uint32_t v;
+    memcpy(&v, b.data() + 4, 4);
+    return v;
+}
+
+}  // namespace
+
+TEST(WallSidecarTest, CrcMatchesTheZipCheckValue) {
+    const char* s = "123456789";
+    EXPECT_EQ(WallSidecar::crc32(reinterpret_cast<const uint8_t*>(s), 9), 0xCBF43926u);
+    // Continuing from a prefix's crc is the crc of the whole.
+    const uint32_t head = WallSidecar::crc32(reinterpret_cast<const uint8_t*>(s), 4);
+    EXPECT_EQ(WallSidecar::crc32(reinterpret_cast<const uint8_t*>(s) + 4, 5, head), 0xCBF43926u);
+}
+
+TEST(WallSidecarTest, RawRoundTripIsExactAndStamped) {
+    const std::string path = tempPath("raw.gxws");
+    const WallSidecar::Contents in = contents();
+    WallSidecar::Stamp written;
+    ASSERT_TRUE(WallSidecar::write(path, in, &written));
+    EXPECT_EQ(version(readBytes(path)), 1u);
+
+    WallSidecar::Contents out;
+    ASSERT_TRUE(WallSidecar::read(path, out));
+    EXPECT_TRUE(written.valid());
+    EXPECT_EQ(out.stamp, written);
+    EXPECT_EQ(out.stamp.bytes, readBytes(path).size());
+    EXPECT_TRUE(same(out.wallDescs, in.wallDescs));
+    EXPECT_TRUE(same(out.mapDescs, in.mapDescs));
+    EXPECT_EQ(out.wallPts, in.wallPts);
+    EXPECT_EQ(out.wallRegions, in.wallRegions);
+    EXPECT_EQ(out.mapPts, in.mapPts);
+    EXPECT_EQ(out.mapConf, in.mapConf);
+    EXPECT_EQ(out.mapObs, in.mapObs);
+    EXPECT_TRUE(out.hasFpView);
+    EXPECT_EQ(0, memcmp(out.fpAnchor, in.fpAnchor, sizeof in.fpAnchor));
+    EXPECT_EQ(0, memcmp(out.fpView, in.fpView, sizeof in.fpView));
+    EXPECT_EQ(0, memcmp(out.fpIntrinsics, in.fpIntrinsics, sizeof in.fpIntrinsics));
+    EXPECT_EQ(0, memcmp(out.mapIntrinsics, in.mapIntrinsics, sizeof in.mapIntrinsics));
+
+    // Mapped, and the mapping outlives the file's name.
+    std::remove(path.c_str());
+    EXPECT_TRUE(same(out.wallDescs, in.wallDescs));
+    cv::Mat copy = out.mapDescs;
+    out = WallSidecar::Contents();
+    EXPECT_TRUE(same(copy, in.mapDescs));
+}
+
+TEST(WallSidecarTest, CodedRoundTripIsVersionTwoAndWithinBound) {
+    const std::string path = tempPath("coded.gxws");
+    WallSidecar::Contents in = contents();
+    in.descCodecLevel = 2;
+    ASSERT_TRUE(WallSidecar::write(path, in));
+    const auto bytes = readBytes(path);
+    EXPECT_EQ(version(bytes), 2u);
+
+    WallSidecar::Contents out;
+    ASSERT_TRUE(WallSidecar::read(path, out));
+    ASSERT_EQ(out.wallDescs.rows, in.wallDescs.rows);
+    ASSERT_EQ(out.wallDescs.type(), CV_32F);
+    for (int r = 0; r < in.wallDescs.rows; ++r) {
+        double e = 0;
+        for (int c = 0; c < in.wallDescs.cols; ++c) {
+            const double d = out.wallDescs.at<float>(r, c) - in.wallDescs.at<float>(r, c);
+            e += d * d;
+        }
+        EXPECT_LE(std::sqrt(e), DescriptorCodec::kMaxRowError) << "row " << r;
+    }
+    EXPECT_TRUE(same(out.mapDescs, in.mapDescs));   // ORB is lossless at every level
+
+    WallSidecar::Contents raw = contents();
+    ASSERT_TRUE(WallSidecar::write(path, raw));
+    EXPECT_LT(bytes.size(), readBytes(path).size());
+    std::remove(path.c_str());
+}
+
+TEST(WallSidecarTest, EveryByteIsUnderTheChecksum) {
+    const std::string path = tempPath("crc.gxws");
+    ASSERT_TRUE(WallSidecar::write(path, contents()));
+    const auto good = readBytes(path);
+    WallSidecar::Contents out;
+    out.mapObs = {42};
+    // A sample of positions past the header: the table, padding and every payload.
+    for (size_t at = 32; at < good.size(); at += 97) {
+        auto bad = good;
+        bad[at] ^= 0x10;
+        writeBytes(path, bad);
+        EXPECT_FALSE(WallSidecar::read(path, out)) << "flip at " << at;
+    }
+    EXPECT_EQ(out.mapObs, std::vector<int>({42})) << "a refused read must leave [out] alone";
+    std::remove(path.c_str());
+}
+
+TEST(WallSidecarTest, ReadRefusesInconsistentFiles) {
+    const std::string path = tempPath("bad.gxws");
+    ASSERT_TRUE(WallSidecar::write(path, contents()));
+    const auto good = readBytes(path);
+    WallSidecar::Contents out;
+    auto refuses = [&](std::vector<uint8_t> b, bool resign) {
+        if (resign) restamp(b);
+        writeBytes(path, b);
+        return !WallSidecar::read(path, out);
+    };
+    auto u32At = [](std::vector<uint8_t> b, size_t at, uint32_t v) { memcpy(b.data() + at, &v, 4); return b; };
+    auto u64At = [](std::vector<uint8_t> b, size_t at, uint64_t v) { memcpy(b.data() + at, &v, 8); return b; };
+    const size_t points = entryOf(good, WallSidecar::kWallPoints);
+    const size_t regions = entryOf(good, WallSidecar::kWallRegions);
+    const size_t mapObs = entryOf(good, WallSidecar::kMapObs);
+    ASSERT_NE(points, 0u);
+    ASSERT_NE(regions, 0u);
+    ASSERT_NE(mapObs, 0u);
+    uint64_t pointsOffset;
+    memcpy(&pointsOffset, good.data() + points + 16, 8);
+
+    auto bad = good;
+    bad[0] = 'X';
+    EXPECT_TRUE(refuses(bad, false)) << "magic";
+    EXPECT_TRUE(refuses(u32At(good, 4, WallSidecar::kVersion + 1), false)) << "newer version";
+    EXPECT_TRUE(refuses(u32At(good, 4, 0), false)) << "version 0";
+    EXPECT_TRUE(refuses(u32At(good, 8, 0), false)) << "no sections";
+    EXPECT_TRUE(refuses(u32At(good, 24, 48), false)) << "alignment not a power of two";
+    EXPECT_TRUE(refuses(std::vector<uint8_t>(good.begin(), good.end() - 1), false)) << "truncated";
+    bad = good;
+    bad.push_back(0);
+    EXPECT_TRUE(refuses(bad, true)) << "longer than it says";
+    EXPECT_TRUE(refuses(std::vector<uint8_t>(good.begin(), good.begin() + 20), false)) << "shorter than a header";
+
+    EXPECT_TRUE(refuses(u64At(good, points + 16, pointsOffset + 4), true)) << "misaligned section";
+    EXPECT_TRUE(refuses(u64At(good, points + 16, good.size()), true)) << "section past the end";
+    EXPECT_TRUE(refuses(u64At(good, points + 16, 0), true)) << "section over the table";
+    EXPECT_TRUE(refuses(u64At(good, points + 24, 12), true)) << "bytes disagree with the shape";
+    EXPECT_TRUE(refuses(u32At(good, points + 4, CV_64F), true)) << "unsupported type";
+    EXPECT_TRUE(refuses(u32At(good, regions, WallSidecar::kWallPoints), true)) << "repeated section";
+    // Self-consistent entries that disagree with the point count.
+    EXPECT_TRUE(refuses(u64At(u32At(good, regions + 12, 39), regions + 24, 39), true)) << "regions";
+    EXPECT_TRUE(refuses(u64At(u32At(good, mapObs + 12, 24), mapObs + 24, 96), true)) << "obs";
+
+    // A section id this build does not know is skipped, not refused.
+    writeBytes(path, [&] { auto b = u32At(good, entryOf(good, WallSidecar::kFpView), 60); restamp(b); return b; }());
+    ASSERT_TRUE(WallSidecar::read(path, out));
+    EXPECT_FALSE(out.hasFpView);
+    EXPECT_EQ(out.wallDescs.rows, 40);
+    std::remove(path.c_str());
+}
+
+TEST(WallSidecarTest, WriteLeavesOutSetsThatDisagreeWithTheirPoints) {
+    const std::string path = tempPath("partial.gxws");
+    WallSidecar::Contents in = contents();
+    in.mapPts.pop_back();
+    ASSERT_TRUE(WallSidecar::write(path, in));
+    WallSidecar::Contents out;
+    ASSERT_TRUE(WallSidecar::read(path, out));
+    EXPECT_EQ(out.wallDescs.rows, 40);
+    EXPECT_TRUE(out.mapDescs.empty());
+    EXPECT_TRUE(out.mapPts.empty());
+
+    in.wallPts.pop_back();
+    EXPECT_FALSE(WallSidecar::write(path, in)) << "nothing left to write";
+    std::remove(path.c_str());
+}
@@ -270,7 +270,9 @@ class ArViewModel @Inject constructor(
                     )
                     return@launch
                 }
-                val fingerprint = slamManager.exportFingerprint() ?: ByteArray(0)
+                // The versioned change set (protocol v3), so the guest learns which wall state it
+                // holds and its later syncs fetch only what self-grow and refinement add to it.
+                val fingerprint = slamManager.exportFingerprintDelta() ?: ByteArray(0)
                 val projectBytes = projectManager.serializeCurrentProject()
                 if (projectBytes.isEmpty()) {
                     // A project is open but its folder didn't serialize (never saved to disk, or the
@@ -288,6 +290,7 @@ class ArViewModel @Inject constructor(
                     fingerprintBytes = fingerprint,
                     projectBytes = projectBytes,
                     localDeviceName = android.os.Build.MODEL,
+                    fingerprintDelta = { epoch, sinceGen -> slamManager.exportFingerprintDelta(epoch, sinceGen) },
                 )
                 _uiState.update {
                     it.copy(
@@ -325,10 +328,15 @@ class ArViewModel @Inject constructor(
                     qr = qr,
                     localDeviceName = android.os.Build.MODEL,
                     onBulkReceived = { fingerprint, project ->
-                        slamManager.alignToPeer(fingerprint)
+                        if (fingerprint.isNotEmpty()) slamManager.applyFingerprintDelta(fingerprint)
                         projectManager.loadAsSpectator(project)
                     },
                     onOp = { op -> dispatchSpectatorOp(op) },
+                    fingerprintBase = {
+                        val base = slamManager.getPeerFingerprintBase()
+                        base[0] to base[1]
+                    },
+                    onFingerprintSync = { delta -> slamManager.applyFingerprintDelta(delta) },
                 )
                 _uiState.update { it.copy(coopRole = com.hereliesaz.graffitixr.common.model.CoopRole.GUEST) }
                 observeCoopState()
@@ -676,10 +684,13 @@ class ArViewModel @Inject constructor(
     /**
      * Push the feature-map switch to the engine. Build and match move together on purpose: matching
      * against a map nothing grows finds nothing, and growing one nothing matches only costs memory.
+     * Wall pre-selection rides the same switch: it votes with the keyframe globals the map builds,
+     * and its proposals are handled in [setTrackingState].
      */
     private fun applyFeatureMapSwitch(on: Boolean) {
         slamManager.setMapBuildEnabled(on)
         slamManager.setMapRelocEnabled(on)
+        slamManager.setWallPreselectEnabled(on)
     }
 
     private val _evalFusionEnabled = MutableStateFlow(false)
@@ -1055,9 +1066,14 @@ class ArViewModel @Inject constructor(
         NativeLibLoader.loadAll()
         startSystemThrottleMonitoring()
         restoreExperimentSwitches()
+        slamManager.setDescriptorCompression(WALL_SIDECAR_COMPRESSION)
+        // Before any project loads, so the first sidecar load starts the journal the autosave appends
+        // to. An append that cannot extend it returns -1 and the autosave saves as it always did.
+        slamManager.setMutationJournalEnabled(true)
         viewModelScope.launch(Dispatchers.IO) {
             slamManager.loadSuperPoint(appContext.assets)
             slamManager.loadDistortionHead(appContext.assets) // optional; inert if asset absent
+            slamManager.loadVocabulary(appContext.assets)     // optional; inert if asset absent
             slamManager.loadLowLightEnhancer(appContext.assets)
         }
         viewModelScope.launch {
@@ -2044,19 +2060,36 @@ class ArViewModel @Inject constructor(
     }
 
     /**
-     * Phase 3b: persist the in-session passive feature map into the project record (.gxr), preserving the
+     * Phase 3b: persist the in-session passive feature map with the project (.gxr), preserving the
      * rest of the current project. No-op when building is off / the map is empty. Async + best-effort.
+     *
+     * Written to the binary sidecar (`docs/data_formats.md` §4) straight from native, with only its
+     * name going into `project.json`; the JSON [WallFeatureMap] is the fallback if that write fails.
      */
     private fun saveWallFeatureMap() {
-        if (projectRepository.currentProject.value == null) return
+        val projectId = projectRepository.currentProject.value?.id ?: return
         viewModelScope.launch(Dispatchers.IO) {
             try {
-                val map = slamManager.getWallFeatureMap() ?: return@launch
-                if (map.pointCount <= 0) return@launch
+                if (slamManager.getMapPointCount() <= 0) return@launch
                 // Merge through the repository's atomic transform (not a full-object write via
                 // projectManager) so a concurrent editor layer-save can't clobber the wall map and
                 // vice-versa — both funnel through updateProject(transform). (docs/AUDIT.md save-race)
-                projectRepository.updateProject { it.copy(wallFeatureMap = map) }
+                // Keyed on the id the save started for: the sidecar was written into that
+                // project's directory, so it must not be recorded on a project opened since.
+                val dir = File(appContext.filesDir, "projects/$projectId").apply { mkdirs() }
+                if (slamManager.saveWallSidecar(File(dir, WALL_SIDECAR_FILE))) {
+                    projectRepository.updateProject {
+                        if (it.id != projectId) it
+                        else it.copy(wallFeatureMap = null, wallSidecarFile = WALL_SIDECAR_FILE)
+                    }
+                    return@launch
+                }
+                val map = slamManager.getWallFeatureMap() ?: return@launch
+                if (map.pointCount <= 0) return@launch
+                // The JSON map now wins on load, so drop the reference to a sidecar it supersedes.
+                projectRepository.updateProject {
+                    if (it.id != projectId) it else it.copy(wallFeatureMap = map, wallSidecarFile = null)
+                }
             } catch (e: Exception) {
                 Timber.e(e, "Wall feature map save failed")
             }
@@ -2426,6 +2459,14 @@ class ArViewModel @Inject constructor(
             // once`, which is why that test exists.)
             if (current != null && current.projectId != project.id) latestDesignFootprint = null
 
+            // A different project: park the outgoing wall in native's registry and swap this
+            // project's in if it is parked there (opened earlier this session). `parked` then means
+            // native already holds exactly what the restores below would push, and they are skipped
+            // — the swap moved it in place. Otherwise native is left empty and labelled, and the
+            // restores fill it as before. Same project, new fingerprint (a re-capture): nothing to
+            // swap, and the restores must run.
+            val parked = current?.projectId != project.id && slamManager.activateWall(project.id)
+
             val intr = project.fingerprintIntrinsics
             val anchor = project.fingerprintAnchor
             // IMPLEMENTATION.md 0.7 — refuse a pre-Phase-0 metric fingerprint instead of
@@ -2498,7 +2539,7 @@ class ArViewModel @Inject constructor(
                     // matches the live capture instead of using a default-intrinsics guess.
                     val view = project.fingerprintViewMatrix
                         .takeIf { it.size == 16 }?.toFloatArray() ?: FloatArray(0)
-                    slamManager.restoreWallFingerprintMetric(
+                    if (!parked) slamManager.restoreWallFingerprintMetric(
                         fp.descriptorsData, fp.descriptorsRows, fp.descriptorsCols,
                         fp.descriptorsType, fp.points3d.toFloatArray(),
                         anchor.toFloatArray(), intr.toFloatArray(),
@@ -2520,7 +2561,7 @@ class ArViewModel @Inject constructor(
 
                 else -> {
                     // Depth-path or pre-existing project: descriptors-only legacy restore.
-                    slamManager.restoreWallFingerprint(
+                    if (!parked) slamManager.restoreWallFingerprint(
                         fp.descriptorsData, fp.descriptorsRows, fp.descriptorsCols,
                         fp.descriptorsType, fp.points3d.toFloatArray(),
                     )
@@ -2554,12 +2595,23 @@ class ArViewModel @Inject constructor(
             // reads it.
             if (fp != null && !legacyFrame && hasCoRegistration) partitionLiveFingerprintIfNeeded()
 
+            // The sidecar when the project has one and it maps and validates; otherwise the JSON map,
+            // which is also what every project saved before the sidecar carries. The name comes from
+            // an untrusted file, so anything but a bare file name is ignored.
+            val sidecar = project.wallSidecarFile
+                ?.takeIf { it.isNotEmpty() && File(it).name == it }
+                ?.let { File(File(appContext.filesDir, "projects/${project.id}"), it) }
             val map = project.wallFeatureMap
-            if (map != null && map.pointCount > 0) {
-                slamManager.restoreWallFeatureMap(map)
-            } else {
+            when {
+                // Swapped in with the fingerprint, grown further than any file if it was in use. The
+                // swap ended the journal, which named the outgoing wall's file; a save writes what
+                // was parked and starts a journal on it, so the autosave appends from here.
+                parked -> saveWallFeatureMap()
+                // Mapped: the map is live, its descriptors read in place from the file.
+                sidecar != null && slamManager.loadWallSidecar(sidecar) -> Unit
+                map != null && map.pointCount > 0 -> slamManager.restoreWallFeatureMap(map)
                 // No map on this project: clear any map left in native from a previously loaded project.
-                slamManager.clearWallFeatureMap()
+                else -> slamManager.clearWallFeatureMap()
             }
         }
     }
@@ -2581,6 +2633,16 @@ class ArViewModel @Inject constructor(
         autoSaveJob = viewModelScope.launch(Dispatchers.IO) {
             while (true) {
                 delay(AUTOSAVE_INTERVAL_MS)
+                // The journal first: what changed since the last tick, appended beside the sidecar,
+                // which costs kilobytes where the save below rewrites every descriptor. -1 means it
+                // cannot (journaling off, no sidecar yet, the map replaced) and the save decides as
+                // before; a journal grown past its budget is folded into a fresh sidecar.
+                val journal = appendWallJournal()
+                if (journal in 0..WALL_JOURNAL_COMPACT_BYTES) continue
+                if (journal > WALL_JOURNAL_COMPACT_BYTES) {
+                    saveMapNow()
+                    continue
+                }
                 // The accumulated ARCore cloud, not the deleted splat map. The old reading was a
                 // hardcoded 0, so `current > 0` was never true and this loop woke every 30s to do
                 // nothing for the whole session — the wall feature map and the cloud were persisted
@@ -2594,6 +2656,23 @@ class ArViewModel @Inject constructor(
         }
     }
 
+    /**
+     * Append the wall's changes since the last call to the journal beside the current project's
+     * sidecar (`docs/data_formats.md` §6). The journal's size in bytes, or -1 when there is no
+     * journal to extend; a full save ([saveWallFeatureMap]) then starts one.
+     */
+    private fun appendWallJournal(): Long {
+        val projectId = projectRepository.currentProject.value?.id ?: return -1L
+        // A full save in flight is writing a newer base; its journal starts empty.
+        if (isSaving.get()) return 0L
+        return try {
+            slamManager.appendWallJournal(File(appContext.filesDir, "projects/$projectId/$WALL_SIDECAR_FILE"))
+        } catch (e: Exception) {
+            Timber.e(e, "Wall journal append failed")
+            -1L
+        }
+    }
+
     private fun stopAutoSave() {
         autoSaveJob?.cancel()
         autoSaveJob = null
@@ -2642,6 +2721,29 @@ class ArViewModel @Inject constructor(
         renderer?.attachSession(session)
     }
 
+    /**
+     * Open the project whose wall pre-selection proposed. The load does the rest: the
+     * `currentProject` emission reaches [loadFingerprintIfExists], whose `activateWall` swaps the
+     * parked wall in without a restore. A project deleted since its wall was parked can't open, and
+     * its wall is dropped so it is not proposed again.
+     */
+    private fun openProposedWall(projectId: String) {
+        viewModelScope.launch {
+            projectRepository.loadProject(projectId)
+                .onSuccess {
+                    val name = projectRepository.currentProject.value?.name ?: return@onSuccess
+                    Timber.i("Wall pre-selection opened project $projectId")
+                    _feedback.tryEmit(
+                        com.hereliesaz.graffitixr.common.model.FeedbackEvent.Toast("Switched to $name"),
+                    )
+                }
+                .onFailure {
+                    Timber.w(it, "Wall pre-selection proposed $projectId, which no longer opens")
+                    slamManager.forgetWall(projectId)
+                }
+        }
+    }
+
     fun setTrackingState(
         isTracking: Boolean,
         splatCount: Int,
@@ -2670,6 +2772,11 @@ class ArViewModel @Inject constructor(
         // Read alongside the diagnostics, not on a success path: the state this exists to expose is
         // "the capture produced nothing", which by definition never reaches one.
         val wallPoints = slamManager.getWallKeypointCount()
+        // Polled on the same tick: the camera has kept preferring another project's parked wall
+        // over this one. Consumed by the read, so one proposal opens the project once.
+        slamManager.takeProposedWall()
+            .takeIf { it.isNotEmpty() && it != loadedProjectId }
+            ?.let { openProposedWall(it) }
 
         val nowMs = System.currentTimeMillis()
 
@@ -3265,6 +3372,25 @@ class ArViewModel @Inject constructor(
          */
         const val AUTOSAVE_POINT_DELTA = 500
 
+        /** The wall sidecar's file name inside a project directory (`docs/data_formats.md` §4). */
+        const val WALL_SIDECAR_FILE = "wall.gxws"
+
+        /**
+         * Descriptor compression for the sidecar ([SlamManager.setDescriptorCompression]). Level 1:
+         * ORB is entropy-coded losslessly and SuperPoint stored as half floats, whose rounding is far
+         * below the matcher's ratio margins, so a reloaded wall matches as the saved one did at about
+         * half the bytes. Level 2's int8 blocks save more but move match distances by up to twice
+         * DescriptorCodec's row bound, which is a trade to make on evidence, not by default.
+         */
+        const val WALL_SIDECAR_COMPRESSION = 1
+
+        /**
+         * Journal size past which an autosave compacts it into a fresh sidecar instead of appending.
+         * Replay reads the whole journal on load, so it is kept to a few autosaves' worth of change:
+         * small next to a SuperPoint map's descriptors, which is what an append avoids rewriting.
+         */
+        const val WALL_JOURNAL_COMPACT_BYTES = 4L * 1024 * 1024
+
         /**
          * Fixed RANSAC seed for eval runs (`IMPLEMENTATION.md` 6a.4, `EVALUATION.md` §3.1).
          *
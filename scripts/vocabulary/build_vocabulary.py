@@ -0,0 +1,174 @@
+#!/usr/bin/env python3
+"""
+build_vocabulary.py — train a bag-of-words vocabulary tree for GraffitiXR's cold relocalization.
+
+Hierarchical k-means over wall-imagery descriptors: k clusters per node, L levels deep, leaves are
+the words. Each word's idf is log(documents / documents containing it), a document being one
+training image (or one .npy file). The native side (VocabularyTree.cpp) reads the result.
+
+Descriptors must match what the device produces:
+  - SuperPoint: 256-float rows, L2-normalised — dump them from the device or the reference model
+    as N x 256 float32 .npy, one file per image.
+  - ORB: 32-byte rows — extracted here from images with OpenCV's ORB (same defaults as the app).
+
+Outputs (little-endian, format documented in VocabularyTree.h):
+  core/nativebridge/src/main/assets/bow_superpoint.voc
+  core/nativebridge/src/main/assets/bow_orb.voc
+
+Usage:
+  pip install numpy opencv-python
+  python3 scripts/vocabulary/build_vocabulary.py --npy dumps/*.npy \\
+      --output core/nativebridge/src/main/assets/bow_superpoint.voc
+  python3 scripts/vocabulary/build_vocabulary.py --images walls/ \\
+      --output core/nativebridge/src/main/assets/bow_orb.voc
+
+The asset ships in the APK and holds every node's centre, so its size is set by k and L: about
+(k^(L+1) - 1) / (k - 1) nodes of 8 bytes plus one centre each (1024 bytes SuperPoint, 32 bytes ORB).
+At k=10, a full tree comes to:
+
+  L   words   SuperPoint   ORB
+  3   1e3     1.1 MB       45 KB
+  4   1e4     11 MB        440 KB
+  5   1e5     115 MB       4.4 MB
+  6   1e6     1.1 GB       44 MB
+
+The defaults are L=4 for SuperPoint and L=5 for ORB, the deepest each can ship at. k=10, L=6 is the
+usual choice in the literature, but only a server could hold it. A small training set stops short of
+these sizes anyway, since a node with fewer than k descriptors becomes a leaf early.
+"""
+
+import argparse
+import math
+import pathlib
+import struct
+import sys
+from collections import deque
+
+import numpy as np
+
+CV_8U = 0
+CV_32F = 5
+ROOT = 0xFFFFFFFF
+
+
+def load_npy(paths):
+    docs = []
+    for p in paths:
+        d = np.load(p)
+        if d.ndim != 2 or len(d) == 0:
+            continue
+        docs.append(d.astype(np.float32) if d.dtype != np.uint8 else d)
+    return docs
+
+
+def load_orb(image_dir, features):
+    import cv2
+    orb = cv2.ORB_create(nfeatures=features)
+    docs = []
+    for p in sorted(pathlib.Path(image_dir).iterdir()):
+        img = cv2.imread(str(p), cv2.IMREAD_GRAYSCALE)
+        if img is None:
+            continue
+        _, d = orb.detectAndCompute(img, None)
+        if d is not None and len(d):
+            docs.append(d)
+    return docs
+
+
+def kmeans_float(x, k, iters, rng):
+    centres = x[rng.choice(len(x), k, replace=False)]
+    for _ in range(iters):
+        dist = (centres * centres).sum(1)[None, :] - 2.0 * x @ centres.T   # + |x|², constant per row
+        assign = dist.argmin(1)
+        for c in range(k):
+            members = x[assign == c]
+            if len(members):
+                centres[c] = members.mean(0)
+    return centres, assign
+
+
+def kmajority_binary(x, k, iters, rng):
+    # Hamming k-means: centres are the per-bit majority of their members (the DBoW2 convention).
+    bits = np.unpackbits(x, axis=1).astype(np.int32)
+    centres = bits[rng.choice(len(x), k, replace=False)].copy()
+    for _ in range(iters):
+        dist = centres.sum(1)[None, :] - 2 * bits @ centres.T   # Hamming, less the per-row popcount
+        assign = dist.argmin(1)
+        for c in range(k):
+            members = bits[assign == c]
+            if len(members):
+                centres[c] = (members.mean(0) >= 0.5).astype(np.int32)
+    return np.packbits(centres.astype(np.uint8), axis=1), assign
+
+
+def build(docs, k, depth, iters, seed):
+    rng = np.random.default_rng(seed)
+    binary = docs[0].dtype == np.uint8
+    x = np.concatenate(docs)
+    doc_of_row = np.concatenate([np.full(len(d), i) for i, d in enumerate(docs)])
+    cols = x.shape[1]
+    cluster = kmajority_binary if binary else kmeans_float
+
+    # Breadth-first, so every parent is written before its children.
+    nodes = [(ROOT, np.zeros(cols, dtype=x.dtype), 0.0)]
+    queue = deque([(0, np.arange(len(x)), 0)])
+    leaves = {}
+    while queue:
+        node, rows, level = queue.popleft()
+        if level == depth or len(rows) < k:
+            leaves[node] = rows
+            continue
+        centres, assign = cluster(x[rows], k, iters, rng)
+        for c in range(k):
+            child = len(nodes)
+            nodes.append((node, centres[c], 0.0))
+            queue.append((child, rows[assign == c], level + 1))
+
+    n_docs = len(docs)
+    for node, rows in leaves.items():
+        containing = len(np.unique(doc_of_row[rows])) if len(rows) else 0
+        idf = math.log(n_docs / containing) if containing else 0.0
+        parent, centre, _ = nodes[node]
+        nodes[node] = (parent, centre, idf)
+    return nodes, CV_8U if binary else CV_32F, cols, len(leaves)
+
+
+def write(path, nodes, desc_type, cols, k, depth):
+    path.parent.mkdir(parents=True, exist_ok=True)
+    with open(path, "wb") as f:
+        f.write(b"GXVT")
+        f.write(struct.pack("<IIIiII", 1, k, depth, desc_type, cols, len(nodes)))
+        dtype = "<f4" if desc_type == CV_32F else "u1"
+        for parent, centre, idf in nodes:
+            f.write(struct.pack("<If", parent, idf))
+            f.write(np.asarray(centre).astype(dtype).tobytes())
+
+
+def main():
+    ap = argparse.ArgumentParser()
+    src = ap.add_mutually_exclusive_group(required=True)
+    src.add_argument("--npy", nargs="+", help="SuperPoint descriptor dumps, one N x 256 float32 .npy per image")
+    src.add_argument("--images", type=str, help="directory of wall images (ORB)")
+    ap.add_argument("--features", type=int, default=1000, help="ORB features per image")
+    ap.add_argument("--k", type=int, default=10, help="branching factor")
+    ap.add_argument("--depth", type=int, default=None,
+                    help="levels below the root (default 4 for SuperPoint, 5 for ORB; see the size table above)")
+    ap.add_argument("--iters", type=int, default=10, help="k-means iterations per node")
+    ap.add_argument("--seed", type=int, default=0)
+    ap.add_argument("--output", type=str, required=True)
+    args = ap.parse_args()
+
+    docs = load_npy(args.npy) if args.npy else load_orb(args.images, args.features)
+    if not docs:
+        sys.exit("no descriptors found")
+
+    depth = args.depth if args.depth is not None else (5 if docs[0].dtype == np.uint8 else 4)
+    nodes, desc_type, cols, words = build(docs, args.k, depth, args.iters, args.seed)
+    out = pathlib.Path(args.output)
+    write(out, nodes, desc_type, cols, args.k, depth)
+    print(f"[✓] {words} words, {len(nodes)} nodes from {len(docs)} documents → {out} "
+          f"({out.stat().st_size // 1024} KB)")
+
+
+if __name__ == "__main__":
+    main()